@@ -0,0 +1,366 @@
+#include "carga.h"
+
+/**
+ * @brief Suma nanosegundos a un instante
+ *
+ * @param instante Instante base
+ * @param nanosegundos Nanosegundos a sumar
+ * @return struct timespec Instante resultante
+ */
+static struct timespec sumar_nanosegundos(struct timespec instante, uint64_t nanosegundos)
+{
+    instante.tv_sec += nanosegundos / 1000000000;
+    instante.tv_nsec += nanosegundos % 1000000000;
+    if (instante.tv_nsec >= 1000000000)
+    {
+        instante.tv_sec++;
+        instante.tv_nsec -= 1000000000;
+    }
+    return instante;
+}
+
+/**
+ * @brief Nanosegundos entre dos instantes (0 si hasta es anterior)
+ *
+ * @param desde Instante inicial
+ * @param hasta Instante final
+ * @return uint64_t Nanosegundos
+ */
+static uint64_t nanosegundos_entre(struct timespec desde, struct timespec hasta)
+{
+    int64_t diferencia = (int64_t)(hasta.tv_sec - desde.tv_sec) * 1000000000 + (hasta.tv_nsec - desde.tv_nsec);
+    return diferencia > 0 ? (uint64_t)diferencia : 0;
+}
+
+/**
+ * @brief Indica si un instante ya pasó respecto de otro
+ *
+ * @param instante Instante a comparar
+ * @param limite Límite
+ * @return bool true si instante >= limite
+ */
+static bool vencido(struct timespec instante, struct timespec limite)
+{
+    return instante.tv_sec > limite.tv_sec || (instante.tv_sec == limite.tv_sec && instante.tv_nsec >= limite.tv_nsec);
+}
+
+/**
+ * @brief Función principal del generador de carga
+ *
+ * 1. Lee la configuración (carga.config o el archivo pasado como argumento)
+ * 2. Lanza un hilo por conexión; todos arrancan en el mismo instante
+ * 3. Durante CALENTAMIENTO_S envían sin medir y durante DURACION_S miden
+ * 4. Suma los histogramas de los hilos e informa throughput y latencias
+ *
+ * @param argc Cantidad de argumentos
+ * @param argv argv[1] opcional: archivo de configuración
+ * @return int EXIT_SUCCESS si todas las conexiones terminaron sin error
+ */
+int main(int argc, char **argv)
+{
+    t_log *logger = log_create("carga.log", "Carga", 1, LOG_LEVEL_INFO);
+
+    char *archivo = argc > 1 ? argv[1] : ARCHIVO_CONFIG_CARGA;
+    t_config *config = config_create(archivo);
+    if (config == NULL)
+    {
+        log_error(logger, "No se encontro el archivo de configuracion %s", archivo);
+        log_destroy(logger);
+        return EXIT_FAILURE;
+    }
+
+    t_config_carga parametros = cargar_config_carga(config);
+    log_info(logger, "%d conexiones, %s de %d bytes x %d, %d s (+%d s de calentamiento)",
+             parametros.conexiones, parametros.tipo == MENSAJE ? "MENSAJE" : "PAQUETE", parametros.tamanio,
+             parametros.tipo == MENSAJE ? 1 : parametros.elementos, parametros.duracion_s, parametros.calentamiento_s);
+    if ((parametros.confirmar || parametros.control_flujo) && protocolo_actual().version != PROTOCOLO_V2)
+    {
+        log_warning(logger, "CONFIRMAR y CONTROL_FLUJO requieren PROTOCOLO=2, se ignoran");
+        parametros.confirmar = parametros.control_flujo = false;
+    }
+    if (parametros.confirmar)
+        log_info(logger, "Solicitudes confirmadas, hasta %d en vuelo por conexion", parametros.ventana);
+    if (parametros.control_flujo)
+        log_info(logger, "Control de flujo por credito del servidor");
+
+    // Arranque común un poco en el futuro, para que todos los hilos estén listos
+    t_hilo_carga *hilos = calloc(parametros.conexiones, sizeof(t_hilo_carga));
+    struct timespec inicio;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    inicio = sumar_nanosegundos(inicio, 100 * 1000000);
+
+    for (int i = 0; i < parametros.conexiones; i++)
+    {
+        hilos[i].config = &parametros;
+        hilos[i].inicio = inicio;
+        hilos[i].latencias = crear_histograma();
+        hilos[i].lanzado = pthread_create(&hilos[i].hilo, NULL, generar_carga, &hilos[i]) == 0;
+        if (!hilos[i].lanzado)
+        {
+            log_error(logger, "No se pudo lanzar el hilo de la conexion %d", i);
+            hilos[i].error = true;
+        }
+    }
+
+    t_histograma *latencias = crear_histograma();
+    unsigned long frames = 0;
+    unsigned long long bytes = 0;
+    unsigned long rechazadas = 0;
+    int fallidas = 0;
+    for (int i = 0; i < parametros.conexiones; i++)
+    {
+        if (hilos[i].lanzado)
+            pthread_join(hilos[i].hilo, NULL);
+        sumar_histograma(latencias, hilos[i].latencias);
+        frames += hilos[i].frames;
+        bytes += hilos[i].bytes;
+        rechazadas += hilos[i].rechazadas;
+        fallidas += hilos[i].error;
+        free(hilos[i].latencias);
+    }
+
+    double segundos = parametros.duracion_s;
+    int valores = parametros.tipo == MENSAJE ? 1 : parametros.elementos;
+    log_info(logger, "Throughput: %.0f frames/s (%.0f valores/s), %.2f MB/s",
+             frames / segundos, frames * valores / segundos, bytes / segundos / (1024 * 1024));
+    log_info(logger, "Latencia de %s (us): p50=%.1f p90=%.1f p99=%.1f p999=%.1f max=%.1f promedio=%.1f",
+             parametros.confirmar ? "ida y vuelta" : "envio",
+             percentil_histograma(latencias, 50) / 1e3, percentil_histograma(latencias, 90) / 1e3,
+             percentil_histograma(latencias, 99) / 1e3, percentil_histograma(latencias, 99.9) / 1e3,
+             latencias->maximo / 1e3, promedio_histograma(latencias) / 1e3);
+    if (rechazadas > 0)
+        log_warning(logger, "El servidor rechazo %lu solicitudes", rechazadas);
+    if (fallidas > 0)
+        log_error(logger, "%d conexiones terminaron con error", fallidas);
+
+    free(latencias);
+    free(hilos);
+    config_destroy(config);
+    log_destroy(logger);
+    return fallidas == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Carga la configuración del generador
+ *
+ * Valores por defecto: CONEXIONES=1, DURACION_S=5, CALENTAMIENTO_S=1,
+ * TIPO=MENSAJE, TAMANIO=64, ELEMENTOS=10, TASA=0, CONFIRMAR=0,
+ * VENTANA=VENTANA_SOLICITUDES, CONTROL_FLUJO=0. PROTOCOLO,
+ * LONGITUDES_VARINT y UMBRAL_COMPRESION se interpretan como en el
+ * cliente.
+ *
+ * @param config Configuración abierta
+ * @return t_config_carga Parámetros
+ */
+t_config_carga cargar_config_carga(t_config *config)
+{
+    t_config_carga parametros = {
+        .ip = config_get_string_value(config, "IP"),
+        .puerto = config_get_string_value(config, "PUERTO"),
+        .conexiones = 1,
+        .duracion_s = 5,
+        .calentamiento_s = 1,
+        .tipo = MENSAJE,
+        .tamanio = 64,
+        .elementos = 10,
+        .tasa = 0,
+        .confirmar = false,
+        .ventana = VENTANA_SOLICITUDES,
+        .control_flujo = false};
+
+    if (config_has_property(config, "CONEXIONES"))
+        parametros.conexiones = config_get_int_value(config, "CONEXIONES");
+    if (config_has_property(config, "DURACION_S"))
+        parametros.duracion_s = config_get_int_value(config, "DURACION_S");
+    if (config_has_property(config, "CALENTAMIENTO_S"))
+        parametros.calentamiento_s = config_get_int_value(config, "CALENTAMIENTO_S");
+    if (config_has_property(config, "TIPO") && strcmp(config_get_string_value(config, "TIPO"), "PAQUETE") == 0)
+        parametros.tipo = PAQUETE;
+    if (config_has_property(config, "TAMANIO"))
+        parametros.tamanio = config_get_int_value(config, "TAMANIO");
+    if (config_has_property(config, "ELEMENTOS"))
+        parametros.elementos = config_get_int_value(config, "ELEMENTOS");
+    if (config_has_property(config, "TASA"))
+        parametros.tasa = config_get_double_value(config, "TASA");
+    if (config_has_property(config, "CONFIRMAR"))
+        parametros.confirmar = config_get_int_value(config, "CONFIRMAR") != 0;
+    if (config_has_property(config, "VENTANA"))
+        parametros.ventana = config_get_int_value(config, "VENTANA");
+    if (config_has_property(config, "CONTROL_FLUJO"))
+        parametros.control_flujo = config_get_int_value(config, "CONTROL_FLUJO") != 0;
+
+    // Formato de los frames, como en el cliente
+    if (config_has_property(config, "PROTOCOLO"))
+    {
+        int flags = 0;
+        if (config_has_property(config, "LONGITUDES_VARINT") && config_get_int_value(config, "LONGITUDES_VARINT") != 0)
+            flags |= FLAG_LONGITUDES_VARINT;
+        establecer_protocolo(config_get_int_value(config, "PROTOCOLO"), flags);
+    }
+    if (config_has_property(config, "UMBRAL_COMPRESION"))
+        establecer_compresion(config_get_int_value(config, "UMBRAL_COMPRESION"));
+
+    if (parametros.conexiones < 1)
+        parametros.conexiones = 1;
+    if (parametros.duracion_s < 1)
+        parametros.duracion_s = 1;
+    if (parametros.calentamiento_s < 0)
+        parametros.calentamiento_s = 0;
+    if (parametros.tamanio < 1)
+        parametros.tamanio = 1;
+    if (parametros.elementos < 1)
+        parametros.elementos = 1;
+    if (parametros.tasa < 0)
+        parametros.tasa = 0;
+    if (parametros.ventana < 1)
+        parametros.ventana = 1;
+
+    return parametros;
+}
+
+/**
+ * @brief Registra la latencia de ida y vuelta de una solicitud confirmada
+ *
+ * Le suma la demora entre el instante programado y el envío, que se
+ * guardó al enviar en el lugar de la ventana de la solicitud.
+ *
+ * @param solicitud ID de la solicitud
+ * @param estado Estado con que la confirmó el servidor
+ * @param latencia_ns Nanosegundos desde el envío hasta el ACK
+ * @param contexto t_hilo_carga de la conexión
+ */
+static void registrar_confirmacion(uint32_t solicitud, uint8_t estado, uint64_t latencia_ns, void *contexto)
+{
+    t_hilo_carga *estado_hilo = contexto;
+    int64_t demora = estado_hilo->demoras[solicitud % estado_hilo->config->ventana];
+
+    if (estado != CONFIRMACION_PROCESADA)
+        estado_hilo->rechazadas++;
+    if (demora < 0)
+        return;
+
+    registrar_en_histograma(estado_hilo->latencias, latencia_ns + (uint64_t)demora);
+    estado_hilo->frames++;
+}
+
+/**
+ * @brief Cuerpo de cada hilo: envía frames por su conexión y mide
+ *
+ * Cada PAQUETE se vuelve a armar en cada envío (reiniciar_paquete() y
+ * agregar_a_paquete()) y cada MENSAJE pasa por enviar_mensaje(), así se
+ * mide el camino completo del cliente y no solo el send(). Con
+ * CONFIRMAR se envían como solicitudes y la latencia se registra al
+ * llegar cada ACK; al final se esperan las que quedaron en vuelo. Con
+ * CONTROL_FLUJO antes del primer envío se pide crédito al servidor.
+ *
+ * @param argumento Puntero a su t_hilo_carga
+ * @return void* Siempre NULL
+ */
+void *generar_carga(void *argumento)
+{
+    t_hilo_carga *estado = argumento;
+    t_config_carga *config = estado->config;
+
+    int conexion = crear_conexion(config->ip, config->puerto);
+    if (conexion == -1)
+    {
+        estado->error = true;
+        return NULL;
+    }
+
+    char *valor = malloc(config->tamanio);
+    memset(valor, 'x', config->tamanio - 1);
+    valor[config->tamanio - 1] = '\0';
+    t_paquete *paquete = crear_paquete();
+    t_solicitudes *solicitudes = NULL;
+    if (config->confirmar)
+        estado->demoras = calloc(config->ventana, sizeof(int64_t));
+    if (config->confirmar || config->control_flujo)
+        solicitudes = crear_solicitudes(conexion, config->ventana, registrar_confirmacion, estado);
+    if ((config->confirmar || config->control_flujo) && solicitudes == NULL)
+        estado->error = true;
+    else if (config->control_flujo && !habilitar_control_flujo(solicitudes))
+        estado->error = true;
+
+    struct timespec medicion = sumar_nanosegundos(estado->inicio, (uint64_t)config->calentamiento_s * 1000000000);
+    struct timespec fin = sumar_nanosegundos(medicion, (uint64_t)config->duracion_s * 1000000000);
+    uint64_t periodo = config->tasa > 0 ? (uint64_t)(1e9 / config->tasa) : 0;
+
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &estado->inicio, NULL);
+
+    struct timespec antes, despues;
+    for (uint64_t enviados = 0; !estado->error; enviados++)
+    {
+        if (periodo > 0)
+        {
+            // El instante programado es la referencia de la latencia
+            antes = sumar_nanosegundos(estado->inicio, enviados * periodo);
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &antes, NULL);
+        }
+        else
+            clock_gettime(CLOCK_MONOTONIC, &antes);
+
+        if (vencido(antes, fin))
+            break;
+
+        int bytes;
+        uint32_t solicitud;
+        if (config->tipo == PAQUETE)
+        {
+            reiniciar_paquete(paquete);
+            for (int i = 0; i < config->elementos; i++)
+                agregar_a_paquete(paquete, valor, config->tamanio);
+        }
+
+        if (config->confirmar)
+            bytes = config->tipo == MENSAJE ? solicitar_mensaje(solicitudes, valor, &solicitud)
+                                            : solicitar_paquete(solicitudes, paquete, &solicitud);
+        else if (solicitudes != NULL && !esperar_credito(solicitudes))
+            bytes = -1;
+        else
+        {
+            bytes = config->tipo == MENSAJE ? enviar_mensaje(valor, conexion) : enviar_paquete(paquete, conexion);
+            if (solicitudes != NULL)
+                descontar_credito(solicitudes, bytes);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &despues);
+
+        if (bytes == -1)
+        {
+            estado->error = true;
+            break;
+        }
+
+        bool medir = vencido(antes, medicion);
+        if (medir)
+            estado->bytes += bytes;
+
+        if (config->confirmar)
+        {
+            // La latencia se registra con el ACK; con TASA se cuenta desde el instante programado
+            int lugar = solicitud % config->ventana;
+            int64_t demora = 0;
+            if (periodo > 0)
+                demora = (int64_t)solicitudes->solicitudes[lugar].envio_ns -
+                         ((int64_t)antes.tv_sec * 1000000000 + antes.tv_nsec);
+            estado->demoras[lugar] = !medir ? -1 : demora > 0 ? demora : 0;
+        }
+        else if (medir)
+        {
+            registrar_en_histograma(estado->latencias, nanosegundos_entre(antes, despues));
+            estado->frames++;
+        }
+    }
+
+    if (solicitudes != NULL)
+    {
+        if (!estado->error && !esperar_solicitudes(solicitudes))
+            estado->error = true;
+        eliminar_solicitudes(solicitudes);
+        free(estado->demoras);
+    }
+    eliminar_paquete(paquete);
+    free(valor);
+    liberar_conexion(conexion);
+    return NULL;
+}
@@ -0,0 +1,100 @@
+#ifndef CARGA_H_
+#define CARGA_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <commons/log.h>
+#include <commons/config.h>
+
+#include "../../src/utils.h"
+#include "../../src/solicitudes.h"
+#include "histograma.h"
+
+/**
+ * @file carga.h
+ * @brief Generador de carga contra el servidor con histograma de latencias
+ *
+ * Abre CONEXIONES conexiones y por cada una envía frames MENSAJE o
+ * PAQUETE del tamaño y la cantidad de elementos configurados, armados
+ * con las funciones del cliente (enviar_mensaje(), agregar_a_paquete(),
+ * enviar_paquete()). Informa mensajes/s, MB/s y los percentiles de
+ * latencia de envío.
+ *
+ * La latencia es lo que tarda en volver el envío: incluye armar el frame
+ * y las esperas por el buffer del socket lleno cuando el servidor no da
+ * abasto. Con TASA > 0 cada envío tiene su instante programado y la
+ * latencia se mide desde ese instante, así una demora no oculta las
+ * esperas de los envíos que vienen atrás (omisión coordinada).
+ *
+ * Con CONFIRMAR=1 (requiere PROTOCOLO=2) cada frame es una solicitud y
+ * la latencia es la de ida y vuelta: desde el envío (o el instante
+ * programado) hasta que llega su ACK. Cada conexión tiene hasta VENTANA
+ * solicitudes en vuelo, así que la tasa sin límite la fija el servidor.
+ *
+ * Con CONTROL_FLUJO=1 (requiere PROTOCOLO=2) cada conexión pide crédito
+ * al servidor y no envía más de lo que tiene: la espera por crédito
+ * queda en la latencia, como la del buffer del socket lleno.
+ */
+
+// ========== CONFIGURACIÓN ==========
+
+/**
+ * @brief Archivo de configuración por defecto (se puede pasar otro como argumento)
+ */
+#define ARCHIVO_CONFIG_CARGA "carga.config"
+
+/**
+ * @brief Parámetros de la carga leídos desde el archivo de configuración
+ */
+typedef struct
+{
+    char *ip;            // IP: servidor destino
+    char *puerto;        // PUERTO: puerto del servidor
+    int conexiones;      // CONEXIONES: conexiones en paralelo (un hilo por conexión)
+    int duracion_s;      // DURACION_S: segundos de medición
+    int calentamiento_s; // CALENTAMIENTO_S: segundos previos que no se miden
+    op_code tipo;        // TIPO: MENSAJE o PAQUETE
+    int tamanio;         // TAMANIO: bytes de cada valor (con el '\0')
+    int elementos;       // ELEMENTOS: valores por PAQUETE
+    double tasa;         // TASA: frames/s por conexión (0 = sin límite)
+    bool confirmar;      // CONFIRMAR: medir hasta el ACK del servidor
+    int ventana;         // VENTANA: solicitudes en vuelo por conexión (con CONFIRMAR)
+    bool control_flujo;  // CONTROL_FLUJO: respetar el crédito que otorga el servidor
+} t_config_carga;
+
+/**
+ * @brief Estado de cada hilo de carga
+ */
+typedef struct
+{
+    t_config_carga *config;      // Parámetros compartidos
+    struct timespec inicio;      // Instante común de arranque (CLOCK_MONOTONIC)
+    t_histograma *latencias;     // Latencias medidas (ns)
+    unsigned long frames;        // Frames medidos (confirmados con CONFIRMAR)
+    unsigned long long bytes;    // Bytes medidos (cabeceras incluidas)
+    unsigned long rechazadas;    // Solicitudes que el servidor rechazó
+    int64_t *demoras;            // Por lugar de la ventana: ns del instante programado al envío (-1 = no se mide)
+    bool error;                  // true si falló la conexión o un envío
+    bool lanzado;                // true si el hilo se creó (hay que esperarlo)
+    pthread_t hilo;              // Hilo que envía por esta conexión
+} t_hilo_carga;
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Carga la configuración del generador
+ * @param config Configuración abierta
+ * @return t_config_carga Parámetros (con valores por defecto para lo que falte)
+ */
+t_config_carga cargar_config_carga(t_config *config);
+
+/**
+ * @brief Cuerpo de cada hilo: envía frames por su conexión y mide
+ * @param argumento Puntero a su t_hilo_carga
+ * @return void* Siempre NULL
+ */
+void *generar_carga(void *argumento);
+
+#endif /* CARGA_H_ */
@@ -0,0 +1,124 @@
+#include "histograma.h"
+
+/**
+ * @brief Cubeta donde se cuenta un valor
+ *
+ * @param valor Valor a ubicar
+ * @return int Índice de la cubeta
+ */
+static int indice_cubeta(uint64_t valor)
+{
+    if (valor < (1u << BITS_SUBCUBETA))
+        return (int)valor;
+
+    // Desplazamiento que deja al valor con BITS_SUBCUBETA bits significativos
+    int desplazamiento = 63 - __builtin_clzll(valor) - (BITS_SUBCUBETA - 1);
+    return desplazamiento * MEDIA_SUBCUBETA + (int)(valor >> desplazamiento);
+}
+
+/**
+ * @brief Mayor valor que se cuenta en una cubeta
+ *
+ * @param indice Índice de la cubeta
+ * @return uint64_t Límite superior (inclusive) de la cubeta
+ */
+static uint64_t limite_cubeta(int indice)
+{
+    if (indice < (1 << BITS_SUBCUBETA))
+        return (uint64_t)indice;
+
+    int desplazamiento = indice / MEDIA_SUBCUBETA - 1;
+    uint64_t mantisa = (uint64_t)(indice - desplazamiento * MEDIA_SUBCUBETA);
+    return ((mantisa + 1) << desplazamiento) - 1;
+}
+
+/**
+ * @brief Crea un histograma vacío
+ *
+ * @return t_histograma* Histograma (liberar con free())
+ */
+t_histograma *crear_histograma(void)
+{
+    t_histograma *histograma = calloc(1, sizeof(t_histograma));
+    histograma->minimo = UINT64_MAX;
+    return histograma;
+}
+
+/**
+ * @brief Registra un valor
+ *
+ * @param histograma Histograma donde contar
+ * @param valor Valor a registrar
+ */
+void registrar_en_histograma(t_histograma *histograma, uint64_t valor)
+{
+    histograma->cubetas[indice_cubeta(valor)]++;
+    histograma->total++;
+    histograma->suma += valor;
+    if (valor < histograma->minimo)
+        histograma->minimo = valor;
+    if (valor > histograma->maximo)
+        histograma->maximo = valor;
+}
+
+/**
+ * @brief Suma los conteos de otro histograma
+ *
+ * @param destino Histograma acumulado
+ * @param origen Histograma a sumar
+ */
+void sumar_histograma(t_histograma *destino, const t_histograma *origen)
+{
+    for (int i = 0; i < CANTIDAD_CUBETAS; i++)
+        destino->cubetas[i] += origen->cubetas[i];
+    destino->total += origen->total;
+    destino->suma += origen->suma;
+    if (origen->minimo < destino->minimo)
+        destino->minimo = origen->minimo;
+    if (origen->maximo > destino->maximo)
+        destino->maximo = origen->maximo;
+}
+
+/**
+ * @brief Valor por debajo del cual queda el porcentaje pedido de los valores
+ *
+ * Recorre las cubetas acumulando hasta cubrir el percentil. Devuelve el
+ * límite superior de esa cubeta, acotado por el máximo registrado.
+ *
+ * @param histograma Histograma con valores
+ * @param percentil Percentil entre 0 y 100 (por ejemplo 99.9)
+ * @return uint64_t Valor del percentil (0 si está vacío)
+ */
+uint64_t percentil_histograma(const t_histograma *histograma, double percentil)
+{
+    if (histograma->total == 0)
+        return 0;
+
+    uint64_t objetivo = (uint64_t)(percentil / 100.0 * histograma->total + 0.5);
+    if (objetivo < 1)
+        objetivo = 1;
+
+    uint64_t acumulado = 0;
+    for (int i = 0; i < CANTIDAD_CUBETAS; i++)
+    {
+        acumulado += histograma->cubetas[i];
+        if (acumulado >= objetivo)
+        {
+            uint64_t limite = limite_cubeta(i);
+            return limite < histograma->maximo ? limite : histograma->maximo;
+        }
+    }
+
+    return histograma->maximo;
+}
+
+/**
+ * @brief Promedio de los valores registrados
+ *
+ * @param histograma Histograma con valores
+ * @return double Promedio (0 si está vacío)
+ */
+double promedio_histograma(const t_histograma *histograma)
+{
+    return histograma->total > 0 ? (double)(histograma->suma / histograma->total) : 0;
+}
@@ -0,0 +1,89 @@
+#ifndef HISTOGRAMA_H_
+#define HISTOGRAMA_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @file histograma.h
+ * @brief Histograma de latencias con precisión relativa fija (estilo HDR)
+ *
+ * Los valores (en nanosegundos) se cuentan en cubetas log-lineales: los
+ * menores a 2^BITS_SUBCUBETA se cuentan exactos y, a partir de ahí, cada
+ * potencia de 2 se divide en 2^(BITS_SUBCUBETA-1) cubetas iguales. Así el
+ * error relativo de cualquier percentil es menor a 1 / 2^(BITS_SUBCUBETA-1)
+ * sin importar la escala, con memoria fija y registro O(1) sin locks
+ * (cada hilo usa su histograma y al final se suman).
+ */
+
+// ========== CONSTANTES ==========
+
+/**
+ * @brief Bits de precisión de cada cubeta (7 = error menor al 1,6%)
+ */
+#define BITS_SUBCUBETA 7
+
+/**
+ * @brief Cubetas por potencia de 2
+ */
+#define MEDIA_SUBCUBETA (1 << (BITS_SUBCUBETA - 1))
+
+/**
+ * @brief Cantidad total de cubetas para cubrir valores de 64 bits
+ */
+#define CANTIDAD_CUBETAS ((64 - BITS_SUBCUBETA + 3) * MEDIA_SUBCUBETA)
+
+// ========== ESTRUCTURAS ==========
+
+/**
+ * @brief Histograma de valores de 64 bits
+ */
+typedef struct
+{
+    uint64_t cubetas[CANTIDAD_CUBETAS]; // Cantidad de valores por cubeta
+    uint64_t total;                     // Valores registrados
+    uint64_t minimo;                    // Menor valor registrado
+    uint64_t maximo;                    // Mayor valor registrado
+    long double suma;                   // Suma de los valores (para el promedio)
+} t_histograma;
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Crea un histograma vacío
+ * @return t_histograma* Histograma (liberar con free())
+ */
+t_histograma *crear_histograma(void);
+
+/**
+ * @brief Registra un valor
+ * @param histograma Histograma donde contar
+ * @param valor Valor a registrar
+ */
+void registrar_en_histograma(t_histograma *histograma, uint64_t valor);
+
+/**
+ * @brief Suma los conteos de otro histograma
+ * @param destino Histograma acumulado
+ * @param origen Histograma a sumar
+ */
+void sumar_histograma(t_histograma *destino, const t_histograma *origen);
+
+/**
+ * @brief Valor por debajo del cual queda el porcentaje pedido de los valores
+ * @param histograma Histograma con valores
+ * @param percentil Percentil entre 0 y 100 (por ejemplo 99.9)
+ * @return uint64_t Límite superior de la cubeta del percentil (0 si está vacío)
+ */
+uint64_t percentil_histograma(const t_histograma *histograma, double percentil);
+
+/**
+ * @brief Promedio de los valores registrados
+ * @param histograma Histograma con valores
+ * @return double Promedio (0 si está vacío)
+ */
+double promedio_histograma(const t_histograma *histograma);
+
+#endif /* HISTOGRAMA_H_ */
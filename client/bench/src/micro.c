@@ -0,0 +1,197 @@
+#include <malloc.h>
+#include <string.h>
+
+#include "micro.h"
+#include "../../src/utils.h"
+
+// ========== CONTADORES DE MEMORIA ==========
+
+/*
+ * malloc(), calloc(), realloc(), free(), memcpy() y memmove() se
+ * reemplazan en este binario para contar. Delegan en las implementaciones
+ * de glibc, así que el costo agregado es incrementar tres contadores del
+ * hilo. El Makefile compila el código medido con -fno-builtin-memcpy y
+ * -fno-builtin-memmove para que las copias de tamaño fijo no se
+ * resuelvan en línea y pasen por acá.
+ */
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t cantidad, size_t size);
+extern void *__libc_realloc(void *puntero, size_t size);
+extern void __libc_free(void *puntero);
+extern void *__memcpy_chk(void *destino, const void *origen, size_t size, size_t capacidad);
+extern void *__memmove_chk(void *destino, const void *origen, size_t size, size_t capacidad);
+
+// Punteros volátiles para que el compilador no convierta las llamadas en memcpy()
+static void *(*volatile copiar)(void *, const void *, size_t, size_t) = __memcpy_chk;
+static void *(*volatile mover)(void *, const void *, size_t, size_t) = __memmove_chk;
+
+static __thread t_contadores_memoria contadores;
+
+void *malloc(size_t size)
+{
+    contadores.reservas++;
+    contadores.bytes_reservados += size;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t cantidad, size_t size)
+{
+    contadores.reservas++;
+    contadores.bytes_reservados += cantidad * size;
+    return __libc_calloc(cantidad, size);
+}
+
+void *realloc(void *puntero, size_t size)
+{
+    size_t anterior = puntero != NULL ? malloc_usable_size(puntero) : 0;
+    void *nuevo = __libc_realloc(puntero, size);
+
+    contadores.reservas++;
+    contadores.bytes_reservados += size;
+    // Si el bloque cambió de lugar, realloc() copió lo que tenía
+    if (puntero != NULL && nuevo != puntero)
+        contadores.bytes_copiados += anterior < size ? anterior : size;
+    return nuevo;
+}
+
+void free(void *puntero)
+{
+    __libc_free(puntero);
+}
+
+void *memcpy(void *destino, const void *origen, size_t size)
+{
+    contadores.bytes_copiados += size;
+    return copiar(destino, origen, size, (size_t)-1);
+}
+
+void *memmove(void *destino, const void *origen, size_t size)
+{
+    contadores.bytes_copiados += size;
+    return mover(destino, origen, size, (size_t)-1);
+}
+
+/**
+ * @brief Contadores de memoria acumulados por el hilo actual
+ *
+ * @return t_contadores_memoria Valores al momento de la llamada
+ */
+t_contadores_memoria contadores_memoria(void)
+{
+    return contadores;
+}
+
+// ========== MEDICIÓN ==========
+
+static int tiempo_medicion_ms = TIEMPO_MEDICION_MS;
+
+/**
+ * @brief Nanosegundos del reloj monotónico
+ *
+ * @return uint64_t Instante actual en nanosegundos
+ */
+static uint64_t ahora_ns(void)
+{
+    struct timespec instante;
+    clock_gettime(CLOCK_MONOTONIC, &instante);
+    return (uint64_t)instante.tv_sec * 1000000000 + instante.tv_nsec;
+}
+
+/**
+ * @brief Repite una operación durante el tiempo de medición e informa sus costos
+ *
+ * Después de una llamada de calentamiento, repite la operación en lotes
+ * que se duplican hasta cubrir tiempo_medicion_ms y divide el tiempo y
+ * los contadores de memoria por la cantidad de repeticiones.
+ *
+ * @param logger Logger donde informar
+ * @param nombre Nombre del caso
+ * @param elementos Elementos por frame del caso
+ * @param tamanio Bytes de cada elemento
+ * @param operacion Operación a medir
+ * @param estado Estado que recibe la operación
+ */
+void medir_micro(t_log *logger, const char *nombre, int elementos, int tamanio,
+                 t_operacion_micro operacion, void *estado)
+{
+    operacion(estado);
+
+    uint64_t limite = (uint64_t)tiempo_medicion_ms * 1000000;
+    uint64_t repeticiones = 0;
+    uint64_t lote = 1;
+    t_contadores_memoria antes = contadores_memoria();
+    uint64_t inicio = ahora_ns();
+    uint64_t transcurrido;
+
+    do
+    {
+        for (uint64_t i = 0; i < lote; i++)
+            operacion(estado);
+        repeticiones += lote;
+        if (lote < 65536)
+            lote *= 2;
+        transcurrido = ahora_ns() - inicio;
+    } while (transcurrido < limite);
+
+    t_contadores_memoria despues = contadores_memoria();
+    double n = (double)repeticiones;
+    log_info(logger, "%-26s %4d x %-6d %12.1f ns/op %8.2f reservas/op %12.0f B reservados/op %12.0f B copiados/op",
+             nombre, elementos, tamanio, transcurrido / n,
+             (despues.reservas - antes.reservas) / n,
+             (despues.bytes_reservados - antes.bytes_reservados) / n,
+             (despues.bytes_copiados - antes.bytes_copiados) / n);
+}
+
+// ========== PROGRAMA PRINCIPAL ==========
+
+static const int elementos_micro[] = {1, 16, 256};
+static const int tamanios_micro[] = {16, 256, 4096};
+
+/**
+ * @brief Función principal de los microbenchmarks
+ *
+ * Lee micro.config (o el archivo pasado como argumento): PROTOCOLO y
+ * LONGITUDES_VARINT eligen el formato de los frames como en el cliente
+ * y TIEMPO_MS cuánto se repite cada caso. Luego mide los casos de
+ * cliente y servidor para cada combinación de elementos y tamaño.
+ *
+ * @param argc Cantidad de argumentos
+ * @param argv argv[1] opcional: archivo de configuración
+ * @return int EXIT_SUCCESS
+ */
+int main(int argc, char **argv)
+{
+    t_log *logger = log_create("micro.log", "Micro", 1, LOG_LEVEL_INFO);
+
+    char *archivo = argc > 1 ? argv[1] : ARCHIVO_CONFIG_MICRO;
+    t_config *config = config_create(archivo);
+    if (config != NULL)
+    {
+        if (config_has_property(config, "PROTOCOLO"))
+        {
+            int flags = 0;
+            if (config_has_property(config, "LONGITUDES_VARINT") && config_get_int_value(config, "LONGITUDES_VARINT") != 0)
+                flags |= FLAG_LONGITUDES_VARINT;
+            establecer_protocolo(config_get_int_value(config, "PROTOCOLO"), flags);
+        }
+        if (config_has_property(config, "TIEMPO_MS") && config_get_int_value(config, "TIEMPO_MS") > 0)
+            tiempo_medicion_ms = config_get_int_value(config, "TIEMPO_MS");
+        config_destroy(config);
+    }
+    else
+        log_warning(logger, "No se encontro %s, se usan los valores por defecto", archivo);
+
+    t_formato formato = protocolo_actual();
+    log_info(logger, "Protocolo v%d (flags 0x%02x), %d ms por caso", formato.version, formato.flags, tiempo_medicion_ms);
+
+    for (size_t i = 0; i < sizeof(elementos_micro) / sizeof(int); i++)
+        for (size_t j = 0; j < sizeof(tamanios_micro) / sizeof(int); j++)
+        {
+            medir_cliente(logger, elementos_micro[i], tamanios_micro[j]);
+            medir_servidor(logger, elementos_micro[i], tamanios_micro[j]);
+        }
+
+    log_destroy(logger);
+    return EXIT_SUCCESS;
+}
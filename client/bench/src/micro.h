@@ -0,0 +1,107 @@
+#ifndef MICRO_H_
+#define MICRO_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+#include <commons/log.h>
+#include <commons/config.h>
+
+/**
+ * @file micro.h
+ * @brief Microbenchmarks de las primitivas de serialización y parseo
+ *
+ * Mide por separado las funciones calientes del cliente (agregar_a_paquete,
+ * serializar_paquete, enviar_mensaje, enviar_paquete) y la recepción del
+ * servidor (recibir_paquete, recibir_paquete_vista, el decodificador y
+ * la copia al buzón del pool de manejadores) sobre un socketpair, para
+ * distintas cantidades y tamaños de elementos.
+ *
+ * Por cada caso informa ns/op, reservas/op (malloc, calloc y realloc),
+ * bytes reservados/op y bytes copiados/op (memcpy, memmove y lo que mueve
+ * realloc al cambiar de lugar). Los contadores son del hilo que mide: los
+ * hilos auxiliares que alimentan o vacían el socketpair no se cuentan.
+ * Las copias que hace el kernel en send()/recv() tampoco.
+ *
+ * Los casos de cliente y servidor están en archivos separados porque sus
+ * utils.h definen los mismos tipos.
+ */
+
+// ========== CONSTANTES ==========
+
+/**
+ * @brief Archivo de configuración por defecto (se puede pasar otro como argumento)
+ */
+#define ARCHIVO_CONFIG_MICRO "micro.config"
+
+/**
+ * @brief Milisegundos que se repite cada caso si la configuración no dice otra cosa
+ */
+#define TIEMPO_MEDICION_MS 200
+
+// ========== ESTRUCTURAS ==========
+
+/**
+ * @brief Contadores de memoria del hilo actual
+ */
+typedef struct
+{
+    uint64_t reservas;         // Llamadas a malloc(), calloc() y realloc()
+    uint64_t bytes_reservados; // Bytes pedidos en esas llamadas
+    uint64_t bytes_copiados;   // Bytes copiados con memcpy(), memmove() y realloc()
+} t_contadores_memoria;
+
+/**
+ * @brief Operación a medir: se la llama muchas veces con el mismo estado
+ */
+typedef void (*t_operacion_micro)(void *estado);
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Contadores de memoria acumulados por el hilo actual
+ * @return t_contadores_memoria Valores al momento de la llamada
+ */
+t_contadores_memoria contadores_memoria(void);
+
+/**
+ * @brief Repite una operación durante el tiempo de medición e informa sus costos
+ * @param logger Logger donde informar
+ * @param nombre Nombre del caso
+ * @param elementos Elementos por frame del caso
+ * @param tamanio Bytes de cada elemento
+ * @param operacion Operación a medir
+ * @param estado Estado que recibe la operación
+ */
+void medir_micro(t_log *logger, const char *nombre, int elementos, int tamanio,
+                 t_operacion_micro operacion, void *estado);
+
+/**
+ * @brief Arma un frame PAQUETE serializado con el protocolo del cliente
+ * @param elementos Cantidad de elementos
+ * @param tamanio Bytes de cada elemento
+ * @param size Se completa con el tamaño del frame (cabecera incluida)
+ * @return void* Frame (liberar con free())
+ */
+void *armar_frame_micro(int elementos, int tamanio, int *size);
+
+/**
+ * @brief Mide las primitivas del cliente para una combinación de elementos y tamaño
+ * @param logger Logger donde informar
+ * @param elementos Elementos por paquete
+ * @param tamanio Bytes de cada elemento
+ */
+void medir_cliente(t_log *logger, int elementos, int tamanio);
+
+/**
+ * @brief Mide la recepción del servidor para una combinación de elementos y tamaño
+ * @param logger Logger donde informar
+ * @param elementos Elementos por paquete
+ * @param tamanio Bytes de cada elemento
+ */
+void medir_servidor(t_log *logger, int elementos, int tamanio);
+
+#endif /* MICRO_H_ */
@@ -0,0 +1,181 @@
+#include <sys/socket.h>
+
+#include "micro.h"
+#include "../../src/utils.h"
+
+/**
+ * @brief Estado compartido por los casos del cliente
+ */
+typedef struct
+{
+    t_paquete *paquete; // Paquete lleno (o reutilizable según el caso)
+    char *valor;        // Elemento de tamanio bytes terminado en '\0'
+    int elementos;      // Elementos por paquete
+    int tamanio;        // Bytes de cada elemento
+    int bytes;          // Tamaño del frame serializado
+    int socket;         // Extremo del socketpair donde se envía
+} t_estado_cliente;
+
+// ========== SOCKETPAIR ==========
+
+/**
+ * @brief Descarta todo lo que llega al otro extremo del socketpair
+ *
+ * Termina cuando se cierra el extremo que envía.
+ *
+ * @param argumento Socket del que leer (intptr_t)
+ * @return void* Siempre NULL
+ */
+static void *vaciar_socket(void *argumento)
+{
+    int socket = (int)(intptr_t)argumento;
+    char descarte[64 * 1024];
+
+    while (recv(socket, descarte, sizeof(descarte), 0) > 0)
+        ;
+
+    close(socket);
+    return NULL;
+}
+
+// ========== CASOS ==========
+
+/**
+ * @brief Tamaño del frame serializado de un paquete (cabecera incluida)
+ */
+static int tamanio_frame(t_paquete *paquete)
+{
+    uint8_t cabecera[TAMANIO_CABECERA_V2];
+    return escribir_cabecera(cabecera, paquete->formato, paquete->codigo_operacion, paquete->buffer->size) +
+           paquete->buffer->size;
+}
+
+/**
+ * @brief Agrega los elementos del caso a un paquete
+ */
+static void llenar_paquete(t_estado_cliente *estado, t_paquete *paquete)
+{
+    for (int i = 0; i < estado->elementos; i++)
+        agregar_a_paquete(paquete, estado->valor, estado->tamanio);
+}
+
+/**
+ * @brief crear_paquete() + agregar_a_paquete() + eliminar_paquete()
+ */
+static void agregar_paquete_nuevo(void *argumento)
+{
+    t_estado_cliente *estado = argumento;
+    t_paquete *paquete = crear_paquete();
+    llenar_paquete(estado, paquete);
+    eliminar_paquete(paquete);
+}
+
+/**
+ * @brief reiniciar_paquete() + agregar_a_paquete() sobre el mismo paquete
+ */
+static void agregar_paquete_reutilizado(void *argumento)
+{
+    t_estado_cliente *estado = argumento;
+    reiniciar_paquete(estado->paquete);
+    llenar_paquete(estado, estado->paquete);
+}
+
+/**
+ * @brief serializar_paquete() del paquete lleno + free()
+ */
+static void serializar(void *argumento)
+{
+    t_estado_cliente *estado = argumento;
+    free(serializar_paquete(estado->paquete, estado->bytes));
+}
+
+/**
+ * @brief enviar_paquete() del paquete lleno
+ */
+static void enviar_paquete_lleno(void *argumento)
+{
+    t_estado_cliente *estado = argumento;
+    enviar_paquete(estado->paquete, estado->socket);
+}
+
+/**
+ * @brief enviar_mensaje() de un string de tamanio bytes
+ */
+static void enviar_valor(void *argumento)
+{
+    t_estado_cliente *estado = argumento;
+    enviar_mensaje(estado->valor, estado->socket);
+}
+
+/**
+ * @brief Arma un frame PAQUETE serializado con el protocolo del cliente
+ *
+ * @param elementos Cantidad de elementos
+ * @param tamanio Bytes de cada elemento
+ * @param size Se completa con el tamaño del frame (cabecera incluida)
+ * @return void* Frame (liberar con free())
+ */
+void *armar_frame_micro(int elementos, int tamanio, int *size)
+{
+    char *valor = malloc(tamanio);
+    memset(valor, 'x', tamanio);
+
+    t_paquete *paquete = crear_paquete();
+    for (int i = 0; i < elementos; i++)
+        agregar_a_paquete(paquete, valor, tamanio);
+
+    *size = tamanio_frame(paquete);
+    void *frame = serializar_paquete(paquete, *size);
+
+    eliminar_paquete(paquete);
+    free(valor);
+    return frame;
+}
+
+/**
+ * @brief Mide las primitivas del cliente para una combinación de elementos y tamaño
+ *
+ * agregar_a_paquete se mide armando un paquete nuevo (incluye su
+ * crecimiento) y reutilizando uno con reiniciar_paquete(). Los envíos van
+ * a un socketpair que otro hilo vacía. enviar_mensaje solo se mide con un
+ * elemento, ya que envía un único string.
+ *
+ * @param logger Logger donde informar
+ * @param elementos Elementos por paquete
+ * @param tamanio Bytes de cada elemento
+ */
+void medir_cliente(t_log *logger, int elementos, int tamanio)
+{
+    t_estado_cliente estado = {.elementos = elementos, .tamanio = tamanio};
+    estado.valor = malloc(tamanio);
+    memset(estado.valor, 'x', tamanio - 1);
+    estado.valor[tamanio - 1] = '\0';
+
+    estado.paquete = crear_paquete();
+    llenar_paquete(&estado, estado.paquete);
+    estado.bytes = tamanio_frame(estado.paquete);
+
+    medir_micro(logger, "agregar_a_paquete nuevo", elementos, tamanio, agregar_paquete_nuevo, &estado);
+    medir_micro(logger, "agregar_a_paquete reusado", elementos, tamanio, agregar_paquete_reutilizado, &estado);
+    medir_micro(logger, "serializar_paquete", elementos, tamanio, serializar, &estado);
+
+    int extremos[2];
+    pthread_t hilo;
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, extremos) == 0)
+    {
+        pthread_create(&hilo, NULL, vaciar_socket, (void *)(intptr_t)extremos[1]);
+        estado.socket = extremos[0];
+
+        medir_micro(logger, "enviar_paquete", elementos, tamanio, enviar_paquete_lleno, &estado);
+        if (elementos == 1)
+            medir_micro(logger, "enviar_mensaje", elementos, tamanio, enviar_valor, &estado);
+
+        close(extremos[0]);
+        pthread_join(hilo, NULL);
+    }
+    else
+        log_error(logger, "No se pudo crear el socketpair");
+
+    eliminar_paquete(estado.paquete);
+    free(estado.valor);
+}
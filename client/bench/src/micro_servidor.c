@@ -0,0 +1,220 @@
+#include <sys/socket.h>
+
+#include "micro.h"
+#include "../../../server/src/utils.h"
+#include "../../../server/src/decodificador.h"
+#include "../../../server/src/planificador.h"
+
+/**
+ * @brief Estado compartido por los casos del servidor
+ */
+typedef struct
+{
+    void *frames;                   // Frame repetido para enviarlo en bloque
+    int size;                       // Bytes de frames
+    int socket;                     // Extremo del socketpair donde se recibe
+    t_decodificador *decodificador; // Decodificador del caso (NULL en los demás)
+    t_vista_paquete *vista;         // Vista reutilizada por el decodificador
+    t_planificador *planificador;   // Pool del caso del buzón (NULL en los demás)
+    t_buzon *buzon;                 // Buzón donde se encolan los frames
+} t_estado_servidor;
+
+/**
+ * @brief Extremo que envía y bloque de frames que un hilo repite
+ */
+typedef struct
+{
+    int socket;
+    t_estado_servidor *estado;
+} t_alimentador;
+
+// ========== SOCKETPAIR ==========
+
+/**
+ * @brief Envía el bloque de frames una y otra vez por el socketpair
+ *
+ * Termina cuando se cierra el extremo que recibe (send() falla con EPIPE).
+ *
+ * @param argumento Puntero a su t_alimentador
+ * @return void* Siempre NULL
+ */
+static void *alimentar_socket(void *argumento)
+{
+    t_alimentador *alimentador = argumento;
+    char *frames = alimentador->estado->frames;
+    int size = alimentador->estado->size;
+
+    for (;;)
+    {
+        for (int enviados = 0; enviados < size;)
+        {
+            ssize_t escritos = send(alimentador->socket, frames + enviados, size - enviados, MSG_NOSIGNAL);
+            if (escritos <= 0)
+            {
+                close(alimentador->socket);
+                return NULL;
+            }
+            enviados += escritos;
+        }
+    }
+}
+
+/**
+ * @brief Mide un caso de recepción sobre un socketpair nuevo
+ *
+ * Cada caso usa su propio socketpair para empezar alineado al primer
+ * frame (el decodificador lee de más y deja bytes en su buffer).
+ *
+ * @param logger Logger donde informar
+ * @param nombre Nombre del caso
+ * @param elementos Elementos por frame
+ * @param tamanio Bytes de cada elemento
+ * @param operacion Operación que recibe y parsea un frame
+ * @param estado Estado del caso
+ */
+static void medir_recepcion(t_log *logger, const char *nombre, int elementos, int tamanio,
+                            t_operacion_micro operacion, t_estado_servidor *estado)
+{
+    int extremos[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, extremos) != 0)
+    {
+        log_error(logger, "No se pudo crear el socketpair");
+        return;
+    }
+
+    t_alimentador alimentador = {.socket = extremos[1], .estado = estado};
+    pthread_t hilo;
+    pthread_create(&hilo, NULL, alimentar_socket, &alimentador);
+    estado->socket = extremos[0];
+
+    medir_micro(logger, nombre, elementos, tamanio, operacion, estado);
+
+    close(extremos[0]);
+    pthread_join(hilo, NULL);
+}
+
+// ========== CASOS ==========
+
+/**
+ * @brief recibir_operacion() + recibir_paquete(): una copia por elemento
+ */
+static void recibir_lista(void *argumento)
+{
+    t_estado_servidor *estado = argumento;
+    recibir_operacion(estado->socket);
+    list_destroy_and_destroy_elements(recibir_paquete(estado->socket), free);
+}
+
+/**
+ * @brief recibir_operacion() + recibir_paquete_vista(): elementos sin copiar
+ */
+static void recibir_vista(void *argumento)
+{
+    t_estado_servidor *estado = argumento;
+    recibir_operacion(estado->socket);
+    eliminar_vista_paquete(recibir_paquete_vista(estado->socket));
+}
+
+/**
+ * @brief Camino del reactor: decodificador + vista reutilizada
+ */
+static void recibir_decodificado(void *argumento)
+{
+    t_estado_servidor *estado = argumento;
+    t_frame frame;
+    decodificador_recibir_frame(estado->decodificador, estado->socket, &frame);
+    parsear_vista_paquete_formato(estado->vista, frame.payload, frame.size, frame.formato);
+}
+
+/**
+ * @brief Manejador del pool que no hace nada: se mide solo la copia al buzón
+ */
+static void ignorar_frame(int socket_cliente, t_frame *frame)
+{
+    (void)socket_cliente;
+    (void)frame;
+}
+
+/**
+ * @brief Camino del reactor con pool: decodificador + copia al buzón
+ *
+ * Como el reactor con un cliente que respeta su crédito, deja de encolar
+ * mientras el buzón tenga un turno de frames (FRAMES_POR_TURNO) sin
+ * procesar.
+ */
+static void encolar_decodificado(void *argumento)
+{
+    t_estado_servidor *estado = argumento;
+    t_frame frame;
+    decodificador_recibir_frame(estado->decodificador, estado->socket, &frame);
+    while (atomic_load(&estado->buzon->bytes_pendientes) >= (long)FRAMES_POR_TURNO * frame.bytes)
+        sched_yield();
+    planificador_encolar(estado->planificador, estado->buzon, &frame);
+}
+
+/**
+ * @brief Mide el encolado en el pool de manejadores
+ *
+ * El código del servidor loguea en su logger global, que en este binario
+ * no crea ningún main(): se usa el de los microbenchmarks.
+ *
+ * @param registro Logger donde informar
+ * @param elementos Elementos por paquete
+ * @param tamanio Bytes de cada elemento
+ * @param estado Estado con el decodificador del caso
+ */
+static void medir_encolado(t_log *registro, int elementos, int tamanio, t_estado_servidor *estado)
+{
+    logger = registro;
+    estado->planificador = planificador_crear(1, ignorar_frame);
+    if (estado->planificador == NULL)
+        return;
+    estado->buzon = buzon_crear(0);
+
+    medir_recepcion(registro, "decodificador + buzon", elementos, tamanio, encolar_decodificado, estado);
+
+    buzon_cerrar(estado->buzon);
+    planificador_destruir(estado->planificador);
+    logger = NULL;
+}
+
+/**
+ * @brief Mide la recepción del servidor para una combinación de elementos y tamaño
+ *
+ * Otro hilo envía por un socketpair frames PAQUETE armados con el
+ * protocolo del cliente y se mide cuánto cuesta recibir y recorrer cada
+ * uno con cada API del servidor.
+ *
+ * @param logger Logger donde informar
+ * @param elementos Elementos por paquete
+ * @param tamanio Bytes de cada elemento
+ */
+void medir_servidor(t_log *logger, int elementos, int tamanio)
+{
+    t_estado_servidor estado = {0};
+    int size_frame;
+    void *frame = armar_frame_micro(elementos, tamanio, &size_frame);
+
+    // Repetir el frame hasta unos 64 KiB para que cada send() mueva varios
+    int repeticiones = 64 * 1024 / size_frame + 1;
+    estado.size = size_frame * repeticiones;
+    estado.frames = malloc(estado.size);
+    for (int i = 0; i < repeticiones; i++)
+        memcpy((char *)estado.frames + i * size_frame, frame, size_frame);
+    free(frame);
+
+    medir_recepcion(logger, "recibir_paquete", elementos, tamanio, recibir_lista, &estado);
+    medir_recepcion(logger, "recibir_paquete_vista", elementos, tamanio, recibir_vista, &estado);
+
+    estado.decodificador = decodificador_crear(0);
+    estado.vista = crear_vista_paquete();
+    medir_recepcion(logger, "decodificador + vista", elementos, tamanio, recibir_decodificado, &estado);
+    eliminar_vista_paquete(estado.vista);
+    decodificador_destruir(estado.decodificador);
+
+    estado.decodificador = decodificador_crear(0);
+    medir_encolado(logger, elementos, tamanio, &estado);
+    decodificador_destruir(estado.decodificador);
+
+    free(estado.frames);
+}
@@ -0,0 +1,243 @@
+#include "lector_journal.h"
+
+/**
+ * @brief Lee un entero de 32 bits en little-endian
+ *
+ * @param origen Lugar con 4 bytes
+ * @return uint32_t Valor leído
+ */
+static uint32_t leer_u32le(const uint8_t *origen)
+{
+    return (uint32_t)origen[0] | (uint32_t)origen[1] << 8 | (uint32_t)origen[2] << 16 | (uint32_t)origen[3] << 24;
+}
+
+/**
+ * @brief Lee un entero de 64 bits en little-endian
+ *
+ * @param origen Lugar con 8 bytes
+ * @return uint64_t Valor leído
+ */
+static uint64_t leer_u64le(const uint8_t *origen)
+{
+    return (uint64_t)leer_u32le(origen) | (uint64_t)leer_u32le(origen + 4) << 32;
+}
+
+/**
+ * @brief Calcula (o continúa) el CRC-32 de un bloque de bytes
+ *
+ * CRC-32 estándar (polinomio reflejado 0xEDB88320), bit a bit: el
+ * lector no está en un camino crítico como el servidor.
+ *
+ * @param crc CRC acumulado (0 para empezar)
+ * @param datos Bytes a procesar
+ * @param tamanio Cantidad de bytes
+ * @return uint32_t CRC-32 acumulado
+ */
+uint32_t crc32_registro_journal(uint32_t crc, const void *datos, size_t tamanio)
+{
+    const uint8_t *bytes = datos;
+    crc = ~crc;
+    for (size_t i = 0; i < tamanio; i++)
+    {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320u : 0);
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Número de segmento de un nombre de archivo
+ *
+ * @param nombre Nombre del archivo
+ * @param numero Se completa con el número
+ * @return bool true si el nombre es <número>.journal
+ */
+static bool numero_de_segmento(const char *nombre, unsigned long *numero)
+{
+    char *fin;
+    *numero = strtoul(nombre, &fin, 10);
+    return fin != nombre && strcmp(fin, EXTENSION_JOURNAL) == 0;
+}
+
+/**
+ * @brief Filtro de scandir(): solo archivos de segmento
+ */
+static int es_segmento(const struct dirent *entrada)
+{
+    unsigned long numero;
+    return numero_de_segmento(entrada->d_name, &numero);
+}
+
+/**
+ * @brief Orden de scandir(): por número de segmento
+ */
+static int comparar_segmentos(const struct dirent **a, const struct dirent **b)
+{
+    unsigned long numero_a, numero_b;
+    numero_de_segmento((*a)->d_name, &numero_a);
+    numero_de_segmento((*b)->d_name, &numero_b);
+    return (numero_a > numero_b) - (numero_a < numero_b);
+}
+
+/**
+ * @brief Desmapea el segmento actual (si hay)
+ *
+ * @param lector Lector abierto
+ */
+static void soltar_segmento(t_lector_journal *lector)
+{
+    if (lector->mapa != NULL)
+        munmap(lector->mapa, lector->tamanio);
+    lector->mapa = NULL;
+    lector->tamanio = 0;
+    lector->posicion = 0;
+}
+
+/**
+ * @brief Mapea el próximo segmento válido
+ *
+ * Los archivos que no empiezan con la cabecera esperada se saltean.
+ *
+ * @param lector Lector abierto
+ * @return bool true si quedó un segmento mapeado
+ */
+static bool mapear_siguiente_segmento(t_lector_journal *lector)
+{
+    soltar_segmento(lector);
+
+    while (lector->actual < lector->cantidad)
+    {
+        char ruta[PATH_MAX + 256];
+        snprintf(ruta, sizeof(ruta), "%s/%s", lector->directorio, lector->segmentos[lector->actual++]->d_name);
+
+        int fd = open(ruta, O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+            continue;
+
+        struct stat datos;
+        uint8_t *mapa = MAP_FAILED;
+        if (fstat(fd, &datos) == 0 && datos.st_size >= TAMANIO_CABECERA_SEGMENTO)
+            mapa = mmap(NULL, datos.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapa == MAP_FAILED)
+            continue;
+
+        if (memcmp(mapa, MAGICO_JOURNAL, 4) != 0 || leer_u32le(mapa + 4) != VERSION_JOURNAL)
+        {
+            munmap(mapa, datos.st_size);
+            continue;
+        }
+
+        // Se lee en orden: el kernel puede adelantar la lectura
+        madvise(mapa, datos.st_size, MADV_SEQUENTIAL);
+
+        lector->mapa = mapa;
+        lector->tamanio = datos.st_size;
+        lector->posicion = TAMANIO_CABECERA_SEGMENTO;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Abre un journal para leerlo desde el primer segmento
+ *
+ * @param directorio Directorio de los segmentos
+ * @return t_lector_journal* Lector o NULL si el directorio no existe
+ */
+t_lector_journal *abrir_lector_journal(const char *directorio)
+{
+    t_lector_journal *lector = calloc(1, sizeof(t_lector_journal));
+    snprintf(lector->directorio, sizeof(lector->directorio), "%s", directorio);
+
+    lector->cantidad = scandir(directorio, &lector->segmentos, es_segmento, comparar_segmentos);
+    if (lector->cantidad < 0)
+    {
+        free(lector);
+        return NULL;
+    }
+
+    return lector;
+}
+
+/**
+ * @brief Devuelve el próximo registro del journal
+ *
+ * Un segmento termina en su EOF, en una longitud 0 (la parte preasignada
+ * de un segmento que no se cerró) o en un registro que no entra o cuyo
+ * crc no coincide.
+ *
+ * @param lector Lector abierto
+ * @param registro Se completa con el registro leído (el payload apunta al
+ *                 segmento y es válido hasta la próxima llamada que cambie de segmento)
+ * @return bool true si había un registro, false al terminar
+ */
+bool siguiente_registro_journal(t_lector_journal *lector, t_registro_journal *registro)
+{
+    while (1)
+    {
+        if (lector->mapa == NULL && !mapear_siguiente_segmento(lector))
+            return false;
+
+        size_t posicion = lector->posicion;
+        if (posicion + TAMANIO_CABECERA_REGISTRO > lector->tamanio)
+        {
+            soltar_segmento(lector);
+            continue;
+        }
+
+        uint8_t *cabecera = lector->mapa + posicion;
+        size_t size = leer_u32le(cabecera);
+        if (size == 0 && leer_u32le(cabecera + 4) == 0)
+        {
+            soltar_segmento(lector);
+            continue;
+        }
+
+        if (posicion + TAMANIO_CABECERA_REGISTRO + size > lector->tamanio ||
+            crc32_registro_journal(0, cabecera + 8, TAMANIO_CABECERA_REGISTRO - 8 + size) != leer_u32le(cabecera + 4))
+        {
+            lector->corruptos++;
+            soltar_segmento(lector);
+            continue;
+        }
+
+        registro->instante = leer_u64le(cabecera + 8);
+        registro->cod_op = leer_u32le(cabecera + 16);
+        registro->formato = (t_formato){.version = cabecera[20], .flags = cabecera[21]};
+        registro->conexion = cabecera[22] | cabecera[23] << 8;
+        registro->payload = cabecera + TAMANIO_CABECERA_REGISTRO;
+        registro->size = size;
+
+        lector->posicion += (TAMANIO_CABECERA_REGISTRO + size + ALINEACION_REGISTRO - 1) & ~(size_t)(ALINEACION_REGISTRO - 1);
+        return true;
+    }
+}
+
+/**
+ * @brief Vuelve al primer registro del primer segmento
+ *
+ * @param lector Lector abierto
+ */
+void rebobinar_lector_journal(t_lector_journal *lector)
+{
+    soltar_segmento(lector);
+    lector->actual = 0;
+    lector->corruptos = 0;
+}
+
+/**
+ * @brief Libera el lector y desmapea su segmento
+ *
+ * @param lector Lector a cerrar
+ */
+void cerrar_lector_journal(t_lector_journal *lector)
+{
+    soltar_segmento(lector);
+    for (int i = 0; i < lector->cantidad; i++)
+        free(lector->segmentos[i]);
+    free(lector->segmentos);
+    free(lector);
+}
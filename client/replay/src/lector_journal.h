@@ -0,0 +1,129 @@
+#ifndef LECTOR_JOURNAL_H_
+#define LECTOR_JOURNAL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../../src/utils.h"
+
+/**
+ * @file lector_journal.h
+ * @brief Lectura de los segmentos del journal binario del servidor
+ *
+ * Recorre en orden los segmentos <número>.journal de un directorio (el
+ * formato está documentado en server/src/journal.h) y devuelve cada
+ * registro apuntando al segmento mapeado, sin copiar el payload. Un
+ * registro con crc inválido se toma como el final de su segmento (lo
+ * que queda de una caída a mitad de escritura) y se sigue con el
+ * siguiente.
+ */
+
+// ========== CONSTANTES ==========
+
+/**
+ * @brief Primeros bytes de cada segmento
+ */
+#define MAGICO_JOURNAL "TPJ1"
+
+/**
+ * @brief Versión del formato de los segmentos que se sabe leer
+ */
+#define VERSION_JOURNAL 1
+
+/**
+ * @brief Extensión de los archivos de segmento
+ */
+#define EXTENSION_JOURNAL ".journal"
+
+/**
+ * @brief Bytes de la cabecera de un segmento
+ */
+#define TAMANIO_CABECERA_SEGMENTO 16
+
+/**
+ * @brief Bytes de la cabecera de un registro
+ */
+#define TAMANIO_CABECERA_REGISTRO 24
+
+/**
+ * @brief Alineación de cada registro dentro del segmento
+ */
+#define ALINEACION_REGISTRO 8
+
+// ========== ESTRUCTURAS ==========
+
+/**
+ * @brief Frame grabado en el journal
+ */
+typedef struct
+{
+    uint64_t instante;  // Instante de llegada al servidor (ns, CLOCK_REALTIME)
+    op_code cod_op;     // Código de operación
+    t_formato formato;  // Versión y flags con que llegó
+    uint16_t conexion;  // Conexión por la que llegó (para agrupar fragmentos)
+    void *payload;      // Datos (apuntan al segmento mapeado)
+    int size;           // Tamaño del payload
+} t_registro_journal;
+
+/**
+ * @brief Recorrido de los segmentos de un journal
+ */
+typedef struct
+{
+    char directorio[PATH_MAX]; // Directorio de los segmentos
+    struct dirent **segmentos; // Segmentos ordenados por número
+    int cantidad;              // Cantidad de segmentos
+    int actual;                // Índice del próximo segmento a abrir
+    uint8_t *mapa;             // Segmento mapeado (NULL si no hay)
+    size_t tamanio;            // Bytes del segmento mapeado
+    size_t posicion;           // Próximo registro dentro del segmento
+    int corruptos;             // Segmentos cortados por un registro inválido
+} t_lector_journal;
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Abre un journal para leerlo desde el primer segmento
+ * @param directorio Directorio de los segmentos
+ * @return t_lector_journal* Lector o NULL si el directorio no existe
+ */
+t_lector_journal *abrir_lector_journal(const char *directorio);
+
+/**
+ * @brief Devuelve el próximo registro del journal
+ * @param lector Lector abierto
+ * @param registro Se completa con el registro leído
+ * @return bool true si había un registro, false al terminar
+ */
+bool siguiente_registro_journal(t_lector_journal *lector, t_registro_journal *registro);
+
+/**
+ * @brief Vuelve al primer registro del primer segmento
+ * @param lector Lector abierto
+ */
+void rebobinar_lector_journal(t_lector_journal *lector);
+
+/**
+ * @brief Libera el lector y desmapea su segmento
+ * @param lector Lector a cerrar
+ */
+void cerrar_lector_journal(t_lector_journal *lector);
+
+/**
+ * @brief Calcula (o continúa) el CRC-32 de un bloque de bytes
+ * @param crc CRC acumulado (0 para empezar)
+ * @param datos Bytes a procesar
+ * @param tamanio Cantidad de bytes
+ * @return uint32_t CRC-32 acumulado (el mismo que usa el servidor)
+ */
+uint32_t crc32_registro_journal(uint32_t crc, const void *datos, size_t tamanio);
+
+#endif /* LECTOR_JOURNAL_H_ */
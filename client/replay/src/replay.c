@@ -0,0 +1,310 @@
+#include "replay.h"
+
+/**
+ * @brief Suma nanosegundos a un instante
+ *
+ * @param instante Instante base
+ * @param nanosegundos Nanosegundos a sumar
+ * @return struct timespec Instante resultante
+ */
+static struct timespec sumar_nanosegundos(struct timespec instante, uint64_t nanosegundos)
+{
+    instante.tv_sec += nanosegundos / 1000000000;
+    instante.tv_nsec += nanosegundos % 1000000000;
+    if (instante.tv_nsec >= 1000000000)
+    {
+        instante.tv_sec++;
+        instante.tv_nsec -= 1000000000;
+    }
+    return instante;
+}
+
+/**
+ * @brief Segundos transcurridos entre dos instantes
+ *
+ * @param desde Instante inicial
+ * @param hasta Instante final
+ * @return double Segundos
+ */
+static double segundos_entre(struct timespec desde, struct timespec hasta)
+{
+    return (hasta.tv_sec - desde.tv_sec) + (hasta.tv_nsec - desde.tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Función principal del replay
+ *
+ * 1. Lee la configuración (replay.config o el archivo pasado como argumento)
+ * 2. Lanza un hilo por conexión; todos recorren el journal completo y
+ *    cada uno envía solo los frames que le tocan
+ * 3. Espera a que terminen e informa frames/s y MB/s logrados
+ *
+ * @param argc Cantidad de argumentos
+ * @param argv argv[1] opcional: archivo de configuración
+ * @return int EXIT_SUCCESS si todas las conexiones terminaron sin error
+ */
+int main(int argc, char **argv)
+{
+    t_log *logger = log_create("replay.log", "Replay", 1, LOG_LEVEL_INFO);
+
+    char *archivo = argc > 1 ? argv[1] : ARCHIVO_CONFIG_REPLAY;
+    t_config *config = config_create(archivo);
+    if (config == NULL)
+    {
+        log_error(logger, "No se encontro el archivo de configuracion %s", archivo);
+        log_destroy(logger);
+        return EXIT_FAILURE;
+    }
+
+    t_config_replay parametros = cargar_config_replay(config);
+
+    // El journal tiene que existir antes de abrir las conexiones
+    t_lector_journal *prueba = abrir_lector_journal(parametros.directorio);
+    if (prueba == NULL || prueba->cantidad == 0)
+    {
+        log_error(logger, "No hay segmentos de journal en %s", parametros.directorio);
+        if (prueba != NULL)
+            cerrar_lector_journal(prueba);
+        config_destroy(config);
+        log_destroy(logger);
+        return EXIT_FAILURE;
+    }
+    cerrar_lector_journal(prueba);
+
+    t_hilo_replay *hilos = calloc(parametros.conexiones, sizeof(t_hilo_replay));
+    if (hilos == NULL)
+    {
+        log_error(logger, "No hay memoria para %d conexiones", parametros.conexiones);
+        config_destroy(config);
+        log_destroy(logger);
+        return EXIT_FAILURE;
+    }
+
+    struct timespec inicio, fin;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+
+    for (int i = 0; i < parametros.conexiones; i++)
+    {
+        hilos[i].indice = i;
+        hilos[i].config = &parametros;
+        hilos[i].inicio = inicio;
+        hilos[i].lanzado = pthread_create(&hilos[i].hilo, NULL, reproducir_conexion, &hilos[i]) == 0;
+        if (!hilos[i].lanzado)
+        {
+            log_error(logger, "No se pudo lanzar el hilo de la conexion %d", i);
+            hilos[i].error = true;
+        }
+    }
+
+    unsigned long frames = 0;
+    unsigned long long bytes = 0;
+    int fallidas = 0;
+    int corruptos = 0;
+    for (int i = 0; i < parametros.conexiones; i++)
+    {
+        if (hilos[i].lanzado)
+            pthread_join(hilos[i].hilo, NULL);
+        frames += hilos[i].frames;
+        bytes += hilos[i].bytes;
+        fallidas += hilos[i].error;
+
+        // Todos leen el mismo journal: un hilo que cortó antes vio menos segmentos
+        if (hilos[i].corruptos > corruptos)
+            corruptos = hilos[i].corruptos;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &fin);
+
+    double segundos = segundos_entre(inicio, fin);
+    log_info(logger, "Frames enviados: %lu en %.3f s por %d conexiones", frames, segundos, parametros.conexiones);
+    log_info(logger, "Throughput: %.0f frames/s, %.2f MB/s", frames / segundos, bytes / segundos / (1024 * 1024));
+    if (corruptos > 0)
+        log_warning(logger, "Se cortaron %d segmentos en un registro invalido", corruptos);
+    if (fallidas > 0)
+        log_error(logger, "%d conexiones terminaron con error", fallidas);
+
+    free(hilos);
+    config_destroy(config);
+    log_destroy(logger);
+    return fallidas == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Carga la configuración del replay
+ *
+ * Valores por defecto: VELOCIDAD=1, CONEXIONES=1, REPETICIONES=1. Los
+ * textos apuntan a la configuración, que debe seguir abierta.
+ * PROTOCOLO no aplica: cada frame se reenvía con el formato con que se
+ * grabó. UMBRAL_COMPRESION (opcional) comprime los frames v2 grandes.
+ *
+ * @param config Configuración abierta
+ * @return t_config_replay Parámetros
+ */
+t_config_replay cargar_config_replay(t_config *config)
+{
+    t_config_replay parametros = {
+        .ip = config_get_string_value(config, "IP"),
+        .puerto = config_get_string_value(config, "PUERTO"),
+        .directorio = config_get_string_value(config, "JOURNAL_DIRECTORIO"),
+        .velocidad = 1,
+        .conexiones = 1,
+        .repeticiones = 1};
+
+    if (config_has_property(config, "VELOCIDAD"))
+        parametros.velocidad = config_get_double_value(config, "VELOCIDAD");
+    if (config_has_property(config, "CONEXIONES"))
+        parametros.conexiones = config_get_int_value(config, "CONEXIONES");
+    if (config_has_property(config, "REPETICIONES"))
+        parametros.repeticiones = config_get_int_value(config, "REPETICIONES");
+    if (config_has_property(config, "UMBRAL_COMPRESION"))
+        establecer_compresion(config_get_int_value(config, "UMBRAL_COMPRESION"));
+
+    if (parametros.conexiones < 1)
+        parametros.conexiones = 1;
+    if (parametros.repeticiones < 1)
+        parametros.repeticiones = 1;
+    if (parametros.velocidad < 0)
+        parametros.velocidad = 0;
+
+    return parametros;
+}
+
+/**
+ * @brief Reenvía un frame grabado por una conexión
+ *
+ * Arma un t_paquete que apunta al payload grabado (sin copiarlo) con el
+ * código y el formato originales y lo envía con enviar_paquete(): los
+ * bytes en el socket son los mismos que mandó el cliente original.
+ * El replay no lee sus sockets, así que nunca pide ACK: sin
+ * FLAG_SOLICITUD el servidor no encola respuestas que nadie va a leer.
+ *
+ * @param socket Socket conectado al servidor
+ * @param registro Frame grabado
+ * @return int Bytes enviados o -1 si hay error
+ */
+int reenviar_registro(int socket, t_registro_journal *registro)
+{
+    t_buffer buffer = {
+        .size = registro->size,
+        .capacidad = registro->size,
+        .stream = registro->payload};
+    t_paquete paquete = {
+        .codigo_operacion = registro->cod_op,
+        .buffer = &buffer,
+        .formato = registro->formato};
+    paquete.formato.flags &= ~FLAG_SOLICITUD;
+
+    return enviar_paquete(&paquete, socket);
+}
+
+/**
+ * @brief Socket de la conexión por la que se reenvían los frames de una versión
+ *
+ * El servidor fija el protocolo de cada conexión con su primer frame, así
+ * que los frames v1 y v2 van por conexiones distintas. Se abren recién
+ * cuando aparece el primer frame de esa versión.
+ *
+ * @param estado Estado del hilo
+ * @param sockets Socket por versión (-1 = sin abrir)
+ * @param version Versión del frame
+ * @return int Socket conectado o -1 si hay error
+ */
+static int socket_para_version(t_hilo_replay *estado, int sockets[], uint8_t version)
+{
+    if (version != PROTOCOLO_V1 && version != PROTOCOLO_V2)
+        return -1;
+
+    if (sockets[version] == -1)
+        sockets[version] = crear_conexion(estado->config->ip, estado->config->puerto);
+    return sockets[version];
+}
+
+/**
+ * @brief Cuerpo de cada hilo: reenvía su parte del journal por sus conexiones
+ *
+ * Los frames se reparten por paquete en round-robin. Los fragmentos que
+ * continúan un paquete (FLAG_PAQUETE_CONTINUADO) van por la misma
+ * conexión que el frame anterior de su conexión original, así el
+ * servidor los recibe en orden. Como todos los hilos recorren el journal
+ * completo y calculan el mismo reparto, no comparten estado.
+ *
+ * Con VELOCIDAD > 0 cada frame espera hasta inicio + (instante - primer
+ * instante) / VELOCIDAD.
+ *
+ * @param argumento Puntero a su t_hilo_replay
+ * @return void* Siempre NULL
+ */
+void *reproducir_conexion(void *argumento)
+{
+    t_hilo_replay *estado = argumento;
+    t_config_replay *config = estado->config;
+
+    t_lector_journal *lector = abrir_lector_journal(config->directorio);
+    if (lector == NULL)
+    {
+        estado->error = true;
+        return NULL;
+    }
+
+    // Conexión de replay asignada a cada conexión original
+    uint16_t *asignada = calloc(UINT16_MAX + 1, sizeof(uint16_t));
+    if (asignada == NULL)
+    {
+        cerrar_lector_journal(lector);
+        estado->error = true;
+        return NULL;
+    }
+
+    int sockets[PROTOCOLO_V2 + 1] = {-1, -1, -1};
+    struct timespec inicio = estado->inicio;
+
+    for (int repeticion = 0; repeticion < config->repeticiones && !estado->error; repeticion++)
+    {
+        t_registro_journal registro;
+        uint64_t primer_instante = 0;
+        unsigned long paquetes = 0;
+
+        if (repeticion > 0)
+            clock_gettime(CLOCK_MONOTONIC, &inicio);
+        rebobinar_lector_journal(lector);
+
+        while (siguiente_registro_journal(lector, &registro))
+        {
+            int destino;
+            if (registro.formato.flags & FLAG_PAQUETE_CONTINUADO)
+                destino = asignada[registro.conexion];
+            else
+                destino = paquetes++ % config->conexiones;
+            asignada[registro.conexion] = destino;
+
+            if (primer_instante == 0)
+                primer_instante = registro.instante;
+            if (destino != estado->indice)
+                continue;
+
+            if (config->velocidad > 0 && registro.instante > primer_instante)
+            {
+                struct timespec objetivo = sumar_nanosegundos(inicio, (registro.instante - primer_instante) / config->velocidad);
+                clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &objetivo, NULL);
+            }
+
+            int conexion = socket_para_version(estado, sockets, registro.formato.version);
+            int enviados = conexion == -1 ? -1 : reenviar_registro(conexion, &registro);
+            if (enviados == -1)
+            {
+                estado->error = true;
+                break;
+            }
+            estado->frames++;
+            estado->bytes += enviados;
+        }
+
+        estado->corruptos = lector->corruptos;
+    }
+
+    for (int version = PROTOCOLO_V1; version <= PROTOCOLO_V2; version++)
+        if (sockets[version] != -1)
+            liberar_conexion(sockets[version]);
+    free(asignada);
+    cerrar_lector_journal(lector);
+    return NULL;
+}
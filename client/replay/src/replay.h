@@ -0,0 +1,88 @@
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <commons/log.h>
+#include <commons/config.h>
+
+#include "../../src/utils.h"
+#include "lector_journal.h"
+
+/**
+ * @file replay.h
+ * @brief Reenvío al servidor del tráfico grabado en su journal
+ *
+ * Lee los frames de un journal (ver server/src/journal.h) y los vuelve a
+ * enviar con las funciones del cliente, respetando los tiempos
+ * originales, acelerados N veces o tan rápido como se pueda, repartidos
+ * en varias conexiones en paralelo. Al terminar informa el throughput
+ * logrado.
+ */
+
+// ========== CONFIGURACIÓN ==========
+
+/**
+ * @brief Archivo de configuración por defecto (se puede pasar otro como argumento)
+ */
+#define ARCHIVO_CONFIG_REPLAY "replay.config"
+
+/**
+ * @brief Parámetros del replay leídos desde el archivo de configuración
+ */
+typedef struct
+{
+    char *ip;         // IP: servidor destino
+    char *puerto;     // PUERTO: puerto del servidor
+    char *directorio; // JOURNAL_DIRECTORIO: segmentos a reproducir
+    double velocidad; // VELOCIDAD: 1 = tiempos originales, N = N veces más rápido, 0 = sin esperas
+    int conexiones;   // CONEXIONES: conexiones en paralelo
+    int repeticiones; // REPETICIONES: veces que se reproduce el journal
+} t_config_replay;
+
+/**
+ * @brief Estado de cada hilo de reenvío (uno por conexión)
+ *
+ * Si el journal tiene frames v1 y v2, el hilo usa una conexión por
+ * versión.
+ */
+typedef struct
+{
+    int indice;                  // Número de conexión (0..conexiones-1)
+    t_config_replay *config;     // Parámetros compartidos
+    struct timespec inicio;      // Instante común de arranque (CLOCK_MONOTONIC)
+    unsigned long frames;        // Frames enviados
+    unsigned long long bytes;    // Bytes enviados (cabeceras incluidas)
+    int corruptos;               // Segmentos cortados por registros inválidos
+    bool error;                  // true si falló la conexión o un envío
+    bool lanzado;                // true si el hilo se creó (hay que esperarlo)
+    pthread_t hilo;              // Hilo que envía por esta conexión
+} t_hilo_replay;
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Carga la configuración del replay
+ * @param config Configuración abierta
+ * @return t_config_replay Parámetros (con valores por defecto para lo que falte)
+ */
+t_config_replay cargar_config_replay(t_config *config);
+
+/**
+ * @brief Reenvía un frame grabado por una conexión
+ * @param socket Socket conectado al servidor
+ * @param registro Frame grabado
+ * @return int Bytes enviados o -1 si hay error
+ */
+int reenviar_registro(int socket, t_registro_journal *registro);
+
+/**
+ * @brief Cuerpo de cada hilo: reenvía su parte del journal por sus conexiones
+ * @param argumento Puntero a su t_hilo_replay
+ * @return void* Siempre NULL
+ */
+void *reproducir_conexion(void *argumento);
+
+#endif /* REPLAY_H_ */
@@ -1,5 +1,63 @@
 #include "client.h"
 
+// Payload máximo por frame al enviar paquetes fragmentados (0 = sin fragmentar)
+static int tamanio_fragmento = 0;
+
+// Solicitudes en vuelo y crédito del servidor (NULL = sin CONFIRMAR ni CONTROL_FLUJO)
+static t_solicitudes *solicitudes = NULL;
+
+// true si los envíos se mandan como solicitudes a confirmar
+static bool confirmar = false;
+
+/**
+ * @brief Envía un mensaje o un paquete según CONFIRMAR y CONTROL_FLUJO
+ *
+ * Sin confirmar, con control de flujo espera crédito antes de enviar y
+ * descuenta lo enviado (las solicitudes lo hacen solas).
+ *
+ * @param conexion File descriptor de la conexión con el servidor
+ * @param mensaje Mensaje a enviar (o NULL para enviar el paquete)
+ * @param paquete Paquete a enviar si mensaje es NULL
+ * @return int Bytes enviados o -1 si hay error
+ */
+static int enviar_al_servidor(int conexion, char *mensaje, t_paquete *paquete)
+{
+    if (confirmar)
+        return mensaje != NULL ? solicitar_mensaje(solicitudes, mensaje, NULL) : solicitar_paquete(solicitudes, paquete, NULL);
+
+    if (solicitudes != NULL && !esperar_credito(solicitudes))
+        return -1;
+
+    int enviado = mensaje != NULL ? enviar_mensaje(mensaje, conexion) : enviar_paquete(paquete, conexion);
+    if (solicitudes != NULL && enviado > 0)
+        descontar_credito(solicitudes, enviado);
+    return enviado;
+}
+
+/**
+ * @brief Envía un fragmento de un paquete fragmentado respetando el crédito
+ *
+ * Cada fragmento espera crédito antes de salir y descuenta lo que ocupó,
+ * así un paquete largo no se pasa del crédito aunque nunca termine.
+ *
+ * @param fragmento Frame a enviar
+ * @param conexion File descriptor de la conexión con el servidor
+ * @param contexto Solicitudes con el crédito del servidor
+ * @return int Bytes enviados o -1 si hay error o se perdió la conexión
+ */
+static int enviar_fragmento_con_credito(t_paquete *fragmento, int conexion, void *contexto)
+{
+    t_solicitudes *credito = contexto;
+
+    if (!esperar_credito(credito))
+        return -1;
+
+    int enviado = enviar_paquete(fragmento, conexion);
+    if (enviado > 0)
+        descontar_credito(credito, enviado);
+    return enviado;
+}
+
 /**
  * @brief Función principal del cliente
  *
@@ -11,6 +69,11 @@
  * 5. Permite al usuario enviar múltiples mensajes en un paquete
  * 6. Limpia recursos y termina
  *
+ * Con CONFIRMAR=1 (y PROTOCOLO=2) el mensaje y el paquete se envían como
+ * solicitudes y antes de terminar se espera la confirmación del servidor.
+ * Con CONTROL_FLUJO=1 (y PROTOCOLO=2) no se envía más que el crédito que
+ * otorga el servidor.
+ *
  * @return int Código de salida del programa (0 = éxito)
  */
 int main(void)
@@ -55,6 +118,24 @@ int main(void)
     puerto = config_get_string_value(config, "PUERTO"); // Puerto del servidor
     ip = config_get_string_value(config, "IP");         // IP del servidor
 
+    // Formato de los frames (opcional, v1 por defecto)
+    if (config_has_property(config, "PROTOCOLO"))
+    {
+        int flags = 0;
+        if (config_has_property(config, "LONGITUDES_VARINT") && config_get_int_value(config, "LONGITUDES_VARINT") != 0)
+            flags |= FLAG_LONGITUDES_VARINT;
+        if (!establecer_protocolo(config_get_int_value(config, "PROTOCOLO"), flags))
+            log_warning(logger, "PROTOCOLO invalido, se usa v1");
+    }
+
+    // Comprimir paquetes grandes (solo con PROTOCOLO=2)
+    if (config_has_property(config, "UMBRAL_COMPRESION"))
+        establecer_compresion(config_get_int_value(config, "UMBRAL_COMPRESION"));
+
+    // Enviar los paquetes en fragmentos acotados (solo con PROTOCOLO=2)
+    if (config_has_property(config, "TAMANIO_FRAGMENTO"))
+        tamanio_fragmento = config_get_int_value(config, "TAMANIO_FRAGMENTO");
+
     // Mostrar valores leídos por consola (para verificación)
     printf("El valor es: %s\n", valor);
     printf("El puerto es: %s\n", puerto);
@@ -75,8 +156,28 @@ int main(void)
     // Establecer conexión TCP con el servidor
     conexion = crear_conexion(ip, puerto);
 
+    // Pedir al servidor que confirme cada envío y/o que otorgue crédito (solo con PROTOCOLO=2)
+    confirmar = config_has_property(config, "CONFIRMAR") && config_get_int_value(config, "CONFIRMAR") != 0;
+    bool control_flujo = config_has_property(config, "CONTROL_FLUJO") && config_get_int_value(config, "CONTROL_FLUJO") != 0;
+    if ((confirmar || control_flujo) && protocolo_actual().version != PROTOCOLO_V2)
+    {
+        log_warning(logger, "CONFIRMAR y CONTROL_FLUJO requieren PROTOCOLO=2, se ignoran");
+        confirmar = control_flujo = false;
+    }
+    if (confirmar || control_flujo)
+        solicitudes = crear_solicitudes(conexion, 0, informar_confirmacion, logger);
+    if ((confirmar || control_flujo) && solicitudes == NULL)
+    {
+        log_error(logger, "No hay memoria para las confirmaciones, se envia sin confirmar");
+        confirmar = control_flujo = false;
+    }
+    if (control_flujo && !habilitar_control_flujo(solicitudes))
+        log_error(logger, "No se pudo obtener credito del servidor");
+
     // Enviar mensaje simple con el valor de la clave de configuración
-    enviar_mensaje(valor, conexion);
+    int enviado = enviar_al_servidor(conexion, valor, NULL);
+    if (enviado == -1)
+        log_error(logger, "No se pudo enviar el mensaje");
 
     // Permitir al usuario enviar múltiples mensajes en un paquete
     paquete(conexion, logger);
@@ -88,6 +189,20 @@ int main(void)
     // Proximamente
 }
 
+/**
+ * @brief Loguea la confirmación de una solicitud y su latencia
+ *
+ * @param solicitud ID de la solicitud
+ * @param estado Estado con que la confirmó el servidor
+ * @param latencia_ns Nanosegundos desde el envío hasta el ACK
+ * @param contexto Logger del cliente
+ */
+void informar_confirmacion(uint32_t solicitud, uint8_t estado, uint64_t latencia_ns, void *contexto)
+{
+    log_info(contexto, "Solicitud %u %s en %.1f us", solicitud,
+             estado == CONFIRMACION_PROCESADA ? "confirmada" : "rechazada", latencia_ns / 1000.0);
+}
+
 /**
  * @brief Inicializa el sistema de logging
  *
@@ -156,6 +271,52 @@ void leer_consola(t_log *logger)
     }
 }
 
+/**
+ * @brief Envía cada línea leída apenas se ingresa, en un paquete fragmentado
+ *
+ * No acumula el paquete en memoria: las líneas se copian a un fragmento
+ * de a lo sumo tamanio_fragmento bytes que se envía cuando se llena.
+ * Con CONTROL_FLUJO cada fragmento espera crédito y lo descuenta; si se
+ * pierde la conexión esperándolo, el paquete se abandona.
+ *
+ * @param envio Envío fragmentado ya iniciado
+ * @param logger Logger para registrar eventos
+ */
+static void paquete_fragmentado(t_envio_fragmentado *envio, t_log *logger)
+{
+    char *leido;
+
+    if (solicitudes != NULL)
+        establecer_envio_fragmentado(envio, enviar_fragmento_con_credito, solicitudes);
+
+    while (1)
+    {
+        leido = readline("> ");
+
+        if (!strcmp(leido, ""))
+        {
+            free(leido);
+            break;
+        }
+
+        log_info(logger, leido);
+
+        int resultado = agregar_a_envio_fragmentado(envio, leido, strlen(leido) + 1);
+        free(leido);
+
+        if (resultado == -1)
+        {
+            log_error(logger, "No se pudo enviar un fragmento del paquete, se abandona");
+            break;
+        }
+    }
+
+    if (!finalizar_envio_fragmentado(envio, NULL))
+        log_error(logger, "No se pudo enviar el paquete");
+    else
+        log_info(logger, "Paquete enviado exitosamente");
+}
+
 /**
  * @brief Permite al usuario enviar múltiples mensajes en un paquete
  *
@@ -166,6 +327,9 @@ void leer_consola(t_log *logger)
  * 4. Cuando se ingresa una línea vacía, envía todo el paquete al servidor
  * 5. Libera la memoria del paquete
  *
+ * Con TAMANIO_FRAGMENTO y PROTOCOLO=2 las líneas se envían a medida que
+ * llenan un fragmento (ver paquete_fragmentado()).
+ *
  * @param conexion File descriptor de la conexión con el servidor
  * @param logger Logger para registrar eventos
  */
@@ -174,6 +338,17 @@ void paquete(int conexion, t_log *logger)
     char *leido;
     t_paquete *paquete;
 
+    if (tamanio_fragmento > 0)
+    {
+        t_envio_fragmentado *envio = iniciar_envio_fragmentado(conexion, PAQUETE, tamanio_fragmento);
+        if (envio != NULL)
+        {
+            paquete_fragmentado(envio, logger);
+            return;
+        }
+        log_warning(logger, "No se pudo fragmentar (TAMANIO_FRAGMENTO requiere PROTOCOLO=2), se envia sin fragmentar");
+    }
+
     // Crear un nuevo paquete vacío
     paquete = crear_paquete();
 
@@ -193,14 +368,18 @@ void paquete(int conexion, t_log *logger)
         log_info(logger, leido);
 
         // Agregar el mensaje al paquete (incluyendo el carácter nulo)
-        agregar_a_paquete(paquete, leido, strlen(leido) + 1);
+        if (!agregar_a_paquete(paquete, leido, strlen(leido) + 1))
+            log_error(logger, "No hay memoria para agregar el mensaje al paquete");
 
         free(leido);
     }
 
     // Enviar el paquete completo con todos los mensajes al servidor
-    enviar_paquete(paquete, conexion);
-    log_info(logger, "Paquete enviado exitosamente");
+    int enviado = enviar_al_servidor(conexion, NULL, paquete);
+    if (enviado == -1)
+        log_error(logger, "No se pudo enviar el paquete");
+    else
+        log_info(logger, "Paquete enviado exitosamente");
 
     // Liberar memoria del paquete
     eliminar_paquete(paquete);
@@ -210,6 +389,7 @@ void paquete(int conexion, t_log *logger)
  * @brief Limpia todos los recursos y termina el programa ordenadamente
  *
  * Esta función se encarga de liberar toda la memoria y cerrar conexiones:
+ * - Espera las confirmaciones pendientes (con CONFIRMAR=1)
  * - Destruye el logger
  * - Destruye la configuración
  * - Cierra la conexión de red
@@ -220,6 +400,17 @@ void paquete(int conexion, t_log *logger)
  */
 void terminar_programa(int conexion, t_log *logger, t_config *config)
 {
+    if (confirmar)
+    {
+        if (!esperar_solicitudes(solicitudes))
+            log_error(logger, "Se perdio la conexion esperando confirmaciones");
+        log_info(logger, "El servidor confirmo %lu solicitudes (%lu rechazadas)",
+                 (unsigned long)(solicitudes->procesadas + solicitudes->rechazadas),
+                 (unsigned long)solicitudes->rechazadas);
+    }
+    if (solicitudes != NULL)
+        eliminar_solicitudes(solicitudes);
+
     // Liberar recursos en orden inverso a su creación
     log_destroy(logger);        // Cerrar y liberar logger
     config_destroy(config);     // Liberar configuración
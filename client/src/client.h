@@ -9,6 +9,8 @@
 #include <readline/readline.h>
 
 #include "utils.h"
+#include "fragmentos.h"
+#include "solicitudes.h"
 
 /**
  * @file client.h
@@ -20,6 +22,15 @@
 
 // ========== DECLARACIONES DE FUNCIONES ==========
 
+/**
+ * @brief Loguea cada solicitud confirmada (firma de t_al_confirmar)
+ * @param solicitud ID de la solicitud
+ * @param estado CONFIRMACION_PROCESADA o CONFIRMACION_RECHAZADA
+ * @param latencia_ns Nanosegundos desde el envío hasta el ACK
+ * @param contexto Logger del cliente
+ */
+void informar_confirmacion(uint32_t, uint8_t, uint64_t, void *);
+
 /**
  * @brief Inicializa el sistema de logging del cliente
  * @return t_log* Logger configurado para el cliente
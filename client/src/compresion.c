@@ -0,0 +1,152 @@
+#include "compresion.h"
+
+// Los últimos bytes del bloque van siempre como literales y ningún match
+// empieza en los últimos FIN_SIN_MATCH bytes (igual que LZ4, así el
+// descompresor de referencia también acepta los bloques)
+#define ULTIMOS_LITERALES 5
+#define FIN_SIN_MATCH 12
+
+/**
+ * @brief Hash de los 4 bytes que empiezan en posicion
+ *
+ * @param posicion Bytes a hashear
+ * @return uint32_t Índice en la tabla de hash
+ */
+static inline uint32_t hash_secuencia(const uint8_t *posicion)
+{
+    uint32_t valor;
+    memcpy(&valor, posicion, sizeof(valor));
+    return (valor * 2654435761u) >> (32 - BITS_HASH_COMPRESION);
+}
+
+/**
+ * @brief Escribe la parte de una longitud que no entra en el nibble del token
+ *
+ * @param salida Posición de escritura (avanza)
+ * @param resto Longitud menos 15
+ */
+static inline void escribir_longitud_extra(uint8_t **salida, int resto)
+{
+    while (resto >= 255)
+    {
+        *(*salida)++ = 255;
+        resto -= 255;
+    }
+    *(*salida)++ = resto;
+}
+
+/**
+ * @brief Escribe una secuencia: literales y, si longitud_match > 0, un match
+ *
+ * @param salida Posición de escritura (avanza)
+ * @param fin_salida Fin del buffer de salida
+ * @param literales Literales a copiar
+ * @param cantidad_literales Cantidad de literales
+ * @param offset Distancia hacia atrás del match
+ * @param longitud_match Longitud del match (0 en la última secuencia)
+ * @return bool false si la secuencia no entra en el buffer de salida
+ */
+static bool escribir_secuencia(uint8_t **salida, uint8_t *fin_salida, const uint8_t *literales,
+                               int cantidad_literales, int offset, int longitud_match)
+{
+    // Peor caso: token + bytes extra de ambas longitudes + literales + offset
+    long requerido = 1 + cantidad_literales / 255 + 1 + cantidad_literales + 2 + longitud_match / 255 + 1;
+    if (requerido > fin_salida - *salida)
+        return false;
+
+    uint8_t *token = (*salida)++;
+    *token = (cantidad_literales >= 15 ? 15 : cantidad_literales) << 4;
+    if (cantidad_literales >= 15)
+        escribir_longitud_extra(salida, cantidad_literales - 15);
+
+    memcpy(*salida, literales, cantidad_literales);
+    *salida += cantidad_literales;
+
+    if (longitud_match == 0)
+        return true;
+
+    *(*salida)++ = offset & 0xFF;
+    *(*salida)++ = offset >> 8;
+
+    int resto_match = longitud_match - MINIMO_MATCH;
+    *token |= resto_match >= 15 ? 15 : resto_match;
+    if (resto_match >= 15)
+        escribir_longitud_extra(salida, resto_match - 15);
+
+    return true;
+}
+
+/**
+ * @brief Peor tamaño posible de un bloque comprimido (datos incompresibles)
+ *
+ * @param tamanio Bytes a comprimir
+ * @return int Capacidad que garantiza que comprimir_bloque() no falle
+ */
+int cota_compresion(int tamanio)
+{
+    return tamanio + tamanio / 255 + 16;
+}
+
+/**
+ * @brief Comprime un bloque
+ *
+ * Búsqueda greedy con una tabla de hash de las últimas posiciones vistas
+ * de cada secuencia de 4 bytes. Cuanto más tiempo pasa sin encontrar
+ * matches, más bytes saltea, así los datos incompresibles cuestan poco.
+ *
+ * @param origen Datos a comprimir
+ * @param tamanio Bytes a comprimir
+ * @param destino Buffer de salida
+ * @param capacidad Bytes disponibles en destino
+ * @return int Bytes escritos en destino, 0 si no entran en capacidad
+ */
+int comprimir_bloque(const void *origen, int tamanio, void *destino, int capacidad)
+{
+    const uint8_t *entrada = origen;
+    const uint8_t *fin = entrada + tamanio;
+    uint8_t *salida = destino;
+    uint8_t *fin_salida = salida + capacidad;
+
+    // Posición + 1 de la última aparición de cada hash (0 = vacía)
+    uint32_t tabla[1 << BITS_HASH_COMPRESION] = {0};
+
+    const uint8_t *literales = entrada;
+    const uint8_t *posicion = entrada;
+    const uint8_t *limite_match = tamanio > FIN_SIN_MATCH ? fin - FIN_SIN_MATCH : entrada;
+
+    while (posicion < limite_match)
+    {
+        uint32_t hash = hash_secuencia(posicion);
+        uint32_t anterior = tabla[hash];
+        tabla[hash] = posicion - entrada + 1;
+
+        const uint8_t *candidato = entrada + anterior - 1;
+        if (anterior == 0 || posicion - candidato > DISTANCIA_MAXIMA_MATCH ||
+            memcmp(candidato, posicion, MINIMO_MATCH) != 0)
+        {
+            posicion += 1 + ((posicion - literales) >> 6);
+            continue;
+        }
+
+        // Extender el match sin pisar los últimos literales
+        const uint8_t *fin_match = posicion + MINIMO_MATCH;
+        const uint8_t *origen_match = candidato + MINIMO_MATCH;
+        while (fin_match < fin - ULTIMOS_LITERALES && *fin_match == *origen_match)
+        {
+            fin_match++;
+            origen_match++;
+        }
+
+        if (!escribir_secuencia(&salida, fin_salida, literales, posicion - literales,
+                                posicion - candidato, fin_match - posicion))
+            return 0;
+
+        posicion = fin_match;
+        literales = posicion;
+    }
+
+    if (!escribir_secuencia(&salida, fin_salida, literales, fin - literales, 0, 0))
+        return 0;
+
+    return salida - (uint8_t *)destino;
+}
@@ -0,0 +1,60 @@
+#ifndef COMPRESION_H_
+#define COMPRESION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * @file compresion.h
+ * @brief Compresor de bloques rápido (formato de bloque LZ4)
+ *
+ * El bloque comprimido es una secuencia de:
+ * [token][longitud extra de literales][literales][offset u16le][longitud extra del match]
+ *
+ * El nibble alto del token es la cantidad de literales y el bajo la
+ * longitud del match menos MINIMO_MATCH; 15 indica que la longitud
+ * sigue en bytes extra (255 significa "sumar y seguir leyendo"). La
+ * última secuencia tiene solo literales.
+ *
+ * El servidor lo descomprime con descomprimir_bloque()
+ * (server/src/descompresion.h).
+ */
+
+// ========== CONSTANTES ==========
+
+/**
+ * @brief Longitud mínima de un match
+ */
+#define MINIMO_MATCH 4
+
+/**
+ * @brief Bits de la tabla de hash del compresor (4096 entradas en el stack)
+ */
+#define BITS_HASH_COMPRESION 12
+
+/**
+ * @brief Distancia máxima hacia atrás de un match (el offset es un u16)
+ */
+#define DISTANCIA_MAXIMA_MATCH 65535
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Peor tamaño posible de un bloque comprimido (datos incompresibles)
+ * @param tamanio Bytes a comprimir
+ * @return int Capacidad que garantiza que comprimir_bloque() no falle
+ */
+int cota_compresion(int tamanio);
+
+/**
+ * @brief Comprime un bloque
+ * @param origen Datos a comprimir
+ * @param tamanio Bytes a comprimir
+ * @param destino Buffer de salida
+ * @param capacidad Bytes disponibles en destino
+ * @return int Bytes escritos en destino, 0 si no entran en capacidad
+ */
+int comprimir_bloque(const void *origen, int tamanio, void *destino, int capacidad);
+
+#endif /* COMPRESION_H_ */
@@ -0,0 +1,246 @@
+#include "fragmentos.h"
+
+/**
+ * @brief Envío por defecto de cada fragmento
+ *
+ * @param fragmento Frame a enviar
+ * @param socket Socket del envío
+ * @param contexto No se usa
+ * @return int Bytes enviados o -1 si hay error
+ */
+static int enviar_fragmento_directo(t_paquete *fragmento, int socket, void *contexto)
+{
+    (void)contexto;
+    return enviar_paquete(fragmento, socket);
+}
+
+/**
+ * @brief Envía el fragmento en construcción y lo deja vacío
+ *
+ * Los flags del frame dicen si continúa al anterior, si el paquete sigue
+ * y si el último elemento quedó partido. Cada fragmento se comprime por
+ * separado con las reglas de enviar_paquete().
+ *
+ * @param envio Envío en curso
+ * @param ultimo true si es el último fragmento del paquete
+ * @param elemento_sigue true si el último elemento sigue en el próximo fragmento
+ * @return int 0 si se envió, -1 si hay error
+ */
+static int enviar_fragmento(t_envio_fragmentado *envio, bool ultimo, bool elemento_sigue)
+{
+    t_paquete *fragmento = envio->fragmento;
+
+    fragmento->formato = envio->formato;
+    fragmento->formato.flags |= envio->flags_continuacion;
+    if (!ultimo)
+        fragmento->formato.flags |= FLAG_PAQUETE_SIGUE;
+    if (elemento_sigue)
+        fragmento->formato.flags |= FLAG_ELEMENTO_SIGUE;
+
+    int bytes = envio->enviar(fragmento, envio->socket, envio->contexto_envio);
+    reiniciar_paquete(fragmento);
+
+    if (bytes < 0)
+    {
+        envio->error = true;
+        return -1;
+    }
+
+    envio->enviados += bytes;
+    envio->flags_continuacion = FLAG_PAQUETE_CONTINUADO | (elemento_sigue ? FLAG_ELEMENTO_CONTINUADO : 0);
+    return 0;
+}
+
+/**
+ * @brief Escribe la longitud de la próxima parte del valor actual
+ *
+ * La parte es lo que falta del valor o lo que entra en el fragmento,
+ * lo que sea menor. Se reserva MAXIMO_BYTES_LONGITUD para la longitud
+ * aunque en varint ocupe menos, así la parte nunca se pasa del fragmento.
+ *
+ * @param envio Envío en curso (con lugar para al menos un byte de datos)
+ */
+static void abrir_parte(t_envio_fragmentado *envio)
+{
+    t_buffer *buffer = envio->fragmento->buffer;
+    int libre = envio->tamanio_fragmento - buffer->size - MAXIMO_BYTES_LONGITUD;
+    int parte = envio->restante_elemento < libre ? envio->restante_elemento : libre;
+
+    buffer->size += escribir_longitud_elemento(buffer->stream + buffer->size, envio->formato, parte);
+    envio->restante_parte = parte;
+}
+
+/**
+ * @brief Indica si en el fragmento entra una longitud y al menos un byte
+ *
+ * @param envio Envío en curso
+ * @return true si hay lugar para empezar otra parte
+ */
+static bool hay_lugar_para_parte(t_envio_fragmentado *envio)
+{
+    return envio->tamanio_fragmento - envio->fragmento->buffer->size > MAXIMO_BYTES_LONGITUD;
+}
+
+/**
+ * @brief Empieza a enviar un paquete fragmentado
+ *
+ * El fragmento se reserva una sola vez con su tamaño máximo y se reutiliza
+ * para todos los frames del paquete. Los valores se envían en el formato
+ * del protocolo actual, que tiene que ser v2 porque v1 no lleva flags.
+ *
+ * @param socket Socket conectado al servidor
+ * @param codigo_operacion Código de operación de los frames
+ * @param tamanio_fragmento Payload máximo de cada frame (0 = TAMANIO_FRAGMENTO)
+ * @return t_envio_fragmentado* Envío creado o NULL si el protocolo no es v2 o no hay memoria
+ */
+t_envio_fragmentado *iniciar_envio_fragmentado(int socket, op_code codigo_operacion, int tamanio_fragmento)
+{
+    t_formato formato = protocolo_actual();
+    if (formato.version != PROTOCOLO_V2)
+        return NULL;
+
+    // Tiene que entrar una longitud y al menos un byte de datos
+    if (tamanio_fragmento <= 0)
+        tamanio_fragmento = TAMANIO_FRAGMENTO;
+    if (tamanio_fragmento <= MAXIMO_BYTES_LONGITUD)
+        tamanio_fragmento = MAXIMO_BYTES_LONGITUD + 1;
+
+    t_envio_fragmentado *envio = calloc(1, sizeof(t_envio_fragmentado));
+    if (envio == NULL)
+        return NULL;
+    envio->socket = socket;
+    envio->tamanio_fragmento = tamanio_fragmento;
+    envio->formato = formato;
+    envio->enviar = enviar_fragmento_directo;
+    envio->fragmento = crear_paquete();
+    envio->fragmento->codigo_operacion = codigo_operacion;
+
+    // Las partes se escriben directo en el stream: sin la reserva no hay envío
+    if (!reservar_en_paquete(envio->fragmento, tamanio_fragmento))
+    {
+        eliminar_paquete(envio->fragmento);
+        free(envio);
+        return NULL;
+    }
+
+    return envio;
+}
+
+/**
+ * @brief Reemplaza la función con que se envía cada fragmento
+ *
+ * Se llama antes de agregar valores, así todos los fragmentos pasan por
+ * la misma función.
+ *
+ * @param envio Envío en curso
+ * @param enviar Función de envío (NULL = enviar_paquete())
+ * @param contexto Puntero que recibe enviar en cada llamada
+ */
+void establecer_envio_fragmentado(t_envio_fragmentado *envio, t_enviar_fragmento enviar, void *contexto)
+{
+    envio->enviar = enviar != NULL ? enviar : enviar_fragmento_directo;
+    envio->contexto_envio = contexto;
+}
+
+/**
+ * @brief Empieza un valor nuevo del paquete
+ *
+ * Si en el fragmento no entra ni la longitud del valor, el fragmento se
+ * envía antes de empezarlo.
+ *
+ * @param envio Envío en curso
+ * @param longitud Tamaño total del valor
+ * @return int 0 si se empezó, -1 si el valor anterior está incompleto o falló un envío
+ */
+int comenzar_elemento_fragmentado(t_envio_fragmentado *envio, int longitud)
+{
+    if (envio->error || envio->restante_elemento > 0 || longitud < 0)
+        return -1;
+
+    if (!hay_lugar_para_parte(envio) && enviar_fragmento(envio, false, false) < 0)
+        return -1;
+
+    envio->restante_elemento = longitud;
+    abrir_parte(envio);
+    return 0;
+}
+
+/**
+ * @brief Escribe la siguiente parte del valor actual
+ *
+ * Los bytes se copian al fragmento. Cuando la parte actual se completa
+ * y al valor le falta, el fragmento está lleno: se envía con
+ * FLAG_ELEMENTO_SIGUE y el resto sigue en el próximo.
+ *
+ * @param envio Envío en curso
+ * @param datos Bytes a escribir (se copian)
+ * @param tamanio Cantidad de bytes (no más de lo que falta del valor)
+ * @return int 0 si se escribió, -1 si hay error
+ */
+int escribir_elemento_fragmentado(t_envio_fragmentado *envio, const void *datos, int tamanio)
+{
+    if (envio->error || tamanio < 0 || tamanio > envio->restante_elemento)
+        return -1;
+
+    t_buffer *buffer = envio->fragmento->buffer;
+    const uint8_t *origen = datos;
+
+    while (tamanio > 0)
+    {
+        if (envio->restante_parte == 0)
+        {
+            if (enviar_fragmento(envio, false, true) < 0)
+                return -1;
+            abrir_parte(envio);
+        }
+
+        int bytes = tamanio < envio->restante_parte ? tamanio : envio->restante_parte;
+        memcpy(buffer->stream + buffer->size, origen, bytes);
+        buffer->size += bytes;
+        envio->restante_parte -= bytes;
+        envio->restante_elemento -= bytes;
+        origen += bytes;
+        tamanio -= bytes;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Agrega un valor completo al paquete
+ *
+ * @param envio Envío en curso
+ * @param valor Datos del valor (se copian)
+ * @param tamanio Tamaño del valor
+ * @return int 0 si se agregó, -1 si hay error
+ */
+int agregar_a_envio_fragmentado(t_envio_fragmentado *envio, const void *valor, int tamanio)
+{
+    if (comenzar_elemento_fragmentado(envio, tamanio) < 0)
+        return -1;
+    return escribir_elemento_fragmentado(envio, valor, tamanio);
+}
+
+/**
+ * @brief Envía el último fragmento y libera el envío
+ *
+ * El último fragmento se envía aunque esté vacío: es el que le indica al
+ * servidor que el paquete terminó. El total es de 64 bits: un paquete
+ * fragmentado puede pasar los 2 GiB.
+ *
+ * @param envio Envío a finalizar
+ * @param enviados Se completa con los bytes enviados en total (puede ser NULL)
+ * @return bool true si se envió todo, false si hubo error o quedó un valor incompleto
+ */
+bool finalizar_envio_fragmentado(t_envio_fragmentado *envio, int64_t *enviados)
+{
+    bool completo = !envio->error && envio->restante_elemento == 0 && enviar_fragmento(envio, true, false) == 0;
+
+    if (enviados != NULL)
+        *enviados = envio->enviados;
+
+    eliminar_paquete(envio->fragmento);
+    free(envio);
+
+    return completo;
+}
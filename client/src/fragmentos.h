@@ -0,0 +1,121 @@
+#ifndef FRAGMENTOS_H_
+#define FRAGMENTOS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "utils.h"
+
+/**
+ * @file fragmentos.h
+ * @brief Envío de paquetes arbitrariamente grandes en fragmentos acotados
+ *
+ * Un envío fragmentado arma el paquete de a un frame de como mucho
+ * tamanio_fragmento bytes y lo envía apenas se llena, así ni el cliente
+ * ni el servidor tienen que tener el paquete entero en memoria. Los
+ * valores se pueden escribir de a partes, por lo que un valor puede ser
+ * más grande que la memoria disponible (por ejemplo, leído de un archivo).
+ *
+ * Cada fragmento es un frame PAQUETE válido por sí solo: un valor que no
+ * entra en el fragmento se parte en varios elementos y los flags
+ * FLAG_PAQUETE_* y FLAG_ELEMENTO_* le indican al servidor cómo se unen.
+ * Requiere el protocolo v2 y un tamanio_fragmento que no supere el
+ * TAMANIO_MAXIMO_FRAME del servidor.
+ */
+
+// ========== CONSTANTES ==========
+
+/**
+ * @brief Tamaño por defecto del payload de cada fragmento
+ */
+#define TAMANIO_FRAGMENTO (64 * 1024)
+
+// ========== ESTRUCTURAS ==========
+
+/**
+ * @brief Función que envía cada fragmento ya armado
+ *
+ * Por defecto es enviar_paquete(). Otra puede, por ejemplo, esperar
+ * crédito antes de enviar y descontarlo después.
+ *
+ * @param fragmento Frame a enviar
+ * @param socket Socket del envío
+ * @param contexto Puntero pasado a establecer_envio_fragmentado()
+ * @return int Bytes enviados (cabecera incluida) o -1 si hay error
+ */
+typedef int (*t_enviar_fragmento)(t_paquete *fragmento, int socket, void *contexto);
+
+/**
+ * @brief Paquete que se está enviando en fragmentos
+ */
+typedef struct
+{
+    int socket;                 // Socket conectado al servidor
+    int tamanio_fragmento;      // Payload máximo de cada frame
+    t_formato formato;          // Formato base de los frames
+    t_paquete *fragmento;       // Frame en construcción (se reutiliza)
+    int restante_elemento;      // Bytes del valor actual que faltan escribir
+    int restante_parte;         // Bytes de la parte actual que faltan escribir
+    uint8_t flags_continuacion; // Flags FLAG_*_CONTINUADO del próximo frame
+    int64_t enviados;           // Bytes enviados hasta ahora (cabeceras incluidas)
+    t_enviar_fragmento enviar;  // Función que envía cada fragmento
+    void *contexto_envio;       // Contexto de enviar
+    bool error;                 // true si falló algún envío
+} t_envio_fragmentado;
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Empieza a enviar un paquete fragmentado
+ * @param socket Socket conectado al servidor
+ * @param codigo_operacion Código de operación de los frames
+ * @param tamanio_fragmento Payload máximo de cada frame (0 = TAMANIO_FRAGMENTO)
+ * @return t_envio_fragmentado* Envío creado o NULL si el protocolo no es v2 o no hay memoria
+ */
+t_envio_fragmentado *iniciar_envio_fragmentado(int socket, op_code codigo_operacion, int tamanio_fragmento);
+
+/**
+ * @brief Reemplaza la función con que se envía cada fragmento
+ * @param envio Envío en curso
+ * @param enviar Función de envío (NULL = enviar_paquete())
+ * @param contexto Puntero que recibe enviar en cada llamada
+ */
+void establecer_envio_fragmentado(t_envio_fragmentado *envio, t_enviar_fragmento enviar, void *contexto);
+
+/**
+ * @brief Empieza un valor nuevo del paquete
+ * @param envio Envío en curso
+ * @param longitud Tamaño total del valor
+ * @return int 0 si se empezó, -1 si el valor anterior está incompleto o falló un envío
+ */
+int comenzar_elemento_fragmentado(t_envio_fragmentado *envio, int longitud);
+
+/**
+ * @brief Escribe la siguiente parte del valor actual
+ * @param envio Envío en curso
+ * @param datos Bytes a escribir (se copian)
+ * @param tamanio Cantidad de bytes (no más de lo que falta del valor)
+ * @return int 0 si se escribió, -1 si hay error
+ */
+int escribir_elemento_fragmentado(t_envio_fragmentado *envio, const void *datos, int tamanio);
+
+/**
+ * @brief Agrega un valor completo al paquete
+ * @param envio Envío en curso
+ * @param valor Datos del valor (se copian)
+ * @param tamanio Tamaño del valor
+ * @return int 0 si se agregó, -1 si hay error
+ */
+int agregar_a_envio_fragmentado(t_envio_fragmentado *envio, const void *valor, int tamanio);
+
+/**
+ * @brief Envía el último fragmento y libera el envío
+ * @param envio Envío a finalizar
+ * @param enviados Se completa con los bytes enviados en total (puede ser NULL)
+ * @return bool true si se envió todo, false si hubo error o quedó un valor incompleto
+ */
+bool finalizar_envio_fragmentado(t_envio_fragmentado *envio, int64_t *enviados);
+
+#endif /* FRAGMENTOS_H_ */
@@ -0,0 +1,284 @@
+#include "lote.h"
+
+/**
+ * @brief Crea un t_buffer vacío para acumular frames
+ *
+ * @return t_buffer* Buffer vacío o NULL si no hay memoria
+ */
+static t_buffer *crear_buffer_lote(void)
+{
+    t_buffer *buffer = malloc(sizeof(t_buffer));
+    if (buffer == NULL)
+        return NULL;
+    buffer->size = 0;
+    buffer->capacidad = 0;
+    buffer->stream = NULL;
+    return buffer;
+}
+
+/**
+ * @brief Libera los buffers y el lote (el hilo de vaciado ya terminó o no existe)
+ *
+ * @param lote Lote a liberar
+ */
+static void liberar_lote(t_lote *lote)
+{
+    pthread_cond_destroy(&lote->hay_datos);
+    pthread_mutex_destroy(&lote->mutex);
+    pthread_mutex_destroy(&lote->mutex_envio);
+
+    if (lote->pendiente != NULL)
+        free(lote->pendiente->stream);
+    free(lote->pendiente);
+    if (lote->en_envio != NULL)
+        free(lote->en_envio->stream);
+    free(lote->en_envio);
+    free(lote);
+}
+
+/**
+ * @brief Suma microsegundos a un instante
+ *
+ * @param instante Instante base
+ * @param microsegundos Microsegundos a sumar
+ * @return struct timespec Instante resultante
+ */
+static struct timespec sumar_microsegundos(struct timespec instante, long microsegundos)
+{
+    instante.tv_sec += microsegundos / 1000000;
+    instante.tv_nsec += (microsegundos % 1000000) * 1000;
+    if (instante.tv_nsec >= 1000000000)
+    {
+        instante.tv_sec++;
+        instante.tv_nsec -= 1000000000;
+    }
+    return instante;
+}
+
+/**
+ * @brief Hilo que envía el lote cuando el primer frame pendiente vence su plazo
+ *
+ * Duerme mientras el lote está vacío. Cuando llega un frame espera hasta
+ * primero + plazo_us y, si para entonces nadie lo envió, vacía el lote.
+ *
+ * @param argumento Puntero al t_lote
+ * @return void* Siempre NULL
+ */
+static void *vaciar_por_plazo(void *argumento)
+{
+    t_lote *lote = argumento;
+
+    pthread_mutex_lock(&lote->mutex);
+    while (lote->activo)
+    {
+        if (lote->pendiente->size == 0)
+        {
+            pthread_cond_wait(&lote->hay_datos, &lote->mutex);
+            continue;
+        }
+
+        struct timespec vencimiento = sumar_microsegundos(lote->primero, lote->plazo_us);
+        int resultado = pthread_cond_timedwait(&lote->hay_datos, &lote->mutex, &vencimiento);
+
+        if (resultado == ETIMEDOUT && lote->pendiente->size > 0)
+        {
+            pthread_mutex_unlock(&lote->mutex);
+            vaciar_lote(lote);
+            pthread_mutex_lock(&lote->mutex);
+        }
+    }
+    pthread_mutex_unlock(&lote->mutex);
+
+    return NULL;
+}
+
+/**
+ * @brief Crea un lote sobre un socket conectado
+ *
+ * Lanza un hilo que se encarga de respetar el plazo máximo de espera
+ * aunque el productor deje de agregar frames.
+ *
+ * @param socket Socket conectado al servidor
+ * @param umbral_bytes Bytes a partir de los cuales se envía (0 = UMBRAL_LOTE)
+ * @param plazo_us Espera máxima de un frame en microsegundos (0 = PLAZO_LOTE_US)
+ * @return t_lote* Lote creado o NULL si no hay memoria o no se pudo lanzar el hilo
+ */
+t_lote *crear_lote(int socket, int umbral_bytes, long plazo_us)
+{
+    t_lote *lote = calloc(1, sizeof(t_lote));
+    if (lote == NULL)
+        return NULL;
+
+    lote->socket = socket;
+    lote->umbral_bytes = umbral_bytes > 0 ? umbral_bytes : UMBRAL_LOTE;
+    lote->plazo_us = plazo_us > 0 ? plazo_us : PLAZO_LOTE_US;
+    lote->formato = protocolo_actual();
+    lote->pendiente = crear_buffer_lote();
+    lote->en_envio = crear_buffer_lote();
+    lote->activo = true;
+
+    // Los plazos se miden con el reloj monotónico, inmune a cambios de hora
+    pthread_condattr_t atributos;
+    pthread_condattr_init(&atributos);
+    pthread_condattr_setclock(&atributos, CLOCK_MONOTONIC);
+    pthread_cond_init(&lote->hay_datos, &atributos);
+    pthread_condattr_destroy(&atributos);
+
+    pthread_mutex_init(&lote->mutex, NULL);
+    pthread_mutex_init(&lote->mutex_envio, NULL);
+
+    if (lote->pendiente == NULL || lote->en_envio == NULL ||
+        pthread_create(&lote->hilo, NULL, vaciar_por_plazo, lote) != 0)
+    {
+        liberar_lote(lote);
+        return NULL;
+    }
+
+    return lote;
+}
+
+/**
+ * @brief Agrega un frame con cualquier código de operación al lote
+ *
+ * Copia cabecera y datos al buffer pendiente. Si el buffer supera el
+ * umbral, el lote se envía en esta misma llamada.
+ *
+ * @param lote Lote donde agregar
+ * @param codigo_operacion Código de operación del frame
+ * @param datos Datos del frame (se copian)
+ * @param size Tamaño de los datos
+ * @return int 0 si se agregó, -1 si un envío anterior falló o el frame no entra
+ *         (ENOMEM o EMSGSIZE: el frame no se agrega y el lote sigue usable)
+ */
+int agregar_frame_a_lote(t_lote *lote, op_code codigo_operacion, void *datos, int size)
+{
+    uint8_t cabecera[TAMANIO_CABECERA_V2];
+    int tamanio_cabecera = escribir_cabecera(cabecera, lote->formato, codigo_operacion, size);
+
+    pthread_mutex_lock(&lote->mutex);
+    if (lote->error != 0)
+    {
+        errno = lote->error;
+        pthread_mutex_unlock(&lote->mutex);
+        return -1;
+    }
+
+    t_buffer *buffer = lote->pendiente;
+    size_t requerida = (size_t)buffer->size + tamanio_cabecera + size;
+    if (requerida > INT_MAX)
+    {
+        pthread_mutex_unlock(&lote->mutex);
+        errno = EMSGSIZE;
+        return -1;
+    }
+    if (requerida > (size_t)buffer->capacidad)
+    {
+        size_t nueva_capacidad = buffer->capacidad > 0 ? (size_t)buffer->capacidad : 4096;
+        while (nueva_capacidad < requerida)
+            nueva_capacidad *= 2;
+        if (nueva_capacidad > INT_MAX)
+            nueva_capacidad = INT_MAX;
+
+        void *stream = realloc(buffer->stream, nueva_capacidad);
+        if (stream == NULL)
+        {
+            pthread_mutex_unlock(&lote->mutex);
+            errno = ENOMEM;
+            return -1;
+        }
+        buffer->stream = stream;
+        buffer->capacidad = (int)nueva_capacidad;
+    }
+
+    memcpy(buffer->stream + buffer->size, cabecera, tamanio_cabecera);
+    memcpy(buffer->stream + buffer->size + tamanio_cabecera, datos, size);
+
+    // El primer frame del lote arranca el plazo de espera
+    if (buffer->size == 0)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &lote->primero);
+        pthread_cond_signal(&lote->hay_datos);
+    }
+    buffer->size = (int)requerida;
+
+    bool lleno = buffer->size >= lote->umbral_bytes;
+    pthread_mutex_unlock(&lote->mutex);
+
+    if (lleno && vaciar_lote(lote) == -1)
+        return -1;
+
+    return 0;
+}
+
+/**
+ * @brief Agrega un mensaje simple al lote
+ *
+ * @param lote Lote donde agregar
+ * @param mensaje String a enviar (terminado en \0)
+ * @return int 0 si se agregó, -1 si un envío anterior falló o el frame no entra
+ *         (ENOMEM o EMSGSIZE: el frame no se agrega y el lote sigue usable)
+ */
+int agregar_mensaje_a_lote(t_lote *lote, char *mensaje)
+{
+    return agregar_frame_a_lote(lote, MENSAJE, mensaje, strlen(mensaje) + 1); // +1 para el \0
+}
+
+/**
+ * @brief Envía ya todos los frames pendientes del lote
+ *
+ * Intercambia el buffer pendiente por el de envío y envía fuera del
+ * mutex principal, así los productores pueden seguir agregando mientras
+ * se escribe en el socket. mutex_envio garantiza que los lotes salgan en
+ * el orden en que se armaron.
+ *
+ * @param lote Lote a vaciar
+ * @return int Bytes enviados o -1 si hay error
+ */
+int vaciar_lote(t_lote *lote)
+{
+    pthread_mutex_lock(&lote->mutex_envio);
+
+    pthread_mutex_lock(&lote->mutex);
+    t_buffer *a_enviar = lote->pendiente;
+    lote->pendiente = lote->en_envio;
+    lote->en_envio = a_enviar;
+    pthread_mutex_unlock(&lote->mutex);
+
+    int enviados = 0;
+    if (a_enviar->size > 0)
+    {
+        struct iovec parte = {.iov_base = a_enviar->stream, .iov_len = a_enviar->size};
+        enviados = enviar_todo(lote->socket, &parte, 1);
+        a_enviar->size = 0;
+
+        if (enviados == -1)
+        {
+            pthread_mutex_lock(&lote->mutex);
+            lote->error = errno;
+            pthread_mutex_unlock(&lote->mutex);
+        }
+    }
+
+    pthread_mutex_unlock(&lote->mutex_envio);
+    return enviados;
+}
+
+/**
+ * @brief Envía lo pendiente, detiene el hilo de vaciado y libera el lote
+ *
+ * No cierra el socket, que pertenece a quien creó el lote.
+ *
+ * @param lote Lote a eliminar
+ */
+void eliminar_lote(t_lote *lote)
+{
+    vaciar_lote(lote);
+
+    pthread_mutex_lock(&lote->mutex);
+    lote->activo = false;
+    pthread_cond_signal(&lote->hay_datos);
+    pthread_mutex_unlock(&lote->mutex);
+    pthread_join(lote->hilo, NULL);
+
+    liberar_lote(lote);
+}
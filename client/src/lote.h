@@ -0,0 +1,109 @@
+#ifndef LOTE_H_
+#define LOTE_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "utils.h"
+
+/**
+ * @file lote.h
+ * @brief Envío por lotes de muchos mensajes chicos
+ *
+ * Un lote acumula frames MENSAJE (o de cualquier operación) en un buffer y
+ * los envía todos juntos con una sola syscall cuando:
+ * - el buffer supera el umbral de bytes,
+ * - el mensaje más viejo pendiente supera el plazo máximo de espera, o
+ * - se llama explícitamente a vaciar_lote().
+ *
+ * El servidor recibe los mismos frames que con enviar_mensaje(): el lote
+ * solo cambia cuántas syscalls hace el cliente.
+ */
+
+// ========== CONSTANTES ==========
+
+/**
+ * @brief Umbral de bytes por defecto a partir del cual se envía el lote
+ */
+#define UMBRAL_LOTE (64 * 1024)
+
+/**
+ * @brief Plazo por defecto (en microsegundos) que puede esperar un mensaje en el lote
+ */
+#define PLAZO_LOTE_US 1000
+
+// ========== ESTRUCTURAS ==========
+
+/**
+ * @brief Acumulador de frames pendientes de envío
+ *
+ * Se usan dos buffers: mientras uno se envía, los productores siguen
+ * agregando frames en el otro.
+ */
+typedef struct
+{
+    int socket;             // Socket conectado al servidor
+    int umbral_bytes;       // Enviar al superar esta cantidad de bytes
+    long plazo_us;          // Enviar si el primer frame pendiente espera más que esto
+    t_formato formato;      // Formato de las cabeceras (el de protocolo_actual() al crear)
+
+    t_buffer *pendiente;    // Frames agregados que todavía no se enviaron
+    t_buffer *en_envio;     // Buffer que se está enviando (o vacío)
+    struct timespec primero; // Momento en que se agregó el primer frame pendiente
+    int error;              // errno del último envío fallido (0 si no hubo)
+    bool activo;            // false cuando se pidió eliminar el lote
+
+    pthread_mutex_t mutex;       // Protege pendiente, primero, error y activo
+    pthread_mutex_t mutex_envio; // Serializa los envíos para mantener el orden
+    pthread_cond_t hay_datos;    // Despierta al hilo de vaciado por plazo
+    pthread_t hilo;              // Hilo que envía los lotes vencidos
+} t_lote;
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Crea un lote sobre un socket conectado
+ * @param socket Socket conectado al servidor
+ * @param umbral_bytes Bytes a partir de los cuales se envía (0 = UMBRAL_LOTE)
+ * @param plazo_us Espera máxima de un frame en microsegundos (0 = PLAZO_LOTE_US)
+ * @return t_lote* Lote creado o NULL si no hay memoria o no se pudo lanzar el hilo
+ */
+t_lote *crear_lote(int socket, int umbral_bytes, long plazo_us);
+
+/**
+ * @brief Agrega un frame con cualquier código de operación al lote
+ * @param lote Lote donde agregar
+ * @param codigo_operacion Código de operación del frame
+ * @param datos Datos del frame (se copian)
+ * @param size Tamaño de los datos
+ * @return int 0 si se agregó, -1 si un envío anterior falló o el frame no entra
+ *         (ENOMEM o EMSGSIZE: el frame no se agrega y el lote sigue usable)
+ */
+int agregar_frame_a_lote(t_lote *lote, op_code codigo_operacion, void *datos, int size);
+
+/**
+ * @brief Agrega un mensaje simple al lote
+ * @param lote Lote donde agregar
+ * @param mensaje String a enviar (terminado en \0)
+ * @return int 0 si se agregó, -1 si un envío anterior falló o el frame no entra
+ *         (ENOMEM o EMSGSIZE: el frame no se agrega y el lote sigue usable)
+ */
+int agregar_mensaje_a_lote(t_lote *lote, char *mensaje);
+
+/**
+ * @brief Envía ya todos los frames pendientes del lote
+ * @param lote Lote a vaciar
+ * @return int Bytes enviados o -1 si hay error
+ */
+int vaciar_lote(t_lote *lote);
+
+/**
+ * @brief Envía lo pendiente, detiene el hilo de vaciado y libera el lote
+ * @param lote Lote a eliminar
+ */
+void eliminar_lote(t_lote *lote);
+
+#endif /* LOTE_H_ */
@@ -0,0 +1,228 @@
+#include "pool.h"
+
+/**
+ * @brief Arma la clave "ip:puerto" de un destino
+ *
+ * @param clave Buffer donde escribir la clave
+ * @param tamanio Tamaño del buffer
+ * @param ip Dirección IP del servidor
+ * @param puerto Puerto del servidor
+ */
+static void clave_destino(char *clave, size_t tamanio, char *ip, char *puerto)
+{
+    snprintf(clave, tamanio, "%s:%s", ip, puerto);
+}
+
+/**
+ * @brief Configura un socket recién conectado para uso persistente
+ *
+ * TCP_NODELAY evita que Nagle retrase los frames chicos y el keepalive
+ * detecta servidores caídos mientras el socket espera en el pool.
+ *
+ * @param socket Socket conectado
+ */
+static void configurar_socket_persistente(int socket)
+{
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &(int){1}, sizeof(int));
+    setsockopt(socket, SOL_SOCKET, SO_KEEPALIVE, &(int){1}, sizeof(int));
+    setsockopt(socket, IPPROTO_TCP, TCP_KEEPIDLE, &(int){30}, sizeof(int));
+    setsockopt(socket, IPPROTO_TCP, TCP_KEEPINTVL, &(int){10}, sizeof(int));
+    setsockopt(socket, IPPROTO_TCP, TCP_KEEPCNT, &(int){3}, sizeof(int));
+}
+
+/**
+ * @brief Busca el destino en el pool y lo crea (resolviendo la dirección) si no existe
+ *
+ * Se llama sin el mutex del pool y vuelve con el mutex tomado (también
+ * si devuelve NULL). getaddrinfo() puede esperar al DNS, así que se
+ * resuelve fuera del mutex; si mientras tanto otro hilo agregó el mismo
+ * destino, se usa ese y se descarta lo resuelto.
+ *
+ * @param pool Pool de conexiones
+ * @param ip Dirección IP del servidor
+ * @param puerto Puerto del servidor
+ * @return t_destino* Destino o NULL si no se pudo resolver la dirección o no hay memoria
+ */
+static t_destino *obtener_destino(t_pool_conexiones *pool, char *ip, char *puerto)
+{
+    char clave[300];
+    clave_destino(clave, sizeof(clave), ip, puerto);
+
+    pthread_mutex_lock(&pool->mutex);
+    t_destino *destino = dictionary_get(pool->destinos, clave);
+    if (destino != NULL)
+        return destino;
+    pthread_mutex_unlock(&pool->mutex);
+
+    struct addrinfo hints;
+    struct addrinfo *direccion;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;       // IPv4
+    hints.ai_socktype = SOCK_STREAM; // TCP
+
+    if (getaddrinfo(ip, puerto, &hints, &direccion) != 0)
+    {
+        pthread_mutex_lock(&pool->mutex);
+        return NULL;
+    }
+
+    t_destino *nuevo = malloc(sizeof(t_destino));
+    int *libres = malloc(pool->maximo_libres * sizeof(int));
+
+    pthread_mutex_lock(&pool->mutex);
+    destino = dictionary_get(pool->destinos, clave);
+    if (destino == NULL && nuevo != NULL && libres != NULL)
+    {
+        nuevo->direccion = direccion;
+        nuevo->libres = libres;
+        nuevo->cantidad_libres = 0;
+        dictionary_put(pool->destinos, clave, nuevo);
+        return nuevo;
+    }
+
+    // Otro hilo lo agregó mientras se resolvía, o no hay memoria
+    freeaddrinfo(direccion);
+    free(libres);
+    free(nuevo);
+    return destino;
+}
+
+/**
+ * @brief Cierra los sockets libres de un destino y lo libera
+ *
+ * @param elemento Puntero al t_destino
+ */
+static void eliminar_destino(void *elemento)
+{
+    t_destino *destino = elemento;
+
+    for (int i = 0; i < destino->cantidad_libres; i++)
+        close(destino->libres[i]);
+
+    freeaddrinfo(destino->direccion);
+    free(destino->libres);
+    free(destino);
+}
+
+/**
+ * @brief Crea un pool de conexiones vacío
+ *
+ * @param maximo_libres Sockets libres a conservar por destino (0 = MAXIMO_LIBRES_POR_DESTINO)
+ * @return t_pool_conexiones* Pool creado o NULL si no hay memoria
+ */
+t_pool_conexiones *crear_pool_conexiones(int maximo_libres)
+{
+    t_pool_conexiones *pool = malloc(sizeof(t_pool_conexiones));
+    if (pool == NULL)
+        return NULL;
+
+    pool->destinos = dictionary_create();
+    pool->maximo_libres = maximo_libres > 0 ? maximo_libres : MAXIMO_LIBRES_POR_DESTINO;
+    pthread_mutex_init(&pool->mutex, NULL);
+
+    return pool;
+}
+
+/**
+ * @brief Verifica que el servidor no haya cerrado un socket inactivo
+ *
+ * Espía el socket sin bloquear: EAGAIN significa que sigue abierto y sin
+ * datos. Si el servidor lo cerró recv() devuelve 0, y si hay datos sin
+ * leer el socket quedó en un estado desconocido; en ambos casos no sirve.
+ *
+ * @param socket Socket a verificar
+ * @return bool true si se puede seguir usando
+ */
+bool conexion_sana(int socket)
+{
+    char byte;
+    ssize_t resultado = recv(socket, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+
+    return resultado == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+/**
+ * @brief Obtiene un socket conectado al destino, reutilizando uno libre si lo hay
+ *
+ * Los sockets libres que el servidor cerró mientras esperaban se descartan.
+ * Si no queda ninguno se abre uno nuevo con la dirección ya resuelta, sin
+ * volver a llamar a getaddrinfo(). La primera resolución y el connect()
+ * se hacen fuera del mutex.
+ *
+ * @param pool Pool de conexiones
+ * @param ip Dirección IP del servidor
+ * @param puerto Puerto del servidor
+ * @return int Socket conectado o -1 si hay error
+ */
+int obtener_conexion(t_pool_conexiones *pool, char *ip, char *puerto)
+{
+    t_destino *destino = obtener_destino(pool, ip, puerto);
+    if (destino == NULL)
+    {
+        pthread_mutex_unlock(&pool->mutex);
+        return -1;
+    }
+
+    while (destino->cantidad_libres > 0)
+    {
+        int socket = destino->libres[--destino->cantidad_libres];
+        if (conexion_sana(socket))
+        {
+            pthread_mutex_unlock(&pool->mutex);
+            return socket;
+        }
+        close(socket);
+    }
+
+    struct addrinfo *direccion = destino->direccion;
+    pthread_mutex_unlock(&pool->mutex);
+
+    // Los destinos solo se liberan junto con el pool: la dirección sigue siendo válida
+    int socket = conectar_direccion(direccion);
+    if (socket != -1)
+        configurar_socket_persistente(socket);
+
+    return socket;
+}
+
+/**
+ * @brief Devuelve al pool un socket sano para reutilizarlo
+ *
+ * Si el destino ya tiene el máximo de sockets libres, el socket se cierra.
+ * Un socket con error de envío no debe devolverse: hay que cerrarlo con
+ * liberar_conexion().
+ *
+ * @param pool Pool de conexiones
+ * @param ip Dirección IP del servidor
+ * @param puerto Puerto del servidor
+ * @param socket Socket obtenido con obtener_conexion()
+ */
+void devolver_conexion(t_pool_conexiones *pool, char *ip, char *puerto, int socket)
+{
+    t_destino *destino = obtener_destino(pool, ip, puerto);
+    if (destino != NULL && destino->cantidad_libres < pool->maximo_libres)
+    {
+        destino->libres[destino->cantidad_libres++] = socket;
+        socket = -1;
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (socket != -1)
+        liberar_conexion(socket);
+}
+
+/**
+ * @brief Cierra todos los sockets libres y libera el pool
+ *
+ * Los sockets que siguen prestados quedan a cargo de quien los tiene.
+ *
+ * @param pool Pool a eliminar
+ */
+void eliminar_pool_conexiones(t_pool_conexiones *pool)
+{
+    dictionary_destroy_and_destroy_elements(pool->destinos, eliminar_destino);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool);
+}
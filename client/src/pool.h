@@ -0,0 +1,94 @@
+#ifndef POOL_H_
+#define POOL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <commons/collections/dictionary.h>
+#include "utils.h"
+
+/**
+ * @file pool.h
+ * @brief Pool de conexiones persistentes por destino IP:PUERTO
+ *
+ * Evita resolver la dirección y hacer el handshake TCP en cada ráfaga de
+ * envíos: la dirección de cada destino se resuelve una sola vez y los
+ * sockets devueltos al pool quedan abiertos (con TCP_NODELAY y keepalive)
+ * para el próximo hilo que los pida. Antes de entregar un socket se
+ * verifica que el servidor no lo haya cerrado.
+ */
+
+// ========== CONSTANTES ==========
+
+/**
+ * @brief Cantidad máxima por defecto de sockets libres guardados por destino
+ */
+#define MAXIMO_LIBRES_POR_DESTINO 8
+
+// ========== ESTRUCTURAS ==========
+
+/**
+ * @brief Estado del pool para un destino IP:PUERTO
+ */
+typedef struct
+{
+    struct addrinfo *direccion; // Dirección resuelta una sola vez
+    int *libres;                // Sockets conectados disponibles (pila)
+    int cantidad_libres;        // Cantidad de sockets en libres
+} t_destino;
+
+/**
+ * @brief Pool de conexiones compartido entre hilos
+ */
+typedef struct
+{
+    t_dictionary *destinos; // "ip:puerto" -> t_destino*
+    int maximo_libres;      // Sockets libres a conservar por destino
+    pthread_mutex_t mutex;  // Protege destinos
+} t_pool_conexiones;
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Crea un pool de conexiones vacío
+ * @param maximo_libres Sockets libres a conservar por destino (0 = MAXIMO_LIBRES_POR_DESTINO)
+ * @return t_pool_conexiones* Pool creado o NULL si no hay memoria
+ */
+t_pool_conexiones *crear_pool_conexiones(int maximo_libres);
+
+/**
+ * @brief Obtiene un socket conectado al destino, reutilizando uno libre si lo hay
+ * @param pool Pool de conexiones
+ * @param ip Dirección IP del servidor
+ * @param puerto Puerto del servidor
+ * @return int Socket conectado o -1 si hay error
+ */
+int obtener_conexion(t_pool_conexiones *pool, char *ip, char *puerto);
+
+/**
+ * @brief Devuelve al pool un socket sano para reutilizarlo
+ * @param pool Pool de conexiones
+ * @param ip Dirección IP del servidor
+ * @param puerto Puerto del servidor
+ * @param socket Socket obtenido con obtener_conexion()
+ */
+void devolver_conexion(t_pool_conexiones *pool, char *ip, char *puerto, int socket);
+
+/**
+ * @brief Verifica que el servidor no haya cerrado un socket inactivo
+ * @param socket Socket a verificar
+ * @return bool true si se puede seguir usando
+ */
+bool conexion_sana(int socket);
+
+/**
+ * @brief Cierra todos los sockets libres y libera el pool
+ * @param pool Pool a eliminar
+ */
+void eliminar_pool_conexiones(t_pool_conexiones *pool);
+
+#endif /* POOL_H_ */
@@ -0,0 +1,372 @@
+#include "solicitudes.h"
+
+/**
+ * @brief Nanosegundos del reloj monotónico
+ *
+ * @return uint64_t Instante actual en nanosegundos
+ */
+static uint64_t ahora_ns(void)
+{
+    struct timespec instante;
+    clock_gettime(CLOCK_MONOTONIC, &instante);
+    return (uint64_t)instante.tv_sec * 1000000000 + instante.tv_nsec;
+}
+
+/**
+ * @brief Lee un entero de 32 bits little-endian
+ *
+ * @param origen Bytes a leer
+ * @return uint32_t Valor leído
+ */
+static uint32_t leer_u32(const uint8_t *origen)
+{
+    return (uint32_t)origen[0] | (uint32_t)origen[1] << 8 | (uint32_t)origen[2] << 16 | (uint32_t)origen[3] << 24;
+}
+
+/**
+ * @brief Crea la ventana de solicitudes de una conexión
+ *
+ * @param socket Socket bloqueante conectado al servidor
+ * @param ventana Solicitudes en vuelo permitidas (0 = VENTANA_SOLICITUDES)
+ * @param al_confirmar Función a llamar por cada confirmación (o NULL)
+ * @param contexto Argumento para al_confirmar
+ * @return t_solicitudes* Ventana creada o NULL si no hay memoria
+ */
+t_solicitudes *crear_solicitudes(int socket, int ventana, t_al_confirmar al_confirmar, void *contexto)
+{
+    t_solicitudes *solicitudes = calloc(1, sizeof(t_solicitudes));
+    if (solicitudes == NULL)
+        return NULL;
+    solicitudes->socket = socket;
+    solicitudes->ventana = ventana > 0 ? ventana : VENTANA_SOLICITUDES;
+    solicitudes->siguiente = 1;
+    solicitudes->solicitudes = calloc(solicitudes->ventana, sizeof(t_solicitud_en_vuelo));
+    if (solicitudes->solicitudes == NULL)
+    {
+        free(solicitudes);
+        return NULL;
+    }
+    solicitudes->al_confirmar = al_confirmar;
+    solicitudes->contexto = contexto;
+    return solicitudes;
+}
+
+/**
+ * @brief Confirma una solicitud en vuelo
+ *
+ * Un ID que no está en vuelo (repetido o desconocido) se ignora.
+ *
+ * @param solicitudes Ventana de la conexión
+ * @param id ID confirmado por el servidor
+ * @param estado Estado recibido
+ * @param ahora Instante en que se leyó el ACK
+ * @return bool true si el ID estaba en vuelo
+ */
+static bool confirmar(t_solicitudes *solicitudes, uint32_t id, uint8_t estado, uint64_t ahora)
+{
+    t_solicitud_en_vuelo *solicitud = &solicitudes->solicitudes[id % solicitudes->ventana];
+    if (!solicitud->activa || solicitud->id != id)
+        return false;
+
+    solicitud->activa = false;
+    solicitudes->en_vuelo--;
+    if (estado == CONFIRMACION_PROCESADA)
+        solicitudes->procesadas++;
+    else
+        solicitudes->rechazadas++;
+
+    if (solicitudes->al_confirmar != NULL)
+        solicitudes->al_confirmar(id, estado, ahora - solicitud->envio_ns, solicitudes->contexto);
+    return true;
+}
+
+/**
+ * @brief Suma el crédito otorgado por el servidor
+ *
+ * CREDITO_ILIMITADO significa que el servidor no tiene control de flujo:
+ * se deja de contar.
+ *
+ * @param solicitudes Ventana de la conexión
+ * @param bytes Crédito recibido
+ */
+static void sumar_credito(t_solicitudes *solicitudes, uint32_t bytes)
+{
+    if (bytes == CREDITO_ILIMITADO)
+        solicitudes->control_flujo = false;
+    else
+        solicitudes->credito += bytes;
+}
+
+/**
+ * @brief Procesa los frames ACK y CREDITO completos recibidos
+ *
+ * Lo que sobra (un frame parcial) se mueve al principio del buffer.
+ *
+ * @param solicitudes Ventana de la conexión
+ * @param frames Se le suman los frames procesados
+ * @return int Solicitudes confirmadas o -1 si llegó algo que no es un ACK ni un CREDITO válido
+ */
+static int procesar_recibido(t_solicitudes *solicitudes, int *frames)
+{
+    uint64_t ahora = ahora_ns();
+    size_t inicio = 0;
+    int confirmadas = 0;
+
+    while (solicitudes->size_recibido - inicio >= TAMANIO_CABECERA_V2)
+    {
+        uint8_t *cabecera = solicitudes->recibido + inicio;
+        uint32_t cod_op = leer_u32(cabecera + 4);
+        uint32_t size = leer_u32(cabecera + 8);
+
+        if (cabecera[0] != MAGIA_PROTOCOLO_0 || cabecera[1] != MAGIA_PROTOCOLO_1 ||
+            cabecera[2] != PROTOCOLO_V2 || size > MAXIMO_BYTES_ACK ||
+            !((cod_op == ACK && size % BYTES_CONFIRMACION == 0) || (cod_op == CREDITO && size == BYTES_CREDITO)))
+            return -1;
+
+        if (solicitudes->size_recibido - inicio - TAMANIO_CABECERA_V2 < size)
+            break;
+
+        uint8_t *payload = cabecera + TAMANIO_CABECERA_V2;
+        if (cod_op == CREDITO)
+            sumar_credito(solicitudes, leer_u32(payload));
+        else
+            for (uint8_t *entrada = payload; entrada < payload + size; entrada += BYTES_CONFIRMACION)
+                confirmadas += confirmar(solicitudes, leer_u32(entrada), entrada[4], ahora);
+
+        inicio += TAMANIO_CABECERA_V2 + size;
+        (*frames)++;
+    }
+
+    if (inicio > 0)
+    {
+        memmove(solicitudes->recibido, solicitudes->recibido + inicio, solicitudes->size_recibido - inicio);
+        solicitudes->size_recibido -= inicio;
+    }
+
+    return confirmadas;
+}
+
+/**
+ * @brief Lee los ACK y el crédito disponibles y confirma sus solicitudes
+ *
+ * Con esperar, bloquea hasta recibir al menos un frame (ACK o CREDITO);
+ * después (o sin esperar) lee sin bloquear hasta vaciar el socket. El
+ * buffer crece solo si un ACK no entra.
+ *
+ * @param solicitudes Ventana de la conexión
+ * @param esperar true para bloquear hasta recibir al menos un ACK o crédito
+ * @return int Solicitudes confirmadas o -1 si el servidor cerró, envió algo inválido
+ *         o no hay memoria para el buffer
+ */
+int recibir_confirmaciones(t_solicitudes *solicitudes, bool esperar)
+{
+    int confirmadas = 0;
+    int frames = 0;
+
+    while (1)
+    {
+        if (solicitudes->size_recibido == solicitudes->capacidad_recibido)
+        {
+            size_t capacidad = solicitudes->capacidad_recibido > 0 ? solicitudes->capacidad_recibido * 2 : 4096;
+            uint8_t *recibido = realloc(solicitudes->recibido, capacidad);
+            if (recibido == NULL)
+            {
+                errno = ENOMEM;
+                return -1;
+            }
+            solicitudes->recibido = recibido;
+            solicitudes->capacidad_recibido = capacidad;
+        }
+
+        int flags = esperar && frames == 0 ? 0 : MSG_DONTWAIT;
+        ssize_t recibidos = recv(solicitudes->socket, solicitudes->recibido + solicitudes->size_recibido,
+                                 solicitudes->capacidad_recibido - solicitudes->size_recibido, flags);
+        if (recibidos == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK ? confirmadas : -1;
+        }
+        if (recibidos == 0)
+            return confirmadas > 0 ? confirmadas : -1;
+
+        solicitudes->size_recibido += recibidos;
+        int procesadas = procesar_recibido(solicitudes, &frames);
+        if (procesadas == -1)
+            return -1;
+        confirmadas += procesadas;
+    }
+}
+
+/**
+ * @brief Bloquea hasta tener crédito para enviar
+ *
+ * Sin control de flujo (o si el servidor otorgó CREDITO_ILIMITADO) no
+ * espera nunca. Alcanza con que quede algún byte de crédito: un frame
+ * más grande que el crédito se envía igual y deja el crédito negativo.
+ *
+ * @param solicitudes Ventana de la conexión
+ * @return bool false si la conexión falló
+ */
+bool esperar_credito(t_solicitudes *solicitudes)
+{
+    while (solicitudes->control_flujo && solicitudes->credito <= 0)
+        if (recibir_confirmaciones(solicitudes, true) == -1)
+            return false;
+
+    return true;
+}
+
+/**
+ * @brief Descuenta del crédito los bytes de un envío
+ *
+ * @param solicitudes Ventana de la conexión
+ * @param bytes Bytes enviados (valor devuelto por las funciones de envío)
+ */
+void descontar_credito(t_solicitudes *solicitudes, int bytes)
+{
+    if (solicitudes->control_flujo && bytes > 0)
+        solicitudes->credito -= bytes;
+}
+
+/**
+ * @brief Pide crédito al servidor y espera el inicial
+ *
+ * Se llama antes del primer envío: el servidor cuenta todo lo que llega
+ * después del pedido.
+ *
+ * @param solicitudes Ventana de la conexión
+ * @return bool false si no se pudo pedir (protocolo v1) o la conexión falló
+ */
+bool habilitar_control_flujo(t_solicitudes *solicitudes)
+{
+    if (enviar_pedido_credito(solicitudes->socket) == -1)
+        return false;
+
+    solicitudes->control_flujo = true;
+    solicitudes->credito = 0;
+    return esperar_credito(solicitudes);
+}
+
+/**
+ * @brief Espera a que se libere el lugar de la próxima solicitud
+ *
+ * Primero lee sin bloquear los ACK que ya llegaron; si el lugar sigue
+ * ocupado (la ventana está llena) bloquea hasta que se confirme. Con
+ * control de flujo también espera tener crédito.
+ *
+ * @param solicitudes Ventana de la conexión
+ * @return t_solicitud_en_vuelo* Lugar libre o NULL si la conexión falló
+ */
+static t_solicitud_en_vuelo *reservar_lugar(t_solicitudes *solicitudes)
+{
+    t_solicitud_en_vuelo *lugar = &solicitudes->solicitudes[solicitudes->siguiente % solicitudes->ventana];
+
+    if (solicitudes->en_vuelo > 0 && recibir_confirmaciones(solicitudes, false) == -1)
+        return NULL;
+
+    while (lugar->activa)
+        if (recibir_confirmaciones(solicitudes, true) == -1)
+            return NULL;
+
+    return esperar_credito(solicitudes) ? lugar : NULL;
+}
+
+/**
+ * @brief Marca en vuelo una solicitud recién enviada
+ *
+ * @param solicitudes Ventana de la conexión
+ * @param lugar Lugar reservado para la solicitud
+ * @param envio Instante previo al envío
+ * @param id Se completa con el ID asignado (puede ser NULL)
+ */
+static void registrar_envio(t_solicitudes *solicitudes, t_solicitud_en_vuelo *lugar, uint64_t envio, uint32_t *id)
+{
+    lugar->id = solicitudes->siguiente;
+    lugar->envio_ns = envio;
+    lugar->activa = true;
+    solicitudes->en_vuelo++;
+
+    if (id != NULL)
+        *id = solicitudes->siguiente;
+    solicitudes->siguiente++;
+}
+
+/**
+ * @brief Envía un paquete como solicitud, esperando lugar en la ventana
+ *
+ * La latencia de la solicitud se mide desde justo antes del envío.
+ *
+ * @param solicitudes Ventana de la conexión
+ * @param paquete Paquete a enviar (v2)
+ * @param id Se completa con el ID asignado (puede ser NULL)
+ * @return int Bytes enviados o -1 si hay error
+ */
+int solicitar_paquete(t_solicitudes *solicitudes, t_paquete *paquete, uint32_t *id)
+{
+    t_solicitud_en_vuelo *lugar = reservar_lugar(solicitudes);
+    if (lugar == NULL)
+        return -1;
+
+    uint64_t envio = ahora_ns();
+    int enviados = enviar_paquete_solicitud(paquete, solicitudes->socket, solicitudes->siguiente);
+    if (enviados != -1)
+    {
+        registrar_envio(solicitudes, lugar, envio, id);
+        descontar_credito(solicitudes, enviados);
+    }
+
+    return enviados;
+}
+
+/**
+ * @brief Envía un mensaje simple como solicitud, esperando lugar en la ventana
+ *
+ * @param solicitudes Ventana de la conexión
+ * @param mensaje String a enviar
+ * @param id Se completa con el ID asignado (puede ser NULL)
+ * @return int Bytes enviados o -1 si hay error
+ */
+int solicitar_mensaje(t_solicitudes *solicitudes, char *mensaje, uint32_t *id)
+{
+    t_solicitud_en_vuelo *lugar = reservar_lugar(solicitudes);
+    if (lugar == NULL)
+        return -1;
+
+    uint64_t envio = ahora_ns();
+    int enviados = enviar_mensaje_solicitud(mensaje, solicitudes->socket, solicitudes->siguiente);
+    if (enviados != -1)
+    {
+        registrar_envio(solicitudes, lugar, envio, id);
+        descontar_credito(solicitudes, enviados);
+    }
+
+    return enviados;
+}
+
+/**
+ * @brief Bloquea hasta que se confirmen todas las solicitudes en vuelo
+ *
+ * @param solicitudes Ventana de la conexión
+ * @return bool false si la conexión falló antes
+ */
+bool esperar_solicitudes(t_solicitudes *solicitudes)
+{
+    while (solicitudes->en_vuelo > 0)
+        if (recibir_confirmaciones(solicitudes, true) == -1)
+            return false;
+
+    return true;
+}
+
+/**
+ * @brief Libera la ventana (no cierra el socket)
+ *
+ * @param solicitudes Ventana a liberar
+ */
+void eliminar_solicitudes(t_solicitudes *solicitudes)
+{
+    free(solicitudes->solicitudes);
+    free(solicitudes->recibido);
+    free(solicitudes);
+}
@@ -0,0 +1,171 @@
+#ifndef SOLICITUDES_H_
+#define SOLICITUDES_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "utils.h"
+
+/**
+ * @file solicitudes.h
+ * @brief Solicitudes confirmadas por el servidor con una ventana de envíos en vuelo
+ *
+ * Cada frame se envía con FLAG_SOLICITUD y un ID creciente; el servidor
+ * lo procesa y responde con un frame ACK que puede confirmar varias
+ * solicitudes juntas. Se pueden enviar hasta "ventana" solicitudes sin
+ * esperar sus confirmaciones (pipelining): la siguiente bloquea hasta
+ * que se confirme la más vieja que ocupa su lugar. Así el servidor
+ * frena al cliente cuando no da abasto y cada confirmación da la
+ * latencia real de ida y vuelta, desde el envío hasta el ACK.
+ *
+ * Antes de cada envío se leen sin bloquear los ACK que ya llegaron,
+ * para que la latencia no incluya el tiempo que el ACK esperó en el
+ * socket. Requiere PROTOCOLO=2 y un socket bloqueante; una instancia no
+ * debe usarse desde varios hilos a la vez.
+ *
+ * La misma instancia lleva el control de flujo por crédito, ya que lee
+ * todo lo que envía el servidor: con habilitar_control_flujo() el
+ * servidor otorga un crédito en bytes y lo repone (en frames CREDITO) a
+ * medida que procesa lo recibido. Antes de cada envío se espera tener
+ * crédito y después se descuentan los bytes enviados, así un productor
+ * rápido no puede dejar en el servidor más que su crédito sin procesar.
+ * Funciona también sin solicitudes, con enviar_mensaje()/enviar_paquete()
+ * entre esperar_credito() y descontar_credito().
+ */
+
+// ========== CONSTANTES ==========
+
+/**
+ * @brief Solicitudes en vuelo por defecto
+ */
+#define VENTANA_SOLICITUDES 64
+
+/**
+ * @brief Tamaño máximo aceptado para el payload de un ACK
+ */
+#define MAXIMO_BYTES_ACK (1024 * 1024)
+
+// ========== ESTRUCTURAS ==========
+
+/**
+ * @brief Función que se llama por cada solicitud confirmada
+ *
+ * @param solicitud ID de la solicitud
+ * @param estado CONFIRMACION_PROCESADA o CONFIRMACION_RECHAZADA
+ * @param latencia_ns Nanosegundos desde el envío hasta leer el ACK
+ * @param contexto Puntero pasado a crear_solicitudes()
+ */
+typedef void (*t_al_confirmar)(uint32_t solicitud, uint8_t estado, uint64_t latencia_ns, void *contexto);
+
+/**
+ * @brief Solicitud enviada que espera su confirmación
+ */
+typedef struct
+{
+    uint32_t id;       // ID de la solicitud
+    uint64_t envio_ns; // Instante del envío (reloj monotónico)
+    bool activa;       // true mientras no llegue su ACK
+} t_solicitud_en_vuelo;
+
+/**
+ * @brief Solicitudes en vuelo de una conexión
+ *
+ * La solicitud con ID n ocupa el lugar n % ventana. Los bytes de ACK
+ * recibidos que todavía no forman un frame completo quedan en
+ * recibido[0, size_recibido).
+ */
+typedef struct
+{
+    int socket;                        // Socket bloqueante conectado al servidor
+    int ventana;                       // Máximo de solicitudes sin confirmar
+    int en_vuelo;                      // Solicitudes enviadas sin confirmar
+    uint32_t siguiente;                // ID de la próxima solicitud
+    t_solicitud_en_vuelo *solicitudes; // Un lugar por solicitud de la ventana
+    uint8_t *recibido;                 // ACK parcial recibido
+    size_t size_recibido;              // Bytes ocupados en recibido
+    size_t capacidad_recibido;         // Bytes reservados en recibido
+    uint64_t procesadas;               // Confirmaciones CONFIRMACION_PROCESADA
+    uint64_t rechazadas;               // Confirmaciones CONFIRMACION_RECHAZADA
+    t_al_confirmar al_confirmar;       // Callback por confirmación (o NULL)
+    void *contexto;                    // Argumento del callback
+    bool control_flujo;                // true si el servidor limita los bytes a enviar
+    int64_t credito;                   // Bytes que se pueden enviar (negativo si el último frame se pasó)
+} t_solicitudes;
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Crea la ventana de solicitudes de una conexión
+ * @param socket Socket bloqueante conectado al servidor
+ * @param ventana Solicitudes en vuelo permitidas (0 = VENTANA_SOLICITUDES)
+ * @param al_confirmar Función a llamar por cada confirmación (o NULL)
+ * @param contexto Argumento para al_confirmar
+ * @return t_solicitudes* Ventana creada o NULL si no hay memoria
+ */
+t_solicitudes *crear_solicitudes(int socket, int ventana, t_al_confirmar al_confirmar, void *contexto);
+
+/**
+ * @brief Envía un paquete como solicitud, esperando lugar en la ventana
+ * @param solicitudes Ventana de la conexión
+ * @param paquete Paquete a enviar (v2)
+ * @param id Se completa con el ID asignado (puede ser NULL)
+ * @return int Bytes enviados o -1 si hay error
+ */
+int solicitar_paquete(t_solicitudes *solicitudes, t_paquete *paquete, uint32_t *id);
+
+/**
+ * @brief Envía un mensaje simple como solicitud, esperando lugar en la ventana
+ * @param solicitudes Ventana de la conexión
+ * @param mensaje String a enviar
+ * @param id Se completa con el ID asignado (puede ser NULL)
+ * @return int Bytes enviados o -1 si hay error
+ */
+int solicitar_mensaje(t_solicitudes *solicitudes, char *mensaje, uint32_t *id);
+
+/**
+ * @brief Lee los ACK y el crédito disponibles y confirma sus solicitudes
+ * @param solicitudes Ventana de la conexión
+ * @param esperar true para bloquear hasta recibir al menos un ACK o crédito
+ * @return int Solicitudes confirmadas o -1 si el servidor cerró, envió algo inválido
+ *         o no hay memoria para el buffer
+ */
+int recibir_confirmaciones(t_solicitudes *solicitudes, bool esperar);
+
+/**
+ * @brief Pide crédito al servidor y espera el inicial
+ * @param solicitudes Ventana de la conexión
+ * @return bool false si no se pudo pedir (protocolo v1) o la conexión falló
+ */
+bool habilitar_control_flujo(t_solicitudes *solicitudes);
+
+/**
+ * @brief Bloquea hasta tener crédito para enviar (sin control de flujo no espera)
+ * @param solicitudes Ventana de la conexión
+ * @return bool false si la conexión falló
+ */
+bool esperar_credito(t_solicitudes *solicitudes);
+
+/**
+ * @brief Descuenta del crédito los bytes de un envío
+ * @param solicitudes Ventana de la conexión
+ * @param bytes Bytes enviados (valor devuelto por las funciones de envío)
+ */
+void descontar_credito(t_solicitudes *solicitudes, int bytes);
+
+/**
+ * @brief Bloquea hasta que se confirmen todas las solicitudes en vuelo
+ * @param solicitudes Ventana de la conexión
+ * @return bool false si la conexión falló antes
+ */
+bool esperar_solicitudes(t_solicitudes *solicitudes);
+
+/**
+ * @brief Libera la ventana (no cierra el socket)
+ * @param solicitudes Ventana a liberar
+ */
+void eliminar_solicitudes(t_solicitudes *solicitudes);
+
+#endif /* SOLICITUDES_H_ */
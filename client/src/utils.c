@@ -1,11 +1,133 @@
 #include "utils.h"
 
+// Formato de los frames que se envían (v1 salvo que se elija otro)
+static t_formato protocolo = FORMATO_V1;
+
+// Paquetes de al menos estos bytes se envían comprimidos (0 = nunca)
+static int umbral_compresion = 0;
+
+/**
+ * @brief Elige el formato de los frames que se envíen de acá en adelante
+ *
+ * Se llama al iniciar, antes de abrir conexiones: el servidor fija la
+ * versión de cada conexión con su primer frame.
+ *
+ * @param version PROTOCOLO_V1 o PROTOCOLO_V2
+ * @param flags Flags de la cabecera v2 (se ignoran en v1)
+ * @return bool false si la versión no existe
+ */
+bool establecer_protocolo(int version, int flags)
+{
+    if (version == PROTOCOLO_V1)
+        protocolo = FORMATO_V1;
+    else if (version == PROTOCOLO_V2)
+        protocolo = (t_formato){.version = PROTOCOLO_V2, .flags = flags};
+    else
+        return false;
+
+    return true;
+}
+
+/**
+ * @brief Formato elegido con establecer_protocolo() (v1 por defecto)
+ *
+ * @return t_formato Formato actual
+ */
+t_formato protocolo_actual(void)
+{
+    return protocolo;
+}
+
+/**
+ * @brief Elige a partir de qué tamaño se comprimen los paquetes enviados
+ *
+ * Solo se comprime en v2: la cabecera v1 no tiene lugar para el flag.
+ *
+ * @param umbral_bytes Tamaño mínimo del paquete a comprimir (0 = no comprimir)
+ */
+void establecer_compresion(int umbral_bytes)
+{
+    umbral_compresion = umbral_bytes > 0 ? umbral_bytes : 0;
+}
+
+/**
+ * @brief Escribe la cabecera de un frame en el formato indicado
+ *
+ * @param destino Lugar para al menos TAMANIO_CABECERA_V2 bytes
+ * @param formato Formato del frame
+ * @param codigo_operacion Código de operación
+ * @param size Tamaño del payload
+ * @return int Bytes escritos
+ */
+int escribir_cabecera(void *destino, t_formato formato, int codigo_operacion, int size)
+{
+    uint8_t *bytes = destino;
+
+    if (formato.version != PROTOCOLO_V2)
+    {
+        memcpy(bytes, &codigo_operacion, sizeof(int));
+        memcpy(bytes + sizeof(int), &size, sizeof(int));
+        return TAMANIO_CABECERA_V1;
+    }
+
+    bytes[0] = MAGIA_PROTOCOLO_0;
+    bytes[1] = MAGIA_PROTOCOLO_1;
+    bytes[2] = PROTOCOLO_V2;
+    bytes[3] = formato.flags;
+    escribir_u32le(bytes + 4, codigo_operacion);
+    escribir_u32le(bytes + 8, size);
+    return TAMANIO_CABECERA_V2;
+}
+
+/**
+ * @brief Escribe la longitud de un elemento de paquete en el formato indicado
+ *
+ * v1 usa un int del host, v2 un u32 little-endian y v2 con
+ * FLAG_LONGITUDES_VARINT un LEB128 (1 byte para elementos de menos de 128).
+ *
+ * @param destino Lugar para al menos MAXIMO_BYTES_LONGITUD bytes
+ * @param formato Formato del paquete
+ * @param longitud Longitud del elemento
+ * @return int Bytes escritos
+ */
+int escribir_longitud_elemento(void *destino, t_formato formato, int longitud)
+{
+    uint8_t *bytes = destino;
+
+    if (formato.version != PROTOCOLO_V2)
+    {
+        memcpy(bytes, &longitud, sizeof(int));
+        return sizeof(int);
+    }
+
+    if (!(formato.flags & FLAG_LONGITUDES_VARINT))
+    {
+        escribir_u32le(bytes, longitud);
+        return 4;
+    }
+
+    uint32_t valor = longitud;
+    int escritos = 0;
+    do
+    {
+        uint8_t byte = valor & 0x7F;
+        valor >>= 7;
+        bytes[escritos++] = valor != 0 ? (byte | 0x80) : byte;
+    } while (valor != 0);
+
+    return escritos;
+}
+
 /**
  * @brief Serializa un paquete en un buffer de bytes para envío por red
  *
  * Convierte la estructura t_paquete en un buffer lineal de bytes que puede
  * ser enviado a través de un socket. El formato del buffer serializado es:
  * [código_operación (4 bytes)] [tamaño_buffer (4 bytes)] [datos del buffer (N bytes)]
+ * (en v2 la cabecera es la de 12 bytes, ver escribir_cabecera())
+ *
+ * enviar_paquete() ya no la usa (envía cabecera y datos con un iovec cada
+ * uno); se conserva para quien necesite el frame en un buffer contiguo.
  *
  * @param paquete Puntero al paquete a serializar
  * @param bytes Tamaño total en bytes que ocupará el buffer serializado
@@ -16,13 +138,8 @@ void *serializar_paquete(t_paquete *paquete, int bytes)
     void *magic = malloc(bytes); // Buffer para datos serializados
     int desplazamiento = 0;      // Offset actual en el buffer
 
-    // Copiar código de operación (MENSAJE o PAQUETE)
-    memcpy(magic + desplazamiento, &(paquete->codigo_operacion), sizeof(int));
-    desplazamiento += sizeof(int);
-
-    // Copiar tamaño del buffer de datos
-    memcpy(magic + desplazamiento, &(paquete->buffer->size), sizeof(int));
-    desplazamiento += sizeof(int);
+    // Copiar código de operación (MENSAJE o PAQUETE) y tamaño del buffer de datos
+    desplazamiento += escribir_cabecera(magic, paquete->formato, paquete->codigo_operacion, paquete->buffer->size);
 
     // Copiar los datos del buffer
     memcpy(magic + desplazamiento, paquete->buffer->stream, paquete->buffer->size);
@@ -55,19 +172,12 @@ int crear_conexion(char *ip, char *puerto)
     hints.ai_family = AF_INET;       // IPv4
     hints.ai_socktype = SOCK_STREAM; // TCP
 
-    // Crear el socket del cliente
-    int socket_cliente = 0;
-
     // Resolver dirección del servidor
-    socket_cliente = getaddrinfo(ip, puerto, &hints, &server_info);
-
-    // Crear socket TCP
-    int fd_conexion = socket(server_info->ai_family,
-                             server_info->ai_socktype,
-                             server_info->ai_protocol);
+    if (getaddrinfo(ip, puerto, &hints, &server_info) != 0)
+        return -1;
 
-    // Conectar al servidor
-    socket_cliente = connect(fd_conexion, server_info->ai_addr, server_info->ai_addrlen);
+    // Crear socket TCP y conectar al servidor
+    int fd_conexion = conectar_direccion(server_info);
 
     // Liberar información del servidor
     freeaddrinfo(server_info);
@@ -76,45 +186,361 @@ int crear_conexion(char *ip, char *puerto)
 }
 
 /**
- * @brief Envía un mensaje simple al servidor
+ * @brief Crea un socket TCP y lo conecta a una dirección ya resuelta
  *
- * Crea un paquete con código de operación MENSAJE, empaqueta el mensaje
- * y lo envía al servidor. Después libera toda la memoria utilizada.
+ * Permite conectarse varias veces a la misma dirección sin volver a
+ * llamar a getaddrinfo().
+ *
+ * @param direccion Dirección resuelta con getaddrinfo()
+ * @return int File descriptor del socket conectado, -1 si hay error
+ */
+int conectar_direccion(struct addrinfo *direccion)
+{
+    int fd_conexion = socket(direccion->ai_family,
+                             direccion->ai_socktype,
+                             direccion->ai_protocol);
+    if (fd_conexion == -1)
+        return -1;
+
+    if (connect(fd_conexion, direccion->ai_addr, direccion->ai_addrlen) == -1)
+    {
+        close(fd_conexion);
+        return -1;
+    }
+
+    return fd_conexion;
+}
+
+/**
+ * @brief Descarta del arreglo de iovecs los bytes que ya se enviaron
+ *
+ * @param partes Arreglo de iovecs (se modifica)
+ * @param cantidad Cantidad de iovecs en el arreglo (se actualiza)
+ * @param enviados Bytes enviados por la última llamada a sendmsg()
+ * @return struct iovec* Primer iovec con bytes pendientes
+ */
+static struct iovec *avanzar_iovecs(struct iovec *partes, int *cantidad, size_t enviados)
+{
+    while (*cantidad > 0 && enviados >= partes->iov_len)
+    {
+        enviados -= partes->iov_len;
+        partes++;
+        (*cantidad)--;
+    }
+
+    if (*cantidad > 0)
+    {
+        partes->iov_base = (char *)partes->iov_base + enviados;
+        partes->iov_len -= enviados;
+    }
+
+    return partes;
+}
+
+/**
+ * @brief Envía todos los bytes de un arreglo de iovecs
+ *
+ * send()/sendmsg() pueden escribir solo una parte de los datos cuando el
+ * buffer del socket está lleno. Esta función repite el envío desde donde
+ * quedó hasta completar, reintenta ante EINTR y, si el socket es no
+ * bloqueante y devuelve EAGAIN, espera con poll() a que haya lugar.
+ *
+ * @param socket_cliente Socket conectado
+ * @param partes Arreglo de iovecs a enviar (se modifica)
+ * @param cantidad Cantidad de iovecs
+ * @return ssize_t Bytes enviados (el total pedido) o -1 si hay error
+ */
+ssize_t enviar_todo(int socket_cliente, struct iovec *partes, int cantidad)
+{
+    ssize_t total = 0;
+
+    while (cantidad > 0)
+    {
+        struct msghdr mensaje = {.msg_iov = partes, .msg_iovlen = cantidad};
+
+        // MSG_NOSIGNAL: si el servidor cerró, devolver error en lugar de SIGPIPE
+        ssize_t enviados = sendmsg(socket_cliente, &mensaje, MSG_NOSIGNAL);
+        if (enviados == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                struct pollfd espera = {.fd = socket_cliente, .events = POLLOUT};
+                if (poll(&espera, 1, -1) == -1 && errno != EINTR)
+                    return -1;
+                continue;
+            }
+            return -1;
+        }
+
+        total += enviados;
+        partes = avanzar_iovecs(partes, &cantidad, enviados);
+    }
+
+    return total;
+}
+
+/**
+ * @brief Crea una cola de salida vacía para un socket no bloqueante
+ *
+ * @return t_cola_salida* Cola creada (liberar con eliminar_cola_salida()) o NULL si no hay memoria
+ */
+t_cola_salida *crear_cola_salida(void)
+{
+    return calloc(1, sizeof(t_cola_salida));
+}
+
+/**
+ * @brief Envía lo que el socket acepte sin bloquear y encola el resto
+ *
+ * Si ya hay datos en la cola se encolan detrás para preservar el orden.
+ * Los bytes que no entren en el socket se copian a la cola; se envían
+ * luego con vaciar_cola_salida() cuando el socket vuelva a estar listo
+ * para escribir (por ejemplo, al recibir EPOLLOUT).
+ *
+ * Si no hay memoria para encolar (errno ENOMEM) parte del mensaje ya
+ * pudo haberse escrito: el stream quedó cortado y hay que cerrar el
+ * socket.
+ *
+ * @param cola Cola de salida del socket
+ * @param socket_cliente Socket no bloqueante conectado
+ * @param partes Arreglo de iovecs a enviar (se modifica)
+ * @param cantidad Cantidad de iovecs
+ * @return ssize_t Bytes escritos en el socket en esta llamada o -1 si hay error
+ */
+ssize_t enviar_o_encolar(t_cola_salida *cola, int socket_cliente, struct iovec *partes, int cantidad)
+{
+    ssize_t escritos = 0;
+
+    if (cola->size - cola->enviados == 0)
+    {
+        // Cola vacía: intentar escribir directo en el socket
+        while (cantidad > 0)
+        {
+            struct msghdr mensaje = {.msg_iov = partes, .msg_iovlen = cantidad};
+            ssize_t enviados = sendmsg(socket_cliente, &mensaje, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (enviados == -1)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    break;
+                return -1;
+            }
+
+            escritos += enviados;
+            partes = avanzar_iovecs(partes, &cantidad, enviados);
+        }
+    }
+
+    // Copiar a la cola lo que no se pudo escribir
+    for (int i = 0; i < cantidad; i++)
+    {
+        size_t requerida = cola->size + partes[i].iov_len;
+        if (requerida > cola->capacidad)
+        {
+            // Descartar lo ya enviado antes de agrandar
+            if (cola->enviados > 0)
+            {
+                memmove(cola->datos, (char *)cola->datos + cola->enviados, cola->size - cola->enviados);
+                cola->size -= cola->enviados;
+                cola->enviados = 0;
+            }
+            requerida = cola->size + partes[i].iov_len;
+
+            size_t nueva_capacidad = cola->capacidad > 0 ? cola->capacidad : 4096;
+            while (nueva_capacidad < requerida)
+                nueva_capacidad *= 2;
+            if (nueva_capacidad != cola->capacidad)
+            {
+                void *datos = realloc(cola->datos, nueva_capacidad);
+                if (datos == NULL)
+                {
+                    errno = ENOMEM;
+                    return -1;
+                }
+                cola->datos = datos;
+                cola->capacidad = nueva_capacidad;
+            }
+        }
+
+        memcpy((char *)cola->datos + cola->size, partes[i].iov_base, partes[i].iov_len);
+        cola->size += partes[i].iov_len;
+    }
+
+    return escritos;
+}
+
+/**
+ * @brief Escribe en el socket todo lo pendiente que acepte sin bloquear
+ *
+ * @param cola Cola de salida del socket
+ * @param socket_cliente Socket no bloqueante conectado
+ * @return ssize_t Bytes escritos en esta llamada o -1 si hay error
+ */
+ssize_t vaciar_cola_salida(t_cola_salida *cola, int socket_cliente)
+{
+    ssize_t escritos = 0;
+
+    while (cola->enviados < cola->size)
+    {
+        ssize_t enviados = send(socket_cliente, (char *)cola->datos + cola->enviados,
+                                cola->size - cola->enviados, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (enviados == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            return -1;
+        }
+
+        cola->enviados += enviados;
+        escritos += enviados;
+    }
+
+    // Cola vacía: volver al principio del buffer
+    if (cola->enviados == cola->size)
+        cola->enviados = cola->size = 0;
+
+    return escritos;
+}
+
+/**
+ * @brief Bytes que todavía esperan en la cola para ser escritos
+ *
+ * @param cola Cola de salida del socket
+ * @return size_t Bytes pendientes (0 si la cola está vacía)
+ */
+size_t pendientes_cola_salida(t_cola_salida *cola)
+{
+    return cola->size - cola->enviados;
+}
+
+/**
+ * @brief Libera la cola de salida y los datos pendientes
+ *
+ * @param cola Cola a liberar
+ */
+void eliminar_cola_salida(t_cola_salida *cola)
+{
+    free(cola->datos);
+    free(cola);
+}
+
+/**
+ * @brief Envía un frame [cabecera][datos] sin armar un buffer intermedio
+ *
+ * La cabecera se arma en el stack y se envía junto con los datos usando un
+ * iovec por parte, por lo que no se reserva memoria ni se copian los datos.
  *
- * @param mensaje String a enviar (debe estar terminado en \0)
  * @param socket_cliente File descriptor del socket conectado al servidor
+ * @param formato Formato de la cabecera
+ * @param codigo_operacion Código de operación del frame
+ * @param datos Datos del frame
+ * @param size Tamaño de los datos en bytes
+ * @return int Bytes enviados (cabecera incluida) o -1 si hay error
  */
-void enviar_mensaje(char *mensaje, int socket_cliente)
+static int enviar_frame(int socket_cliente, t_formato formato, op_code codigo_operacion, void *datos, int size)
 {
-    // Crear estructura de paquete
-    t_paquete *paquete = malloc(sizeof(t_paquete));
+    uint8_t cabecera[TAMANIO_CABECERA_V2];
+    int tamanio_cabecera = escribir_cabecera(cabecera, formato, codigo_operacion, size);
 
-    // Configurar como mensaje simple
-    paquete->codigo_operacion = MENSAJE;
-    paquete->buffer = malloc(sizeof(t_buffer));
-    paquete->buffer->size = strlen(mensaje) + 1; // +1 para el \0
-    paquete->buffer->stream = malloc(paquete->buffer->size);
+    struct iovec partes[2] = {
+        {.iov_base = cabecera, .iov_len = tamanio_cabecera},
+        {.iov_base = datos, .iov_len = size}};
 
-    // Copiar el mensaje al buffer
-    memcpy(paquete->buffer->stream, mensaje, paquete->buffer->size);
+    return enviar_todo(socket_cliente, partes, 2);
+}
 
-    // Calcular tamaño total: datos + código_op + tamaño
-    int bytes = paquete->buffer->size + 2 * sizeof(int);
+/**
+ * @brief Envía un frame [cabecera][ID de solicitud][datos] sin armar un buffer intermedio
+ *
+ * El ID se escribe en el stack a continuación de la cabecera, así que se
+ * envía en el mismo iovec.
+ *
+ * @param socket_cliente File descriptor del socket conectado al servidor
+ * @param formato Formato de la cabecera (tiene que ser v2)
+ * @param codigo_operacion Código de operación del frame
+ * @param solicitud ID de la solicitud
+ * @param datos Datos del frame
+ * @param size Tamaño de los datos en bytes
+ * @return int Bytes enviados (cabecera e ID incluidos) o -1 si hay error o el formato es v1
+ */
+static int enviar_frame_solicitud(int socket_cliente, t_formato formato, op_code codigo_operacion,
+                                  uint32_t solicitud, void *datos, int size)
+{
+    // v1 no tiene flags: el servidor no tendría cómo saber que hay un ID
+    if (formato.version != PROTOCOLO_V2)
+        return -1;
+
+    uint8_t cabecera[TAMANIO_CABECERA_V2 + BYTES_ID_SOLICITUD];
+    formato.flags |= FLAG_SOLICITUD;
+    int tamanio_cabecera = escribir_cabecera(cabecera, formato, codigo_operacion, size + BYTES_ID_SOLICITUD);
+    escribir_u32le(cabecera + tamanio_cabecera, solicitud);
+
+    struct iovec partes[2] = {
+        {.iov_base = cabecera, .iov_len = tamanio_cabecera + BYTES_ID_SOLICITUD},
+        {.iov_base = datos, .iov_len = size}};
+
+    return enviar_todo(socket_cliente, partes, 2);
+}
 
-    // Serializar y enviar
-    void *a_enviar = serializar_paquete(paquete, bytes);
-    send(socket_cliente, a_enviar, bytes, 0);
+/**
+ * @brief Envía un mensaje simple al servidor
+ *
+ * Envía el mensaje (incluyendo el \0) con código de operación MENSAJE
+ * directamente desde el string recibido, sin copiarlo.
+ *
+ * @param mensaje String a enviar (debe estar terminado en \0)
+ * @param socket_cliente File descriptor del socket conectado al servidor
+ * @return int Bytes enviados o -1 si hay error
+ */
+int enviar_mensaje(char *mensaje, int socket_cliente)
+{
+    return enviar_frame(socket_cliente, protocolo, MENSAJE, mensaje, strlen(mensaje) + 1); // +1 para el \0
+}
 
-    // Liberar memoria
-    free(a_enviar);
-    eliminar_paquete(paquete);
+/**
+ * @brief Envía un mensaje simple como solicitud a confirmar
+ *
+ * Igual que enviar_mensaje() pero con FLAG_SOLICITUD y el ID antes del
+ * mensaje: el servidor responde con un ACK que lo incluye.
+ *
+ * @param mensaje String a enviar (debe estar terminado en \0)
+ * @param socket_cliente File descriptor del socket conectado al servidor
+ * @param solicitud ID de la solicitud
+ * @return int Bytes enviados o -1 si hay error o el protocolo es v1
+ */
+int enviar_mensaje_solicitud(char *mensaje, int socket_cliente, uint32_t solicitud)
+{
+    return enviar_frame_solicitud(socket_cliente, protocolo, MENSAJE, solicitud, mensaje, strlen(mensaje) + 1);
+}
+
+/**
+ * @brief Pide al servidor control de flujo por crédito
+ *
+ * Envía un frame CREDITO sin payload; el servidor responde con el
+ * crédito inicial (ver solicitudes.h).
+ *
+ * @param socket_cliente File descriptor del socket conectado al servidor
+ * @return int Bytes enviados o -1 si hay error o el protocolo es v1
+ */
+int enviar_pedido_credito(int socket_cliente)
+{
+    // Como las solicitudes, el control de flujo es parte del protocolo v2
+    if (protocolo.version != PROTOCOLO_V2)
+        return -1;
+
+    return enviar_frame(socket_cliente, protocolo, CREDITO, NULL, 0);
 }
 
 /**
  * @brief Inicializa el buffer de un paquete
  *
  * Crea un buffer vacío dentro del paquete, listo para recibir datos.
- * El buffer se inicializa con tamaño 0 y stream NULL.
+ * El buffer se inicializa con tamaño 0, capacidad 0 y stream NULL.
  *
  * @param paquete Puntero al paquete al que se le creará el buffer
  */
@@ -122,6 +548,7 @@ void crear_buffer(t_paquete *paquete)
 {
     paquete->buffer = malloc(sizeof(t_buffer));
     paquete->buffer->size = 0;      // Tamaño inicial: 0 bytes
+    paquete->buffer->capacidad = 0; // Sin memoria reservada
     paquete->buffer->stream = NULL; // Sin datos inicialmente
 }
 
@@ -140,6 +567,7 @@ t_paquete *crear_paquete(void)
 
     // Configurar como paquete múltiple
     paquete->codigo_operacion = PAQUETE;
+    paquete->formato = protocolo;
 
     // Inicializar buffer vacío
     crear_buffer(paquete);
@@ -147,54 +575,209 @@ t_paquete *crear_paquete(void)
     return paquete;
 }
 
+/**
+ * @brief Reserva lugar en el paquete para agregar datos sin reallocs
+ *
+ * Garantiza que el buffer pueda crecer `bytes` más sin volver a reservar
+ * memoria. La capacidad al menos se duplica en cada crecimiento, así que
+ * armar un paquete de n valores hace O(log n) reallocs. Los productores
+ * que conocen el tamaño final pueden llamarla una vez antes de agregar.
+ *
+ * El tamaño se calcula en size_t y se acota a INT_MAX, el máximo que
+ * puede llevar un frame; si no se puede reservar el buffer queda como
+ * estaba.
+ *
+ * @param paquete Paquete donde reservar
+ * @param bytes Bytes adicionales que se van a agregar
+ * @return bool true si hay lugar, false si el paquete pasaría INT_MAX o no hay memoria
+ */
+bool reservar_en_paquete(t_paquete *paquete, int bytes)
+{
+    t_buffer *buffer = paquete->buffer;
+    size_t requerida = (size_t)buffer->size + (size_t)bytes;
+
+    if (bytes < 0 || requerida > INT_MAX)
+        return false;
+    if (requerida <= (size_t)buffer->capacidad)
+        return true;
+
+    // Crecimiento geométrico: duplicar hasta cubrir lo requerido
+    size_t nueva_capacidad = buffer->capacidad > 0 ? (size_t)buffer->capacidad : 64;
+    while (nueva_capacidad < requerida)
+        nueva_capacidad *= 2;
+    if (nueva_capacidad > INT_MAX)
+        nueva_capacidad = INT_MAX;
+
+    void *stream = realloc(buffer->stream, nueva_capacidad);
+    if (stream == NULL)
+        return false;
+
+    buffer->stream = stream;
+    buffer->capacidad = (int)nueva_capacidad;
+    return true;
+}
+
 /**
  * @brief Agrega datos a un paquete existente
  *
  * Expande el buffer del paquete para incluir nuevos datos. El formato interno es:
  * [tamaño_dato (4 bytes)] [dato (N bytes)] [tamaño_siguiente_dato] [siguiente_dato] ...
+ * (el tamaño se escribe según paquete->formato, ver escribir_longitud_elemento())
  *
  * @param paquete Puntero al paquete donde agregar los datos
  * @param valor Puntero a los datos a agregar
  * @param tamanio Cantidad de bytes a agregar
+ * @return bool true si se agregó, false si no hay lugar (el paquete no cambia)
  */
-void agregar_a_paquete(t_paquete *paquete, void *valor, int tamanio)
+bool agregar_a_paquete(t_paquete *paquete, void *valor, int tamanio)
 {
-    // Expandir el buffer para incluir: tamaño (4 bytes) + datos (tamanio bytes)
-    paquete->buffer->stream = realloc(paquete->buffer->stream,
-                                      paquete->buffer->size + tamanio + sizeof(int));
+    // Asegurar lugar para: tamaño (hasta 5 bytes) + datos (tamanio bytes)
+    if (tamanio < 0 || tamanio > INT_MAX - MAXIMO_BYTES_LONGITUD ||
+        !reservar_en_paquete(paquete, tamanio + MAXIMO_BYTES_LONGITUD))
+        return false;
 
     // Escribir primero el tamaño del dato
-    memcpy(paquete->buffer->stream + paquete->buffer->size, &tamanio, sizeof(int));
+    int bytes_longitud = escribir_longitud_elemento(paquete->buffer->stream + paquete->buffer->size,
+                                                    paquete->formato, tamanio);
 
     // Escribir los datos después del tamaño
-    memcpy(paquete->buffer->stream + paquete->buffer->size + sizeof(int), valor, tamanio);
+    memcpy(paquete->buffer->stream + paquete->buffer->size + bytes_longitud, valor, tamanio);
 
     // Actualizar el tamaño total del buffer
-    paquete->buffer->size += tamanio + sizeof(int);
+    paquete->buffer->size += tamanio + bytes_longitud;
+    return true;
+}
+
+/**
+ * @brief Vacía el paquete conservando su memoria para reutilizarlo
+ *
+ * Permite armar y enviar muchos paquetes seguidos con una sola allocation:
+ * después de enviar_paquete() se reinicia y se vuelve a llenar.
+ *
+ * @param paquete Paquete a reiniciar
+ */
+void reiniciar_paquete(t_paquete *paquete)
+{
+    paquete->buffer->size = 0;
+}
+
+/**
+ * @brief Elige qué bytes enviar para un paquete, comprimiéndolo si corresponde
+ *
+ * Se comprime en v2 a partir de umbral_compresion. Si el bloque comprimido
+ * no ahorra bytes (o no hay memoria para armarlo) se envía el stream
+ * original. El bloque queda en un buffer del hilo que se reutiliza en
+ * cada envío.
+ *
+ * @param paquete Paquete a enviar
+ * @param formato Se completa con el formato del frame
+ * @param datos Se completa con los bytes a enviar
+ * @param size Se completa con la cantidad de bytes a enviar
+ */
+static void preparar_envio_paquete(t_paquete *paquete, t_formato *formato, void **datos, int *size)
+{
+    static __thread uint8_t *comprimido = NULL;
+    static __thread int capacidad = 0;
+
+    *formato = paquete->formato;
+    *datos = paquete->buffer->stream;
+    *size = paquete->buffer->size;
+
+    if (formato->version != PROTOCOLO_V2 || umbral_compresion == 0 ||
+        *size < umbral_compresion || *size <= BYTES_TAMANIO_ORIGINAL + 1)
+        return;
+
+    // Sin memoria para el bloque se envía sin comprimir
+    if (*size > capacidad)
+    {
+        uint8_t *nuevo = realloc(comprimido, *size);
+        if (nuevo == NULL)
+            return;
+        comprimido = nuevo;
+        capacidad = *size;
+    }
+
+    // El bloque tiene que ocupar menos que el original, si no no se usa
+    int bloque = comprimir_bloque(*datos, *size, comprimido + BYTES_TAMANIO_ORIGINAL,
+                                  *size - BYTES_TAMANIO_ORIGINAL - 1);
+    if (bloque == 0)
+        return;
+
+    escribir_u32le(comprimido, *size);
+    *datos = comprimido;
+    *size = BYTES_TAMANIO_ORIGINAL + bloque;
+    formato->flags |= FLAG_COMPRIMIDO;
 }
 
 /**
  * @brief Envía un paquete completo al servidor
  *
- * Serializa el paquete y lo envía a través del socket. No libera el paquete,
- * eso debe hacerse por separado con eliminar_paquete().
+ * Envía la cabecera y el stream del paquete con un solo sendmsg(), sin
+ * serializarlo en un buffer intermedio. No libera el paquete, eso debe
+ * hacerse por separado con eliminar_paquete() (o reutilizarlo con
+ * reiniciar_paquete()).
  *
  * @param paquete Puntero al paquete a enviar
  * @param socket_cliente File descriptor del socket conectado al servidor
+ * @return int Bytes enviados o -1 si hay error
+ */
+int enviar_paquete(t_paquete *paquete, int socket_cliente)
+{
+    t_formato formato;
+    void *datos;
+    int size;
+
+    preparar_envio_paquete(paquete, &formato, &datos, &size);
+    return enviar_frame(socket_cliente, formato, paquete->codigo_operacion, datos, size);
+}
+
+/**
+ * @brief Envía un paquete como solicitud a confirmar
+ *
+ * Igual que enviar_paquete() (con compresión si corresponde) pero con
+ * FLAG_SOLICITUD y el ID antes del payload.
+ *
+ * @param paquete Puntero al paquete a enviar
+ * @param socket_cliente File descriptor del socket conectado al servidor
+ * @param solicitud ID de la solicitud
+ * @return int Bytes enviados o -1 si hay error o el paquete no es v2
+ */
+int enviar_paquete_solicitud(t_paquete *paquete, int socket_cliente, uint32_t solicitud)
+{
+    t_formato formato;
+    void *datos;
+    int size;
+
+    preparar_envio_paquete(paquete, &formato, &datos, &size);
+    return enviar_frame_solicitud(socket_cliente, formato, paquete->codigo_operacion, solicitud, datos, size);
+}
+
+/**
+ * @brief Envía un paquete por un socket no bloqueante sin esperar
+ *
+ * Lo que el socket no acepte queda copiado en la cola de salida, por lo
+ * que el paquete puede reutilizarse o liberarse apenas retorna.
+ *
+ * @param paquete Paquete a enviar
+ * @param socket_cliente Socket no bloqueante conectado
+ * @param cola Cola de salida del socket
+ * @return int Bytes escritos en el socket en esta llamada o -1 si hay error
  */
-void enviar_paquete(t_paquete *paquete, int socket_cliente)
+int encolar_paquete(t_paquete *paquete, int socket_cliente, t_cola_salida *cola)
 {
-    // Calcular tamaño total del paquete serializado
-    int bytes = paquete->buffer->size + 2 * sizeof(int);
+    t_formato formato;
+    void *datos;
+    int size;
+    preparar_envio_paquete(paquete, &formato, &datos, &size);
 
-    // Serializar el paquete
-    void *a_enviar = serializar_paquete(paquete, bytes);
+    uint8_t cabecera[TAMANIO_CABECERA_V2];
+    int tamanio_cabecera = escribir_cabecera(cabecera, formato, paquete->codigo_operacion, size);
 
-    // Enviar por socket
-    send(socket_cliente, a_enviar, bytes, 0);
+    struct iovec partes[2] = {
+        {.iov_base = cabecera, .iov_len = tamanio_cabecera},
+        {.iov_base = datos, .iov_len = size}};
 
-    // Liberar buffer temporal de serialización
-    free(a_enviar);
+    return enviar_o_encolar(cola, socket_cliente, partes, 2);
 }
 
 /**
@@ -6,9 +6,16 @@
 #include <signal.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netdb.h>
 #include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdbool.h>
 #include <commons/log.h>
+#include "compresion.h"
 
 /**
  * @file utils.h
@@ -19,6 +26,87 @@
  * personalizado de paquetes.
  */
 
+// ========== PROTOCOLO ==========
+
+/**
+ * @brief Versiones del formato de los frames (igual que en server/src/utils.h)
+ *
+ * - v1: [int cod_op][int size][payload], enteros en el orden del host.
+ * - v2: ['T']['P'][u8 versión][u8 flags][u32 cod_op][u32 size][payload],
+ *   enteros little-endian. Con FLAG_LONGITUDES_VARINT las longitudes de
+ *   los elementos de un paquete van en LEB128 en lugar de u32.
+ *
+ * El servidor toma la versión del primer frame de cada conexión, así que
+ * todos los frames de una conexión deben usar la misma.
+ */
+#define PROTOCOLO_V1 1
+#define PROTOCOLO_V2 2
+
+#define MAGIA_PROTOCOLO_0 'T'
+#define MAGIA_PROTOCOLO_1 'P'
+
+#define TAMANIO_CABECERA_V1 (2 * (int)sizeof(int))
+#define TAMANIO_CABECERA_V2 12
+
+/**
+ * @brief Flags de la cabecera v2
+ */
+#define FLAG_LONGITUDES_VARINT 0x01   // Longitudes de elementos en LEB128
+#define FLAG_COMPRIMIDO 0x02          // Payload comprimido (ver compresion.h)
+#define FLAG_PAQUETE_SIGUE 0x04       // El paquete sigue en el próximo frame
+#define FLAG_PAQUETE_CONTINUADO 0x08  // El frame continúa el paquete del frame anterior
+#define FLAG_ELEMENTO_SIGUE 0x10      // El último elemento sigue en el próximo frame
+#define FLAG_ELEMENTO_CONTINUADO 0x20 // El primer elemento continúa al último del frame anterior
+#define FLAG_SOLICITUD 0x40           // El payload empieza con el ID de solicitud a confirmar
+
+/**
+ * @brief Bytes del tamaño original al principio de un payload comprimido
+ *
+ * Un payload con FLAG_COMPRIMIDO es [u32le tamaño original][bloque].
+ */
+#define BYTES_TAMANIO_ORIGINAL 4
+
+/**
+ * @brief Bytes del ID de solicitud al principio de un payload con FLAG_SOLICITUD
+ *
+ * Un frame con FLAG_SOLICITUD es [cabecera][u32le ID][payload]: el ID va
+ * afuera del bloque comprimido y la cabecera lo cuenta en el tamaño. El
+ * servidor lo confirma con un frame ACK (ver solicitudes.h).
+ */
+#define BYTES_ID_SOLICITUD 4
+
+/**
+ * @brief Bytes de cada confirmación en el payload de un frame ACK
+ *
+ * El payload de un ACK es una secuencia de [u32le ID][u8 estado].
+ */
+#define BYTES_CONFIRMACION 5
+
+/**
+ * @brief Estados de una solicitud confirmada
+ */
+#define CONFIRMACION_PROCESADA 0 // El servidor procesó el frame
+#define CONFIRMACION_RECHAZADA 1 // Operación desconocida o payload mal formado
+
+/**
+ * @brief Bytes del payload de un frame CREDITO del servidor
+ *
+ * El servidor otorga crédito con [u32le bytes]: el cliente puede enviar
+ * esa cantidad de bytes más, cabeceras incluidas. El cliente lo pide con
+ * un CREDITO sin payload (ver solicitudes.h).
+ */
+#define BYTES_CREDITO 4
+
+/**
+ * @brief Crédito que otorga un servidor sin control de flujo
+ */
+#define CREDITO_ILIMITADO UINT32_MAX
+
+/**
+ * @brief Bytes máximos que ocupa la longitud de un elemento (LEB128 de 32 bits)
+ */
+#define MAXIMO_BYTES_LONGITUD 5
+
 // ========== ENUMERACIONES ==========
 
 /**
@@ -27,25 +115,53 @@
  * Define los tipos de mensaje que se pueden enviar:
  * - MENSAJE: Un mensaje simple
  * - PAQUETE: Múltiples mensajes agrupados
+ * - ACK: Confirmaciones de solicitudes (solo las envía el servidor)
+ * - CREDITO: Pedido u otorgamiento de crédito para el control de flujo
+ *
+ * El enum se comparte con server/src/utils.h: ambos deben coincidir.
  */
 typedef enum
 {
-    MENSAJE, // Operación para enviar un mensaje simple
-    PAQUETE  // Operación para enviar múltiples mensajes
+    MENSAJE = 0, // Operación para enviar un mensaje simple
+    PAQUETE = 1, // Operación para enviar múltiples mensajes
+    ACK = 2,     // Confirmaciones de solicitudes (servidor -> cliente)
+    CREDITO = 3, // Pedido (cliente -> servidor) u otorgamiento (servidor -> cliente) de crédito
+
+    // Las operaciones nuevas van acá, con valor explícito y en el mismo
+    // orden en cliente y servidor (es el valor que viaja por la red)
+
+    OP_CODE_MAX // Cantidad de códigos (no es una operación)
 } op_code;
 
 // ========== ESTRUCTURAS ==========
 
+/**
+ * @brief Formato con el que se envían los frames
+ */
+typedef struct
+{
+    uint8_t version; // PROTOCOLO_V1 o PROTOCOLO_V2
+    uint8_t flags;   // Flags de la cabecera (siempre 0 en v1)
+} t_formato;
+
+/**
+ * @brief Formato de los frames v1 (el del protocolo original)
+ */
+#define FORMATO_V1 ((t_formato){.version = PROTOCOLO_V1, .flags = 0})
+
 /**
  * @brief Buffer de datos para almacenar información serializada
  *
- * Contiene un puntero a los datos y su tamaño total.
+ * Contiene un puntero a los datos, su tamaño y la capacidad reservada.
+ * La capacidad crece geométricamente, por lo que agregar n valores hace
+ * O(log n) reallocs en lugar de uno por valor.
  * Usado dentro de t_paquete para almacenar los datos a transmitir.
  */
 typedef struct
 {
-    int size;     // Tamaño en bytes de los datos
-    void *stream; // Puntero a los datos (buffer de bytes)
+    int size;       // Tamaño en bytes de los datos
+    int capacidad;  // Bytes reservados en stream (capacidad >= size)
+    void *stream;   // Puntero a los datos (buffer de bytes)
 } t_buffer;
 
 /**
@@ -58,10 +174,71 @@ typedef struct
 {
     op_code codigo_operacion; // Tipo de operación (MENSAJE o PAQUETE)
     t_buffer *buffer;         // Buffer con los datos a enviar
+    t_formato formato;        // Formato de la cabecera y de las longitudes
 } t_paquete;
 
+/**
+ * @brief Datos pendientes de escritura de un socket no bloqueante
+ *
+ * Los bytes válidos pendientes están en datos[enviados, size).
+ */
+typedef struct
+{
+    void *datos;      // Bytes que el socket todavía no aceptó
+    size_t size;      // Bytes ocupados en datos
+    size_t enviados;  // Bytes de datos ya escritos en el socket
+    size_t capacidad; // Bytes reservados en datos
+} t_cola_salida;
+
 // ========== DECLARACIONES DE FUNCIONES ==========
 
+/**
+ * @brief Serializa un paquete en un buffer contiguo [cabecera][datos]
+ * @param paquete Paquete a serializar
+ * @param bytes Tamaño total del buffer serializado (cabecera + datos)
+ * @return void* Buffer serializado (debe liberarse con free())
+ */
+void *serializar_paquete(t_paquete *paquete, int bytes);
+
+/**
+ * @brief Elige el formato de los frames que se envíen de acá en adelante
+ * @param version PROTOCOLO_V1 o PROTOCOLO_V2
+ * @param flags Flags de la cabecera v2 (se ignoran en v1)
+ * @return bool false si la versión no existe
+ */
+bool establecer_protocolo(int version, int flags);
+
+/**
+ * @brief Formato elegido con establecer_protocolo() (v1 por defecto)
+ * @return t_formato Formato actual
+ */
+t_formato protocolo_actual(void);
+
+/**
+ * @brief Elige a partir de qué tamaño se comprimen los paquetes enviados
+ * @param umbral_bytes Tamaño mínimo del paquete a comprimir (0 = no comprimir)
+ */
+void establecer_compresion(int umbral_bytes);
+
+/**
+ * @brief Escribe la cabecera de un frame en el formato indicado
+ * @param destino Lugar para al menos TAMANIO_CABECERA_V2 bytes
+ * @param formato Formato del frame
+ * @param codigo_operacion Código de operación
+ * @param size Tamaño del payload
+ * @return int Bytes escritos
+ */
+int escribir_cabecera(void *destino, t_formato formato, int codigo_operacion, int size);
+
+/**
+ * @brief Escribe la longitud de un elemento de paquete en el formato indicado
+ * @param destino Lugar para al menos MAXIMO_BYTES_LONGITUD bytes
+ * @param formato Formato del paquete
+ * @param longitud Longitud del elemento
+ * @return int Bytes escritos
+ */
+int escribir_longitud_elemento(void *destino, t_formato formato, int longitud);
+
 /**
  * @brief Establece conexión TCP con el servidor
  * @param ip Dirección IP del servidor
@@ -70,12 +247,83 @@ typedef struct
  */
 int crear_conexion(char *ip, char *puerto);
 
+/**
+ * @brief Crea un socket TCP conectado a una dirección ya resuelta
+ * @param direccion Dirección resuelta con getaddrinfo()
+ * @return int File descriptor del socket conectado, -1 si hay error
+ */
+int conectar_direccion(struct addrinfo *direccion);
+
+/**
+ * @brief Envía todos los bytes de un arreglo de iovecs, reintentando envíos parciales
+ * @param socket_cliente Socket conectado
+ * @param partes Arreglo de iovecs a enviar (se modifica)
+ * @param cantidad Cantidad de iovecs
+ * @return ssize_t Bytes enviados o -1 si hay error
+ */
+ssize_t enviar_todo(int socket_cliente, struct iovec *partes, int cantidad);
+
+/**
+ * @brief Crea una cola de salida vacía para un socket no bloqueante
+ * @return t_cola_salida* Cola creada o NULL si no hay memoria
+ */
+t_cola_salida *crear_cola_salida(void);
+
+/**
+ * @brief Envía lo que el socket acepte sin bloquear y encola el resto
+ * @param cola Cola de salida del socket
+ * @param socket_cliente Socket no bloqueante conectado
+ * @param partes Arreglo de iovecs a enviar (se modifica)
+ * @param cantidad Cantidad de iovecs
+ * @return ssize_t Bytes escritos en el socket o -1 si hay error (con ENOMEM
+ *         el mensaje quedó cortado y hay que cerrar el socket)
+ */
+ssize_t enviar_o_encolar(t_cola_salida *cola, int socket_cliente, struct iovec *partes, int cantidad);
+
+/**
+ * @brief Escribe en el socket todo lo pendiente que acepte sin bloquear
+ * @param cola Cola de salida del socket
+ * @param socket_cliente Socket no bloqueante conectado
+ * @return ssize_t Bytes escritos o -1 si hay error
+ */
+ssize_t vaciar_cola_salida(t_cola_salida *cola, int socket_cliente);
+
+/**
+ * @brief Bytes que todavía esperan en la cola para ser escritos
+ * @param cola Cola de salida del socket
+ * @return size_t Bytes pendientes
+ */
+size_t pendientes_cola_salida(t_cola_salida *cola);
+
+/**
+ * @brief Libera la cola de salida y los datos pendientes
+ * @param cola Cola a liberar
+ */
+void eliminar_cola_salida(t_cola_salida *cola);
+
 /**
  * @brief Envía un mensaje simple al servidor
  * @param mensaje String a enviar
  * @param socket_cliente Socket conectado al servidor
+ * @return int Bytes enviados o -1 si hay error
+ */
+int enviar_mensaje(char *mensaje, int socket_cliente);
+
+/**
+ * @brief Envía un mensaje simple como solicitud a confirmar (solo v2)
+ * @param mensaje String a enviar
+ * @param socket_cliente Socket conectado al servidor
+ * @param solicitud ID de la solicitud
+ * @return int Bytes enviados o -1 si hay error o el protocolo es v1
  */
-void enviar_mensaje(char *mensaje, int socket_cliente);
+int enviar_mensaje_solicitud(char *mensaje, int socket_cliente, uint32_t solicitud);
+
+/**
+ * @brief Pide al servidor control de flujo por crédito (solo v2)
+ * @param socket_cliente Socket conectado al servidor
+ * @return int Bytes enviados o -1 si hay error o el protocolo es v1
+ */
+int enviar_pedido_credito(int socket_cliente);
 
 /**
  * @brief Crea un nuevo paquete vacío
@@ -88,15 +336,49 @@ t_paquete *crear_paquete(void);
  * @param paquete Paquete donde agregar los datos
  * @param valor Datos a agregar
  * @param tamanio Tamaño de los datos en bytes
+ * @return bool true si se agregó, false si no hay lugar (el paquete no cambia)
+ */
+bool agregar_a_paquete(t_paquete *paquete, void *valor, int tamanio);
+
+/**
+ * @brief Reserva lugar en el paquete para agregar datos sin reallocs
+ * @param paquete Paquete donde reservar
+ * @param bytes Bytes adicionales que se van a agregar
+ * @return bool true si hay lugar, false si el paquete pasaría INT_MAX o no hay memoria
+ */
+bool reservar_en_paquete(t_paquete *paquete, int bytes);
+
+/**
+ * @brief Vacía el paquete conservando su memoria para reutilizarlo
+ * @param paquete Paquete a reiniciar
  */
-void agregar_a_paquete(t_paquete *paquete, void *valor, int tamanio);
+void reiniciar_paquete(t_paquete *paquete);
 
 /**
  * @brief Envía un paquete completo al servidor
  * @param paquete Paquete a enviar
  * @param socket_cliente Socket conectado al servidor
+ * @return int Bytes enviados o -1 si hay error
+ */
+int enviar_paquete(t_paquete *paquete, int socket_cliente);
+
+/**
+ * @brief Envía un paquete como solicitud a confirmar (solo v2)
+ * @param paquete Paquete a enviar
+ * @param socket_cliente Socket conectado al servidor
+ * @param solicitud ID de la solicitud
+ * @return int Bytes enviados o -1 si hay error o el paquete no es v2
  */
-void enviar_paquete(t_paquete *paquete, int socket_cliente);
+int enviar_paquete_solicitud(t_paquete *paquete, int socket_cliente, uint32_t solicitud);
+
+/**
+ * @brief Envía un paquete por un socket no bloqueante, encolando lo que no entre
+ * @param paquete Paquete a enviar
+ * @param socket_cliente Socket no bloqueante conectado
+ * @param cola Cola de salida del socket
+ * @return int Bytes escritos en el socket o -1 si hay error
+ */
+int encolar_paquete(t_paquete *paquete, int socket_cliente, t_cola_salida *cola);
 
 /**
  * @brief Cierra una conexión de socket
@@ -110,4 +392,18 @@ void liberar_conexion(int socket_cliente);
  */
 void eliminar_paquete(t_paquete *paquete);
 
+/**
+ * @brief Escribe un entero de 32 bits little-endian
+ * @param destino Lugar para 4 bytes
+ * @param valor Valor a escribir
+ */
+static inline void escribir_u32le(void *destino, uint32_t valor)
+{
+    uint8_t *bytes = destino;
+    bytes[0] = valor;
+    bytes[1] = valor >> 8;
+    bytes[2] = valor >> 16;
+    bytes[3] = valor >> 24;
+}
+
 #endif /* UTILS_H_ */
@@ -5,10 +5,18 @@
 #include <string.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
 
 // Incluir los headers del cliente
 #include "../../src/utils.h"
 #include "../../src/client.h"
+#include "../../src/lote.h"
+#include "../../src/pool.h"
+#include "../../src/fragmentos.h"
+#include "../../src/solicitudes.h"
+#include "../../replay/src/lector_journal.h"
+#include "../../bench/src/histograma.h"
 
 /**
  * @file test_client_utils.c
@@ -273,3 +281,891 @@ end
 end
 }
 end
+
+// ========== TESTS PARA CRECIMIENTO Y REUTILIZACIÓN DE PAQUETES ==========
+
+context(test_capacidad_paquetes){
+
+    describe("Crecimiento geométrico del buffer"){
+
+        it("debería no reservar memoria al agregar si ya hay capacidad"){
+            t_paquete *paquete = crear_paquete();
+
+            reservar_en_paquete(paquete, 1000);
+            should_int(paquete->buffer->capacidad) be greater than(999);
+
+            void *stream = paquete->buffer->stream;
+            for (int i = 0; i < 10; i++)
+                agregar_a_paquete(paquete, "dato", 5);
+
+            // 10 * (4 + 5) bytes entran en lo reservado: el stream no se movió
+            should_ptr(paquete->buffer->stream) be equal to(stream);
+            should_int(paquete->buffer->size) be equal to(90);
+
+            eliminar_paquete(paquete);
+        } end
+
+        it("debería crecer geométricamente al agregar muchos valores"){
+            t_paquete *paquete = crear_paquete();
+            int crecimientos = 0;
+            int capacidad_anterior = paquete->buffer->capacidad;
+
+            for (int i = 0; i < 10000; i++)
+            {
+                agregar_a_paquete(paquete, "x", 2);
+                if (paquete->buffer->capacidad != capacidad_anterior)
+                {
+                    crecimientos++;
+                    capacidad_anterior = paquete->buffer->capacidad;
+                }
+            }
+
+            should_int(paquete->buffer->size) be equal to(10000 * 6);
+            should_int(crecimientos) be less than(20);
+
+            eliminar_paquete(paquete);
+        } end
+
+        it("debería reutilizar la memoria al reiniciar el paquete"){
+            t_paquete *paquete = crear_paquete();
+            agregar_a_paquete(paquete, "Hola", 5);
+
+            int capacidad = paquete->buffer->capacidad;
+            reiniciar_paquete(paquete);
+
+            should_int(paquete->buffer->size) be equal to(0);
+            should_int(paquete->buffer->capacidad) be equal to(capacidad);
+            should_int(paquete->codigo_operacion) be equal to(PAQUETE);
+
+            eliminar_paquete(paquete);
+        } end
+
+        it("debería rechazar un paquete que pasaría INT_MAX sin tocar el buffer"){
+            t_paquete *paquete = crear_paquete();
+            agregar_a_paquete(paquete, "Hola", 5);
+
+            void *stream = paquete->buffer->stream;
+            int capacidad = paquete->buffer->capacidad;
+
+            should_bool(reservar_en_paquete(paquete, INT_MAX)) be equal to(false);
+            should_bool(agregar_a_paquete(paquete, "x", INT_MAX - 2)) be equal to(false);
+            should_ptr(paquete->buffer->stream) be equal to(stream);
+            should_int(paquete->buffer->capacidad) be equal to(capacidad);
+            should_int(paquete->buffer->size) be equal to(9);
+
+            eliminar_paquete(paquete);
+        } end
+
+    } end
+
+    describe("Protocolo v2"){
+
+        after{
+            establecer_protocolo(PROTOCOLO_V1, 0);
+        } end
+
+        it("debería escribir la cabecera v2 con magia, versión y enteros little-endian"){
+            uint8_t cabecera[TAMANIO_CABECERA_V2];
+            t_formato formato = {.version = PROTOCOLO_V2, .flags = 0};
+
+            should_int(escribir_cabecera(cabecera, formato, PAQUETE, 0x0102)) be equal to(TAMANIO_CABECERA_V2);
+            should_int(cabecera[0]) be equal to('T');
+            should_int(cabecera[1]) be equal to('P');
+            should_int(cabecera[2]) be equal to(PROTOCOLO_V2);
+            should_int(cabecera[4]) be equal to(PAQUETE);
+            should_int(cabecera[8]) be equal to(0x02);
+            should_int(cabecera[9]) be equal to(0x01);
+
+            should_int(escribir_cabecera(cabecera, FORMATO_V1, PAQUETE, 10)) be equal to(TAMANIO_CABECERA_V1);
+        } end
+
+        it("debería codificar las longitudes en LEB128 con FLAG_LONGITUDES_VARINT"){
+            uint8_t bytes[MAXIMO_BYTES_LONGITUD];
+            t_formato formato = {.version = PROTOCOLO_V2, .flags = FLAG_LONGITUDES_VARINT};
+
+            should_int(escribir_longitud_elemento(bytes, formato, 5)) be equal to(1);
+            should_int(bytes[0]) be equal to(5);
+            should_int(escribir_longitud_elemento(bytes, formato, 300)) be equal to(2);
+            should_int(bytes[0]) be equal to(0xAC);
+            should_int(bytes[1]) be equal to(0x02);
+        } end
+
+        it("debería armar los paquetes en el protocolo elegido"){
+            should_bool(establecer_protocolo(3, 0)) be equal to(false);
+            should_bool(establecer_protocolo(PROTOCOLO_V2, FLAG_LONGITUDES_VARINT)) be equal to(true);
+
+            t_paquete *paquete = crear_paquete();
+            agregar_a_paquete(paquete, "dato", 5);
+
+            // 1 byte de longitud en lugar de 4
+            should_int(paquete->buffer->size) be equal to(6);
+            should_int(paquete->formato.version) be equal to(PROTOCOLO_V2);
+
+            eliminar_paquete(paquete);
+        } end
+
+    } end
+
+    describe("Compresión de paquetes"){
+
+        after{
+            establecer_compresion(0);
+            establecer_protocolo(PROTOCOLO_V1, 0);
+        } end
+
+        it("debería comprimir datos repetidos dentro de la cota"){
+            char datos[1000];
+            for (int i = 0; i < (int)sizeof(datos); i++)
+                datos[i] = "valor repetido "[i % 15];
+
+            uint8_t bloque[1000 + 1000 / 255 + 16];
+            should_int(cota_compresion(sizeof(datos))) be equal to(sizeof(bloque));
+
+            int comprimido = comprimir_bloque(datos, sizeof(datos), bloque, sizeof(bloque));
+            should_int(comprimido) be greater than(0);
+            should_int(comprimido) be less than(100);
+
+            // Sin lugar suficiente no escribe nada
+            should_int(comprimir_bloque(datos, sizeof(datos), bloque, 10)) be equal to(0);
+        } end
+
+        it("debería enviar comprimidos solo los paquetes v2 que superan el umbral"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+            establecer_protocolo(PROTOCOLO_V2, 0);
+            establecer_compresion(64);
+
+            char valor[512];
+            memset(valor, 'x', sizeof(valor) - 1);
+            valor[sizeof(valor) - 1] = '\0';
+
+            t_paquete *grande = crear_paquete();
+            agregar_a_paquete(grande, valor, sizeof(valor));
+            t_paquete *chico = crear_paquete();
+            agregar_a_paquete(chico, "dato", 5);
+
+            enviar_paquete(grande, sockets[0]);
+            enviar_paquete(chico, sockets[0]);
+
+            uint8_t cabecera[TAMANIO_CABECERA_V2];
+            uint8_t payload[1024];
+
+            recv(sockets[1], cabecera, sizeof(cabecera), MSG_WAITALL);
+            int size = cabecera[8] | cabecera[9] << 8;
+            recv(sockets[1], payload, size, MSG_WAITALL);
+            should_int(cabecera[3] & FLAG_COMPRIMIDO) be equal to(FLAG_COMPRIMIDO);
+            should_int(size) be less than(grande->buffer->size);
+            should_int(payload[0] | payload[1] << 8) be equal to(grande->buffer->size);
+
+            recv(sockets[1], cabecera, sizeof(cabecera), MSG_WAITALL);
+            should_int(cabecera[3] & FLAG_COMPRIMIDO) be equal to(0);
+            should_int(cabecera[8]) be equal to(chico->buffer->size);
+
+            eliminar_paquete(grande);
+            eliminar_paquete(chico);
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+    } end
+
+} end
+
+// ========== TESTS PARA ENVÍO COMPLETO Y COLA DE SALIDA ==========
+
+// Bytes que dice haber enviado el envío falso de fragmentos
+#define BYTES_FRAGMENTO_GIGANTE (1 << 30)
+
+static int fragmentos_falsos;
+
+/**
+ * @brief Envío falso que cuenta cada fragmento como 1 GiB enviado
+ */
+static int enviar_fragmento_gigante(t_paquete *fragmento, int socket, void *contexto)
+{
+    (void)fragmento;
+    (void)socket;
+    (void)contexto;
+    fragmentos_falsos++;
+    return BYTES_FRAGMENTO_GIGANTE;
+}
+
+context(test_envio){
+
+    describe("Envío sin truncar datos"){
+
+        it("debería informar los bytes enviados por enviar_mensaje"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+
+            int enviados = enviar_mensaje("Hola", sockets[0]);
+            should_int(enviados) be equal to(2 * sizeof(int) + 5);
+
+            int cabecera[2];
+            char datos[5];
+            recv(sockets[1], cabecera, sizeof(cabecera), MSG_WAITALL);
+            recv(sockets[1], datos, sizeof(datos), MSG_WAITALL);
+            should_int(cabecera[0]) be equal to(MENSAJE);
+            should_int(cabecera[1]) be equal to(5);
+            should_string(datos) be equal to("Hola");
+
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+        it("debería encolar lo que no entra en un socket no bloqueante"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+            fcntl(sockets[0], F_SETFL, O_NONBLOCK);
+
+            // Un paquete más grande que el buffer del socket
+            t_paquete *paquete = crear_paquete();
+            int tamanio = 4 * 1024 * 1024;
+            char *valor = calloc(1, tamanio);
+            agregar_a_paquete(paquete, valor, tamanio);
+
+            t_cola_salida *cola = crear_cola_salida();
+            int escritos = encolar_paquete(paquete, sockets[0], cola);
+            int total = 2 * sizeof(int) + paquete->buffer->size;
+
+            should_int(escritos + (int)pendientes_cola_salida(cola)) be equal to(total);
+            should_bool(pendientes_cola_salida(cola) > 0) be equal to(true);
+
+            // El paquete se puede liberar: la cola tiene su propia copia
+            eliminar_paquete(paquete);
+            free(valor);
+
+            // Leer del otro extremo hasta recibir todo
+            char lectura[65536];
+            int recibidos = 0;
+            while (recibidos < total)
+            {
+                vaciar_cola_salida(cola, sockets[0]);
+                ssize_t leidos = recv(sockets[1], lectura, sizeof(lectura), MSG_DONTWAIT);
+                if (leidos > 0)
+                    recibidos += leidos;
+            }
+
+            should_int(recibidos) be equal to(total);
+            should_int(pendientes_cola_salida(cola)) be equal to(0);
+
+            eliminar_cola_salida(cola);
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+    } end
+
+    describe("Paquetes fragmentados"){
+
+        before{
+            fragmentos_falsos = 0;
+        } end
+
+        after{
+            establecer_protocolo(PROTOCOLO_V1, 0);
+        } end
+
+        it("no debería fragmentar con el protocolo v1"){
+            should_ptr(iniciar_envio_fragmentado(0, PAQUETE, 32)) be equal to(NULL);
+        } end
+
+        it("debería partir un valor grande en frames acotados unidos por flags"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+            establecer_protocolo(PROTOCOLO_V2, 0);
+
+            char valor[50];
+            for (int i = 0; i < (int)sizeof(valor); i++)
+                valor[i] = 'a' + i % 26;
+
+            t_envio_fragmentado *envio = iniciar_envio_fragmentado(sockets[0], PAQUETE, 32);
+            should_ptr(envio) be not equal to(NULL);
+
+            // El valor grande se escribe de a partes, como si viniera de un archivo
+            should_int(comenzar_elemento_fragmentado(envio, sizeof(valor))) be equal to(0);
+            should_int(escribir_elemento_fragmentado(envio, valor, 20)) be equal to(0);
+            should_int(escribir_elemento_fragmentado(envio, valor + 20, 30)) be equal to(0);
+            should_int(agregar_a_envio_fragmentado(envio, "ok", 3)) be equal to(0);
+            int64_t enviados;
+            should_bool(finalizar_envio_fragmentado(envio, &enviados)) be equal to(true);
+
+            uint8_t flags_esperados[] = {
+                FLAG_PAQUETE_SIGUE | FLAG_ELEMENTO_SIGUE,
+                FLAG_PAQUETE_CONTINUADO | FLAG_ELEMENTO_CONTINUADO | FLAG_PAQUETE_SIGUE,
+                FLAG_PAQUETE_CONTINUADO};
+            char reconstruido[sizeof(valor)];
+            int copiados = 0;
+            int recibidos = 0;
+
+            for (int frame = 0; frame < 3; frame++)
+            {
+                uint8_t cabecera[TAMANIO_CABECERA_V2];
+                uint8_t payload[32];
+                recv(sockets[1], cabecera, sizeof(cabecera), MSG_WAITALL);
+                int size = cabecera[8] | cabecera[9] << 8;
+                should_int(size) be less than(33);
+                should_int(cabecera[3]) be equal to(flags_esperados[frame]);
+                recv(sockets[1], payload, size, MSG_WAITALL);
+                recibidos += TAMANIO_CABECERA_V2 + size;
+
+                // Juntar las partes del valor partido (longitudes de 4 bytes)
+                int longitud = payload[0] | payload[1] << 8;
+                if (frame < 2)
+                {
+                    memcpy(reconstruido + copiados, payload + 4, longitud);
+                    copiados += longitud;
+                }
+                else
+                    should_string((char *)payload + 4) be equal to("ok");
+            }
+
+            should_int(copiados) be equal to(sizeof(valor));
+            should_bool(memcmp(reconstruido, valor, sizeof(valor)) == 0) be equal to(true);
+            should_int(enviados) be equal to(recibidos);
+
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+        it("debería fallar al finalizar con un valor incompleto"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+            establecer_protocolo(PROTOCOLO_V2, 0);
+
+            t_envio_fragmentado *envio = iniciar_envio_fragmentado(sockets[0], PAQUETE, 0);
+            comenzar_elemento_fragmentado(envio, 10);
+            escribir_elemento_fragmentado(envio, "12345", 5);
+            should_int(escribir_elemento_fragmentado(envio, "123456", 6)) be equal to(-1);
+            should_bool(finalizar_envio_fragmentado(envio, NULL)) be equal to(false);
+
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+        it("debería contar más de 2 GiB enviados sin desbordar"){
+            establecer_protocolo(PROTOCOLO_V2, 0);
+
+            t_envio_fragmentado *envio = iniciar_envio_fragmentado(-1, PAQUETE, 32);
+            establecer_envio_fragmentado(envio, enviar_fragmento_gigante, NULL);
+            char valor[100] = {0};
+            should_int(agregar_a_envio_fragmentado(envio, valor, sizeof(valor))) be equal to(0);
+
+            int64_t enviados;
+            should_bool(finalizar_envio_fragmentado(envio, &enviados)) be equal to(true);
+            should_bool(fragmentos_falsos >= 3) be equal to(true);
+            should_bool(enviados == (int64_t)fragmentos_falsos * BYTES_FRAGMENTO_GIGANTE) be equal to(true);
+            should_bool(enviados > INT32_MAX) be equal to(true);
+        } end
+
+    } end
+
+} end
+
+// ========== TESTS PARA ENVÍO POR LOTES ==========
+
+context(test_lotes){
+
+    describe("Envío de mensajes por lotes"){
+
+        it("debería enviar varios mensajes juntos al vaciar el lote"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+
+            // Plazo largo: solo se envía al vaciar explícitamente
+            t_lote *lote = crear_lote(sockets[0], 0, 10 * 1000 * 1000);
+            agregar_mensaje_a_lote(lote, "uno");
+            agregar_mensaje_a_lote(lote, "dos");
+            agregar_mensaje_a_lote(lote, "tres");
+
+            char lectura[128];
+            should_int(recv(sockets[1], lectura, sizeof(lectura), MSG_DONTWAIT)) be equal to(-1);
+
+            int esperados = 3 * 2 * sizeof(int) + 4 + 4 + 5;
+            should_int(vaciar_lote(lote)) be equal to(esperados);
+            should_int(recv(sockets[1], lectura, sizeof(lectura), MSG_WAITALL | MSG_DONTWAIT)) be equal to(esperados);
+
+            int cabecera[2];
+            memcpy(cabecera, lectura + 2 * sizeof(int) + 4, sizeof(cabecera));
+            should_int(cabecera[0]) be equal to(MENSAJE);
+            should_int(cabecera[1]) be equal to(4);
+
+            eliminar_lote(lote);
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+        it("debería enviar solo el lote cuando vence el plazo"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+
+            t_lote *lote = crear_lote(sockets[0], 0, 1000);
+            agregar_mensaje_a_lote(lote, "plazo");
+
+            // Esperar bastante más que el plazo de 1 ms
+            usleep(50 * 1000);
+
+            char lectura[64];
+            should_int(recv(sockets[1], lectura, sizeof(lectura), MSG_DONTWAIT)) be equal to(2 * sizeof(int) + 6);
+
+            eliminar_lote(lote);
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+        it("debería rechazar un frame que no entra sin perder lo pendiente"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+
+            t_lote *lote = crear_lote(sockets[0], 0, 10 * 1000 * 1000);
+            agregar_mensaje_a_lote(lote, "uno");
+
+            // El tamaño se rechaza antes de copiar los datos
+            errno = 0;
+            should_int(agregar_frame_a_lote(lote, PAQUETE, "x", INT_MAX)) be equal to(-1);
+            should_int(errno) be equal to(EMSGSIZE);
+
+            // El lote sigue usable y conserva el mensaje anterior
+            should_int(agregar_mensaje_a_lote(lote, "dos")) be equal to(0);
+            should_int(vaciar_lote(lote)) be equal to(2 * 2 * sizeof(int) + 4 + 4);
+
+            eliminar_lote(lote);
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+    } end
+
+} end
+
+// ========== TESTS PARA EL POOL DE CONEXIONES ==========
+
+context(test_pool_conexiones){
+
+    describe("Pool de conexiones persistentes"){
+
+        it("debería reutilizar el socket devuelto y descartar los cerrados"){
+            // Servidor local en un puerto libre
+            int escucha = socket(AF_INET, SOCK_STREAM, 0);
+            struct sockaddr_in direccion = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+            socklen_t largo = sizeof(direccion);
+            bind(escucha, (struct sockaddr *)&direccion, sizeof(direccion));
+            listen(escucha, 8);
+            getsockname(escucha, (struct sockaddr *)&direccion, &largo);
+            char puerto[8];
+            sprintf(puerto, "%d", ntohs(direccion.sin_port));
+
+            t_pool_conexiones *pool = crear_pool_conexiones(0);
+
+            int primera = obtener_conexion(pool, "127.0.0.1", puerto);
+            should_int(primera) be greater than(-1);
+            int aceptada = accept(escucha, NULL, NULL);
+
+            devolver_conexion(pool, "127.0.0.1", puerto, primera);
+            int segunda = obtener_conexion(pool, "127.0.0.1", puerto);
+            should_int(segunda) be equal to(primera);
+            should_bool(conexion_sana(segunda)) be equal to(true);
+
+            // Si el servidor cierra, el socket deja de estar sano
+            close(aceptada);
+            usleep(10 * 1000);
+            should_bool(conexion_sana(segunda)) be equal to(false);
+
+            liberar_conexion(segunda);
+            eliminar_pool_conexiones(pool);
+            close(escucha);
+        } end
+
+    } end
+
+} end
+
+// ========== TESTS PARA EL LECTOR DEL JOURNAL ==========
+
+/**
+ * @brief Escribe un registro de journal como lo hace el servidor
+ *
+ * @param destino Lugar para el registro (alineado a ALINEACION_REGISTRO)
+ * @param cod_op Código de operación
+ * @param flags Flags del frame v2
+ * @param payload Datos del frame
+ * @param size Tamaño del payload
+ * @return int Bytes que ocupa el registro
+ */
+static int escribir_registro_de_prueba(uint8_t *destino, op_code cod_op, uint8_t flags, const void *payload, int size)
+{
+    memset(destino, 0, TAMANIO_CABECERA_REGISTRO);
+    escribir_u32le(destino, size);
+    escribir_u32le(destino + 8, 1000);
+    escribir_u32le(destino + 16, cod_op);
+    destino[20] = PROTOCOLO_V2;
+    destino[21] = flags;
+    destino[22] = 7;
+    memcpy(destino + TAMANIO_CABECERA_REGISTRO, payload, size);
+    escribir_u32le(destino + 4, crc32_registro_journal(0, destino + 8, TAMANIO_CABECERA_REGISTRO - 8 + size));
+    return (TAMANIO_CABECERA_REGISTRO + size + ALINEACION_REGISTRO - 1) & ~(ALINEACION_REGISTRO - 1);
+}
+
+/**
+ * @brief Guarda un segmento de journal en un archivo
+ *
+ * @param ruta Ruta del archivo
+ * @param datos Contenido
+ * @param size Bytes del contenido
+ */
+static void guardar_segmento_de_prueba(const char *ruta, const void *datos, int size)
+{
+    FILE *archivo = fopen(ruta, "wb");
+    fwrite(datos, 1, size, archivo);
+    fclose(archivo);
+}
+
+context(test_lector_journal){
+
+    describe("Lectura de los segmentos del journal"){
+
+        it("debería leer los registros en orden y cortar un segmento en un crc inválido"){
+            char directorio[] = "/tmp/test_lector_journal_XXXXXX";
+            mkdtemp(directorio);
+
+            uint8_t segmento[256] = {'T', 'P', 'J', '1', VERSION_JOURNAL};
+            int size = TAMANIO_CABECERA_SEGMENTO;
+            size += escribir_registro_de_prueba(segmento + size, MENSAJE, 0, "uno", 4);
+            size += escribir_registro_de_prueba(segmento + size, PAQUETE, FLAG_PAQUETE_SIGUE, "\x03dos", 4);
+            int corrupto = size;
+            size += escribir_registro_de_prueba(segmento + size, MENSAJE, 0, "roto", 5);
+            segmento[corrupto + TAMANIO_CABECERA_REGISTRO] = 'R';
+
+            char ruta[PATH_MAX + 32];
+            snprintf(ruta, sizeof(ruta), "%s/00000002%s", directorio, EXTENSION_JOURNAL);
+            guardar_segmento_de_prueba(ruta, segmento, size);
+
+            // El segmento 10 va después del 2 aunque el nombre ordene antes
+            size = TAMANIO_CABECERA_SEGMENTO;
+            size += escribir_registro_de_prueba(segmento + size, MENSAJE, 0, "tres", 5);
+            snprintf(ruta, sizeof(ruta), "%s/10%s", directorio, EXTENSION_JOURNAL);
+            guardar_segmento_de_prueba(ruta, segmento, size);
+
+            t_lector_journal *lector = abrir_lector_journal(directorio);
+            should_ptr(lector) be not equal to(NULL);
+            should_int(lector->cantidad) be equal to(2);
+
+            t_registro_journal registro;
+            should_bool(siguiente_registro_journal(lector, &registro)) be equal to(true);
+            should_int(registro.cod_op) be equal to(MENSAJE);
+            should_string(registro.payload) be equal to("uno");
+            should_int(registro.conexion) be equal to(7);
+
+            should_bool(siguiente_registro_journal(lector, &registro)) be equal to(true);
+            should_int(registro.cod_op) be equal to(PAQUETE);
+            should_int(registro.formato.version) be equal to(PROTOCOLO_V2);
+            should_int(registro.formato.flags) be equal to(FLAG_PAQUETE_SIGUE);
+            should_int(registro.size) be equal to(4);
+
+            should_bool(siguiente_registro_journal(lector, &registro)) be equal to(true);
+            should_string(registro.payload) be equal to("tres");
+            should_int(lector->corruptos) be equal to(1);
+
+            should_bool(siguiente_registro_journal(lector, &registro)) be equal to(false);
+
+            // Al rebobinar se vuelve a leer desde el primero
+            rebobinar_lector_journal(lector);
+            should_bool(siguiente_registro_journal(lector, &registro)) be equal to(true);
+            should_string(registro.payload) be equal to("uno");
+
+            cerrar_lector_journal(lector);
+        } end
+
+        it("debería calcular el CRC-32 estándar"){
+            should_int(crc32_registro_journal(0, "123456789", 9)) be equal to(0xCBF43926);
+        } end
+
+    } end
+
+} end
+
+// ========== TESTS DEL HISTOGRAMA DE LATENCIAS ==========
+
+context(test_histograma){
+
+    describe("Percentiles con precisión relativa fija"){
+
+        it("debería contar exactos los valores chicos"){
+            t_histograma *histograma = crear_histograma();
+            for (uint64_t valor = 1; valor <= 100; valor++)
+                registrar_en_histograma(histograma, valor);
+
+            should_int(histograma->total) be equal to(100);
+            should_int(percentil_histograma(histograma, 50)) be equal to(50);
+            should_int(percentil_histograma(histograma, 99)) be equal to(99);
+            should_int(percentil_histograma(histograma, 100)) be equal to(100);
+            should_int(histograma->minimo) be equal to(1);
+            should_bool(promedio_histograma(histograma) == 50.5) be equal to(true);
+            free(histograma);
+        } end
+
+        it("debería acotar el error relativo en valores grandes"){
+            t_histograma *histograma = crear_histograma();
+            for (uint64_t valor = 1000; valor <= 1000000; valor += 1000)
+                registrar_en_histograma(histograma, valor);
+
+            uint64_t p50 = percentil_histograma(histograma, 50);
+            uint64_t p999 = percentil_histograma(histograma, 99.9);
+            should_bool(p50 >= 500000 && p50 < 500000 * 1.016) be equal to(true);
+            should_bool(p999 >= 999000 && p999 <= 1000000) be equal to(true);
+            should_int(percentil_histograma(histograma, 100)) be equal to(1000000);
+            free(histograma);
+        } end
+
+        it("debería sumar los conteos de varios histogramas"){
+            t_histograma *total = crear_histograma();
+            t_histograma *rapido = crear_histograma();
+            t_histograma *lento = crear_histograma();
+            for (int i = 0; i < 99; i++)
+                registrar_en_histograma(rapido, 10);
+            registrar_en_histograma(lento, 5000000000ULL);
+
+            sumar_histograma(total, rapido);
+            sumar_histograma(total, lento);
+
+            should_int(total->total) be equal to(100);
+            should_int(percentil_histograma(total, 99)) be equal to(10);
+            should_bool(percentil_histograma(total, 100) == 5000000000ULL) be equal to(true);
+            should_int(total->minimo) be equal to(10);
+            free(total);
+            free(rapido);
+            free(lento);
+        } end
+
+        it("debería devolver cero si está vacío"){
+            t_histograma *histograma = crear_histograma();
+            should_int(percentil_histograma(histograma, 99)) be equal to(0);
+            should_bool(promedio_histograma(histograma) == 0) be equal to(true);
+            free(histograma);
+        } end
+
+    } end
+
+} end
+
+// ========== TESTS PARA SOLICITUDES CONFIRMADAS ==========
+
+// Confirmaciones recibidas por el callback de prueba
+static uint32_t solicitudes_confirmadas[8];
+static int cantidad_confirmadas;
+
+static void al_confirmar_de_prueba(uint32_t solicitud, uint8_t estado, uint64_t latencia_ns, void *contexto)
+{
+    (void)estado;
+    (void)latencia_ns;
+    (void)contexto;
+    solicitudes_confirmadas[cantidad_confirmadas++] = solicitud;
+}
+
+/**
+ * @brief Escribe en el socket un ACK con las confirmaciones dadas, como el servidor
+ */
+static void responder_ack(int socket, uint32_t *ids, uint8_t *estados, int cantidad)
+{
+    uint8_t ack[TAMANIO_CABECERA_V2 + 8 * BYTES_CONFIRMACION] = {
+        MAGIA_PROTOCOLO_0, MAGIA_PROTOCOLO_1, PROTOCOLO_V2, 0, ACK, 0, 0, 0, cantidad * BYTES_CONFIRMACION, 0, 0, 0};
+    for (int i = 0; i < cantidad; i++)
+    {
+        uint8_t *entrada = ack + TAMANIO_CABECERA_V2 + i * BYTES_CONFIRMACION;
+        entrada[0] = ids[i];
+        entrada[1] = ids[i] >> 8;
+        entrada[2] = ids[i] >> 16;
+        entrada[3] = ids[i] >> 24;
+        entrada[4] = estados[i];
+    }
+    send(socket, ack, TAMANIO_CABECERA_V2 + cantidad * BYTES_CONFIRMACION, 0);
+}
+
+context(test_solicitudes){
+
+    describe("Ventana de solicitudes en vuelo"){
+
+        before{
+            cantidad_confirmadas = 0;
+        } end
+
+        after{
+            establecer_protocolo(PROTOCOLO_V1, 0);
+        } end
+
+        it("no debería enviar solicitudes con el protocolo v1"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+
+            should_int(enviar_mensaje_solicitud("Hola", sockets[0], 1)) be equal to(-1);
+
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+        it("debería enviar el ID de la solicitud después de la cabecera"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+            establecer_protocolo(PROTOCOLO_V2, 0);
+
+            should_int(enviar_mensaje_solicitud("Hola", sockets[0], 258)) be equal to(TAMANIO_CABECERA_V2 + BYTES_ID_SOLICITUD + 5);
+
+            uint8_t frame[TAMANIO_CABECERA_V2 + BYTES_ID_SOLICITUD + 5];
+            recv(sockets[1], frame, sizeof(frame), MSG_WAITALL);
+            should_int(frame[3] & FLAG_SOLICITUD) be equal to(FLAG_SOLICITUD);
+            should_int(frame[8]) be equal to(BYTES_ID_SOLICITUD + 5);
+            should_int(frame[TAMANIO_CABECERA_V2]) be equal to(2);
+            should_int(frame[TAMANIO_CABECERA_V2 + 1]) be equal to(1);
+            should_string((char *)frame + TAMANIO_CABECERA_V2 + BYTES_ID_SOLICITUD) be equal to("Hola");
+
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+        it("debería liberar la ventana con las confirmaciones del servidor"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+            establecer_protocolo(PROTOCOLO_V2, 0);
+
+            t_solicitudes *solicitudes = crear_solicitudes(sockets[0], 2, al_confirmar_de_prueba, NULL);
+            uint32_t primera, segunda;
+            should_bool(solicitar_mensaje(solicitudes, "uno", &primera) > 0) be equal to(true);
+            should_bool(solicitar_mensaje(solicitudes, "dos", &segunda) > 0) be equal to(true);
+            should_int(solicitudes->en_vuelo) be equal to(2);
+            should_int(recibir_confirmaciones(solicitudes, false)) be equal to(0);
+
+            // Un ID que no está en vuelo se ignora
+            uint32_t ids[] = {segunda, 99, primera};
+            uint8_t estados[] = {CONFIRMACION_RECHAZADA, CONFIRMACION_PROCESADA, CONFIRMACION_PROCESADA};
+            responder_ack(sockets[1], ids, estados, 3);
+
+            should_int(recibir_confirmaciones(solicitudes, true)) be equal to(2);
+            should_int(solicitudes->en_vuelo) be equal to(0);
+            should_int(solicitudes->procesadas) be equal to(1);
+            should_int(solicitudes->rechazadas) be equal to(1);
+            should_int(cantidad_confirmadas) be equal to(2);
+            should_int(solicitudes_confirmadas[0]) be equal to(segunda);
+            should_int(solicitudes_confirmadas[1]) be equal to(primera);
+            should_bool(esperar_solicitudes(solicitudes)) be equal to(true);
+
+            eliminar_solicitudes(solicitudes);
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+        it("debería fallar si el servidor responde algo que no es un ACK"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+            establecer_protocolo(PROTOCOLO_V2, 0);
+
+            t_solicitudes *solicitudes = crear_solicitudes(sockets[0], 1, NULL, NULL);
+            should_bool(solicitar_mensaje(solicitudes, "uno", NULL) > 0) be equal to(true);
+            send(sockets[1], "basura basura", 13, 0);
+
+            should_int(recibir_confirmaciones(solicitudes, true)) be equal to(-1);
+
+            // Si el servidor cierra, la solicitud nunca se confirma
+            close(sockets[1]);
+            should_bool(esperar_solicitudes(solicitudes)) be equal to(false);
+
+            eliminar_solicitudes(solicitudes);
+            close(sockets[0]);
+        } end
+
+    } end
+
+} end
+
+/**
+ * @brief Escribe en el socket un frame CREDITO con los bytes dados, como el servidor
+ */
+static void responder_credito(int socket, uint32_t bytes)
+{
+    uint8_t frame[TAMANIO_CABECERA_V2 + BYTES_CREDITO] = {
+        MAGIA_PROTOCOLO_0, MAGIA_PROTOCOLO_1, PROTOCOLO_V2, 0, CREDITO, 0, 0, 0, BYTES_CREDITO, 0, 0, 0,
+        bytes, bytes >> 8, bytes >> 16, bytes >> 24};
+    send(socket, frame, sizeof(frame), 0);
+}
+
+context(test_control_flujo_cliente){
+
+    describe("Crédito otorgado por el servidor"){
+
+        after{
+            establecer_protocolo(PROTOCOLO_V1, 0);
+        } end
+
+        it("no debería pedir crédito con el protocolo v1"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+
+            should_int(enviar_pedido_credito(sockets[0])) be equal to(-1);
+
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+        it("debería pedir crédito y descontar lo enviado"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+            establecer_protocolo(PROTOCOLO_V2, 0);
+            responder_credito(sockets[1], 100);
+
+            t_solicitudes *solicitudes = crear_solicitudes(sockets[0], 1, NULL, NULL);
+            should_bool(habilitar_control_flujo(solicitudes)) be equal to(true);
+            should_bool(solicitudes->control_flujo) be equal to(true);
+            should_int(solicitudes->credito) be equal to(100);
+
+            uint8_t pedido[TAMANIO_CABECERA_V2];
+            should_int(recv(sockets[1], pedido, sizeof(pedido), MSG_DONTWAIT)) be equal to(TAMANIO_CABECERA_V2);
+            should_int(pedido[4]) be equal to(CREDITO);
+            should_int(pedido[8]) be equal to(0);
+
+            // Se puede pasar del crédito con un envío, pero después hay que esperar
+            descontar_credito(solicitudes, 150);
+            should_int(solicitudes->credito) be equal to(-50);
+            responder_credito(sockets[1], 80);
+            should_bool(esperar_credito(solicitudes)) be equal to(true);
+            should_int(solicitudes->credito) be equal to(30);
+
+            eliminar_solicitudes(solicitudes);
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+        it("debería dejar de contar si el servidor otorga crédito ilimitado"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+            establecer_protocolo(PROTOCOLO_V2, 0);
+            responder_credito(sockets[1], CREDITO_ILIMITADO);
+
+            t_solicitudes *solicitudes = crear_solicitudes(sockets[0], 1, NULL, NULL);
+            should_bool(habilitar_control_flujo(solicitudes)) be equal to(true);
+            should_bool(solicitudes->control_flujo) be equal to(false);
+            descontar_credito(solicitudes, 1000);
+            should_bool(esperar_credito(solicitudes)) be equal to(true);
+
+            eliminar_solicitudes(solicitudes);
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+        it("debería fallar la espera si el servidor cierra sin otorgar crédito"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+            establecer_protocolo(PROTOCOLO_V2, 0);
+            responder_credito(sockets[1], 10);
+
+            t_solicitudes *solicitudes = crear_solicitudes(sockets[0], 1, NULL, NULL);
+            should_bool(habilitar_control_flujo(solicitudes)) be equal to(true);
+            descontar_credito(solicitudes, 10);
+            close(sockets[1]);
+            should_bool(esperar_credito(solicitudes)) be equal to(false);
+
+            eliminar_solicitudes(solicitudes);
+            close(sockets[0]);
+        } end
+
+    } end
+
+} end
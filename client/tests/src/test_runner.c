@@ -19,6 +19,14 @@ extern context(test_configuracion);
 extern context(test_logging);
 extern context(test_mensajes);
 extern context(test_auxiliares);
+extern context(test_capacidad_paquetes);
+extern context(test_envio);
+extern context(test_lotes);
+extern context(test_pool_conexiones);
+extern context(test_lector_journal);
+extern context(test_histograma);
+extern context(test_solicitudes);
+extern context(test_control_flujo_cliente);
 
 // Tests del servidor
 extern context(test_server_logging);
@@ -26,6 +34,17 @@ extern context(test_server_data_handling);
 extern context(test_operation_codes);
 extern context(test_buffer_simulation);
 extern context(test_constants);
+extern context(test_deserializacion_paquete);
+extern context(test_decodificador);
+extern context(test_vista_paquete);
+extern context(test_log_async);
+extern context(test_planificador);
+extern context(test_operaciones);
+extern context(test_journal);
+extern context(test_metricas);
+extern context(test_confirmaciones);
+extern context(test_control_flujo);
+extern context(test_uring);
 
 /**
  * @brief Función principal del runner de tests
@@ -63,6 +82,30 @@ int main()
     printf("\n🧹 Ejecutando tests auxiliares...\n");
     cspec_run_context(test_auxiliares, "", "");
 
+    printf("\n📈 Ejecutando tests de capacidad de paquetes...\n");
+    cspec_run_context(test_capacidad_paquetes, "", "");
+
+    printf("\n📤 Ejecutando tests de envío...\n");
+    cspec_run_context(test_envio, "", "");
+
+    printf("\n📬 Ejecutando tests de envío por lotes...\n");
+    cspec_run_context(test_lotes, "", "");
+
+    printf("\n🔌 Ejecutando tests del pool de conexiones...\n");
+    cspec_run_context(test_pool_conexiones, "", "");
+
+    printf("\n⏪ Ejecutando tests del lector del journal...\n");
+    cspec_run_context(test_lector_journal, "", "");
+
+    printf("\n📊 Ejecutando tests del histograma de latencias...\n");
+    cspec_run_context(test_histograma, "", "");
+
+    printf("\n📨 Ejecutando tests de solicitudes confirmadas...\n");
+    cspec_run_context(test_solicitudes, "", "");
+
+    printf("\n🚦 Ejecutando tests de control de flujo del cliente...\n");
+    cspec_run_context(test_control_flujo_cliente, "", "");
+
     // ========== EJECUTAR TESTS DEL SERVIDOR ==========
 
     printf("\n");
@@ -84,6 +127,39 @@ int main()
     printf("\n🔧 Ejecutando tests de constantes...\n");
     cspec_run_context(test_constants, "", "");
 
+    printf("\n📦 Ejecutando tests de deserialización de paquetes...\n");
+    cspec_run_context(test_deserializacion_paquete, "", "");
+
+    printf("\n🧩 Ejecutando tests del decodificador de frames...\n");
+    cspec_run_context(test_decodificador, "", "");
+
+    printf("\n🔍 Ejecutando tests de vista de paquetes...\n");
+    cspec_run_context(test_vista_paquete, "", "");
+
+    printf("\n🗒️  Ejecutando tests de logging asíncrono...\n");
+    cspec_run_context(test_log_async, "", "");
+
+    printf("\n🧵 Ejecutando tests del pool de manejadores...\n");
+    cspec_run_context(test_planificador, "", "");
+
+    printf("\n🗂️  Ejecutando tests del registro de operaciones...\n");
+    cspec_run_context(test_operaciones, "", "");
+
+    printf("\n💾 Ejecutando tests del journal binario...\n");
+    cspec_run_context(test_journal, "", "");
+
+    printf("\n📈 Ejecutando tests de métricas...\n");
+    cspec_run_context(test_metricas, "", "");
+
+    printf("\n✅ Ejecutando tests de confirmaciones...\n");
+    cspec_run_context(test_confirmaciones, "", "");
+
+    printf("\n🚦 Ejecutando tests de control de flujo...\n");
+    cspec_run_context(test_control_flujo, "", "");
+
+    printf("\n💍 Ejecutando tests de io_uring...\n");
+    cspec_run_context(test_uring, "", "");
+
     // ========== MOSTRAR RESUMEN FINAL ==========
 
     printf("\n");
@@ -5,11 +5,19 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <netdb.h>
 
 // Incluir los headers del servidor
 #include "../../server/src/utils.h"
 #include "../../server/src/server.h"
+#include "../../server/src/log_async.h"
+#include "../../server/src/planificador.h"
+#include "../../server/src/operaciones.h"
+#include "../../server/src/journal.h"
+#include "../../server/src/metricas.h"
+#include "../../server/src/confirmaciones.h"
+#include "../../server/src/uring.h"
 
 /**
  * @file test_server_utils.c
@@ -298,3 +306,1169 @@ end
 end
 }
 end
+
+// ========== TESTS PARA DESERIALIZACIÓN DE PAQUETES ==========
+
+context(test_deserializacion_paquete){
+
+    describe("Deserialización de buffers de paquete"){
+
+        it("debería devolver una copia de cada elemento del buffer"){
+            char buffer[64];
+            int offset = 0;
+            char *valores[] = {"Hola", "Mundo"};
+
+            for (int i = 0; i < 2; i++)
+            {
+                int tamanio = strlen(valores[i]) + 1;
+                memcpy(buffer + offset, &tamanio, sizeof(int));
+                offset += sizeof(int);
+                memcpy(buffer + offset, valores[i], tamanio);
+                offset += tamanio;
+            }
+
+            t_list *lista = deserializar_paquete(buffer, offset);
+
+            should_int(list_size(lista)) be equal to(2);
+            should_string((char *)list_get(lista, 0)) be equal to("Hola");
+            should_string((char *)list_get(lista, 1)) be equal to("Mundo");
+
+            list_destroy_and_destroy_elements(lista, free);
+        } end
+
+        it("debería descartar elementos con tamaño fuera del buffer"){
+            char buffer[16];
+            int tamanio = 1000;
+            memcpy(buffer, &tamanio, sizeof(int));
+
+            t_list *lista = deserializar_paquete(buffer, sizeof(buffer));
+
+            should_int(list_size(lista)) be equal to(0);
+
+            list_destroy(lista);
+        } end
+
+    } end
+
+} end
+
+// ========== TESTS PARA EL DECODIFICADOR DE FRAMES ==========
+
+context(test_decodificador){
+
+    describe("Decodificación incremental de frames"){
+
+        it("debería extraer varios frames de una sola lectura y esperar al incompleto"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+
+            // Dos frames MENSAJE completos y la cabecera de un tercero
+            char datos[64];
+            int offset = 0;
+            int cabecera[2];
+            char *mensajes[] = {"uno", "dos"};
+            for (int i = 0; i < 2; i++)
+            {
+                cabecera[0] = MENSAJE;
+                cabecera[1] = strlen(mensajes[i]) + 1;
+                memcpy(datos + offset, cabecera, sizeof(cabecera));
+                offset += sizeof(cabecera);
+                memcpy(datos + offset, mensajes[i], cabecera[1]);
+                offset += cabecera[1];
+            }
+            cabecera[0] = PAQUETE;
+            cabecera[1] = 4;
+            memcpy(datos + offset, cabecera, sizeof(cabecera));
+            offset += sizeof(cabecera);
+            send(sockets[1], datos, offset, 0);
+
+            t_decodificador *decodificador = decodificador_crear(0);
+            t_frame frame;
+
+            should_int(decodificador_leer(decodificador, sockets[0])) be equal to(offset);
+            should_int(decodificador_siguiente(decodificador, &frame)) be equal to(1);
+            should_string((char *)frame.payload) be equal to("uno");
+            should_int(decodificador_siguiente(decodificador, &frame)) be equal to(1);
+            should_string((char *)frame.payload) be equal to("dos");
+            should_int(decodificador_siguiente(decodificador, &frame)) be equal to(0);
+
+            // Completar el tercer frame
+            send(sockets[1], "abc", 4, 0);
+            should_int(decodificador_recibir_frame(decodificador, sockets[0], &frame)) be equal to(1);
+            should_int(frame.cod_op) be equal to(PAQUETE);
+            should_int(frame.size) be equal to(4);
+
+            decodificador_destruir(decodificador);
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+        it("debería rechazar frames con tamaño negativo"){
+            t_decodificador *decodificador = decodificador_crear(0);
+            int cabecera[2] = {MENSAJE, -1};
+            t_frame frame;
+
+            memcpy(decodificador->buffer, cabecera, sizeof(cabecera));
+            decodificador->fin = sizeof(cabecera);
+
+            should_int(decodificador_siguiente(decodificador, &frame)) be equal to(-1);
+
+            decodificador_destruir(decodificador);
+        } end
+
+        it("debería detectar un frame v2 y leer su cabecera little-endian"){
+            // ['T']['P'][v2][flags=varint][cod_op=1][size=6] y un paquete {"hola"}
+            uint8_t datos[] = {'T', 'P', PROTOCOLO_V2, FLAG_LONGITUDES_VARINT,
+                               1, 0, 0, 0, 6, 0, 0, 0,
+                               5, 'h', 'o', 'l', 'a', '\0'};
+            t_decodificador *decodificador = decodificador_crear(0);
+            t_frame frame;
+
+            memcpy(decodificador->buffer, datos, sizeof(datos));
+            decodificador->fin = sizeof(datos);
+
+            should_int(decodificador_siguiente(decodificador, &frame)) be equal to(1);
+            should_int(frame.cod_op) be equal to(PAQUETE);
+            should_int(frame.size) be equal to(6);
+            should_int(frame.formato.version) be equal to(PROTOCOLO_V2);
+            should_int(frame.formato.flags) be equal to(FLAG_LONGITUDES_VARINT);
+
+            t_list *valores = deserializar_paquete_formato(frame.payload, frame.size, frame.formato);
+            should_int(list_size(valores)) be equal to(1);
+            should_string(list_get(valores, 0)) be equal to("hola");
+            list_destroy_and_destroy_elements(valores, free);
+
+            decodificador_destruir(decodificador);
+        } end
+
+        it("debería descomprimir un frame con FLAG_COMPRIMIDO"){
+            // Paquete {"abababababab"} (14 bytes) comprimido: literales "\x0D" "ab",
+            // match de 10 bytes a distancia 2 y el '\0' final como literal
+            uint8_t datos[] = {'T', 'P', PROTOCOLO_V2, FLAG_LONGITUDES_VARINT | FLAG_COMPRIMIDO,
+                               1, 0, 0, 0, 12, 0, 0, 0,
+                               14, 0, 0, 0,
+                               0x36, 13, 'a', 'b', 2, 0,
+                               0x10, '\0'};
+            t_decodificador *decodificador = decodificador_crear(0);
+            t_frame frame;
+
+            memcpy(decodificador->buffer, datos, sizeof(datos));
+            decodificador->fin = sizeof(datos);
+
+            should_int(decodificador_siguiente(decodificador, &frame)) be equal to(1);
+            should_int(frame.size) be equal to(14);
+            should_int(frame.formato.flags) be equal to(FLAG_LONGITUDES_VARINT);
+
+            t_list *valores = deserializar_paquete_formato(frame.payload, frame.size, frame.formato);
+            should_int(list_size(valores)) be equal to(1);
+            should_string(list_get(valores, 0)) be equal to("abababababab");
+            list_destroy_and_destroy_elements(valores, free);
+
+            decodificador_destruir(decodificador);
+        } end
+
+        it("debería rechazar un bloque comprimido con un offset fuera del buffer"){
+            uint8_t payload[] = {14, 0, 0, 0, 0x36, 13, 'a', 'b', 9, 0, 0x10, '\0'};
+            char destino[14];
+
+            should_int(tamanio_original_comprimido(payload, sizeof(payload))) be equal to(14);
+            should_bool(descomprimir_payload(payload, sizeof(payload), destino)) be equal to(false);
+        } end
+
+        it("debería rechazar un frame más grande que el máximo configurado"){
+            // Cabecera v2 de un frame de 64 bytes con un máximo de 32
+            uint8_t datos[] = {'T', 'P', PROTOCOLO_V2, 0, 1, 0, 0, 0, 64, 0, 0, 0};
+            t_decodificador *decodificador = decodificador_crear(0);
+            t_frame frame;
+
+            establecer_tamanio_maximo_frame(32);
+            memcpy(decodificador->buffer, datos, sizeof(datos));
+            decodificador->fin = sizeof(datos);
+
+            should_int(decodificador_siguiente(decodificador, &frame)) be equal to(-1);
+
+            establecer_tamanio_maximo_frame(0);
+            should_int(tamanio_maximo_frame()) be equal to(TAMANIO_MAXIMO_FRAME);
+            decodificador_destruir(decodificador);
+        } end
+
+        it("debería rechazar una versión desconocida"){
+            uint8_t datos[] = {'T', 'P', 9, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+            t_decodificador *decodificador = decodificador_crear(0);
+            t_frame frame;
+
+            memcpy(decodificador->buffer, datos, sizeof(datos));
+            decodificador->fin = sizeof(datos);
+
+            should_int(decodificador_siguiente(decodificador, &frame)) be equal to(-1);
+
+            decodificador_destruir(decodificador);
+        } end
+
+    } end
+
+} end
+
+// ========== TESTS PARA LA VISTA DE PAQUETES ==========
+
+context(test_vista_paquete){
+
+    describe("Vista de paquetes sin copias"){
+
+        it("debería ubicar cada elemento dentro del buffer recibido"){
+            char buffer[64];
+            int offset = 0;
+            char *valores[] = {"Hola", "Mundo", "!"};
+
+            for (int i = 0; i < 3; i++)
+            {
+                int tamanio = strlen(valores[i]) + 1;
+                memcpy(buffer + offset, &tamanio, sizeof(int));
+                offset += sizeof(int);
+                memcpy(buffer + offset, valores[i], tamanio);
+                offset += tamanio;
+            }
+
+            t_vista_paquete *vista = crear_vista_paquete();
+
+            should_bool(parsear_vista_paquete(vista, buffer, offset)) be equal to(true);
+            should_int(vista->cantidad) be equal to(3);
+
+            int longitud;
+            char *elemento = elemento_vista_paquete(vista, 1, &longitud);
+            should_int(longitud) be equal to(6);
+            should_string(elemento) be equal to("Mundo");
+
+            // El elemento apunta al buffer original, no a una copia
+            should_bool(elemento > buffer && elemento < buffer + offset) be equal to(true);
+
+            eliminar_vista_paquete(vista);
+        } end
+
+        it("debería indicar qué elementos están partidos entre fragmentos"){
+            // Fragmento del medio: termina un valor, trae uno entero y empieza otro
+            uint8_t buffer[] = {2, 'a', 'b', 3, 'c', 'd', '\0', 1, 'e'};
+            t_formato formato = {.version = PROTOCOLO_V2,
+                                 .flags = FLAG_LONGITUDES_VARINT | FLAG_PAQUETE_CONTINUADO | FLAG_PAQUETE_SIGUE |
+                                          FLAG_ELEMENTO_CONTINUADO | FLAG_ELEMENTO_SIGUE};
+
+            t_vista_paquete *vista = crear_vista_paquete();
+
+            should_bool(parsear_vista_paquete_formato(vista, buffer, sizeof(buffer), formato)) be equal to(true);
+            should_int(vista->cantidad) be equal to(3);
+
+            t_fragmento_elemento primero = fragmento_vista_paquete(vista, 0);
+            should_bool(primero.comienza) be equal to(false);
+            should_bool(primero.termina) be equal to(true);
+            should_int(primero.longitud) be equal to(2);
+
+            t_fragmento_elemento medio = fragmento_vista_paquete(vista, 1);
+            should_bool(medio.comienza && medio.termina) be equal to(true);
+            should_string(medio.datos) be equal to("cd");
+
+            t_fragmento_elemento ultimo = fragmento_vista_paquete(vista, 2);
+            should_bool(ultimo.comienza) be equal to(true);
+            should_bool(ultimo.termina) be equal to(false);
+
+            eliminar_vista_paquete(vista);
+        } end
+
+        it("debería rechazar buffers con tamaños corruptos"){
+            char buffer[8];
+            int tamanio = 100;
+            memcpy(buffer, &tamanio, sizeof(int));
+
+            t_vista_paquete *vista = crear_vista_paquete();
+
+            should_bool(parsear_vista_paquete(vista, buffer, sizeof(buffer))) be equal to(false);
+
+            eliminar_vista_paquete(vista);
+        } end
+
+    } end
+
+} end
+
+// ========== TESTS PARA EL LOGGING ASÍNCRONO ==========
+
+/**
+ * @brief Loguea sin parar hasta que se le indique, para finalizar con productores activos
+ */
+static void *loguear_en_otro_hilo(void *argumento)
+{
+    atomic_bool *seguir = argumento;
+    while (atomic_load(seguir))
+        log_async(LOG_LEVEL_DEBUG, "Concurrente %.*s", "x", 1);
+    return NULL;
+}
+
+context(test_log_async){
+
+    describe("Logging asíncrono del servidor"){
+
+        before{
+            logger = log_create("test_log_async.log", "Test_Servidor", 0, LOG_LEVEL_DEBUG);
+        } end
+
+        after{
+            log_destroy(logger);
+            logger = NULL;
+            unlink("test_log_async.log");
+        } end
+
+        it("debería escribir todos los mensajes encolados al finalizar"){
+            should_bool(iniciar_log_async(64, LOG_ASYNC_BLOQUEAR)) be equal to(true);
+
+            char texto[32];
+            for (int i = 0; i < 1000; i++)
+            {
+                int longitud = sprintf(texto, "Mensaje async %d", i);
+                log_async(LOG_LEVEL_INFO, "%.*s", texto, longitud);
+            }
+            finalizar_log_async();
+
+            FILE *archivo = fopen("test_log_async.log", "r");
+            char *linea = NULL;
+            size_t tamanio = 0;
+            int lineas = 0;
+            while (getline(&linea, &tamanio, archivo) != -1)
+                if (strstr(linea, "Mensaje async") != NULL)
+                    lineas++;
+            free(linea);
+            fclose(archivo);
+
+            should_int(lineas) be equal to(1000);
+        } end
+
+        it("debería escribir completo un texto más largo que una entrada"){
+            should_bool(iniciar_log_async(64, LOG_ASYNC_BLOQUEAR)) be equal to(true);
+
+            char texto[1000];
+            for (int i = 0; i < (int)sizeof(texto); i++)
+                texto[i] = 'a' + i % 26;
+            log_async(LOG_LEVEL_INFO, "Largo: %.*s", texto, sizeof(texto));
+            log_async(LOG_LEVEL_INFO, "%.*s", "Siguiente", 9);
+            finalizar_log_async();
+
+            FILE *archivo = fopen("test_log_async.log", "r");
+            char *linea = NULL;
+            size_t tamanio = 0;
+            bool completo = false;
+            bool siguiente = false;
+            while (getline(&linea, &tamanio, archivo) != -1)
+            {
+                char *largo = strstr(linea, "Largo: ");
+                if (largo != NULL)
+                    completo = strncmp(largo + 7, texto, sizeof(texto)) == 0 && largo[7 + sizeof(texto)] == '\n';
+                else if (strstr(linea, "Siguiente") != NULL)
+                    siguiente = completo;
+            }
+            free(linea);
+            fclose(archivo);
+
+            should_bool(completo) be equal to(true);
+            should_bool(siguiente) be equal to(true);
+        } end
+
+        it("debería finalizar mientras otros hilos siguen logueando"){
+            should_bool(iniciar_log_async(16, LOG_ASYNC_BLOQUEAR)) be equal to(true);
+
+            atomic_bool seguir = true;
+            pthread_t hilos[4];
+            for (int i = 0; i < 4; i++)
+                pthread_create(&hilos[i], NULL, loguear_en_otro_hilo, &seguir);
+
+            usleep(20 * 1000);
+            finalizar_log_async();
+
+            // Los que llegan después escriben en el momento, sin tocar el anillo liberado
+            usleep(5 * 1000);
+            atomic_store(&seguir, false);
+            for (int i = 0; i < 4; i++)
+                pthread_join(hilos[i], NULL);
+
+            should_bool(iniciar_log_async(16, LOG_ASYNC_BLOQUEAR)) be equal to(true);
+            finalizar_log_async();
+        } end
+
+        it("debería loguear en línea si no está iniciado"){
+            log_async(LOG_LEVEL_INFO, "Sin hilo: %.*s", "ok", 2);
+
+            struct stat info;
+            stat("test_log_async.log", &info);
+            should_bool(info.st_size > 0) be equal to(true);
+        } end
+
+        it("debería interpretar la política de configuración"){
+            should_int(politica_log_desde_texto("BLOQUEAR")) be equal to(LOG_ASYNC_BLOQUEAR);
+            should_int(politica_log_desde_texto("DESCARTAR")) be equal to(LOG_ASYNC_DESCARTAR);
+            should_int(politica_log_desde_texto(NULL)) be equal to(LOG_ASYNC_DESCARTAR);
+        } end
+
+    } end
+
+} end
+
+// ========== TESTS PARA EL POOL DE MANEJADORES ==========
+
+// Último valor procesado por conexión y frames fuera de orden
+static int ultimo_valor[4];
+static atomic_int frames_procesados;
+static atomic_int frames_desordenados;
+
+static void manejador_lento(int socket_cliente, t_frame *frame)
+{
+    usleep(1000);
+    atomic_fetch_add(&frames_procesados, 1);
+}
+
+// Mientras sea false, manejador_bloqueado no vuelve
+static atomic_bool liberar_manejador;
+
+static void manejador_bloqueado(int socket_cliente, t_frame *frame)
+{
+    while (!atomic_load(&liberar_manejador))
+        usleep(1000);
+}
+
+// Espera a que el pool termine de atender un buzón (y devuelva sus frames)
+static void esperar_buzon_atendido(t_buzon *buzon)
+{
+    bool programado = true;
+    while (programado)
+    {
+        usleep(1000);
+        pthread_mutex_lock(&buzon->mutex);
+        programado = buzon->programado;
+        pthread_mutex_unlock(&buzon->mutex);
+    }
+}
+
+static void manejador_de_prueba(int socket_cliente, t_frame *frame)
+{
+    int valor;
+    memcpy(&valor, frame->payload, sizeof(int));
+    if (valor != ultimo_valor[socket_cliente] + 1)
+        atomic_fetch_add(&frames_desordenados, 1);
+    ultimo_valor[socket_cliente] = valor;
+    atomic_fetch_add(&frames_procesados, 1);
+}
+
+context(test_planificador){
+
+    describe("Pool de manejadores con robo de trabajo"){
+
+        before{
+            logger = log_create("test_planificador.log", "Test_Servidor", 0, LOG_LEVEL_DEBUG);
+        } end
+
+        after{
+            log_destroy(logger);
+            logger = NULL;
+            unlink("test_planificador.log");
+        } end
+
+        it("debería procesar todos los frames respetando el orden de cada conexión"){
+            t_planificador *planificador = planificador_crear(3, manejador_de_prueba);
+            should_ptr(planificador) be not equal to(NULL);
+
+            t_buzon *buzones[4];
+            for (int i = 0; i < 4; i++)
+                buzones[i] = buzon_crear(i);
+
+            for (int valor = 1; valor <= 5000; valor++)
+            {
+                t_frame frame = {.cod_op = MENSAJE, .size = sizeof(int), .payload = &valor, .formato = FORMATO_V1};
+                for (int i = 0; i < 4; i++)
+                    planificador_encolar(planificador, buzones[i], &frame);
+            }
+
+            // Cerrar los buzones con frames pendientes: se procesan igual
+            for (int i = 0; i < 4; i++)
+                buzon_cerrar(buzones[i]);
+            planificador_destruir(planificador);
+
+            should_int(atomic_load(&frames_procesados)) be equal to(4 * 5000);
+            should_int(atomic_load(&frames_desordenados)) be equal to(0);
+        } end
+
+        it("debería reutilizar los frames que ya procesó el pool"){
+            t_planificador *planificador = planificador_crear(1, manejador_lento);
+            t_buzon *buzon = buzon_crear(0);
+
+            int valor = 0;
+            t_frame frame = {.cod_op = MENSAJE, .size = sizeof(int), .payload = &valor, .formato = FORMATO_V1};
+            planificador_encolar(planificador, buzon, &frame);
+            esperar_buzon_atendido(buzon);
+            t_frame_pendiente *primero = buzon->libres;
+            should_ptr(primero) be not equal to(NULL);
+
+            // El reactor se lleva los libres a su reserva y copia los frames siguientes ahí
+            for (int i = 0; i < 3; i++)
+            {
+                planificador_encolar(planificador, buzon, &frame);
+                esperar_buzon_atendido(buzon);
+                should_ptr(buzon->libres) be equal to(primero);
+                should_ptr(buzon->reserva) be equal to(NULL);
+            }
+
+            buzon_cerrar(buzon);
+            planificador_destruir(planificador);
+        } end
+
+        it("debería descartar lo pendiente cuando vence el plazo de drenado"){
+            atomic_store(&frames_procesados, 0);
+            t_planificador *planificador = planificador_crear(1, manejador_lento);
+            t_buzon *buzon = buzon_crear(0);
+
+            int valor = 0;
+            t_frame frame = {.cod_op = MENSAJE, .size = sizeof(int), .payload = &valor, .formato = FORMATO_V1};
+            for (int i = 0; i < 1000; i++)
+                planificador_encolar(planificador, buzon, &frame);
+            buzon_cerrar(buzon);
+
+            // 1000 frames de 1 ms no entran en 50 ms
+            should_bool(planificador_drenar(planificador, 50)) be equal to(false);
+            should_int(atomic_load(&frames_procesados)) be less than(1000);
+        } end
+
+        it("debería abandonar los hilos que no terminan después del plazo"){
+            atomic_store(&liberar_manejador, false);
+            t_planificador *planificador = planificador_crear(2, manejador_bloqueado);
+            t_buzon *buzon = buzon_crear(0);
+
+            int valor = 0;
+            t_frame frame = {.cod_op = MENSAJE, .size = sizeof(int), .payload = &valor, .formato = FORMATO_V1};
+            planificador_encolar(planificador, buzon, &frame);
+            buzon_cerrar(buzon);
+            usleep(10 * 1000);
+
+            struct timespec antes, despues;
+            clock_gettime(CLOCK_MONOTONIC, &antes);
+            should_bool(planificador_drenar(planificador, 50)) be equal to(false);
+            clock_gettime(CLOCK_MONOTONIC, &despues);
+
+            // Plazo más la gracia de descarte, sin esperar al manejador bloqueado
+            long transcurrido_ms = (despues.tv_sec - antes.tv_sec) * 1000 + (despues.tv_nsec - antes.tv_nsec) / 1000000;
+            should_bool(transcurrido_ms < 50 + GRACIA_DESCARTE_MS + 200) be equal to(true);
+
+            atomic_store(&liberar_manejador, true);
+        } end
+
+    } end
+
+} end
+
+// ========== TESTS PARA EL REGISTRO DE OPERACIONES ==========
+
+// Último contexto recibido por el manejador de prueba
+static t_contexto_operacion contexto_recibido;
+static int operaciones_manejadas;
+
+static bool decodificador_de_prueba(t_contexto_operacion *contexto)
+{
+    contexto->decodificado = contexto->payload;
+    return contexto->size > 0;
+}
+
+static void operacion_de_prueba(t_contexto_operacion *contexto)
+{
+    contexto_recibido = *contexto;
+    operaciones_manejadas++;
+}
+
+context(test_operaciones){
+
+    describe("Registro y despacho de operaciones"){
+
+        before{
+            logger = log_create("test_operaciones.log", "Test_Servidor", 0, LOG_LEVEL_DEBUG);
+            operaciones_manejadas = 0;
+        } end
+
+        after{
+            log_destroy(logger);
+            logger = NULL;
+            unlink("test_operaciones.log");
+        } end
+
+        it("debería despachar al manejador registrado para el código"){
+            should_bool(registrar_operacion(MENSAJE, "PRUEBA", decodificador_de_prueba, operacion_de_prueba)) be equal to(true);
+
+            char payload[] = "Hola";
+            t_frame frame = {.cod_op = MENSAJE, .size = sizeof(payload), .payload = payload, .formato = FORMATO_V1};
+            despachar_operacion(7, &frame);
+
+            should_int(operaciones_manejadas) be equal to(1);
+            should_int(contexto_recibido.socket_cliente) be equal to(7);
+            should_ptr(contexto_recibido.decodificado) be equal to(payload);
+        } end
+
+        it("debería descartar frames que el decodificador rechaza"){
+            t_frame frame = {.cod_op = MENSAJE, .size = 0, .payload = "", .formato = FORMATO_V1};
+            despachar_operacion(7, &frame);
+
+            should_int(operaciones_manejadas) be equal to(0);
+        } end
+
+        it("debería descartar códigos desconocidos sin terminar el proceso"){
+            t_frame frame = {.cod_op = OP_CODE_MAX, .size = 1, .payload = "x", .formato = FORMATO_V1};
+            despachar_operacion(7, &frame);
+            frame.cod_op = -1;
+            despachar_operacion(7, &frame);
+
+            should_int(operaciones_manejadas) be equal to(0);
+            should_ptr(buscar_operacion(-1)) be equal to(NULL);
+            should_ptr(buscar_operacion(OP_CODE_MAX)) be equal to(NULL);
+        } end
+
+        it("debería rechazar registros duplicados o fuera de rango"){
+            should_bool(registrar_operacion(MENSAJE, "OTRA", NULL, operacion_de_prueba)) be equal to(false);
+            should_bool(registrar_operacion(OP_CODE_MAX, "FUERA", NULL, operacion_de_prueba)) be equal to(false);
+        } end
+
+    } end
+
+} end
+
+// ========== TESTS PARA EL JOURNAL BINARIO ==========
+
+// Directorio temporal de los segmentos (lo crea el primer test)
+static char directorio[] = "/tmp/test_journal_XXXXXX";
+
+/**
+ * @brief Lee un segmento del journal completo a memoria
+ *
+ * @param directorio Directorio del journal
+ * @param numero Número de segmento
+ * @param tamanio Se completa con el tamaño del archivo (-1 si no existe)
+ * @return uint8_t* Contenido del archivo (liberar con free) o NULL
+ */
+static uint8_t *leer_segmento_de_prueba(const char *directorio, int numero, long *tamanio)
+{
+    char ruta[PATH_MAX + 32];
+    snprintf(ruta, sizeof(ruta), "%s/%08d%s", directorio, numero, EXTENSION_JOURNAL);
+
+    *tamanio = -1;
+    FILE *archivo = fopen(ruta, "rb");
+    if (archivo == NULL)
+        return NULL;
+
+    fseek(archivo, 0, SEEK_END);
+    *tamanio = ftell(archivo);
+    rewind(archivo);
+    uint8_t *contenido = malloc(*tamanio > 0 ? *tamanio : 1);
+    if (fread(contenido, 1, *tamanio, archivo) != (size_t)*tamanio)
+        *tamanio = -1;
+    fclose(archivo);
+    return contenido;
+}
+
+context(test_journal){
+
+    describe("Journal binario de frames"){
+
+        it("debería guardar cada frame con su cabecera y crc, rotando segmentos"){
+            mkdtemp(directorio);
+            t_parametros_journal parametros = {.tamanio_segmento = 4096, .politica = JOURNAL_FSYNC_SIEMPRE};
+            snprintf(parametros.directorio, sizeof(parametros.directorio), "%s", directorio);
+
+            char payload[1500];
+            memset(payload, 'j', sizeof(payload));
+            t_formato formato = {.version = PROTOCOLO_V2, .flags = FLAG_LONGITUDES_VARINT};
+
+            should_bool(iniciar_journal(parametros)) be equal to(true);
+            for (int i = 0; i < 3; i++)
+                should_bool(registrar_en_journal(9, PAQUETE, formato, payload, sizeof(payload))) be equal to(true);
+            finalizar_journal();
+            should_bool(registrar_en_journal(9, MENSAJE, formato, "tarde", 6)) be equal to(false);
+
+            // Entran dos registros de 1528 bytes en el primer segmento de 4096
+            long tamanio;
+            uint8_t *segmento = leer_segmento_de_prueba(directorio, 1, &tamanio);
+            should_int(tamanio) be equal to(TAMANIO_CABECERA_SEGMENTO + 2 * 1528);
+            should_bool(memcmp(segmento, MAGICO_JOURNAL, 4) == 0) be equal to(true);
+            should_int(leer_u32le(segmento + 4)) be equal to(VERSION_JOURNAL);
+
+            uint8_t *registro = segmento + TAMANIO_CABECERA_SEGMENTO;
+            should_int(leer_u32le(registro)) be equal to(sizeof(payload));
+            should_int(leer_u32le(registro + 4)) be equal to(crc32_journal(0, registro + 8, TAMANIO_CABECERA_REGISTRO - 8 + sizeof(payload)));
+            should_int(leer_u32le(registro + 16)) be equal to(PAQUETE);
+            should_int(registro[20]) be equal to(PROTOCOLO_V2);
+            should_int(registro[21]) be equal to(FLAG_LONGITUDES_VARINT);
+            should_int(registro[22] | registro[23] << 8) be equal to(9);
+            should_bool(memcmp(registro + TAMANIO_CABECERA_REGISTRO, payload, sizeof(payload)) == 0) be equal to(true);
+            free(segmento);
+
+            segmento = leer_segmento_de_prueba(directorio, 2, &tamanio);
+            should_int(tamanio) be equal to(TAMANIO_CABECERA_SEGMENTO + 1528);
+            should_int(leer_u32le(segmento + 8)) be equal to(2);
+            free(segmento);
+        } end
+
+        it("debería empezar un segmento nuevo en cada inicio y sincronizar por lotes"){
+            // Mismo directorio que el test anterior: ya tiene los segmentos 1 y 2
+            t_parametros_journal parametros = {.politica = JOURNAL_FSYNC_LOTE, .lote_bytes = 1, .intervalo_ms = 5};
+            snprintf(parametros.directorio, sizeof(parametros.directorio), "%s", directorio);
+
+            should_bool(iniciar_journal(parametros)) be equal to(true);
+            should_bool(registrar_en_journal(9, MENSAJE, FORMATO_V1, "Hola", 5)) be equal to(true);
+            usleep(20 * 1000);
+            should_bool(registrar_en_journal(9, MENSAJE, FORMATO_V1, "Chau", 5)) be equal to(true);
+            finalizar_journal();
+
+            long tamanio;
+            uint8_t *segmento = leer_segmento_de_prueba(directorio, 3, &tamanio);
+            should_int(tamanio) be equal to(TAMANIO_CABECERA_SEGMENTO + 2 * 32);
+            should_string((char *)segmento + TAMANIO_CABECERA_SEGMENTO + 32 + TAMANIO_CABECERA_REGISTRO) be equal to("Chau");
+            free(segmento);
+        } end
+
+        it("debería interpretar la política de fsync de la configuración"){
+            should_int(politica_fsync_desde_texto("NUNCA")) be equal to(JOURNAL_FSYNC_NUNCA);
+            should_int(politica_fsync_desde_texto("SIEMPRE")) be equal to(JOURNAL_FSYNC_SIEMPRE);
+            should_int(politica_fsync_desde_texto("LOTE")) be equal to(JOURNAL_FSYNC_LOTE);
+            should_int(politica_fsync_desde_texto(NULL)) be equal to(JOURNAL_FSYNC_LOTE);
+        } end
+
+    } end
+
+} end
+
+// ========== TESTS PARA LAS MÉTRICAS ==========
+
+/**
+ * @brief Cuenta desde otro hilo, para verificar que se suman todos los bloques
+ */
+static void *contar_en_otro_hilo(void *argumento)
+{
+    (void)argumento;
+    metricas_bytes_recibidos(50);
+    metricas_error_decodificacion();
+    return NULL;
+}
+
+/**
+ * @brief Indica si el resumen tiene una línea exacta
+ */
+static bool resumen_contiene(const char *resumen, const char *linea)
+{
+    size_t largo = strlen(linea);
+    for (const char *cursor = strstr(resumen, linea); cursor != NULL; cursor = strstr(cursor + 1, linea))
+        if ((cursor == resumen || cursor[-1] == '\n') && cursor[largo] == '\n')
+            return true;
+    return false;
+}
+
+context(test_metricas){
+
+    describe("Contadores por hilo y resumen"){
+
+        before{
+            logger = log_create("test_metricas.log", "Test_Servidor", 0, LOG_LEVEL_DEBUG);
+        } end
+
+        after{
+            finalizar_metricas();
+            log_destroy(logger);
+            logger = NULL;
+            unlink("test_metricas.log");
+        } end
+
+        it("debería sumar los contadores de todos los hilos"){
+            should_bool(iniciar_metricas("")) be equal to(true);
+
+            metricas_conexion_abierta();
+            metricas_conexion_abierta();
+            metricas_conexion_cerrada();
+            metricas_bytes_recibidos(100);
+            metricas_reserva(64);
+            metricas_frame(OPERACION_DESCONOCIDA, 0);
+
+            pthread_t hilo;
+            pthread_create(&hilo, NULL, contar_en_otro_hilo, NULL);
+            pthread_join(hilo, NULL);
+
+            char *resumen = texto_metricas();
+            should_bool(resumen_contiene(resumen, "conexiones_activas 1")) be equal to(true);
+            should_bool(resumen_contiene(resumen, "conexiones_aceptadas 2")) be equal to(true);
+            should_bool(resumen_contiene(resumen, "bytes_recibidos 150")) be equal to(true);
+            should_bool(resumen_contiene(resumen, "errores_decodificacion 1")) be equal to(true);
+            should_bool(resumen_contiene(resumen, "bytes_reservados 64")) be equal to(true);
+            should_bool(resumen_contiene(resumen, "frames{op=\"DESCONOCIDA\"} 1")) be equal to(true);
+            free(resumen);
+        } end
+
+        it("debería contar los frames despachados y la latencia de su operación"){
+            registrar_operacion(MENSAJE, "PRUEBA", decodificador_de_prueba, operacion_de_prueba);
+            should_bool(iniciar_metricas("")) be equal to(true);
+
+            char payload[] = "Hola";
+            t_frame frame = {.cod_op = MENSAJE, .size = sizeof(payload), .payload = payload, .formato = FORMATO_V1};
+            despachar_operacion(7, &frame);
+            despachar_operacion(7, &frame);
+            frame.size = 0; // El decodificador de prueba lo rechaza
+            despachar_operacion(7, &frame);
+
+            char esperado[128];
+            char *resumen = texto_metricas();
+            snprintf(esperado, sizeof(esperado), "frames{op=\"%s\"} 2", buscar_operacion(MENSAJE)->nombre);
+            should_bool(resumen_contiene(resumen, esperado)) be equal to(true);
+            should_bool(resumen_contiene(resumen, "errores_decodificacion 1")) be equal to(true);
+            snprintf(esperado, sizeof(esperado), "latencia_ns{op=\"%s\",percentil=\"50\"} 0", buscar_operacion(MENSAJE)->nombre);
+            should_bool(resumen_contiene(resumen, esperado)) be equal to(false);
+            free(resumen);
+        } end
+
+        it("no debería contar fuera de iniciar_metricas() y finalizar_metricas()"){
+            should_bool(iniciar_metricas("")) be equal to(true);
+            finalizar_metricas();
+            metricas_bytes_recibidos(10);
+            should_bool(metricas_instante() == 0) be equal to(true);
+
+            char *resumen = texto_metricas();
+            should_bool(resumen_contiene(resumen, "bytes_recibidos 0")) be equal to(true);
+            free(resumen);
+        } end
+
+        it("debería responder el resumen por el socket de consulta"){
+            char ruta[64];
+            snprintf(ruta, sizeof(ruta), "/tmp/test_metricas_%d.sock", getpid());
+            should_bool(iniciar_metricas(ruta)) be equal to(true);
+            metricas_bytes_recibidos(42);
+
+            struct sockaddr_un direccion = {.sun_family = AF_UNIX};
+            strcpy(direccion.sun_path, ruta);
+            int consulta = socket(AF_UNIX, SOCK_STREAM, 0);
+            should_int(connect(consulta, (struct sockaddr *)&direccion, sizeof(direccion))) be equal to(0);
+
+            char resumen[4096];
+            int leidos = 0, n;
+            while ((n = recv(consulta, resumen + leidos, sizeof(resumen) - 1 - leidos, 0)) > 0)
+                leidos += n;
+            resumen[leidos] = '\0';
+            close(consulta);
+
+            should_bool(resumen_contiene(resumen, "bytes_recibidos 42")) be equal to(true);
+
+            finalizar_metricas();
+            should_int(access(ruta, F_OK)) be equal to(-1);
+        } end
+
+    } end
+
+} end
+
+// ========== TESTS PARA LAS CONFIRMACIONES DE SOLICITUDES ==========
+
+/**
+ * @brief Lee un entero de 32 bits little-endian de un ACK recibido
+ */
+static uint32_t leer_entero_ack(const uint8_t *origen)
+{
+    return (uint32_t)origen[0] | (uint32_t)origen[1] << 8 | (uint32_t)origen[2] << 16 | (uint32_t)origen[3] << 24;
+}
+
+context(test_confirmaciones){
+
+    describe("Solicitudes y frames ACK"){
+
+        before{
+            logger = log_create("test_confirmaciones.log", "Test_Servidor", 0, LOG_LEVEL_DEBUG);
+        } end
+
+        after{
+            log_destroy(logger);
+            logger = NULL;
+            unlink("test_confirmaciones.log");
+        } end
+
+        it("debería separar el ID de la solicitud del payload"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+
+            uint8_t datos[TAMANIO_CABECERA_V2 + BYTES_ID_SOLICITUD + 5] = {
+                MAGIA_PROTOCOLO_0, MAGIA_PROTOCOLO_1, PROTOCOLO_V2, FLAG_SOLICITUD,
+                MENSAJE, 0, 0, 0,
+                BYTES_ID_SOLICITUD + 5, 0, 0, 0,
+                42, 1, 0, 0};
+            memcpy(datos + TAMANIO_CABECERA_V2 + BYTES_ID_SOLICITUD, "Hola", 5);
+            send(sockets[1], datos, sizeof(datos), 0);
+
+            t_decodificador *decodificador = decodificador_crear(0);
+            t_frame frame;
+            should_int(decodificador_recibir_frame(decodificador, sockets[0], &frame)) be equal to(1);
+            should_bool(frame.confirmar) be equal to(true);
+            should_int(frame.solicitud) be equal to(298);
+            should_int(frame.size) be equal to(5);
+            should_int(frame.formato.flags & FLAG_SOLICITUD) be equal to(0);
+            should_string((char *)frame.payload) be equal to("Hola");
+
+            decodificador_destruir(decodificador);
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+        it("debería rechazar una solicitud sin lugar para el ID"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+
+            uint8_t datos[TAMANIO_CABECERA_V2 + 2] = {
+                MAGIA_PROTOCOLO_0, MAGIA_PROTOCOLO_1, PROTOCOLO_V2, FLAG_SOLICITUD,
+                MENSAJE, 0, 0, 0,
+                2, 0, 0, 0};
+            send(sockets[1], datos, sizeof(datos), 0);
+
+            t_decodificador *decodificador = decodificador_crear(0);
+            t_frame frame;
+            should_int(decodificador_recibir_frame(decodificador, sockets[0], &frame)) be equal to(-1);
+
+            decodificador_destruir(decodificador);
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+        it("debería juntar varias confirmaciones en un solo ACK"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+
+            t_confirmaciones *confirmaciones = confirmaciones_crear(sockets[0], false);
+            should_bool(confirmar_solicitud(confirmaciones, 1, CONFIRMACION_PROCESADA)) be equal to(true);
+            should_bool(confirmar_solicitud(confirmaciones, 2, CONFIRMACION_RECHAZADA)) be equal to(true);
+            should_bool(confirmar_solicitud(confirmaciones, 70000, CONFIRMACION_PROCESADA)) be equal to(true);
+            should_int(confirmaciones_pendientes(confirmaciones)) be equal to(TAMANIO_CABECERA_V2 + 3 * BYTES_CONFIRMACION);
+
+            should_bool(enviar_confirmaciones(confirmaciones)) be equal to(true);
+            should_int(confirmaciones_pendientes(confirmaciones)) be equal to(0);
+
+            uint8_t ack[TAMANIO_CABECERA_V2 + 3 * BYTES_CONFIRMACION];
+            should_int(recv(sockets[1], ack, sizeof(ack), MSG_DONTWAIT)) be equal to(sizeof(ack));
+            should_int(ack[2]) be equal to(PROTOCOLO_V2);
+            should_int(leer_entero_ack(ack + 4)) be equal to(ACK);
+            should_int(leer_entero_ack(ack + 8)) be equal to(3 * BYTES_CONFIRMACION);
+            uint8_t *entradas = ack + TAMANIO_CABECERA_V2;
+            should_int(leer_entero_ack(entradas)) be equal to(1);
+            should_int(entradas[4]) be equal to(CONFIRMACION_PROCESADA);
+            should_int(entradas[BYTES_CONFIRMACION + 4]) be equal to(CONFIRMACION_RECHAZADA);
+            should_int(leer_entero_ack(entradas + 2 * BYTES_CONFIRMACION)) be equal to(70000);
+
+            // Sin confirmaciones nuevas no se envía nada
+            should_bool(enviar_confirmaciones(confirmaciones)) be equal to(true);
+            should_int(recv(sockets[1], ack, sizeof(ack), MSG_DONTWAIT)) be equal to(-1);
+
+            confirmaciones_destruir(confirmaciones);
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+        it("no debería descartar confirmaciones aunque el cliente no las lea"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+            t_confirmaciones *confirmaciones = confirmaciones_crear(sockets[0], false);
+
+            // Más que MAXIMO_BYTES_CONFIRMACIONES: el reactor pausa la lectura, la cola no descarta
+            int cantidad = MAXIMO_BYTES_CONFIRMACIONES / BYTES_CONFIRMACION + 100;
+            bool todas = true;
+            for (int i = 0; i < cantidad; i++)
+                todas = confirmar_solicitud(confirmaciones, i, CONFIRMACION_PROCESADA) && todas;
+            should_bool(todas) be equal to(true);
+            should_int(confirmaciones_pendientes(confirmaciones)) be equal to(TAMANIO_CABECERA_V2 + cantidad * BYTES_CONFIRMACION);
+
+            confirmaciones_destruir(confirmaciones);
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+        it("debería confirmar como procesados o rechazados los frames despachados"){
+            registrar_operacion(MENSAJE, "PRUEBA", decodificador_de_prueba, operacion_de_prueba);
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+            t_confirmaciones *confirmaciones = confirmaciones_crear(sockets[0], false);
+
+            char payload[] = "Hola";
+            t_frame frame = {.cod_op = MENSAJE, .size = sizeof(payload), .payload = payload, .formato = FORMATO_V1,
+                             .confirmar = true, .solicitud = 5, .confirmaciones = confirmaciones};
+            despachar_operacion(sockets[0], &frame);
+            frame.solicitud = 6;
+            frame.size = 0; // El decodificador de prueba lo rechaza
+            despachar_operacion(sockets[0], &frame);
+            frame.solicitud = 7;
+            frame.cod_op = ACK; // Ninguna operación registrada
+            despachar_operacion(sockets[0], &frame);
+            frame.confirmar = false;
+            frame.cod_op = MENSAJE;
+            frame.size = sizeof(payload);
+            despachar_operacion(sockets[0], &frame);
+            enviar_confirmaciones(confirmaciones);
+
+            uint8_t ack[TAMANIO_CABECERA_V2 + 4 * BYTES_CONFIRMACION];
+            should_int(recv(sockets[1], ack, sizeof(ack), MSG_DONTWAIT)) be equal to(TAMANIO_CABECERA_V2 + 3 * BYTES_CONFIRMACION);
+            uint8_t *entradas = ack + TAMANIO_CABECERA_V2;
+            should_int(leer_entero_ack(entradas)) be equal to(5);
+            should_int(entradas[4]) be equal to(CONFIRMACION_PROCESADA);
+            should_int(leer_entero_ack(entradas + BYTES_CONFIRMACION)) be equal to(6);
+            should_int(entradas[BYTES_CONFIRMACION + 4]) be equal to(CONFIRMACION_RECHAZADA);
+            should_int(leer_entero_ack(entradas + 2 * BYTES_CONFIRMACION)) be equal to(7);
+            should_int(entradas[2 * BYTES_CONFIRMACION + 4]) be equal to(CONFIRMACION_RECHAZADA);
+
+            confirmaciones_destruir(confirmaciones);
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+    } end
+
+} end
+
+context(test_control_flujo){
+
+    describe("Crédito por conexión"){
+
+        before{
+            logger = log_create("test_control_flujo.log", "Test_Servidor", 0, LOG_LEVEL_DEBUG);
+        } end
+
+        after{
+            log_destroy(logger);
+            logger = NULL;
+            unlink("test_control_flujo.log");
+        } end
+
+        it("debería contar los bytes que ocupó cada frame en el socket"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+
+            uint8_t datos[TAMANIO_CABECERA_V2 + 5] = {
+                MAGIA_PROTOCOLO_0, MAGIA_PROTOCOLO_1, PROTOCOLO_V2, 0,
+                MENSAJE, 0, 0, 0,
+                5, 0, 0, 0};
+            memcpy(datos + TAMANIO_CABECERA_V2, "Hola", 5);
+            send(sockets[1], datos, sizeof(datos), 0);
+
+            t_decodificador *decodificador = decodificador_crear(0);
+            t_frame frame;
+            should_int(decodificador_recibir_frame(decodificador, sockets[0], &frame)) be equal to(1);
+            should_int(frame.bytes) be equal to(TAMANIO_CABECERA_V2 + 5);
+
+            decodificador_destruir(decodificador);
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+        it("debería otorgar el crédito inicial y devolver lo procesado en un solo frame"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+            t_confirmaciones *confirmaciones = confirmaciones_crear(sockets[0], false);
+
+            habilitar_credito(confirmaciones, 1000);
+            otorgar_credito(confirmaciones, 50);
+            otorgar_credito(confirmaciones, 50);
+            should_bool(enviar_confirmaciones(confirmaciones)) be equal to(true);
+
+            uint8_t frames[2 * (TAMANIO_CABECERA_V2 + BYTES_CREDITO)];
+            should_int(recv(sockets[1], frames, sizeof(frames), MSG_DONTWAIT)) be equal to(sizeof(frames));
+            should_int(leer_entero_ack(frames + 4)) be equal to(CREDITO);
+            should_int(leer_entero_ack(frames + 8)) be equal to(BYTES_CREDITO);
+            should_int(leer_entero_ack(frames + TAMANIO_CABECERA_V2)) be equal to(1000);
+            uint8_t *devuelto = frames + TAMANIO_CABECERA_V2 + BYTES_CREDITO;
+            should_int(leer_entero_ack(devuelto + 4)) be equal to(CREDITO);
+            should_int(leer_entero_ack(devuelto + TAMANIO_CABECERA_V2)) be equal to(100);
+
+            confirmaciones_destruir(confirmaciones);
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+        it("no debería devolver crédito si se otorgó ilimitado"){
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+            t_confirmaciones *confirmaciones = confirmaciones_crear(sockets[0], false);
+
+            habilitar_credito(confirmaciones, CREDITO_ILIMITADO);
+            otorgar_credito(confirmaciones, 50);
+            enviar_confirmaciones(confirmaciones);
+
+            uint8_t frames[2 * (TAMANIO_CABECERA_V2 + BYTES_CREDITO)];
+            should_int(recv(sockets[1], frames, sizeof(frames), MSG_DONTWAIT)) be equal to(TAMANIO_CABECERA_V2 + BYTES_CREDITO);
+            should_bool(leer_entero_ack(frames + TAMANIO_CABECERA_V2) == CREDITO_ILIMITADO) be equal to(true);
+
+            confirmaciones_destruir(confirmaciones);
+            close(sockets[0]);
+            close(sockets[1]);
+        } end
+
+    } end
+
+} end
+
+context(test_uring){
+
+    describe("Recepción con io_uring"){
+
+        it("debería decodificar frames cargados de a pedazos"){
+            t_decodificador *decodificador = decodificador_crear(16);
+            uint8_t datos[2 * (TAMANIO_CABECERA_V2 + 40)];
+            for (int i = 0; i < 2; i++)
+            {
+                uint8_t *frame = datos + i * (TAMANIO_CABECERA_V2 + 40);
+                uint8_t cabecera[TAMANIO_CABECERA_V2] = {
+                    MAGIA_PROTOCOLO_0, MAGIA_PROTOCOLO_1, PROTOCOLO_V2, 0, MENSAJE, 0, 0, 0, 40, 0, 0, 0};
+                memcpy(frame, cabecera, sizeof(cabecera));
+                memset(frame + TAMANIO_CABECERA_V2, 'a' + i, 40);
+            }
+
+            // Un pedazo con la cabecera a medias y otro más grande que el buffer
+            t_frame frame;
+            decodificador_cargar(decodificador, datos, 5);
+            should_int(decodificador_siguiente(decodificador, &frame)) be equal to(0);
+            decodificador_cargar(decodificador, datos + 5, sizeof(datos) - 5);
+            should_int(decodificador_siguiente(decodificador, &frame)) be equal to(1);
+            should_int(frame.size) be equal to(40);
+            should_int(((char *)frame.payload)[0]) be equal to('a');
+            should_int(decodificador_siguiente(decodificador, &frame)) be equal to(1);
+            should_int(((char *)frame.payload)[39]) be equal to('b');
+            should_int(decodificador_siguiente(decodificador, &frame)) be equal to(0);
+
+            decodificador_destruir(decodificador);
+        } end
+
+        it("debería recibir en un buffer provisto con un recv multishot"){
+            // Sin soporte del kernel el reactor usa epoll: no hay nada que probar
+            t_uring *uring = uring_crear();
+            if (uring == NULL)
+                return;
+
+            int sockets[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+            uring_preparar_recibir(uring_obtener_sqe(uring), sockets[0], 42);
+            send(sockets[1], "Hola", 5, 0);
+            should_int(uring_enviar(uring, 1000)) be equal to(0);
+
+            struct io_uring_cqe *completado = uring_completado(uring);
+            should_bool(completado != NULL) be equal to(true);
+            should_bool(completado->user_data == 42) be equal to(true);
+            should_int(completado->res) be equal to(5);
+            should_bool((completado->flags & IORING_CQE_F_BUFFER) != 0) be equal to(true);
+            should_bool((completado->flags & IORING_CQE_F_MORE) != 0) be equal to(true);
+            unsigned buffer = completado->flags >> IORING_CQE_BUFFER_SHIFT;
+            should_string(uring_buffer(uring, buffer)) be equal to("Hola");
+            uring_devolver_buffer(uring, buffer);
+            uring_completado_visto(uring);
+
+            // Sigue activo: el cierre del otro extremo llega como un último recv de 0 bytes
+            close(sockets[1]);
+            should_int(uring_enviar(uring, 1000)) be equal to(0);
+            completado = uring_completado(uring);
+            should_bool(completado != NULL) be equal to(true);
+            should_int(completado->res) be equal to(0);
+            should_bool((completado->flags & IORING_CQE_F_MORE) != 0) be equal to(false);
+            uring_completado_visto(uring);
+            should_bool(uring_completado(uring) == NULL) be equal to(true);
+
+            uring_destruir(uring);
+            close(sockets[0]);
+        } end
+
+    } end
+
+} end
@@ -0,0 +1,315 @@
+#include "confirmaciones.h"
+
+/**
+ * @brief Escribe un entero de 32 bits little-endian
+ *
+ * @param destino Lugar para 4 bytes
+ * @param valor Valor a escribir
+ */
+static void escribir_u32(uint8_t *destino, uint32_t valor)
+{
+    destino[0] = valor;
+    destino[1] = valor >> 8;
+    destino[2] = valor >> 16;
+    destino[3] = valor >> 24;
+}
+
+/**
+ * @brief Crea la cola de confirmaciones de una conexión
+ *
+ * Con el pool de manejadores la cola la usa un hilo que no es dueño de
+ * la conexión, así que recibe un dup() del socket: si el reactor cierra
+ * la conexión, el número de descriptor no puede reutilizarse para otro
+ * cliente mientras queden confirmaciones por enviar.
+ *
+ * @param socket Socket no bloqueante del cliente
+ * @param socket_propio true si la cola cierra el socket al destruirse
+ * @return t_confirmaciones* Cola creada o NULL si no hay memoria
+ */
+t_confirmaciones *confirmaciones_crear(int socket, bool socket_propio)
+{
+    t_confirmaciones *confirmaciones = calloc(1, sizeof(t_confirmaciones));
+    if (confirmaciones == NULL)
+        return NULL;
+    pthread_mutex_init(&confirmaciones->mutex, NULL);
+    confirmaciones->socket = socket;
+    confirmaciones->socket_propio = socket_propio;
+    confirmaciones->frame_abierto = -1;
+    return confirmaciones;
+}
+
+/**
+ * @brief Asegura lugar para agregar bytes al final de la cola
+ *
+ * Antes de crecer descarta lo ya enviado moviendo lo pendiente al
+ * principio del buffer.
+ *
+ * @param confirmaciones Cola (con el mutex tomado)
+ * @param bytes Bytes a agregar
+ * @return bool false si no hay memoria (la cola queda como estaba)
+ */
+static bool reservar_confirmaciones(t_confirmaciones *confirmaciones, size_t bytes)
+{
+    if (confirmaciones->size + bytes <= confirmaciones->capacidad)
+        return true;
+
+    if (confirmaciones->enviados > 0)
+    {
+        memmove(confirmaciones->datos, confirmaciones->datos + confirmaciones->enviados,
+                confirmaciones->size - confirmaciones->enviados);
+        if (confirmaciones->frame_abierto != -1)
+            confirmaciones->frame_abierto -= confirmaciones->enviados;
+        confirmaciones->size -= confirmaciones->enviados;
+        confirmaciones->enviados = 0;
+    }
+
+    size_t capacidad = confirmaciones->capacidad > 0 ? confirmaciones->capacidad : 256;
+    while (confirmaciones->size + bytes > capacidad)
+        capacidad *= 2;
+
+    if (capacidad != confirmaciones->capacidad)
+    {
+        uint8_t *datos = realloc(confirmaciones->datos, capacidad);
+        if (datos == NULL)
+            return false;
+        confirmaciones->datos = datos;
+        confirmaciones->capacidad = capacidad;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Corta la conexión cuando no hay memoria para seguir respondiendo
+ *
+ * Descarta lo pendiente y hace shutdown() del socket (el duplicado del
+ * pool comparte la conexión): el reactor ve el cierre y la libera, y el
+ * cliente deja de esperar confirmaciones que no van a llegar.
+ *
+ * @param confirmaciones Cola (con el mutex tomado)
+ */
+static void cortar_conexion(t_confirmaciones *confirmaciones)
+{
+    confirmaciones->cortada = true;
+    confirmaciones->enviados = confirmaciones->size = 0;
+    confirmaciones->frame_abierto = -1;
+    confirmaciones->credito = 0;
+    shutdown(confirmaciones->socket, SHUT_RDWR);
+}
+
+/**
+ * @brief Agrega la confirmación de una solicitud al ACK abierto
+ *
+ * Si no hay un ACK abierto se reserva lugar para su cabecera, que se
+ * escribe al cerrarlo con la cantidad de confirmaciones que juntó. La
+ * cola no tiene tope: el reactor deja de leer la conexión cuando pasa
+ * MAXIMO_BYTES_CONFIRMACIONES.
+ *
+ * @param confirmaciones Cola de la conexión
+ * @param solicitud ID de la solicitud
+ * @param estado CONFIRMACION_PROCESADA o CONFIRMACION_RECHAZADA
+ * @return bool false si no hay memoria (la conexión queda cortada)
+ */
+bool confirmar_solicitud(t_confirmaciones *confirmaciones, uint32_t solicitud, uint8_t estado)
+{
+    pthread_mutex_lock(&confirmaciones->mutex);
+
+    bool abrir = confirmaciones->frame_abierto == -1;
+    if (confirmaciones->cortada ||
+        !reservar_confirmaciones(confirmaciones, (abrir ? TAMANIO_CABECERA_V2 : 0) + BYTES_CONFIRMACION))
+    {
+        if (!confirmaciones->cortada)
+            cortar_conexion(confirmaciones);
+        pthread_mutex_unlock(&confirmaciones->mutex);
+        return false;
+    }
+
+    if (abrir)
+    {
+        confirmaciones->frame_abierto = (long)confirmaciones->size;
+        confirmaciones->size += TAMANIO_CABECERA_V2;
+    }
+
+    uint8_t *entrada = confirmaciones->datos + confirmaciones->size;
+    escribir_u32(entrada, solicitud);
+    entrada[4] = estado;
+    confirmaciones->size += BYTES_CONFIRMACION;
+
+    pthread_mutex_unlock(&confirmaciones->mutex);
+    return true;
+}
+
+/**
+ * @brief Completa la cabecera del ACK abierto
+ *
+ * @param confirmaciones Cola (con el mutex tomado)
+ */
+static void cerrar_frame_ack(t_confirmaciones *confirmaciones)
+{
+    if (confirmaciones->frame_abierto == -1)
+        return;
+
+    uint8_t *cabecera = confirmaciones->datos + confirmaciones->frame_abierto;
+    size_t size = confirmaciones->size - confirmaciones->frame_abierto - TAMANIO_CABECERA_V2;
+
+    cabecera[0] = MAGIA_PROTOCOLO_0;
+    cabecera[1] = MAGIA_PROTOCOLO_1;
+    cabecera[2] = PROTOCOLO_V2;
+    cabecera[3] = 0;
+    escribir_u32(cabecera + 4, ACK);
+    escribir_u32(cabecera + 8, (uint32_t)size);
+
+    confirmaciones->frame_abierto = -1;
+}
+
+/**
+ * @brief Agrega un frame CREDITO a la cola
+ *
+ * Cierra antes el ACK abierto, para que las confirmaciones que lleguen
+ * después vayan en un ACK nuevo.
+ *
+ * @param confirmaciones Cola (con el mutex tomado)
+ * @param bytes Crédito otorgado
+ * @return bool false si no hay memoria (la conexión queda cortada)
+ */
+static bool agregar_frame_credito(t_confirmaciones *confirmaciones, uint32_t bytes)
+{
+    cerrar_frame_ack(confirmaciones);
+    if (confirmaciones->cortada || !reservar_confirmaciones(confirmaciones, TAMANIO_CABECERA_V2 + BYTES_CREDITO))
+    {
+        if (!confirmaciones->cortada)
+            cortar_conexion(confirmaciones);
+        return false;
+    }
+
+    uint8_t *cabecera = confirmaciones->datos + confirmaciones->size;
+    cabecera[0] = MAGIA_PROTOCOLO_0;
+    cabecera[1] = MAGIA_PROTOCOLO_1;
+    cabecera[2] = PROTOCOLO_V2;
+    cabecera[3] = 0;
+    escribir_u32(cabecera + 4, CREDITO);
+    escribir_u32(cabecera + 8, BYTES_CREDITO);
+    escribir_u32(cabecera + TAMANIO_CABECERA_V2, bytes);
+    confirmaciones->size += TAMANIO_CABECERA_V2 + BYTES_CREDITO;
+    return true;
+}
+
+/**
+ * @brief Activa el control de flujo y otorga el crédito inicial
+ *
+ * Con CREDITO_ILIMITADO el cliente deja de contar lo que envía y la cola
+ * no vuelve a otorgarle crédito.
+ *
+ * @param confirmaciones Cola de la conexión
+ * @param inicial Bytes que el cliente puede enviar (CREDITO_ILIMITADO = sin control)
+ */
+void habilitar_credito(t_confirmaciones *confirmaciones, uint32_t inicial)
+{
+    pthread_mutex_lock(&confirmaciones->mutex);
+    confirmaciones->control_flujo = inicial != CREDITO_ILIMITADO;
+    agregar_frame_credito(confirmaciones, inicial);
+    pthread_mutex_unlock(&confirmaciones->mutex);
+}
+
+/**
+ * @brief Devuelve al cliente el crédito de un frame procesado
+ *
+ * El crédito se acumula y viaja en un solo CREDITO en el próximo
+ * vaciado. Sin control de flujo no hace nada.
+ *
+ * @param confirmaciones Cola de la conexión
+ * @param bytes Bytes que ocupaba el frame en el socket
+ */
+void otorgar_credito(t_confirmaciones *confirmaciones, size_t bytes)
+{
+    pthread_mutex_lock(&confirmaciones->mutex);
+    if (confirmaciones->control_flujo)
+        confirmaciones->credito += bytes;
+    pthread_mutex_unlock(&confirmaciones->mutex);
+}
+
+/**
+ * @brief Cierra el ACK abierto y envía lo pendiente sin bloquear
+ *
+ * El crédito acumulado se agrega en un frame CREDITO. Si el socket no
+ * acepta todo, el resto queda para el próximo vaciado.
+ *
+ * @param confirmaciones Cola de la conexión
+ * @return bool false si el socket falló (las confirmaciones se descartan)
+ */
+bool enviar_confirmaciones(t_confirmaciones *confirmaciones)
+{
+    bool ok = true;
+
+    pthread_mutex_lock(&confirmaciones->mutex);
+    cerrar_frame_ack(confirmaciones);
+
+    // Sin pasar de CREDITO_ILIMITADO, que el cliente interpreta distinto
+    while (confirmaciones->credito > 0)
+    {
+        uint32_t bytes = confirmaciones->credito < CREDITO_ILIMITADO ? confirmaciones->credito : CREDITO_ILIMITADO - 1;
+        if (!agregar_frame_credito(confirmaciones, bytes))
+            break;
+        confirmaciones->credito -= bytes;
+    }
+
+    if (confirmaciones->cortada)
+        ok = false;
+
+    while (confirmaciones->enviados < confirmaciones->size)
+    {
+        ssize_t escritos = send(confirmaciones->socket,
+                                confirmaciones->datos + confirmaciones->enviados,
+                                confirmaciones->size - confirmaciones->enviados,
+                                MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (escritos == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            // El cliente se fue: nadie va a leer lo pendiente
+            confirmaciones->enviados = confirmaciones->size;
+            ok = false;
+            break;
+        }
+        confirmaciones->enviados += escritos;
+    }
+
+    // Cola vacía: volver al principio del buffer
+    if (confirmaciones->enviados == confirmaciones->size)
+        confirmaciones->enviados = confirmaciones->size = 0;
+
+    pthread_mutex_unlock(&confirmaciones->mutex);
+    return ok;
+}
+
+/**
+ * @brief Bytes de confirmaciones que todavía no aceptó el socket
+ *
+ * @param confirmaciones Cola de la conexión
+ * @return size_t Bytes pendientes (ACK abierto incluido)
+ */
+size_t confirmaciones_pendientes(t_confirmaciones *confirmaciones)
+{
+    pthread_mutex_lock(&confirmaciones->mutex);
+    size_t pendientes = confirmaciones->size - confirmaciones->enviados;
+    pthread_mutex_unlock(&confirmaciones->mutex);
+    return pendientes;
+}
+
+/**
+ * @brief Libera la cola (y cierra el socket si es propio)
+ *
+ * Lo que no se haya enviado se pierde: se llama al cerrar la conexión.
+ *
+ * @param confirmaciones Cola a liberar
+ */
+void confirmaciones_destruir(t_confirmaciones *confirmaciones)
+{
+    if (confirmaciones->socket_propio)
+        close(confirmaciones->socket);
+    pthread_mutex_destroy(&confirmaciones->mutex);
+    free(confirmaciones->datos);
+    free(confirmaciones);
+}
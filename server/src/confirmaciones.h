@@ -0,0 +1,127 @@
+#ifndef CONFIRMACIONES_H_
+#define CONFIRMACIONES_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "utils.h"
+
+/**
+ * @file confirmaciones.h
+ * @brief Confirmaciones (ACK) y crédito de control de flujo de una conexión
+ *
+ * Un frame con FLAG_SOLICITUD trae un ID que el cliente espera ver
+ * confirmado. Cada confirmación se agrega al frame ACK abierto de la
+ * conexión y el frame se cierra y se envía recién cuando se vacía la
+ * cola: una vez por lectura del socket en el reactor o por turno del
+ * buzón en el pool de manejadores. Así una ráfaga de solicitudes se
+ * confirma con un solo frame y una sola syscall.
+ *
+ * El envío nunca bloquea: lo que el socket no acepta queda en la cola y
+ * se reintenta en el próximo vaciado (el reactor también vacía la cola
+ * cuando epoll avisa que el socket volvió a aceptar datos). Ninguna
+ * confirmación se descarta: si la cola crece porque el cliente no la lee,
+ * el reactor deja de leer la conexión hasta que se vacíe, y si no hay
+ * memoria para agregar una, la conexión se corta para que el cliente no
+ * espere un ACK que no va a llegar.
+ *
+ * Si el cliente pidió control de flujo, la misma cola acumula los bytes
+ * de los frames ya procesados y los devuelve como crédito en un frame
+ * CREDITO al vaciarse, junto con los ACK.
+ */
+
+// ========== CONSTANTES ==========
+
+/**
+ * @brief Bytes pendientes de envío a partir de los cuales se pausa la lectura de la conexión
+ *
+ * Solo se alcanza si el cliente envía solicitudes sin leer las
+ * confirmaciones (o con una ventana muy grande): la cola puede pasarse
+ * solo por los frames que ya se habían leído.
+ */
+#define MAXIMO_BYTES_CONFIRMACIONES (1024 * 1024)
+
+// ========== TIPOS ==========
+
+/**
+ * @brief Confirmaciones pendientes de envío de una conexión
+ *
+ * Los bytes sin enviar están en datos[enviados, size). Si hay un frame
+ * ACK abierto, su cabecera empieza en datos[frame_abierto] y se completa
+ * al cerrarlo.
+ */
+typedef struct
+{
+    pthread_mutex_t mutex; // Lo comparten el reactor y los manejadores
+    int socket;            // Socket donde se envían los ACK
+    bool socket_propio;    // true si hay que cerrarlo al destruir
+    uint8_t *datos;        // Frames ACK armados (y el abierto)
+    size_t size;           // Bytes ocupados en datos
+    size_t enviados;       // Bytes de datos ya escritos en el socket
+    size_t capacidad;      // Bytes reservados en datos
+    long frame_abierto;    // Posición de la cabecera del ACK abierto (-1 = ninguno)
+    bool control_flujo;    // true si el cliente pidió crédito
+    uint64_t credito;      // Bytes procesados a devolver en el próximo vaciado
+    bool cortada;          // true si faltó memoria y se cortó la conexión
+} t_confirmaciones;
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Crea la cola de confirmaciones de una conexión
+ * @param socket Socket no bloqueante del cliente
+ * @param socket_propio true si la cola cierra el socket al destruirse
+ * @return t_confirmaciones* Cola creada o NULL si no hay memoria
+ */
+t_confirmaciones *confirmaciones_crear(int socket, bool socket_propio);
+
+/**
+ * @brief Agrega la confirmación de una solicitud al ACK abierto
+ * @param confirmaciones Cola de la conexión
+ * @param solicitud ID de la solicitud
+ * @param estado CONFIRMACION_PROCESADA o CONFIRMACION_RECHAZADA
+ * @return bool false si no hay memoria (la conexión queda cortada)
+ */
+bool confirmar_solicitud(t_confirmaciones *confirmaciones, uint32_t solicitud, uint8_t estado);
+
+/**
+ * @brief Activa el control de flujo y otorga el crédito inicial
+ * @param confirmaciones Cola de la conexión
+ * @param inicial Bytes que el cliente puede enviar (CREDITO_ILIMITADO = sin control)
+ */
+void habilitar_credito(t_confirmaciones *confirmaciones, uint32_t inicial);
+
+/**
+ * @brief Devuelve al cliente el crédito de un frame procesado
+ * @param confirmaciones Cola de la conexión
+ * @param bytes Bytes que ocupaba el frame en el socket
+ */
+void otorgar_credito(t_confirmaciones *confirmaciones, size_t bytes);
+
+/**
+ * @brief Cierra el ACK abierto y envía lo pendiente sin bloquear
+ * @param confirmaciones Cola de la conexión
+ * @return bool false si el socket falló o la conexión está cortada (las confirmaciones se descartan)
+ */
+bool enviar_confirmaciones(t_confirmaciones *confirmaciones);
+
+/**
+ * @brief Bytes de confirmaciones que todavía no aceptó el socket
+ * @param confirmaciones Cola de la conexión
+ * @return size_t Bytes pendientes (ACK abierto incluido)
+ */
+size_t confirmaciones_pendientes(t_confirmaciones *confirmaciones);
+
+/**
+ * @brief Libera la cola (y cierra el socket si es propio)
+ * @param confirmaciones Cola a liberar
+ */
+void confirmaciones_destruir(t_confirmaciones *confirmaciones);
+
+#endif /* CONFIRMACIONES_H_ */
@@ -0,0 +1,351 @@
+#include "decodificador.h"
+
+/**
+ * @brief Crea un decodificador con un buffer de la capacidad indicada
+ *
+ * @param capacidad Capacidad inicial (0 = CAPACIDAD_DECODIFICADOR)
+ * @return t_decodificador* Decodificador creado o NULL si no hay memoria
+ */
+t_decodificador *decodificador_crear(size_t capacidad)
+{
+    if (capacidad < (size_t)TAMANIO_CABECERA_V2)
+        capacidad = CAPACIDAD_DECODIFICADOR;
+
+    t_decodificador *decodificador = malloc(sizeof(t_decodificador));
+    if (decodificador == NULL)
+        return NULL;
+    decodificador->buffer = malloc(capacidad);
+    if (decodificador->buffer == NULL)
+    {
+        free(decodificador);
+        return NULL;
+    }
+    metricas_reserva(capacidad);
+    decodificador->capacidad = capacidad;
+    decodificador->inicio = 0;
+    decodificador->fin = 0;
+    decodificador->version = 0;
+    decodificador->descomprimido = NULL;
+    decodificador->capacidad_descomprimido = 0;
+
+    return decodificador;
+}
+
+/**
+ * @brief Libera el decodificador y su buffer
+ *
+ * @param decodificador Decodificador a liberar
+ */
+void decodificador_destruir(t_decodificador *decodificador)
+{
+    free(decodificador->buffer);
+    free(decodificador->descomprimido);
+    free(decodificador);
+}
+
+/**
+ * @brief Tamaño de la cabecera según la versión de la conexión
+ *
+ * Mientras la versión no se detectó se usa la más grande.
+ *
+ * @param decodificador Decodificador de la conexión
+ * @return size_t Bytes de cabecera
+ */
+static size_t tamanio_cabecera(t_decodificador *decodificador)
+{
+    return decodificador->version == PROTOCOLO_V1 ? TAMANIO_CABECERA_V1 : TAMANIO_CABECERA_V2;
+}
+
+/**
+ * @brief Interpreta la cabecera del frame pendiente
+ *
+ * Un tamaño mayor que tamanio_maximo_frame() hace inválida la cabecera,
+ * así el buffer nunca crece más allá de un frame de tamaño máximo.
+ *
+ * @param decodificador Decodificador de la conexión (con la cabecera completa)
+ * @param frame Se completa con el código, el tamaño y el formato
+ * @return bool false si la cabecera es inválida
+ */
+static bool leer_cabecera(t_decodificador *decodificador, t_frame *frame)
+{
+    uint8_t *cabecera = (uint8_t *)decodificador->buffer + decodificador->inicio;
+
+    if (decodificador->version == PROTOCOLO_V1)
+    {
+        memcpy(&frame->cod_op, cabecera, sizeof(int));
+        memcpy(&frame->size, cabecera + sizeof(int), sizeof(int));
+        frame->formato = FORMATO_V1;
+        return frame->size >= 0 && frame->size <= tamanio_maximo_frame();
+    }
+
+    if (cabecera[0] != MAGIA_PROTOCOLO_0 || cabecera[1] != MAGIA_PROTOCOLO_1 || cabecera[2] != PROTOCOLO_V2)
+        return false;
+
+    frame->formato = (t_formato){.version = PROTOCOLO_V2, .flags = cabecera[3]};
+    frame->cod_op = (int)leer_u32le(cabecera + 4);
+    frame->size = (int)leer_u32le(cabecera + 8);
+    return frame->size >= 0 && frame->size <= tamanio_maximo_frame();
+}
+
+/**
+ * @brief Descomprime el payload de un frame en el buffer reutilizable del decodificador
+ *
+ * @param decodificador Decodificador de la conexión
+ * @param frame Frame comprimido (queda apuntando a la copia descomprimida)
+ * @return bool false si el payload comprimido es inválido
+ */
+static bool descomprimir_frame(t_decodificador *decodificador, t_frame *frame)
+{
+    int original = tamanio_original_comprimido(frame->payload, frame->size);
+    if (original == -1)
+        return false;
+
+    if ((size_t)original > decodificador->capacidad_descomprimido)
+    {
+        void *descomprimido = realloc(decodificador->descomprimido, original);
+        if (descomprimido == NULL)
+            return false;
+        decodificador->descomprimido = descomprimido;
+        metricas_reserva(original);
+        decodificador->capacidad_descomprimido = original;
+    }
+
+    if (!descomprimir_payload(frame->payload, frame->size, decodificador->descomprimido))
+        return false;
+
+    frame->payload = decodificador->descomprimido;
+    frame->size = original;
+    frame->formato.flags &= ~FLAG_COMPRIMIDO;
+    return true;
+}
+
+/**
+ * @brief Saca el ID de solicitud del principio del payload
+ *
+ * El ID va antes del bloque comprimido, así que se extrae primero.
+ *
+ * @param frame Frame con FLAG_SOLICITUD (queda sin el flag y sin el ID)
+ * @return bool false si el payload no alcanza para el ID
+ */
+static bool extraer_solicitud(t_frame *frame)
+{
+    if (frame->size < BYTES_ID_SOLICITUD)
+        return false;
+
+    frame->solicitud = leer_u32le(frame->payload);
+    frame->confirmar = true;
+    frame->payload = (char *)frame->payload + BYTES_ID_SOLICITUD;
+    frame->size -= BYTES_ID_SOLICITUD;
+    frame->formato.flags &= ~FLAG_SOLICITUD;
+    return true;
+}
+
+/**
+ * @brief Bytes que necesita el frame pendiente para estar completo
+ *
+ * @param decodificador Decodificador de la conexión
+ * @return size_t Tamaño total del frame pendiente, o de la cabecera si todavía no llegó
+ */
+static size_t bytes_frame_pendiente(t_decodificador *decodificador)
+{
+    size_t cabecera = tamanio_cabecera(decodificador);
+    t_frame frame;
+
+    if (decodificador->version == 0 || decodificador->fin - decodificador->inicio < cabecera)
+        return cabecera;
+
+    if (!leer_cabecera(decodificador, &frame))
+        return cabecera;
+
+    return cabecera + (size_t)frame.size;
+}
+
+/**
+ * @brief Deja lugar en el buffer para seguir recibiendo
+ *
+ * Mueve los bytes sin consumir (normalmente un frame parcial) al principio
+ * del buffer y, si el frame pendiente no entra, agranda el buffer.
+ * El tamaño del frame ya está acotado por tamanio_maximo_frame().
+ *
+ * @param decodificador Decodificador de la conexión
+ * @return bool false si no hay memoria para el frame pendiente (el buffer queda como estaba)
+ */
+static bool preparar_espacio(t_decodificador *decodificador)
+{
+    size_t pendientes = decodificador->fin - decodificador->inicio;
+    size_t necesarios = bytes_frame_pendiente(decodificador);
+
+    size_t libres = decodificador->capacidad - decodificador->fin;
+
+    // Compactar solo si el frame pendiente no entra o queda poco lugar libre
+    if (decodificador->inicio > 0 &&
+        (libres < necesarios - pendientes || libres < decodificador->capacidad / 4))
+    {
+        memmove(decodificador->buffer, decodificador->buffer + decodificador->inicio, pendientes);
+        decodificador->inicio = 0;
+        decodificador->fin = pendientes;
+    }
+
+    if (necesarios > decodificador->capacidad)
+    {
+        char *buffer = realloc(decodificador->buffer, necesarios);
+        if (buffer == NULL)
+            return false;
+        decodificador->buffer = buffer;
+        metricas_reserva(necesarios);
+        decodificador->capacidad = necesarios;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Lee del socket todos los bytes que entren en el buffer con un solo recv()
+ *
+ * Los frames extraídos antes de esta llamada dejan de ser válidos, ya que el
+ * buffer puede compactarse o agrandarse.
+ *
+ * @param decodificador Decodificador de la conexión
+ * @param socket Socket del que leer
+ * @return ssize_t Bytes leídos, 0 si el cliente cerró, -1 si hay error (ver errno)
+ */
+ssize_t decodificador_leer(t_decodificador *decodificador, int socket)
+{
+    if (!preparar_espacio(decodificador))
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    ssize_t recibidos;
+    do
+    {
+        recibidos = recv(socket,
+                         decodificador->buffer + decodificador->fin,
+                         decodificador->capacidad - decodificador->fin, 0);
+    } while (recibidos == -1 && errno == EINTR);
+
+    if (recibidos > 0)
+        decodificador->fin += recibidos;
+
+    return recibidos;
+}
+
+/**
+ * @brief Agrega al buffer bytes ya recibidos por otro medio (io_uring)
+ *
+ * Copia todos los bytes, agrandando el buffer si no entran: quien los
+ * recibió ya no los tiene en el socket. Igual que con
+ * decodificador_leer(), los frames extraídos antes dejan de ser válidos.
+ *
+ * @param decodificador Decodificador de la conexión
+ * @param datos Bytes recibidos
+ * @param cantidad Cantidad de bytes
+ * @return bool false si no hay memoria para guardarlos (el buffer queda como estaba)
+ */
+bool decodificador_cargar(t_decodificador *decodificador, const void *datos, size_t cantidad)
+{
+    if (!preparar_espacio(decodificador))
+        return false;
+
+    if (decodificador->capacidad - decodificador->fin < cantidad)
+    {
+        size_t pendientes = decodificador->fin - decodificador->inicio;
+        memmove(decodificador->buffer, decodificador->buffer + decodificador->inicio, pendientes);
+        decodificador->inicio = 0;
+        decodificador->fin = pendientes;
+    }
+
+    if (decodificador->capacidad - decodificador->fin < cantidad)
+    {
+        size_t necesarios = decodificador->fin + cantidad;
+        if (necesarios < 2 * decodificador->capacidad)
+            necesarios = 2 * decodificador->capacidad;
+        char *buffer = realloc(decodificador->buffer, necesarios);
+        if (buffer == NULL)
+            return false;
+        decodificador->buffer = buffer;
+        metricas_reserva(necesarios);
+        decodificador->capacidad = necesarios;
+    }
+
+    memcpy(decodificador->buffer + decodificador->fin, datos, cantidad);
+    decodificador->fin += cantidad;
+    return true;
+}
+
+/**
+ * @brief Extrae el siguiente frame completo del buffer
+ *
+ * No hace syscalls: solo interpreta los bytes ya recibidos.
+ *
+ * @param decodificador Decodificador de la conexión
+ * @param frame Se completa con el frame extraído
+ * @return int 1 si se extrajo un frame, 0 si falta recibir datos, -1 si el frame es inválido
+ */
+int decodificador_siguiente(t_decodificador *decodificador, t_frame *frame)
+{
+    size_t pendientes = decodificador->fin - decodificador->inicio;
+    char *inicio = decodificador->buffer + decodificador->inicio;
+
+    // El primer frame de la conexión define la versión: v2 empieza con la magia
+    if (decodificador->version == 0)
+    {
+        if (pendientes < 2)
+            return 0;
+        decodificador->version = inicio[0] == MAGIA_PROTOCOLO_0 && inicio[1] == MAGIA_PROTOCOLO_1
+                                     ? PROTOCOLO_V2
+                                     : PROTOCOLO_V1;
+    }
+
+    size_t cabecera = tamanio_cabecera(decodificador);
+    if (pendientes < cabecera)
+        return 0;
+
+    if (!leer_cabecera(decodificador, frame))
+        return -1;
+    if (pendientes - cabecera < (size_t)frame->size)
+        return 0;
+
+    frame->payload = inicio + cabecera;
+    frame->bytes = (int)(cabecera + frame->size);
+    frame->confirmar = false;
+    frame->confirmaciones = NULL;
+    decodificador->inicio += cabecera + frame->size;
+
+    if ((frame->formato.flags & FLAG_SOLICITUD) && !extraer_solicitud(frame))
+        return -1;
+    if ((frame->formato.flags & FLAG_COMPRIMIDO) && !descomprimir_frame(decodificador, frame))
+        return -1;
+
+    // Buffer vacío: volver al principio sin mover nada
+    if (decodificador->inicio == decodificador->fin)
+        decodificador->inicio = decodificador->fin = 0;
+
+    return 1;
+}
+
+/**
+ * @brief Bloquea hasta obtener un frame completo de un socket bloqueante
+ *
+ * Si en una lectura anterior llegaron varios frames, los siguientes se
+ * devuelven sin volver a llamar a recv().
+ *
+ * @param decodificador Decodificador de la conexión
+ * @param socket Socket bloqueante del que leer
+ * @param frame Se completa con el frame extraído
+ * @return int 1 si se obtuvo un frame, 0 si el cliente cerró, -1 si hay error
+ */
+int decodificador_recibir_frame(t_decodificador *decodificador, int socket, t_frame *frame)
+{
+    int resultado;
+
+    while ((resultado = decodificador_siguiente(decodificador, frame)) == 0)
+    {
+        ssize_t recibidos = decodificador_leer(decodificador, socket);
+        if (recibidos <= 0)
+            return recibidos == 0 ? 0 : -1;
+    }
+
+    return resultado;
+}
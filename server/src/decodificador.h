@@ -0,0 +1,131 @@
+#ifndef DECODIFICADOR_H_
+#define DECODIFICADOR_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include "utils.h"
+#include "metricas.h"
+#include "confirmaciones.h"
+
+/**
+ * @file decodificador.h
+ * @brief Decodificador incremental de frames [código_operación][tamaño][payload]
+ *
+ * Cada conexión tiene un decodificador con un buffer reutilizable. Una sola
+ * llamada a recv() trae todos los bytes disponibles y luego se extraen tantos
+ * frames completos como haya, sin syscalls ni copias extra: el payload de cada
+ * frame apunta directamente al buffer del decodificador.
+ *
+ * Funciona tanto con sockets bloqueantes como no bloqueantes.
+ *
+ * La versión del protocolo (v1 o v2) se detecta con el primer frame de
+ * la conexión y se mantiene para todos los siguientes.
+ *
+ * Un frame más grande que tamanio_maximo_frame() se rechaza apenas llega
+ * su cabecera, por lo que el buffer de cada conexión queda acotado.
+ */
+
+// ========== CONSTANTES ==========
+
+/**
+ * @brief Capacidad inicial por defecto del buffer de cada decodificador
+ */
+#define CAPACIDAD_DECODIFICADOR (16 * 1024)
+
+// ========== TIPOS ==========
+
+/**
+ * @brief Frame completo extraído por el decodificador
+ *
+ * El payload apunta al buffer del decodificador y solo es válido hasta la
+ * próxima llamada a decodificador_leer() o decodificador_cargar(). Si el
+ * frame llegó comprimido apunta a la copia descomprimida, válida hasta la
+ * próxima llamada a decodificador_siguiente().
+ *
+ * Si el frame trae FLAG_SOLICITUD, el ID queda en solicitud y no en el
+ * payload. El decodificador no sabe a qué conexión pertenece: quien
+ * despacha el frame completa confirmaciones con la cola de la conexión.
+ */
+typedef struct
+{
+    int cod_op;                       // Código de operación
+    int size;                         // Tamaño del payload en bytes
+    void *payload;                    // Datos del frame (no debe liberarse)
+    t_formato formato;                // Versión y flags con que llegó el frame
+    int bytes;                        // Bytes que ocupó en el socket (cabecera incluida)
+    bool confirmar;                   // true si el cliente espera un ACK de este frame
+    uint32_t solicitud;               // ID de solicitud (si confirmar)
+    t_confirmaciones *confirmaciones; // Cola donde confirmar (NULL = no confirmar)
+} t_frame;
+
+/**
+ * @brief Buffer de recepción de una conexión
+ *
+ * Los bytes válidos sin consumir están en buffer[inicio, fin).
+ */
+typedef struct
+{
+    char *buffer;     // Bytes recibidos
+    size_t capacidad; // Tamaño del buffer
+    size_t inicio;    // Primer byte sin consumir
+    size_t fin;       // Primer byte libre
+    int version;      // Versión del protocolo de la conexión (0 = sin detectar)
+    char *descomprimido;             // Payload del último frame comprimido
+    size_t capacidad_descomprimido;  // Tamaño de descomprimido
+} t_decodificador;
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Crea un decodificador con un buffer de la capacidad indicada
+ * @param capacidad Capacidad inicial (0 = CAPACIDAD_DECODIFICADOR)
+ * @return t_decodificador* Decodificador creado o NULL si no hay memoria
+ */
+t_decodificador *decodificador_crear(size_t capacidad);
+
+/**
+ * @brief Libera el decodificador y su buffer
+ * @param decodificador Decodificador a liberar
+ */
+void decodificador_destruir(t_decodificador *decodificador);
+
+/**
+ * @brief Lee del socket todos los bytes que entren en el buffer con un solo recv()
+ * @param decodificador Decodificador de la conexión
+ * @param socket Socket del que leer
+ * @return ssize_t Bytes leídos, 0 si el cliente cerró, -1 si hay error (ver errno)
+ */
+ssize_t decodificador_leer(t_decodificador *decodificador, int socket);
+
+/**
+ * @brief Agrega al buffer bytes ya recibidos por otro medio (io_uring)
+ * @param decodificador Decodificador de la conexión
+ * @param datos Bytes recibidos
+ * @param cantidad Cantidad de bytes
+ * @return bool false si no hay memoria para guardarlos
+ */
+bool decodificador_cargar(t_decodificador *decodificador, const void *datos, size_t cantidad);
+
+/**
+ * @brief Extrae el siguiente frame completo del buffer
+ * @param decodificador Decodificador de la conexión
+ * @param frame Se completa con el frame extraído
+ * @return int 1 si se extrajo un frame, 0 si falta recibir datos, -1 si el frame es inválido
+ */
+int decodificador_siguiente(t_decodificador *decodificador, t_frame *frame);
+
+/**
+ * @brief Bloquea hasta obtener un frame completo de un socket bloqueante
+ * @param decodificador Decodificador de la conexión
+ * @param socket Socket bloqueante del que leer
+ * @param frame Se completa con el frame extraído
+ * @return int 1 si se obtuvo un frame, 0 si el cliente cerró, -1 si hay error
+ */
+int decodificador_recibir_frame(t_decodificador *decodificador, int socket, t_frame *frame);
+
+#endif /* DECODIFICADOR_H_ */
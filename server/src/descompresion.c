@@ -0,0 +1,88 @@
+#include "descompresion.h"
+
+/**
+ * @brief Lee la parte de una longitud que no entró en el nibble del token
+ *
+ * @param entrada Posición de lectura (avanza)
+ * @param fin Fin del bloque
+ * @param longitud Longitud a completar (ya vale 15)
+ * @param maximo Longitud máxima aceptable
+ * @return int 0 si se leyó, -1 si el bloque se corta o la longitud se pasa de maximo
+ */
+static int leer_longitud_extra(const uint8_t **entrada, const uint8_t *fin, long *longitud, long maximo)
+{
+    uint8_t byte;
+    do
+    {
+        if (*entrada >= fin)
+            return -1;
+        byte = *(*entrada)++;
+        *longitud += byte;
+        if (*longitud > maximo)
+            return -1;
+    } while (byte == 255);
+
+    return 0;
+}
+
+/**
+ * @brief Descomprime un bloque
+ *
+ * @param origen Bloque comprimido
+ * @param tamanio Bytes del bloque comprimido
+ * @param destino Buffer de salida
+ * @param capacidad Bytes disponibles en destino
+ * @return int Bytes escritos en destino, -1 si el bloque es inválido o no entra
+ */
+int descomprimir_bloque(const void *origen, int tamanio, void *destino, int capacidad)
+{
+    const uint8_t *entrada = origen;
+    const uint8_t *fin = entrada + tamanio;
+    uint8_t *salida = destino;
+    uint8_t *fin_salida = salida + capacidad;
+
+    while (entrada < fin)
+    {
+        uint8_t token = *entrada++;
+
+        // Literales
+        long literales = token >> 4;
+        if (literales == 15 && leer_longitud_extra(&entrada, fin, &literales, capacidad) == -1)
+            return -1;
+        if (literales > fin - entrada || literales > fin_salida - salida)
+            return -1;
+        memcpy(salida, entrada, literales);
+        entrada += literales;
+        salida += literales;
+
+        // La última secuencia no tiene match
+        if (entrada == fin)
+            break;
+
+        // Match
+        if (fin - entrada < 2)
+            return -1;
+        long offset = entrada[0] | entrada[1] << 8;
+        entrada += 2;
+        if (offset == 0 || offset > salida - (uint8_t *)destino)
+            return -1;
+
+        long longitud = token & 0x0F;
+        if (longitud == 15 && leer_longitud_extra(&entrada, fin, &longitud, capacidad) == -1)
+            return -1;
+        longitud += MINIMO_MATCH_BLOQUE;
+        if (longitud > fin_salida - salida)
+            return -1;
+
+        // Con offset < longitud el match se superpone con lo que se escribe
+        const uint8_t *copia = salida - offset;
+        if (offset >= longitud)
+            memcpy(salida, copia, longitud);
+        else
+            for (long i = 0; i < longitud; i++)
+                salida[i] = copia[i];
+        salida += longitud;
+    }
+
+    return salida - (uint8_t *)destino;
+}
@@ -0,0 +1,36 @@
+#ifndef DESCOMPRESION_H_
+#define DESCOMPRESION_H_
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @file descompresion.h
+ * @brief Descompresor de bloques en formato de bloque LZ4
+ *
+ * Deshace lo que hace comprimir_bloque() en el cliente
+ * (client/src/compresion.h). Como el bloque viene de la red, se valida
+ * cada longitud y cada offset: un bloque corrupto o malicioso nunca lee
+ * ni escribe fuera de los buffers.
+ */
+
+// ========== CONSTANTES ==========
+
+/**
+ * @brief Longitud mínima de un match (la del compresor)
+ */
+#define MINIMO_MATCH_BLOQUE 4
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Descomprime un bloque
+ * @param origen Bloque comprimido
+ * @param tamanio Bytes del bloque comprimido
+ * @param destino Buffer de salida
+ * @param capacidad Bytes disponibles en destino
+ * @return int Bytes escritos en destino, -1 si el bloque es inválido o no entra
+ */
+int descomprimir_bloque(const void *origen, int tamanio, void *destino, int capacidad);
+
+#endif /* DESCOMPRESION_H_ */
@@ -0,0 +1,460 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // fallocate()
+#endif
+#include "journal.h"
+
+// ========== ESTADO DEL JOURNAL ==========
+
+static t_parametros_journal parametros;          // Parámetros con los que se inició
+static t_segmento_journal segmento = {.fd = -1}; // Segmento donde se agrega
+static unsigned long siguiente_numero;           // Número del próximo segmento a crear
+static size_t tamanio_pagina;                    // Para alinear los rangos de msync()
+
+static atomic_bool activo;            // true mientras se aceptan registros
+static bool sincronizando;            // true mientras el hilo hace msync() sin el mutex
+static bool hilo_lanzado;             // true si hay hilo de sincronización (política LOTE)
+static pthread_t hilo;                // Hilo de sincronización
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t hay_pendientes; // Avisa al hilo que se juntó un lote
+static pthread_cond_t sincronizacion_terminada = PTHREAD_COND_INITIALIZER;
+
+static uint32_t tabla_crc[256];
+static pthread_once_t tabla_crc_lista = PTHREAD_ONCE_INIT;
+
+// ========== AUXILIARES ==========
+
+/**
+ * @brief Arma la tabla del CRC-32 (polinomio reflejado 0xEDB88320)
+ */
+static void armar_tabla_crc(void)
+{
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320u : 0);
+        tabla_crc[i] = crc;
+    }
+}
+
+/**
+ * @brief Calcula (o continúa) el CRC-32 de un bloque de bytes
+ *
+ * @param crc CRC acumulado (0 para empezar)
+ * @param datos Bytes a procesar
+ * @param tamanio Cantidad de bytes
+ * @return uint32_t CRC-32 acumulado
+ */
+uint32_t crc32_journal(uint32_t crc, const void *datos, size_t tamanio)
+{
+    pthread_once(&tabla_crc_lista, armar_tabla_crc);
+
+    const uint8_t *bytes = datos;
+    crc = ~crc;
+    for (size_t i = 0; i < tamanio; i++)
+        crc = tabla_crc[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+/**
+ * @brief Escribe un entero de 32 bits en little-endian
+ *
+ * @param destino Lugar para 4 bytes
+ * @param valor Valor a escribir
+ */
+static void escribir_u32le(uint8_t *destino, uint32_t valor)
+{
+    for (int i = 0; i < 4; i++)
+        destino[i] = (uint8_t)(valor >> (8 * i));
+}
+
+/**
+ * @brief Escribe un entero de 64 bits en little-endian
+ *
+ * @param destino Lugar para 8 bytes
+ * @param valor Valor a escribir
+ */
+static void escribir_u64le(uint8_t *destino, uint64_t valor)
+{
+    for (int i = 0; i < 8; i++)
+        destino[i] = (uint8_t)(valor >> (8 * i));
+}
+
+/**
+ * @brief Busca el número de segmento más alto que ya existe en el directorio
+ *
+ * @param directorio Directorio de los segmentos
+ * @return unsigned long Número más alto (0 si no hay segmentos)
+ */
+static unsigned long ultimo_segmento(const char *directorio)
+{
+    unsigned long ultimo = 0;
+    DIR *dir = opendir(directorio);
+    if (dir == NULL)
+        return 0;
+
+    struct dirent *entrada;
+    while ((entrada = readdir(dir)) != NULL)
+    {
+        char *fin;
+        unsigned long numero = strtoul(entrada->d_name, &fin, 10);
+        if (fin != entrada->d_name && strcmp(fin, EXTENSION_JOURNAL) == 0 && numero > ultimo)
+            ultimo = numero;
+    }
+
+    closedir(dir);
+    return ultimo;
+}
+
+/**
+ * @brief Fuerza a disco el directorio para que la entrada del segmento sobreviva
+ */
+static void sincronizar_directorio(void)
+{
+    int fd = open(parametros.directorio, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1)
+        return;
+    fsync(fd);
+    close(fd);
+}
+
+/**
+ * @brief Crea, preasigna y mapea el siguiente segmento
+ *
+ * El segmento tiene al menos parametros.tamanio_segmento bytes, o más si
+ * el registro que no entraba en el anterior es más grande.
+ *
+ * @param minimo Bytes de registro que tienen que entrar
+ * @return bool true si el segmento quedó listo
+ */
+static bool abrir_segmento(size_t minimo)
+{
+    size_t tamanio = parametros.tamanio_segmento;
+    if (tamanio < TAMANIO_CABECERA_SEGMENTO + minimo)
+        tamanio = TAMANIO_CABECERA_SEGMENTO + minimo;
+    tamanio = (tamanio + tamanio_pagina - 1) & ~(tamanio_pagina - 1);
+
+    char ruta[PATH_MAX + 32];
+    snprintf(ruta, sizeof(ruta), "%s/%08lu%s", parametros.directorio, siguiente_numero, EXTENSION_JOURNAL);
+
+    int fd = open(ruta, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd == -1)
+    {
+        log_error(logger, "No se pudo crear el segmento %s: %s", ruta, strerror(errno));
+        return false;
+    }
+
+    // Preasignar los bloques: escribir en el mapa no los tiene que reservar
+    if (fallocate(fd, 0, 0, tamanio) != 0 && ftruncate(fd, tamanio) != 0)
+    {
+        log_error(logger, "No se pudo preasignar el segmento %s: %s", ruta, strerror(errno));
+        close(fd);
+        unlink(ruta);
+        return false;
+    }
+
+    uint8_t *mapa = mmap(NULL, tamanio, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapa == MAP_FAILED)
+    {
+        log_error(logger, "No se pudo mapear el segmento %s: %s", ruta, strerror(errno));
+        close(fd);
+        unlink(ruta);
+        return false;
+    }
+
+    memcpy(mapa, MAGICO_JOURNAL, 4);
+    escribir_u32le(mapa + 4, VERSION_JOURNAL);
+    escribir_u64le(mapa + 8, siguiente_numero);
+
+    if (parametros.politica != JOURNAL_FSYNC_NUNCA)
+    {
+        fsync(fd);
+        sincronizar_directorio();
+    }
+
+    segmento = (t_segmento_journal){
+        .fd = fd,
+        .mapa = mapa,
+        .tamanio = tamanio,
+        .escrito = TAMANIO_CABECERA_SEGMENTO,
+        .sincronizado = 0,
+        .numero = siguiente_numero};
+    siguiente_numero++;
+
+    return true;
+}
+
+/**
+ * @brief Fuerza a disco un rango del segmento
+ *
+ * msync() exige una dirección alineada a página: el rango se extiende
+ * hacia atrás hasta el comienzo de su página.
+ *
+ * @param mapa Segmento mapeado
+ * @param desde Primer byte a sincronizar
+ * @param hasta Fin (exclusivo) del rango
+ */
+static void sincronizar_rango(uint8_t *mapa, size_t desde, size_t hasta)
+{
+    size_t inicio = desde & ~(tamanio_pagina - 1);
+    if (hasta > inicio)
+        msync(mapa + inicio, hasta - inicio, MS_SYNC);
+}
+
+/**
+ * @brief Cierra el segmento actual dejando el archivo del tamaño escrito
+ *
+ * Se llama con el mutex tomado y sin una sincronización en curso.
+ */
+static void cerrar_segmento(void)
+{
+    if (segmento.fd == -1)
+        return;
+
+    if (parametros.politica != JOURNAL_FSYNC_NUNCA)
+        sincronizar_rango(segmento.mapa, segmento.sincronizado, segmento.escrito);
+    munmap(segmento.mapa, segmento.tamanio);
+
+    // Sacar la parte preasignada que no se usó
+    if (ftruncate(segmento.fd, segmento.escrito) == 0 && parametros.politica != JOURNAL_FSYNC_NUNCA)
+        fsync(segmento.fd);
+    close(segmento.fd);
+
+    segmento = (t_segmento_journal){.fd = -1};
+}
+
+/**
+ * @brief Suma milisegundos al reloj monotónico actual
+ *
+ * @param milisegundos Milisegundos a sumar
+ * @return struct timespec Instante resultante
+ */
+static struct timespec dentro_de_ms(int milisegundos)
+{
+    struct timespec instante;
+    clock_gettime(CLOCK_MONOTONIC, &instante);
+    instante.tv_sec += milisegundos / 1000;
+    instante.tv_nsec += (long)(milisegundos % 1000) * 1000000;
+    if (instante.tv_nsec >= 1000000000)
+    {
+        instante.tv_sec++;
+        instante.tv_nsec -= 1000000000;
+    }
+    return instante;
+}
+
+/**
+ * @brief Hilo que sincroniza el segmento por lotes (política LOTE)
+ *
+ * Duerme hasta que se juntan lote_bytes sin sincronizar o vence el
+ * intervalo. El msync() se hace sin el mutex para no frenar a quienes
+ * agregan registros; mientras tanto el segmento no se puede rotar.
+ *
+ * @param argumento No se usa
+ * @return void* Siempre NULL
+ */
+static void *sincronizar_por_lotes(void *argumento)
+{
+    (void)argumento;
+
+    pthread_mutex_lock(&mutex);
+    while (atomic_load(&activo))
+    {
+        if (segmento.escrito - segmento.sincronizado < parametros.lote_bytes)
+        {
+            struct timespec vencimiento = dentro_de_ms(parametros.intervalo_ms);
+            pthread_cond_timedwait(&hay_pendientes, &mutex, &vencimiento);
+        }
+
+        if (segmento.fd == -1 || segmento.escrito == segmento.sincronizado)
+            continue;
+
+        uint8_t *mapa = segmento.mapa;
+        size_t desde = segmento.sincronizado;
+        size_t hasta = segmento.escrito;
+
+        sincronizando = true;
+        pthread_mutex_unlock(&mutex);
+        sincronizar_rango(mapa, desde, hasta);
+        pthread_mutex_lock(&mutex);
+        sincronizando = false;
+
+        segmento.sincronizado = hasta;
+        pthread_cond_broadcast(&sincronizacion_terminada);
+    }
+    pthread_mutex_unlock(&mutex);
+
+    return NULL;
+}
+
+// ========== API ==========
+
+/**
+ * @brief Abre un segmento nuevo en el directorio y lanza la sincronización
+ *
+ * Los segmentos existentes no se tocan: se numera a continuación del
+ * último, así cada arranque del servidor empieza en un segmento propio.
+ *
+ * @param elegidos Directorio, tamaños y política de fsync
+ * @return bool true si el journal quedó activo
+ */
+bool iniciar_journal(t_parametros_journal elegidos)
+{
+    if (atomic_load(&activo))
+        return true;
+
+    parametros = elegidos;
+    if (parametros.tamanio_segmento == 0)
+        parametros.tamanio_segmento = TAMANIO_SEGMENTO_JOURNAL;
+    if (parametros.lote_bytes == 0)
+        parametros.lote_bytes = LOTE_BYTES_JOURNAL;
+    if (parametros.intervalo_ms <= 0)
+        parametros.intervalo_ms = INTERVALO_JOURNAL_MS;
+    tamanio_pagina = sysconf(_SC_PAGESIZE);
+
+    if (mkdir(parametros.directorio, 0755) != 0 && errno != EEXIST)
+    {
+        log_error(logger, "No se pudo crear el directorio del journal %s: %s", parametros.directorio, strerror(errno));
+        return false;
+    }
+
+    siguiente_numero = ultimo_segmento(parametros.directorio) + 1;
+    if (!abrir_segmento(0))
+        return false;
+
+    // Los plazos se miden con el reloj monotónico, inmune a cambios de hora
+    pthread_condattr_t atributos;
+    pthread_condattr_init(&atributos);
+    pthread_condattr_setclock(&atributos, CLOCK_MONOTONIC);
+    pthread_cond_init(&hay_pendientes, &atributos);
+    pthread_condattr_destroy(&atributos);
+
+    atomic_store(&activo, true);
+    hilo_lanzado = false;
+    if (parametros.politica == JOURNAL_FSYNC_LOTE)
+    {
+        if (pthread_create(&hilo, NULL, sincronizar_por_lotes, NULL) != 0)
+        {
+            atomic_store(&activo, false);
+            cerrar_segmento();
+            pthread_cond_destroy(&hay_pendientes);
+            return false;
+        }
+        hilo_lanzado = true;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Agrega un frame recibido al journal
+ *
+ * Con el mutex tomado reserva el lugar, copia cabecera y payload al
+ * segmento mapeado y calcula el crc. Si el registro no entra, antes
+ * rota al segmento siguiente. Con la política SIEMPRE también espera el
+ * msync() del registro; con LOTE solo avisa al hilo si se juntó un lote.
+ *
+ * @param conexion Socket por el que llegó el frame
+ * @param cod_op Código de operación del frame
+ * @param formato Versión y flags con que llegó el frame
+ * @param payload Datos del frame (se copian)
+ * @param size Tamaño del payload
+ * @return bool true si se agregó
+ */
+bool registrar_en_journal(int conexion, op_code cod_op, t_formato formato, const void *payload, int size)
+{
+    if (!atomic_load_explicit(&activo, memory_order_relaxed) || size < 0)
+        return false;
+
+    struct timespec ahora;
+    clock_gettime(CLOCK_REALTIME, &ahora);
+    uint64_t instante = (uint64_t)ahora.tv_sec * 1000000000u + ahora.tv_nsec;
+
+    size_t registro = (TAMANIO_CABECERA_REGISTRO + (size_t)size + ALINEACION_REGISTRO - 1) & ~(size_t)(ALINEACION_REGISTRO - 1);
+
+    pthread_mutex_lock(&mutex);
+
+    // finalizar_journal() pudo cerrar el segmento mientras se esperaba el mutex
+    if (!atomic_load(&activo))
+    {
+        pthread_mutex_unlock(&mutex);
+        return false;
+    }
+
+    if (segmento.fd == -1 || segmento.escrito + registro > segmento.tamanio)
+    {
+        while (sincronizando)
+            pthread_cond_wait(&sincronizacion_terminada, &mutex);
+        cerrar_segmento();
+        if (!abrir_segmento(registro))
+        {
+            pthread_mutex_unlock(&mutex);
+            return false;
+        }
+    }
+
+    uint8_t *destino = segmento.mapa + segmento.escrito;
+    escribir_u64le(destino + 8, instante);
+    escribir_u32le(destino + 16, cod_op);
+    destino[20] = formato.version;
+    destino[21] = formato.flags;
+    destino[22] = (uint8_t)conexion;
+    destino[23] = (uint8_t)(conexion >> 8);
+    memcpy(destino + TAMANIO_CABECERA_REGISTRO, payload, size);
+    escribir_u32le(destino + 4, crc32_journal(0, destino + 8, TAMANIO_CABECERA_REGISTRO - 8 + size));
+    escribir_u32le(destino, size);
+    segmento.escrito += registro;
+
+    if (parametros.politica == JOURNAL_FSYNC_SIEMPRE)
+    {
+        sincronizar_rango(segmento.mapa, segmento.sincronizado, segmento.escrito);
+        segmento.sincronizado = segmento.escrito;
+    }
+    else if (parametros.politica == JOURNAL_FSYNC_LOTE &&
+             segmento.escrito - segmento.sincronizado >= parametros.lote_bytes)
+        pthread_cond_signal(&hay_pendientes);
+
+    pthread_mutex_unlock(&mutex);
+    return true;
+}
+
+/**
+ * @brief Sincroniza lo pendiente según la política y cierra el segmento
+ *
+ * Se llama al apagar, después de que los manejadores terminaron.
+ */
+void finalizar_journal(void)
+{
+    if (!atomic_load(&activo))
+        return;
+
+    pthread_mutex_lock(&mutex);
+    atomic_store(&activo, false);
+    pthread_cond_signal(&hay_pendientes);
+    pthread_mutex_unlock(&mutex);
+
+    if (hilo_lanzado)
+        pthread_join(hilo, NULL);
+
+    pthread_mutex_lock(&mutex);
+    cerrar_segmento();
+    pthread_mutex_unlock(&mutex);
+
+    pthread_cond_destroy(&hay_pendientes);
+}
+
+/**
+ * @brief Convierte el texto de configuración en una política de fsync
+ *
+ * @param texto "NUNCA", "LOTE" o "SIEMPRE"
+ * @return t_politica_fsync Política (LOTE si el texto no se reconoce)
+ */
+t_politica_fsync politica_fsync_desde_texto(char *texto)
+{
+    if (texto != NULL && strcmp(texto, "NUNCA") == 0)
+        return JOURNAL_FSYNC_NUNCA;
+    if (texto != NULL && strcmp(texto, "SIEMPRE") == 0)
+        return JOURNAL_FSYNC_SIEMPRE;
+
+    return JOURNAL_FSYNC_LOTE;
+}
@@ -0,0 +1,185 @@
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <commons/log.h>
+#include "utils.h"
+
+/**
+ * @file journal.h
+ * @brief Journal binario de los frames recibidos, sobre segmentos mapeados
+ *
+ * Cada frame MENSAJE/PAQUETE se agrega tal cual llegó (ya descomprimido)
+ * al final del segmento actual, un archivo preasignado con fallocate() y
+ * mapeado en memoria: agregar un registro es una copia, sin formatear
+ * ni llamar a write(). Cuando el segmento se llena se trunca a lo
+ * escrito y se abre el siguiente.
+ *
+ * Formato de un segmento <directorio>/<número de 8 dígitos>.journal:
+ *
+ *   [magic "TPJ1"][u32le versión][u64le número de segmento]
+ *   registro, registro, ... (hasta EOF o hasta una longitud 0)
+ *
+ * Cada registro empieza alineado a 8 bytes:
+ *
+ *   [u32le longitud del payload][u32le crc32][u64le instante en ns]
+ *   [u32le cod_op][u8 versión][u8 flags][u16le conexión][payload]
+ *
+ * El crc32 cubre desde el instante hasta el final del payload, así un
+ * registro a medio escribir antes de una caída se detecta al leerlo.
+ * La conexión (16 bits bajos del socket) solo identifica qué frames
+ * llegaron por la misma conexión, para reproducir juntos los fragmentos
+ * de un paquete.
+ *
+ * La política de fsync decide cuándo se fuerza a disco lo escrito: nunca
+ * (lo hace el kernel), por lotes desde un hilo de fondo (por bytes o por
+ * tiempo) o después de cada registro.
+ */
+
+// ========== CONSTANTES ==========
+
+/**
+ * @brief Primeros bytes de cada segmento
+ */
+#define MAGICO_JOURNAL "TPJ1"
+
+/**
+ * @brief Versión del formato de los segmentos
+ */
+#define VERSION_JOURNAL 1
+
+/**
+ * @brief Extensión de los archivos de segmento
+ */
+#define EXTENSION_JOURNAL ".journal"
+
+/**
+ * @brief Bytes de la cabecera de un segmento
+ */
+#define TAMANIO_CABECERA_SEGMENTO 16
+
+/**
+ * @brief Bytes de la cabecera de un registro
+ */
+#define TAMANIO_CABECERA_REGISTRO 24
+
+/**
+ * @brief Alineación de cada registro dentro del segmento
+ */
+#define ALINEACION_REGISTRO 8
+
+/**
+ * @brief Tamaño por defecto de cada segmento
+ */
+#define TAMANIO_SEGMENTO_JOURNAL (64 * 1024 * 1024)
+
+/**
+ * @brief Bytes sin sincronizar que despiertan al hilo de fondo (política LOTE)
+ */
+#define LOTE_BYTES_JOURNAL (1024 * 1024)
+
+/**
+ * @brief Espera máxima entre sincronizaciones (política LOTE)
+ */
+#define INTERVALO_JOURNAL_MS 100
+
+// ========== TIPOS ==========
+
+/**
+ * @brief Cuándo se fuerza a disco lo escrito en el journal
+ */
+typedef enum
+{
+    JOURNAL_FSYNC_NUNCA,  // Lo escribe el kernel cuando quiera (y al rotar no se espera)
+    JOURNAL_FSYNC_LOTE,   // msync() desde un hilo de fondo por bytes o por tiempo
+    JOURNAL_FSYNC_SIEMPRE // msync() antes de volver de cada registro
+} t_politica_fsync;
+
+/**
+ * @brief Parámetros del journal
+ */
+typedef struct
+{
+    char directorio[PATH_MAX];   // Directorio de los segmentos (se crea si no existe)
+    size_t tamanio_segmento;     // Bytes preasignados por segmento (0 = TAMANIO_SEGMENTO_JOURNAL)
+    t_politica_fsync politica;   // Cuándo sincronizar
+    size_t lote_bytes;           // Bytes pendientes que disparan un msync (0 = LOTE_BYTES_JOURNAL)
+    int intervalo_ms;            // Espera máxima entre msync (0 = INTERVALO_JOURNAL_MS)
+} t_parametros_journal;
+
+/**
+ * @brief Segmento mapeado donde se agregan los registros
+ */
+typedef struct
+{
+    int fd;               // Archivo del segmento
+    uint8_t *mapa;        // Segmento mapeado completo
+    size_t tamanio;       // Bytes preasignados y mapeados
+    size_t escrito;       // Bytes ocupados (cabecera incluida)
+    size_t sincronizado;  // Bytes ya forzados a disco
+    unsigned long numero; // Número del segmento
+} t_segmento_journal;
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Abre un segmento nuevo en el directorio y lanza la sincronización
+ *
+ * Los segmentos existentes no se tocan: se numera a continuación del último.
+ *
+ * @param parametros Directorio, tamaños y política de fsync
+ * @return bool true si el journal quedó activo
+ */
+bool iniciar_journal(t_parametros_journal parametros);
+
+/**
+ * @brief Agrega un frame recibido al journal
+ *
+ * Si el journal no está iniciado no hace nada. Puede llamarse desde
+ * varios hilos a la vez.
+ *
+ * @param conexion Socket por el que llegó el frame
+ * @param cod_op Código de operación del frame
+ * @param formato Versión y flags con que llegó el frame
+ * @param payload Datos del frame (se copian)
+ * @param size Tamaño del payload
+ * @return bool true si se agregó
+ */
+bool registrar_en_journal(int conexion, op_code cod_op, t_formato formato, const void *payload, int size);
+
+/**
+ * @brief Sincroniza lo pendiente según la política y cierra el segmento
+ */
+void finalizar_journal(void);
+
+/**
+ * @brief Calcula (o continúa) el CRC-32 de un bloque de bytes
+ * @param crc CRC acumulado (0 para empezar)
+ * @param datos Bytes a procesar
+ * @param tamanio Cantidad de bytes
+ * @return uint32_t CRC-32 acumulado
+ */
+uint32_t crc32_journal(uint32_t crc, const void *datos, size_t tamanio);
+
+/**
+ * @brief Convierte el texto de configuración en una política de fsync
+ * @param texto "NUNCA", "LOTE" o "SIEMPRE"
+ * @return t_politica_fsync Política (LOTE si el texto no se reconoce)
+ */
+t_politica_fsync politica_fsync_desde_texto(char *texto);
+
+#endif /* JOURNAL_H_ */
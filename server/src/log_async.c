@@ -0,0 +1,479 @@
+#include "log_async.h"
+
+// ========== ESTADO DEL LOGGER ASÍNCRONO ==========
+
+static t_entrada_log *anillo;        // Entradas del anillo
+static size_t mascara;               // capacidad - 1 (capacidad potencia de 2)
+static t_politica_log politica;      // Qué hacer con el anillo lleno
+static atomic_size_t posicion_escritura; // Próxima entrada a reservar por los productores
+static size_t posicion_lectura;          // Próxima entrada a leer (solo el consumidor)
+static atomic_ulong descartados;         // Mensajes descartados por anillo lleno
+
+static atomic_bool activo;           // true mientras se aceptan mensajes en el anillo
+static atomic_bool terminar;         // true cuando el consumidor debe vaciar el anillo y salir
+static atomic_int productores;       // Hilos dentro de log_async() que pueden usar el anillo
+static atomic_bool durmiendo;        // true si el consumidor espera en la condición
+static pthread_t hilo;               // Hilo consumidor
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t hay_entradas = PTHREAD_COND_INITIALIZER;
+
+// Buffers del consumidor, que se reutilizan entre tandas
+static char *salida;             // Líneas de la tanda en curso
+static size_t capacidad_salida;  // Bytes reservados en salida
+static size_t usados_salida;     // Bytes escritos en salida
+static char *texto_largo;        // Texto juntado de varias entradas
+static size_t capacidad_texto;   // Bytes reservados en texto_largo
+
+/**
+ * @brief Escribe una entrada con el logger global según su nivel
+ *
+ * @param nivel Nivel del mensaje
+ * @param formato Literal con un único "%.*s"
+ * @param texto Texto a insertar
+ * @param longitud Bytes de texto
+ */
+static void escribir_entrada(t_log_level nivel, const char *formato, const char *texto, int longitud)
+{
+    switch (nivel)
+    {
+    case LOG_LEVEL_TRACE:
+        log_trace(logger, formato, longitud, texto);
+        break;
+    case LOG_LEVEL_DEBUG:
+        log_debug(logger, formato, longitud, texto);
+        break;
+    case LOG_LEVEL_INFO:
+        log_info(logger, formato, longitud, texto);
+        break;
+    case LOG_LEVEL_WARNING:
+        log_warning(logger, formato, longitud, texto);
+        break;
+    default:
+        log_error(logger, formato, longitud, texto);
+        break;
+    }
+}
+
+/**
+ * @brief Agrega texto con formato al buffer de la tanda, agrandándolo si hace falta
+ *
+ * @param formato Formato de printf
+ */
+static void agregar_a_salida(const char *formato, ...)
+{
+    va_list argumentos;
+
+    while (1)
+    {
+        size_t libres = capacidad_salida - usados_salida;
+
+        va_start(argumentos, formato);
+        int escritos = vsnprintf(salida + usados_salida, libres, formato, argumentos);
+        va_end(argumentos);
+
+        if (escritos < 0)
+            return;
+        if ((size_t)escritos < libres)
+        {
+            usados_salida += escritos;
+            return;
+        }
+
+        size_t nueva_capacidad = capacidad_salida > 0 ? capacidad_salida * 2 : 64 * 1024;
+        while (nueva_capacidad - usados_salida <= (size_t)escritos)
+            nueva_capacidad *= 2;
+
+        char *nueva = realloc(salida, nueva_capacidad);
+        if (nueva == NULL)
+            return;
+        salida = nueva;
+        capacidad_salida = nueva_capacidad;
+    }
+}
+
+/**
+ * @brief Escribe de una vez las líneas de la tanda en el archivo y la consola del logger
+ */
+static void escribir_salida(void)
+{
+    if (usados_salida == 0)
+        return;
+
+    if (logger->file != NULL)
+    {
+        fwrite(salida, 1, usados_salida, logger->file);
+        fflush(logger->file);
+    }
+
+    if (logger->is_active_console)
+    {
+        fwrite(salida, 1, usados_salida, stdout);
+        fflush(stdout);
+    }
+
+    usados_salida = 0;
+}
+
+/**
+ * @brief Cantidad de entradas que ocupa un texto
+ *
+ * @param longitud Bytes del texto
+ * @return size_t Entradas consecutivas necesarias (al menos una)
+ */
+static size_t entradas_para(int longitud)
+{
+    if (longitud <= TAMANIO_TEXTO_LOG)
+        return 1;
+
+    return ((size_t)longitud + TAMANIO_TEXTO_LOG - 1) / TAMANIO_TEXTO_LOG;
+}
+
+/**
+ * @brief Devuelve el texto de un mensaje, juntándolo si ocupa varias entradas
+ *
+ * @param entrada Primera entrada del mensaje
+ * @param cantidad Entradas que ocupa
+ * @return const char* Texto contiguo (o NULL si no hay memoria para juntarlo)
+ */
+static const char *texto_de_mensaje(t_entrada_log *entrada, size_t cantidad)
+{
+    if (cantidad == 1)
+        return entrada->texto;
+
+    if (capacidad_texto < (size_t)entrada->longitud)
+    {
+        char *nuevo = realloc(texto_largo, entrada->longitud);
+        if (nuevo == NULL)
+            return NULL;
+        texto_largo = nuevo;
+        capacidad_texto = entrada->longitud;
+    }
+
+    for (size_t i = 0; i < cantidad; i++)
+    {
+        int copiados = i * TAMANIO_TEXTO_LOG;
+        int bytes = entrada->longitud - copiados < TAMANIO_TEXTO_LOG ? entrada->longitud - copiados : TAMANIO_TEXTO_LOG;
+        memcpy(texto_largo + copiados, anillo[(posicion_lectura + i) & mascara].texto, bytes);
+    }
+
+    return texto_largo;
+}
+
+/**
+ * @brief Escribe hasta TANDA_LOG_ASYNC mensajes listos del anillo
+ *
+ * Cada mensaje se formatea como lo haría el logger global (nivel, hora,
+ * programa, pid e hilo) en un buffer, y la tanda entera se escribe con
+ * un solo fwrite() por destino. El productor publica la primera entrada
+ * de un mensaje después de las demás, así que si la primera está lista
+ * también lo está el resto.
+ *
+ * @param id_hilo Identificador del hilo consumidor, para las líneas
+ * @return int Cantidad de mensajes leídos del anillo
+ */
+static int vaciar_tanda(unsigned int id_hilo)
+{
+    int escritas = 0;
+    char hora[32] = "";
+
+    while (escritas < TANDA_LOG_ASYNC)
+    {
+        t_entrada_log *entrada = &anillo[posicion_lectura & mascara];
+
+        // La entrada está lista cuando su secuencia es posicion + 1
+        if (atomic_load_explicit(&entrada->secuencia, memory_order_acquire) != posicion_lectura + 1)
+            break;
+
+        // Una sola hora para toda la tanda, con el formato de las commons
+        if (hora[0] == '\0')
+        {
+            struct timespec ahora;
+            struct tm local;
+            clock_gettime(CLOCK_REALTIME, &ahora);
+            localtime_r(&ahora.tv_sec, &local);
+            snprintf(hora, sizeof(hora), "%02d:%02d:%02d:%03ld",
+                     local.tm_hour, local.tm_min, local.tm_sec, ahora.tv_nsec / 1000000);
+        }
+
+        size_t cantidad = entradas_para(entrada->longitud);
+        const char *texto = texto_de_mensaje(entrada, cantidad);
+
+        if (texto != NULL && entrada->nivel >= logger->detail)
+        {
+            agregar_a_salida("[%s] %s %s/(%d:%u): ", log_level_as_string(entrada->nivel), hora,
+                             logger->program_name, logger->pid, id_hilo);
+            agregar_a_salida(entrada->formato, entrada->longitud, texto);
+            agregar_a_salida("\n");
+        }
+
+        // Liberar las entradas para la siguiente vuelta del anillo
+        for (size_t i = 0; i < cantidad; i++)
+            atomic_store_explicit(&anillo[(posicion_lectura + i) & mascara].secuencia,
+                                  posicion_lectura + i + mascara + 1, memory_order_release);
+        posicion_lectura += cantidad;
+        escritas++;
+    }
+
+    escribir_salida();
+    return escritas;
+}
+
+/**
+ * @brief Cuerpo del hilo consumidor
+ *
+ * Vacía el anillo por tandas. Cuando no hay nada que escribir duerme en
+ * una condición con timeout, así un aviso perdido solo demora el log.
+ *
+ * @param argumento No se usa
+ * @return void* Siempre NULL
+ */
+static void *consumir_log(void *argumento)
+{
+    (void)argumento;
+    unsigned int id_hilo = syscall(SYS_gettid);
+
+    while (1)
+    {
+        if (vaciar_tanda(id_hilo) > 0)
+            continue;
+
+        unsigned long perdidos = atomic_exchange(&descartados, 0);
+        if (perdidos > 0)
+            log_warning(logger, "Log asincrono lleno: se descartaron %lu mensajes", perdidos);
+
+        if (atomic_load(&terminar))
+            break;
+
+        // Esperar productores (como máximo 10 ms)
+        struct timespec limite;
+        clock_gettime(CLOCK_REALTIME, &limite);
+        limite.tv_nsec += 10 * 1000 * 1000;
+        if (limite.tv_nsec >= 1000000000)
+        {
+            limite.tv_sec++;
+            limite.tv_nsec -= 1000000000;
+        }
+
+        pthread_mutex_lock(&mutex);
+        atomic_store(&durmiendo, true);
+        if (atomic_load_explicit(&anillo[posicion_lectura & mascara].secuencia, memory_order_acquire) != posicion_lectura + 1)
+            pthread_cond_timedwait(&hay_entradas, &mutex, &limite);
+        atomic_store(&durmiendo, false);
+        pthread_mutex_unlock(&mutex);
+    }
+
+    // Escribir lo que haya quedado antes de terminar
+    while (vaciar_tanda(id_hilo) > 0)
+        ;
+
+    free(salida);
+    free(texto_largo);
+    salida = texto_largo = NULL;
+    capacidad_salida = capacidad_texto = usados_salida = 0;
+    return NULL;
+}
+
+/**
+ * @brief Espera a que ningún productor esté usando el anillo
+ *
+ * Se llama después de apagar activo: los productores que lleguen desde
+ * entonces ya no lo tocan, y los que estaban adentro terminan enseguida
+ * (con BLOQUEAR, cuando el consumidor, que sigue corriendo, les hace lugar).
+ */
+static void esperar_productores(void)
+{
+    while (atomic_load(&productores) > 0)
+        sched_yield();
+}
+
+/**
+ * @brief Lanza el hilo de logging asíncrono sobre el logger global
+ *
+ * @param capacidad Entradas del anillo (0 = CAPACIDAD_LOG_ASYNC)
+ * @param politica_elegida Qué hacer cuando el anillo está lleno
+ * @return bool true si se inició correctamente
+ */
+bool iniciar_log_async(size_t capacidad, t_politica_log politica_elegida)
+{
+    if (atomic_load(&activo))
+        return true;
+
+    // Redondear la capacidad a potencia de 2 para indexar con una máscara
+    size_t potencia = 2;
+    while (potencia < (capacidad > 0 ? capacidad : CAPACIDAD_LOG_ASYNC))
+        potencia *= 2;
+
+    anillo = malloc(potencia * sizeof(t_entrada_log));
+    if (anillo == NULL)
+        return false;
+    for (size_t i = 0; i < potencia; i++)
+        atomic_init(&anillo[i].secuencia, i);
+
+    mascara = potencia - 1;
+    politica = politica_elegida;
+    atomic_store(&posicion_escritura, 0);
+    posicion_lectura = 0;
+    atomic_store(&descartados, 0);
+    atomic_store(&terminar, false);
+    atomic_store(&activo, true);
+
+    if (pthread_create(&hilo, NULL, consumir_log, NULL) != 0)
+    {
+        atomic_store(&activo, false);
+        esperar_productores();
+        free(anillo);
+        anillo = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Copia un mensaje al anillo
+ *
+ * Reserva las entradas que ocupa el texto con un compare-and-swap sobre
+ * la posición de escritura, copia el texto y publica las entradas. No
+ * toma locks salvo para despertar al consumidor si estaba dormido.
+ *
+ * @param nivel Nivel del mensaje
+ * @param formato Literal con un único "%.*s"
+ * @param texto Texto a insertar en el formato (se copia)
+ * @param longitud Bytes de texto
+ * @return bool true si se encoló o se descartó, false si hay que escribirlo en el momento
+ */
+static bool encolar_mensaje(t_log_level nivel, const char *formato, const void *texto, int longitud)
+{
+    size_t cantidad = entradas_para(longitud);
+
+    // Un texto que ocuparía buena parte del anillo se escribe en el momento
+    if (cantidad > 1 && cantidad > (mascara + 1) / 4)
+        return false;
+
+    t_entrada_log *entrada;
+    size_t posicion = atomic_load_explicit(&posicion_escritura, memory_order_relaxed);
+
+    while (1)
+    {
+        // El consumidor libera en orden: si la última entrada está libre, las anteriores también
+        t_entrada_log *ultima = &anillo[(posicion + cantidad - 1) & mascara];
+        size_t secuencia = atomic_load_explicit(&ultima->secuencia, memory_order_acquire);
+        intptr_t diferencia = (intptr_t)secuencia - (intptr_t)(posicion + cantidad - 1);
+
+        if (diferencia == 0)
+        {
+            // Entradas libres: intentar reservarlas
+            if (atomic_compare_exchange_weak_explicit(&posicion_escritura, &posicion, posicion + cantidad,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        }
+        else if (diferencia < 0)
+        {
+            // Anillo lleno
+            if (politica == LOG_ASYNC_DESCARTAR)
+            {
+                atomic_fetch_add_explicit(&descartados, 1, memory_order_relaxed);
+                return true;
+            }
+            sched_yield();
+            posicion = atomic_load_explicit(&posicion_escritura, memory_order_relaxed);
+        }
+        else
+        {
+            // Otro productor reservó estas entradas: reintentar con la posición actual
+            posicion = atomic_load_explicit(&posicion_escritura, memory_order_relaxed);
+        }
+    }
+
+    // Copiar la continuación del texto y publicar esas entradas primero
+    for (size_t i = 1; i < cantidad; i++)
+    {
+        int copiados = i * TAMANIO_TEXTO_LOG;
+        int bytes = longitud - copiados < TAMANIO_TEXTO_LOG ? longitud - copiados : TAMANIO_TEXTO_LOG;
+        entrada = &anillo[(posicion + i) & mascara];
+        memcpy(entrada->texto, (const char *)texto + copiados, bytes);
+        atomic_store_explicit(&entrada->secuencia, posicion + i + 1, memory_order_release);
+    }
+
+    entrada = &anillo[posicion & mascara];
+    entrada->nivel = nivel;
+    entrada->formato = formato;
+    entrada->longitud = longitud;
+    memcpy(entrada->texto, texto, longitud < TAMANIO_TEXTO_LOG ? longitud : TAMANIO_TEXTO_LOG);
+
+    // Publicar la primera entrada para el consumidor
+    atomic_store_explicit(&entrada->secuencia, posicion + 1, memory_order_release);
+
+    if (atomic_load_explicit(&durmiendo, memory_order_relaxed))
+    {
+        pthread_mutex_lock(&mutex);
+        pthread_cond_signal(&hay_entradas);
+        pthread_mutex_unlock(&mutex);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Encola un mensaje para loguearlo en segundo plano
+ *
+ * El productor se cuenta antes de mirar si el logging está activo, así
+ * finalizar_log_async() puede esperar a que nadie esté usando el anillo
+ * antes de liberarlo. Si no está activo se loguea en el momento.
+ *
+ * @param nivel Nivel del mensaje
+ * @param formato Literal con un único "%.*s"
+ * @param texto Texto a insertar en el formato (se copia)
+ * @param longitud Bytes de texto
+ */
+void log_async(t_log_level nivel, const char *formato, const void *texto, int longitud)
+{
+    if (longitud < 0)
+        longitud = 0;
+
+    atomic_fetch_add(&productores, 1);
+    bool encolado = atomic_load(&activo) && encolar_mensaje(nivel, formato, texto, longitud);
+    atomic_fetch_sub(&productores, 1);
+
+    if (!encolado)
+        escribir_entrada(nivel, formato, texto, longitud);
+}
+
+/**
+ * @brief Escribe todo lo pendiente y detiene el hilo de logging
+ *
+ * Deja de aceptar mensajes, espera a que terminen los productores que ya
+ * estaban encolando y recién entonces le pide al consumidor que vacíe el
+ * anillo y termine. Los mensajes posteriores se loguean en el momento.
+ */
+void finalizar_log_async(void)
+{
+    if (!atomic_load(&activo))
+        return;
+
+    atomic_store(&activo, false);
+    esperar_productores();
+
+    pthread_mutex_lock(&mutex);
+    atomic_store(&terminar, true);
+    pthread_cond_signal(&hay_entradas);
+    pthread_mutex_unlock(&mutex);
+
+    pthread_join(hilo, NULL);
+    free(anillo);
+    anillo = NULL;
+}
+
+/**
+ * @brief Convierte el texto de configuración en una política
+ *
+ * @param texto "DESCARTAR" o "BLOQUEAR"
+ * @return t_politica_log Política (DESCARTAR si el texto no se reconoce)
+ */
+t_politica_log politica_log_desde_texto(char *texto)
+{
+    if (texto != NULL && strcmp(texto, "BLOQUEAR") == 0)
+        return LOG_ASYNC_BLOQUEAR;
+
+    return LOG_ASYNC_DESCARTAR;
+}
@@ -0,0 +1,114 @@
+#ifndef LOG_ASYNC_H_
+#define LOG_ASYNC_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <commons/log.h>
+#include "utils.h"
+
+/**
+ * @file log_async.h
+ * @brief Logging asíncrono fuera del camino de recepción
+ *
+ * Los hilos que reciben frames no formatean ni escriben: copian el texto
+ * a una entrada de un anillo acotado sin locks (múltiples productores,
+ * un consumidor) y siguen. Un hilo de fondo vacía el anillo por tandas:
+ * arma las líneas de toda la tanda en un buffer, con el mismo formato que
+ * el logger global del servidor, y las escribe con un solo fwrite().
+ *
+ * Un texto que no entra en una entrada ocupa varias consecutivas. Si
+ * necesita más de la cuarta parte del anillo se loguea en el momento.
+ *
+ * Si el anillo se llena, la política configurada decide si el mensaje se
+ * descarta (y se informa la cantidad descartada) o si el productor espera.
+ */
+
+// ========== CONSTANTES ==========
+
+/**
+ * @brief Bytes de texto por entrada (un texto más largo ocupa varias)
+ */
+#define TAMANIO_TEXTO_LOG 224
+
+/**
+ * @brief Capacidad por defecto del anillo (se redondea a potencia de 2)
+ */
+#define CAPACIDAD_LOG_ASYNC 65536
+
+/**
+ * @brief Cantidad máxima de mensajes que escribe el consumidor por tanda
+ */
+#define TANDA_LOG_ASYNC 256
+
+// ========== TIPOS ==========
+
+/**
+ * @brief Qué hacer cuando el anillo está lleno
+ */
+typedef enum
+{
+    LOG_ASYNC_DESCARTAR, // Descartar el mensaje y contarlo
+    LOG_ASYNC_BLOQUEAR   // Esperar a que el consumidor libere lugar
+} t_politica_log;
+
+/**
+ * @brief Entrada del anillo de log
+ *
+ * El formato debe ser un literal con un único "%.*s", que se completa
+ * con el texto copiado al momento de encolar. Si el texto ocupa varias
+ * entradas, la primera tiene el nivel, el formato y la longitud total, y
+ * las siguientes solo la continuación del texto.
+ */
+typedef struct
+{
+    atomic_size_t secuencia;         // Turno de la entrada (protocolo del anillo)
+    t_log_level nivel;               // Nivel del mensaje
+    const char *formato;             // Literal con un único "%.*s"
+    int longitud;                    // Bytes del texto completo
+    char texto[TAMANIO_TEXTO_LOG];   // Copia del texto a formatear
+} t_entrada_log;
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Lanza el hilo de logging asíncrono sobre el logger global
+ * @param capacidad Entradas del anillo (0 = CAPACIDAD_LOG_ASYNC)
+ * @param politica Qué hacer cuando el anillo está lleno
+ * @return bool true si se inició correctamente
+ */
+bool iniciar_log_async(size_t capacidad, t_politica_log politica);
+
+/**
+ * @brief Encola un mensaje para loguearlo en segundo plano
+ *
+ * Si el logging asíncrono no está iniciado se loguea en el momento.
+ *
+ * @param nivel Nivel del mensaje
+ * @param formato Literal con un único "%.*s"
+ * @param texto Texto a insertar en el formato (se copia)
+ * @param longitud Bytes de texto
+ */
+void log_async(t_log_level nivel, const char *formato, const void *texto, int longitud);
+
+/**
+ * @brief Escribe todo lo pendiente y detiene el hilo de logging
+ */
+void finalizar_log_async(void);
+
+/**
+ * @brief Convierte el texto de configuración en una política
+ * @param texto "DESCARTAR" o "BLOQUEAR"
+ * @return t_politica_log Política (DESCARTAR si el texto no se reconoce)
+ */
+t_politica_log politica_log_desde_texto(char *texto);
+
+#endif /* LOG_ASYNC_H_ */
@@ -0,0 +1,520 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // open_memstream()
+#endif
+#include "metricas.h"
+#include "operaciones.h"
+
+// ========== ESTADO DE LAS MÉTRICAS ==========
+
+static atomic_bool activas;                                   // true mientras se cuenta
+static t_metricas_hilo *_Atomic hilos[MAXIMO_HILOS_METRICAS]; // Bloque de cada hilo registrado
+static atomic_int cantidad_hilos;                             // Hilos que pidieron bloque
+static t_metricas_hilo compartidas;                           // Para los hilos que no entran
+static __thread t_metricas_hilo *propias;                     // Bloque del hilo actual
+
+static int socket_consulta = -1;                 // Socket Unix de escucha (-1 = ninguno)
+static char ruta_consulta[TAMANIO_RUTA_METRICAS]; // Ruta para borrarlo al finalizar
+static bool hilo_lanzado;                        // true si hay hilo atendiendo consultas
+static pthread_t hilo;                           // Hilo que atiende el socket
+
+// Frames de la consulta anterior, para calcular frames/s
+static pthread_mutex_t mutex_consulta = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t frames_anteriores[OP_CODE_MAX + 1];
+static uint64_t instante_anterior;
+static uint64_t instante_inicio;
+
+// ========== AUXILIARES ==========
+
+/**
+ * @brief Nanosegundos del reloj monotónico
+ *
+ * @return uint64_t Instante actual
+ */
+static uint64_t ahora_ns(void)
+{
+    struct timespec instante;
+    clock_gettime(CLOCK_MONOTONIC, &instante);
+    return (uint64_t)instante.tv_sec * 1000000000 + instante.tv_nsec;
+}
+
+/**
+ * @brief Suma a un contador del hilo actual
+ *
+ * Como solo lo escribe su hilo no hace falta un fetch_add: una lectura y
+ * una escritura relajadas alcanzan y no bloquean el bus. El bloque
+ * compartido lo escriben varios hilos, así que ahí sí se usa fetch_add.
+ *
+ * @param contador Contador del bloque de metricas_del_hilo()
+ * @param cantidad Cantidad a sumar
+ */
+static inline void sumar(atomic_uint_fast64_t *contador, uint64_t cantidad)
+{
+    if (propias == &compartidas)
+        atomic_fetch_add_explicit(contador, cantidad, memory_order_relaxed);
+    else
+        atomic_store_explicit(contador, atomic_load_explicit(contador, memory_order_relaxed) + cantidad,
+                              memory_order_relaxed);
+}
+
+/**
+ * @brief Sube un máximo del hilo actual si el valor lo supera
+ *
+ * En el bloque compartido se compara e intercambia, así otro hilo no
+ * pisa un máximo mayor.
+ *
+ * @param maximo Máximo del bloque de metricas_del_hilo()
+ * @param valor Valor observado
+ */
+static inline void subir_maximo(atomic_uint_fast64_t *maximo, uint64_t valor)
+{
+    uint_fast64_t actual = atomic_load_explicit(maximo, memory_order_relaxed);
+    if (propias != &compartidas)
+    {
+        if (valor > actual)
+            atomic_store_explicit(maximo, valor, memory_order_relaxed);
+        return;
+    }
+
+    while (valor > actual &&
+           !atomic_compare_exchange_weak_explicit(maximo, &actual, valor, memory_order_relaxed, memory_order_relaxed))
+        ;
+}
+
+/**
+ * @brief Lee un contador de cualquier hilo
+ *
+ * @param contador Contador a leer
+ * @return uint64_t Valor actual
+ */
+static inline uint64_t leer(atomic_uint_fast64_t *contador)
+{
+    return atomic_load_explicit(contador, memory_order_relaxed);
+}
+
+/**
+ * @brief Bloque de contadores del hilo actual, creándolo la primera vez
+ *
+ * Si no hay lugar o memoria para un bloque propio, el hilo usa el
+ * compartido (su lugar en hilos queda en NULL y se saltea al sumar).
+ *
+ * @return t_metricas_hilo* Bloque propio (o el compartido si no hay lugar)
+ */
+static t_metricas_hilo *metricas_del_hilo(void)
+{
+    if (propias != NULL)
+        return propias;
+
+    int indice = atomic_fetch_add(&cantidad_hilos, 1);
+    if (indice >= MAXIMO_HILOS_METRICAS)
+        return propias = &compartidas;
+
+    t_metricas_hilo *bloque = aligned_alloc(_Alignof(t_metricas_hilo), sizeof(t_metricas_hilo));
+    if (bloque == NULL)
+        return propias = &compartidas;
+    memset(bloque, 0, sizeof(t_metricas_hilo));
+    atomic_store(&hilos[indice], bloque);
+    return propias = bloque;
+}
+
+/**
+ * @brief Cubeta donde se cuenta una latencia (log-lineal, como el histograma del bench)
+ *
+ * @param valor Latencia en ns
+ * @return int Índice de la cubeta
+ */
+static int cubeta_latencia(uint64_t valor)
+{
+    if (valor < (1u << BITS_CUBETA_LATENCIA))
+        return (int)valor;
+
+    int desplazamiento = 63 - __builtin_clzll(valor) - (BITS_CUBETA_LATENCIA - 1);
+    return desplazamiento * MEDIA_CUBETA_LATENCIA + (int)(valor >> desplazamiento);
+}
+
+/**
+ * @brief Mayor latencia que se cuenta en una cubeta
+ *
+ * @param indice Índice de la cubeta
+ * @return uint64_t Límite superior (inclusive)
+ */
+static uint64_t limite_cubeta_latencia(int indice)
+{
+    if (indice < (1 << BITS_CUBETA_LATENCIA))
+        return (uint64_t)indice;
+
+    int desplazamiento = indice / MEDIA_CUBETA_LATENCIA - 1;
+    uint64_t mantisa = (uint64_t)(indice - desplazamiento * MEDIA_CUBETA_LATENCIA);
+    return ((mantisa + 1) << desplazamiento) - 1;
+}
+
+/**
+ * @brief Percentil de un histograma de latencias ya sumado
+ *
+ * @param cubetas Conteos por cubeta
+ * @param total Suma de los conteos
+ * @param maxima Mayor latencia vista (acota el resultado)
+ * @param percentil Percentil entre 0 y 100
+ * @return uint64_t Latencia del percentil en ns (0 si no hay datos)
+ */
+static uint64_t percentil_latencia(const uint64_t *cubetas, uint64_t total, uint64_t maxima, double percentil)
+{
+    if (total == 0)
+        return 0;
+
+    uint64_t objetivo = (uint64_t)(percentil / 100.0 * total + 0.5);
+    if (objetivo < 1)
+        objetivo = 1;
+
+    uint64_t acumulado = 0;
+    for (int i = 0; i < CUBETAS_LATENCIA; i++)
+    {
+        acumulado += cubetas[i];
+        if (acumulado >= objetivo)
+        {
+            uint64_t limite = limite_cubeta_latencia(i);
+            return limite < maxima ? limite : maxima;
+        }
+    }
+
+    return maxima;
+}
+
+// ========== CONTADORES ==========
+
+/**
+ * @brief Indica si se están contando métricas
+ *
+ * @return bool true entre iniciar_metricas() y finalizar_metricas()
+ */
+bool metricas_activas(void)
+{
+    return atomic_load_explicit(&activas, memory_order_relaxed);
+}
+
+/**
+ * @brief Instante para medir la latencia de un manejador
+ *
+ * @return uint64_t Nanosegundos monotónicos (0 si no se cuentan métricas)
+ */
+uint64_t metricas_instante(void)
+{
+    return metricas_activas() ? ahora_ns() : 0;
+}
+
+/**
+ * @brief Cuenta una conexión aceptada
+ */
+void metricas_conexion_abierta(void)
+{
+    if (metricas_activas())
+        sumar(&metricas_del_hilo()->conexiones_abiertas, 1);
+}
+
+/**
+ * @brief Cuenta una conexión cerrada
+ */
+void metricas_conexion_cerrada(void)
+{
+    if (metricas_activas())
+        sumar(&metricas_del_hilo()->conexiones_cerradas, 1);
+}
+
+/**
+ * @brief Cuenta bytes leídos de un socket
+ *
+ * @param bytes Bytes recibidos
+ */
+void metricas_bytes_recibidos(size_t bytes)
+{
+    if (metricas_activas())
+        sumar(&metricas_del_hilo()->bytes_recibidos, bytes);
+}
+
+/**
+ * @brief Cuenta un frame inválido o mal formado
+ */
+void metricas_error_decodificacion(void)
+{
+    if (metricas_activas())
+        sumar(&metricas_del_hilo()->errores_decodificacion, 1);
+}
+
+/**
+ * @brief Cuenta una conexión que se deja de leer por falta de memoria
+ */
+void metricas_lectura_pausada(void)
+{
+    if (metricas_activas())
+        sumar(&metricas_del_hilo()->lecturas_pausadas, 1);
+}
+
+/**
+ * @brief Cuenta memoria reservada en el camino de recepción
+ *
+ * @param bytes Bytes reservados
+ */
+void metricas_reserva(size_t bytes)
+{
+    if (metricas_activas())
+        sumar(&metricas_del_hilo()->bytes_reservados, bytes);
+}
+
+/**
+ * @brief Cuenta un frame procesado y la latencia de su manejador
+ *
+ * @param cod_op Código de operación (fuera de rango = desconocido, sin latencia)
+ * @param inicio Valor de metricas_instante() antes de decodificar
+ */
+void metricas_frame(int cod_op, uint64_t inicio)
+{
+    if (!metricas_activas())
+        return;
+
+    t_metricas_hilo *metricas = metricas_del_hilo();
+    if ((unsigned)cod_op >= OP_CODE_MAX)
+    {
+        sumar(&metricas->frames[OPERACION_DESCONOCIDA], 1);
+        return;
+    }
+
+    sumar(&metricas->frames[cod_op], 1);
+    if (inicio == 0)
+        return;
+
+    uint64_t latencia = ahora_ns() - inicio;
+    sumar(&metricas->latencias[cod_op][cubeta_latencia(latencia)], 1);
+    subir_maximo(&metricas->latencia_maxima[cod_op], latencia);
+}
+
+// ========== RESUMEN ==========
+
+/**
+ * @brief Suma los contadores de todos los hilos y arma el resumen en texto
+ *
+ * Los frames/s de cada operación se calculan contra la consulta anterior
+ * (o contra el inicio, en la primera).
+ *
+ * @return char* Resumen (liberar con free())
+ */
+char *texto_metricas(void)
+{
+    uint64_t abiertas = 0, cerradas = 0, bytes = 0, errores = 0, reservados = 0, pausadas = 0, maxima[OP_CODE_MAX] = {0};
+    uint64_t frames[OP_CODE_MAX + 1] = {0};
+    uint64_t latencias[OP_CODE_MAX][CUBETAS_LATENCIA] = {{0}};
+
+    int cantidad = atomic_load(&cantidad_hilos);
+    if (cantidad > MAXIMO_HILOS_METRICAS)
+        cantidad = MAXIMO_HILOS_METRICAS;
+
+    for (int i = 0; i <= cantidad; i++)
+    {
+        // El último lugar es el bloque compartido
+        t_metricas_hilo *metricas = i < cantidad ? atomic_load(&hilos[i]) : &compartidas;
+        if (metricas == NULL)
+            continue; // Hilo registrándose en este momento
+
+        abiertas += leer(&metricas->conexiones_abiertas);
+        cerradas += leer(&metricas->conexiones_cerradas);
+        bytes += leer(&metricas->bytes_recibidos);
+        errores += leer(&metricas->errores_decodificacion);
+        reservados += leer(&metricas->bytes_reservados);
+        pausadas += leer(&metricas->lecturas_pausadas);
+        for (int op = 0; op <= OP_CODE_MAX; op++)
+            frames[op] += leer(&metricas->frames[op]);
+        for (int op = 0; op < OP_CODE_MAX; op++)
+        {
+            for (int c = 0; c < CUBETAS_LATENCIA; c++)
+                latencias[op][c] += leer(&metricas->latencias[op][c]);
+            uint64_t maxima_hilo = leer(&metricas->latencia_maxima[op]);
+            if (maxima_hilo > maxima[op])
+                maxima[op] = maxima_hilo;
+        }
+    }
+
+    char *texto = NULL;
+    size_t size = 0;
+    FILE *salida = open_memstream(&texto, &size);
+
+    pthread_mutex_lock(&mutex_consulta);
+    uint64_t ahora = ahora_ns();
+    double segundos = (ahora - instante_anterior) / 1e9;
+
+    fprintf(salida, "tiempo_activo_s %.1f\n", (ahora - instante_inicio) / 1e9);
+    fprintf(salida, "conexiones_activas %lu\n", (unsigned long)(abiertas - cerradas));
+    fprintf(salida, "conexiones_aceptadas %lu\n", (unsigned long)abiertas);
+    fprintf(salida, "bytes_recibidos %lu\n", (unsigned long)bytes);
+    fprintf(salida, "errores_decodificacion %lu\n", (unsigned long)errores);
+    fprintf(salida, "bytes_reservados %lu\n", (unsigned long)reservados);
+    fprintf(salida, "lecturas_pausadas %lu\n", (unsigned long)pausadas);
+
+    for (int op = 0; op <= OP_CODE_MAX; op++)
+    {
+        t_operacion *operacion = op < OP_CODE_MAX ? buscar_operacion(op) : NULL;
+        if (op < OP_CODE_MAX && operacion == NULL)
+            continue;
+        const char *nombre = operacion != NULL ? operacion->nombre : "DESCONOCIDA";
+
+        fprintf(salida, "frames{op=\"%s\"} %lu\n", nombre, (unsigned long)frames[op]);
+        fprintf(salida, "frames_por_segundo{op=\"%s\"} %.1f\n", nombre,
+                segundos > 0 ? (frames[op] - frames_anteriores[op]) / segundos : 0);
+        frames_anteriores[op] = frames[op];
+
+        if (op == OPERACION_DESCONOCIDA)
+            continue;
+
+        uint64_t total = 0;
+        for (int c = 0; c < CUBETAS_LATENCIA; c++)
+            total += latencias[op][c];
+        fprintf(salida, "latencia_ns{op=\"%s\",percentil=\"50\"} %lu\n", nombre,
+                (unsigned long)percentil_latencia(latencias[op], total, maxima[op], 50));
+        fprintf(salida, "latencia_ns{op=\"%s\",percentil=\"99\"} %lu\n", nombre,
+                (unsigned long)percentil_latencia(latencias[op], total, maxima[op], 99));
+        fprintf(salida, "latencia_ns{op=\"%s\",percentil=\"99.9\"} %lu\n", nombre,
+                (unsigned long)percentil_latencia(latencias[op], total, maxima[op], 99.9));
+        fprintf(salida, "latencia_ns{op=\"%s\",percentil=\"100\"} %lu\n", nombre, (unsigned long)maxima[op]);
+    }
+
+    instante_anterior = ahora;
+    pthread_mutex_unlock(&mutex_consulta);
+
+    fclose(salida);
+    return texto;
+}
+
+// ========== SOCKET DE CONSULTA ==========
+
+/**
+ * @brief Cuerpo del hilo de consultas
+ *
+ * A cada conexión le escribe el resumen y la cierra. Termina cuando
+ * finalizar_metricas() cierra el socket de escucha.
+ *
+ * @param argumento No se usa
+ * @return void* Siempre NULL
+ */
+static void *atender_consultas(void *argumento)
+{
+    (void)argumento;
+
+    while (1)
+    {
+        int cliente = accept(socket_consulta, NULL, NULL);
+        if (cliente == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        char *texto = texto_metricas();
+        size_t pendientes = strlen(texto);
+        for (char *cursor = texto; pendientes > 0;)
+        {
+            ssize_t escritos = send(cliente, cursor, pendientes, MSG_NOSIGNAL);
+            if (escritos <= 0)
+                break;
+            cursor += escritos;
+            pendientes -= escritos;
+        }
+
+        free(texto);
+        close(cliente);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Abre el socket Unix de consulta y lanza su hilo
+ *
+ * @param ruta Ruta del socket (si ya existe un archivo ahí se reemplaza)
+ * @return bool true si quedó escuchando
+ */
+static bool abrir_socket_consulta(const char *ruta)
+{
+    struct sockaddr_un direccion = {.sun_family = AF_UNIX};
+    if (strlen(ruta) >= sizeof(direccion.sun_path))
+    {
+        log_error(logger, "La ruta del socket de metricas es demasiado larga: %s", ruta);
+        return false;
+    }
+    strcpy(direccion.sun_path, ruta);
+
+    socket_consulta = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    unlink(ruta); // Socket de una ejecución anterior
+    if (socket_consulta == -1 ||
+        bind(socket_consulta, (struct sockaddr *)&direccion, sizeof(direccion)) == -1 ||
+        listen(socket_consulta, SOMAXCONN) == -1)
+    {
+        log_error(logger, "No se pudo abrir el socket de metricas %s: %s", ruta, strerror(errno));
+        if (socket_consulta != -1)
+            close(socket_consulta);
+        socket_consulta = -1;
+        return false;
+    }
+
+    snprintf(ruta_consulta, sizeof(ruta_consulta), "%s", ruta);
+    hilo_lanzado = pthread_create(&hilo, NULL, atender_consultas, NULL) == 0;
+    if (!hilo_lanzado)
+    {
+        close(socket_consulta);
+        unlink(ruta_consulta);
+        socket_consulta = -1;
+        return false;
+    }
+
+    return true;
+}
+
+// ========== INICIO Y FIN ==========
+
+/**
+ * @brief Pone los contadores en cero, empieza a contar y abre el socket de consulta
+ *
+ * Se llama antes de lanzar los workers, así nadie escribe mientras se
+ * limpian los bloques.
+ *
+ * @param ruta_socket Ruta del socket Unix ("" = contar sin socket)
+ * @return bool true si se pudo abrir el socket (o no se pidió)
+ */
+bool iniciar_metricas(const char *ruta_socket)
+{
+    int cantidad = atomic_load(&cantidad_hilos);
+    for (int i = 0; i < cantidad && i < MAXIMO_HILOS_METRICAS; i++)
+        if (hilos[i] != NULL)
+            memset(hilos[i], 0, sizeof(t_metricas_hilo));
+    memset(&compartidas, 0, sizeof(compartidas));
+    memset(frames_anteriores, 0, sizeof(frames_anteriores));
+    instante_inicio = instante_anterior = ahora_ns();
+
+    atomic_store(&activas, true);
+
+    if (ruta_socket == NULL || ruta_socket[0] == '\0')
+        return true;
+
+    if (!abrir_socket_consulta(ruta_socket))
+        return false;
+
+    log_info(logger, "Metricas disponibles en %s", ruta_socket);
+    return true;
+}
+
+/**
+ * @brief Deja de contar, cierra el socket de consulta y espera a su hilo
+ *
+ * shutdown() despierta al hilo bloqueado en accept().
+ */
+void finalizar_metricas(void)
+{
+    atomic_store(&activas, false);
+
+    if (!hilo_lanzado)
+        return;
+
+    shutdown(socket_consulta, SHUT_RDWR);
+    pthread_join(hilo, NULL);
+    close(socket_consulta);
+    unlink(ruta_consulta);
+    socket_consulta = -1;
+    hilo_lanzado = false;
+}
@@ -0,0 +1,167 @@
+#ifndef METRICAS_H_
+#define METRICAS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <commons/log.h>
+#include "utils.h"
+
+/**
+ * @file metricas.h
+ * @brief Contadores del servidor por hilo, sin locks, y su socket de consulta
+ *
+ * Cada hilo que recibe o procesa frames (workers y manejadores) tiene su
+ * propio bloque de contadores, alineado a una línea de caché. Solo ese
+ * hilo lo escribe, con lecturas y escrituras atómicas relajadas (sin
+ * instrucciones con lock ni compartir líneas entre hilos), así contar no
+ * frena el bucle de recepción.
+ *
+ * Los bloques se suman recién cuando alguien consulta: con
+ * METRICAS_SOCKET configurado, un hilo de fondo atiende un socket Unix y
+ * a cada conexión le escribe un resumen en texto y la cierra:
+ *
+ *   socat - UNIX-CONNECT:metricas.sock
+ *
+ * El resumen tiene una métrica por línea ("nombre valor" o
+ * "nombre{etiquetas} valor"): conexiones, bytes recibidos, errores de
+ * decodificación, bytes reservados en la recepción, y por operación los
+ * frames totales, frames/s desde la consulta anterior y los percentiles
+ * de la latencia de los manejadores (decodificador incluido).
+ */
+
+// ========== CONSTANTES ==========
+
+/**
+ * @brief Cantidad máxima de hilos con contadores propios
+ *
+ * Los hilos de más comparten un bloque, que se suma con operaciones
+ * atómicas (más lentas, pero sin perder cuentas).
+ */
+#define MAXIMO_HILOS_METRICAS 256
+
+/**
+ * @brief Bits de precisión de las cubetas de latencia (error menor al 12,5%)
+ */
+#define BITS_CUBETA_LATENCIA 4
+
+/**
+ * @brief Cubetas por potencia de 2
+ */
+#define MEDIA_CUBETA_LATENCIA (1 << (BITS_CUBETA_LATENCIA - 1))
+
+/**
+ * @brief Cubetas para cubrir latencias de 64 bits (en ns)
+ */
+#define CUBETAS_LATENCIA ((64 - BITS_CUBETA_LATENCIA + 3) * MEDIA_CUBETA_LATENCIA)
+
+/**
+ * @brief Bytes de la ruta del socket de consulta (sun_path de sockaddr_un)
+ */
+#define TAMANIO_RUTA_METRICAS 108
+
+/**
+ * @brief Índice de los contadores de frames con código desconocido
+ */
+#define OPERACION_DESCONOCIDA OP_CODE_MAX
+
+// ========== TIPOS ==========
+
+/**
+ * @brief Contadores de un hilo (solo los escribe ese hilo)
+ */
+typedef struct
+{
+    _Alignas(64) atomic_uint_fast64_t conexiones_abiertas;        // Conexiones aceptadas
+    atomic_uint_fast64_t conexiones_cerradas;                      // Conexiones cerradas
+    atomic_uint_fast64_t bytes_recibidos;                          // Bytes leídos de los sockets
+    atomic_uint_fast64_t errores_decodificacion;                   // Frames inválidos o mal formados
+    atomic_uint_fast64_t bytes_reservados;                         // Memoria pedida al recibir
+    atomic_uint_fast64_t lecturas_pausadas;                        // Veces que se dejó de leer una conexión
+    atomic_uint_fast64_t frames[OP_CODE_MAX + 1];                  // Por op_code (+ desconocidos)
+    atomic_uint_fast64_t latencias[OP_CODE_MAX][CUBETAS_LATENCIA]; // Cubetas de ns por op_code
+    atomic_uint_fast64_t latencia_maxima[OP_CODE_MAX];             // ns por op_code
+} t_metricas_hilo;
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Pone los contadores en cero, empieza a contar y abre el socket de consulta
+ * @param ruta_socket Ruta del socket Unix ("" = contar sin socket)
+ * @return bool true si se pudo abrir el socket (o no se pidió)
+ */
+bool iniciar_metricas(const char *ruta_socket);
+
+/**
+ * @brief Deja de contar, cierra el socket de consulta y espera a su hilo
+ */
+void finalizar_metricas(void);
+
+/**
+ * @brief Indica si se están contando métricas
+ * @return bool true entre iniciar_metricas() y finalizar_metricas()
+ */
+bool metricas_activas(void);
+
+/**
+ * @brief Instante para medir la latencia de un manejador
+ * @return uint64_t Nanosegundos monotónicos (0 si no se cuentan métricas)
+ */
+uint64_t metricas_instante(void);
+
+/**
+ * @brief Cuenta una conexión aceptada
+ */
+void metricas_conexion_abierta(void);
+
+/**
+ * @brief Cuenta una conexión cerrada
+ */
+void metricas_conexion_cerrada(void);
+
+/**
+ * @brief Cuenta bytes leídos de un socket
+ * @param bytes Bytes recibidos
+ */
+void metricas_bytes_recibidos(size_t bytes);
+
+/**
+ * @brief Cuenta un frame inválido o mal formado
+ */
+void metricas_error_decodificacion(void);
+
+/**
+ * @brief Cuenta una conexión que se deja de leer por falta de memoria
+ */
+void metricas_lectura_pausada(void);
+
+/**
+ * @brief Cuenta memoria reservada en el camino de recepción
+ * @param bytes Bytes reservados
+ */
+void metricas_reserva(size_t bytes);
+
+/**
+ * @brief Cuenta un frame procesado y la latencia de su manejador
+ * @param cod_op Código de operación (fuera de rango = desconocido, sin latencia)
+ * @param inicio Valor de metricas_instante() antes de decodificar
+ */
+void metricas_frame(int cod_op, uint64_t inicio);
+
+/**
+ * @brief Suma los contadores de todos los hilos y arma el resumen en texto
+ * @return char* Resumen (liberar con free())
+ */
+char *texto_metricas(void);
+
+#endif /* METRICAS_H_ */
@@ -0,0 +1,113 @@
+#include "operaciones.h"
+
+// Tabla densa de operaciones indexada por op_code
+static t_operacion operaciones[OP_CODE_MAX];
+
+/**
+ * @brief Registra el decodificador y el manejador de una operación
+ *
+ * @param cod_op Código de operación (menor que OP_CODE_MAX)
+ * @param nombre Nombre para los logs
+ * @param decodificar Decodificador del payload (o NULL)
+ * @param manejar Manejador de la operación
+ * @return bool true si se registró, false si el código es inválido o ya estaba registrado
+ */
+bool registrar_operacion(op_code cod_op, const char *nombre, t_decodificar_operacion decodificar, t_manejar_operacion manejar)
+{
+    if ((unsigned)cod_op >= OP_CODE_MAX || manejar == NULL)
+    {
+        log_error(logger, "No se puede registrar la operacion %s (%d)", nombre, cod_op);
+        return false;
+    }
+
+    if (operaciones[cod_op].manejar != NULL)
+    {
+        log_error(logger, "La operacion %d ya esta registrada como %s", cod_op, operaciones[cod_op].nombre);
+        return false;
+    }
+
+    operaciones[cod_op] = (t_operacion){
+        .nombre = nombre,
+        .decodificar = decodificar,
+        .manejar = manejar};
+
+    return true;
+}
+
+/**
+ * @brief Busca la operación registrada para un código
+ *
+ * @param cod_op Código de operación recibido
+ * @return t_operacion* Operación o NULL si no hay ninguna registrada
+ */
+t_operacion *buscar_operacion(int cod_op)
+{
+    // El cast a unsigned descarta también los códigos negativos
+    if ((unsigned)cod_op >= OP_CODE_MAX || operaciones[cod_op].manejar == NULL)
+        return NULL;
+
+    return &operaciones[cod_op];
+}
+
+/**
+ * @brief Confirma la solicitud de un frame, si el cliente la pidió
+ *
+ * @param socket_cliente Socket del cliente (para el log)
+ * @param frame Frame despachado
+ * @param estado CONFIRMACION_PROCESADA o CONFIRMACION_RECHAZADA
+ */
+static void confirmar_frame(int socket_cliente, t_frame *frame, uint8_t estado)
+{
+    if (!frame->confirmar || frame->confirmaciones == NULL)
+        return;
+
+    if (!confirmar_solicitud(frame->confirmaciones, frame->solicitud, estado))
+        log_error(logger, "No hay memoria para confirmar la solicitud %u del cliente %d. Se corta la conexion",
+                  frame->solicitud, socket_cliente);
+}
+
+/**
+ * @brief Despacha un frame a su operación
+ *
+ * Cuenta el frame y la latencia del decodificador más el manejador en
+ * las métricas del hilo (ver metricas.h). Si el frame es una solicitud,
+ * agrega su confirmación a la cola de la conexión: procesada después del
+ * manejador, rechazada si la operación no existe o el payload está mal
+ * formado. Enviar la cola le corresponde a quien despacha.
+ *
+ * @param socket_cliente Socket del cliente que envió el frame
+ * @param frame Frame recibido
+ */
+void despachar_operacion(int socket_cliente, t_frame *frame)
+{
+    uint64_t inicio = metricas_instante();
+
+    t_operacion *operacion = buscar_operacion(frame->cod_op);
+    if (operacion == NULL)
+    {
+        metricas_frame(OPERACION_DESCONOCIDA, 0);
+        log_warning(logger, "Operacion desconocida (%d) del cliente %d. Se descarta el frame", frame->cod_op, socket_cliente);
+        confirmar_frame(socket_cliente, frame, CONFIRMACION_RECHAZADA);
+        return;
+    }
+
+    t_contexto_operacion contexto = {
+        .socket_cliente = socket_cliente,
+        .cod_op = frame->cod_op,
+        .payload = frame->payload,
+        .size = frame->size,
+        .formato = frame->formato,
+        .decodificado = NULL};
+
+    if (operacion->decodificar != NULL && !operacion->decodificar(&contexto))
+    {
+        metricas_error_decodificacion();
+        log_warning(logger, "%s mal formado del cliente %d", operacion->nombre, socket_cliente);
+        confirmar_frame(socket_cliente, frame, CONFIRMACION_RECHAZADA);
+        return;
+    }
+
+    operacion->manejar(&contexto);
+    metricas_frame(frame->cod_op, inicio);
+    confirmar_frame(socket_cliente, frame, CONFIRMACION_PROCESADA);
+}
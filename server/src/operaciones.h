@@ -0,0 +1,98 @@
+#ifndef OPERACIONES_H_
+#define OPERACIONES_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <commons/log.h>
+#include "utils.h"
+#include "decodificador.h"
+#include "metricas.h"
+
+/**
+ * @file operaciones.h
+ * @brief Registro de operaciones del servidor indexado por op_code
+ *
+ * Cada operación se registra una vez al iniciar con un decodificador
+ * opcional y un manejador. El despacho de un frame es un acceso a una
+ * tabla densa por código de operación: agregar una operación nueva no
+ * requiere tocar el bucle de recepción.
+ */
+
+// ========== TIPOS ==========
+
+/**
+ * @brief Datos de un frame que recibe el manejador de una operación
+ */
+typedef struct
+{
+    int socket_cliente; // Socket del cliente que envió el frame
+    op_code cod_op;     // Código de operación
+    void *payload;      // Datos del frame (solo válidos durante la llamada)
+    int size;           // Tamaño en bytes del payload
+    t_formato formato;  // Versión y flags con que llegó el frame
+    void *decodificado; // Resultado del decodificador (NULL si no tiene)
+} t_contexto_operacion;
+
+/**
+ * @brief Interpreta el payload de una operación antes de manejarla
+ *
+ * Debe dejar el resultado en contexto->decodificado. Si devuelve false el
+ * frame se descarta sin llamar al manejador.
+ *
+ * @param contexto Frame a decodificar
+ * @return bool true si el payload es válido
+ */
+typedef bool (*t_decodificar_operacion)(t_contexto_operacion *contexto);
+
+/**
+ * @brief Procesa un frame de una operación
+ * @param contexto Frame (y su payload decodificado)
+ */
+typedef void (*t_manejar_operacion)(t_contexto_operacion *contexto);
+
+/**
+ * @brief Entrada de la tabla de operaciones
+ */
+typedef struct
+{
+    const char *nombre;                  // Nombre para los logs
+    t_decodificar_operacion decodificar; // Decodificador (NULL = payload crudo)
+    t_manejar_operacion manejar;         // Manejador (NULL = operación no registrada)
+} t_operacion;
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Registra el decodificador y el manejador de una operación
+ *
+ * Se llama al iniciar, antes de lanzar los workers: la tabla no se
+ * protege con locks.
+ *
+ * @param cod_op Código de operación (menor que OP_CODE_MAX)
+ * @param nombre Nombre para los logs
+ * @param decodificar Decodificador del payload (o NULL)
+ * @param manejar Manejador de la operación
+ * @return bool true si se registró, false si el código es inválido o ya estaba registrado
+ */
+bool registrar_operacion(op_code cod_op, const char *nombre, t_decodificar_operacion decodificar, t_manejar_operacion manejar);
+
+/**
+ * @brief Busca la operación registrada para un código
+ * @param cod_op Código de operación recibido
+ * @return t_operacion* Operación o NULL si no hay ninguna registrada
+ */
+t_operacion *buscar_operacion(int cod_op);
+
+/**
+ * @brief Despacha un frame a su operación (firma de t_procesar_frame)
+ *
+ * Los códigos sin operación registrada se descartan con un warning. Las
+ * solicitudes se confirman en frame->confirmaciones.
+ *
+ * @param socket_cliente Socket del cliente que envió el frame
+ * @param frame Frame recibido
+ */
+void despachar_operacion(int socket_cliente, t_frame *frame);
+
+#endif /* OPERACIONES_H_ */
@@ -0,0 +1,681 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // pthread_timedjoin_np()
+#endif
+
+#include "planificador.h"
+
+// Cola propia del hilo manejador actual (-1 en hilos que no son del pool)
+static __thread int cola_propia = -1;
+
+/**
+ * @brief Argumentos de cada hilo manejador
+ */
+typedef struct
+{
+    t_planificador *planificador;
+    int indice;
+} t_argumento_manejador;
+
+// ========== COLAS DOBLES ==========
+
+/**
+ * @brief Agrega un buzón al final de una cola, creciendo si está llena
+ *
+ * @param cola Cola destino
+ * @param buzon Buzón a agregar
+ */
+static void cola_agregar(t_cola_robo *cola, t_buzon *buzon)
+{
+    pthread_mutex_lock(&cola->mutex);
+
+    if (cola->cantidad == cola->capacidad)
+    {
+        // Duplicar y desenrollar el arreglo circular
+        int nueva_capacidad = cola->capacidad * 2;
+        t_buzon **buzones = malloc(nueva_capacidad * sizeof(t_buzon *));
+        for (int i = 0; i < cola->cantidad; i++)
+            buzones[i] = cola->buzones[(cola->inicio + i) % cola->capacidad];
+        free(cola->buzones);
+        cola->buzones = buzones;
+        cola->capacidad = nueva_capacidad;
+        cola->inicio = 0;
+    }
+
+    cola->buzones[(cola->inicio + cola->cantidad) % cola->capacidad] = buzon;
+    cola->cantidad++;
+
+    pthread_mutex_unlock(&cola->mutex);
+}
+
+/**
+ * @brief Toma el buzón más nuevo de una cola (lo usa su dueño)
+ *
+ * @param cola Cola propia
+ * @return t_buzon* Buzón o NULL si la cola está vacía
+ */
+static t_buzon *cola_tomar(t_cola_robo *cola)
+{
+    t_buzon *buzon = NULL;
+
+    pthread_mutex_lock(&cola->mutex);
+    if (cola->cantidad > 0)
+    {
+        cola->cantidad--;
+        buzon = cola->buzones[(cola->inicio + cola->cantidad) % cola->capacidad];
+    }
+    pthread_mutex_unlock(&cola->mutex);
+
+    return buzon;
+}
+
+/**
+ * @brief Roba el buzón más viejo de una cola ajena
+ *
+ * @param cola Cola de la víctima
+ * @return t_buzon* Buzón o NULL si la cola está vacía
+ */
+static t_buzon *cola_robar(t_cola_robo *cola)
+{
+    t_buzon *buzon = NULL;
+
+    // No esperar a una víctima ocupada: probar con otra
+    if (pthread_mutex_trylock(&cola->mutex) != 0)
+        return NULL;
+
+    if (cola->cantidad > 0)
+    {
+        buzon = cola->buzones[cola->inicio];
+        cola->inicio = (cola->inicio + 1) % cola->capacidad;
+        cola->cantidad--;
+    }
+    pthread_mutex_unlock(&cola->mutex);
+
+    return buzon;
+}
+
+// ========== BUZONES ==========
+
+/**
+ * @brief Crea el buzón de una conexión
+ *
+ * @param socket Socket del cliente
+ * @return t_buzon* Buzón creado (liberar con buzon_cerrar()) o NULL si no hay memoria
+ */
+t_buzon *buzon_crear(int socket)
+{
+    t_buzon *buzon = calloc(1, sizeof(t_buzon));
+    if (buzon == NULL)
+        return NULL;
+    buzon->socket = socket;
+    pthread_mutex_init(&buzon->mutex, NULL);
+    atomic_init(&buzon->referencias, 1); // Referencia del reactor
+    return buzon;
+}
+
+/**
+ * @brief Suelta una referencia al buzón y lo libera si era la última
+ *
+ * @param buzon Buzón a soltar
+ */
+static void buzon_soltar(t_buzon *buzon)
+{
+    if (atomic_fetch_sub(&buzon->referencias, 1) != 1)
+        return;
+
+    t_frame_pendiente *listas[] = {buzon->primero, buzon->libres, buzon->reserva};
+    for (size_t i = 0; i < sizeof(listas) / sizeof(listas[0]); i++)
+    {
+        t_frame_pendiente *frame = listas[i];
+        while (frame != NULL)
+        {
+            t_frame_pendiente *siguiente = frame->siguiente;
+            free(frame);
+            frame = siguiente;
+        }
+    }
+
+    if (buzon->confirmaciones != NULL)
+        confirmaciones_destruir(buzon->confirmaciones);
+    pthread_mutex_destroy(&buzon->mutex);
+    free(buzon);
+}
+
+/**
+ * @brief Devuelve la cola de confirmaciones del buzón, creándola si hace falta
+ *
+ * Solo el reactor crea la cola, mientras el socket sigue abierto: por eso
+ * puede duplicarlo sin que el número de descriptor sea de otro cliente.
+ *
+ * @param buzon Buzón de la conexión (solo desde el hilo del reactor)
+ * @return t_confirmaciones* Cola del buzón o NULL si no se pudo duplicar el socket
+ */
+t_confirmaciones *buzon_confirmaciones(t_buzon *buzon)
+{
+    pthread_mutex_lock(&buzon->mutex);
+
+    if (buzon->confirmaciones == NULL)
+    {
+        int socket = dup(buzon->socket);
+        if (socket != -1)
+        {
+            buzon->confirmaciones = confirmaciones_crear(socket, true);
+            if (buzon->confirmaciones == NULL)
+                close(socket);
+        }
+        else
+            log_warning(logger, "No se puede responder al cliente %d: %s", buzon->socket, strerror(errno));
+    }
+    t_confirmaciones *confirmaciones = buzon->confirmaciones;
+
+    pthread_mutex_unlock(&buzon->mutex);
+    return confirmaciones;
+}
+
+/**
+ * @brief Consigue un frame para copiar un payload, reutilizando uno libre si entra
+ *
+ * Solo desde el reactor: usa la reserva del buzón sin el mutex y, cuando
+ * se vacía, se lleva de una vez los frames que ya devolvieron los
+ * manejadores.
+ *
+ * @param buzon Buzón de la conexión
+ * @param size Bytes del payload
+ * @return t_frame_pendiente* Frame con lugar para el payload o NULL si no hay memoria
+ */
+static t_frame_pendiente *tomar_frame(t_buzon *buzon, int size)
+{
+    if (buzon->reserva == NULL)
+    {
+        pthread_mutex_lock(&buzon->mutex);
+        buzon->reserva = buzon->libres;
+        buzon->libres = NULL;
+        buzon->cantidad_libres = 0;
+        pthread_mutex_unlock(&buzon->mutex);
+    }
+
+    t_frame_pendiente *frame = buzon->reserva;
+    if (frame != NULL)
+    {
+        buzon->reserva = frame->siguiente;
+        if (frame->capacidad >= size)
+            return frame;
+        free(frame);
+    }
+
+    int capacidad = size > PAYLOAD_MINIMO_PENDIENTE ? size : PAYLOAD_MINIMO_PENDIENTE;
+    frame = malloc(sizeof(t_frame_pendiente) + capacidad);
+    if (frame == NULL)
+        return NULL;
+    metricas_reserva(sizeof(t_frame_pendiente) + capacidad);
+    frame->capacidad = capacidad;
+    return frame;
+}
+
+/**
+ * @brief Devuelve un frame procesado a los libres de su buzón
+ *
+ * Los frames grandes y los que exceden FRAMES_LIBRES_POR_BUZON se liberan.
+ *
+ * @param buzon Buzón del frame (con el mutex tomado)
+ * @param frame Frame procesado (NULL = nada que devolver)
+ */
+static void devolver_frame(t_buzon *buzon, t_frame_pendiente *frame)
+{
+    if (frame == NULL)
+        return;
+
+    if (frame->capacidad > PAYLOAD_MAXIMO_REUTILIZABLE || buzon->cantidad_libres >= FRAMES_LIBRES_POR_BUZON)
+    {
+        free(frame);
+        return;
+    }
+
+    frame->siguiente = buzon->libres;
+    buzon->libres = frame;
+    buzon->cantidad_libres++;
+}
+
+/**
+ * @brief Suelta la referencia del reactor al buzón de una conexión cerrada
+ *
+ * @param buzon Buzón a cerrar
+ */
+void buzon_cerrar(t_buzon *buzon)
+{
+    buzon_soltar(buzon);
+}
+
+// ========== PROGRAMACIÓN ==========
+
+/**
+ * @brief Pone un buzón en una cola del pool y despierta a un manejador
+ *
+ * Desde un hilo manejador se usa su propia cola; desde un reactor se
+ * reparten en ronda entre las colas.
+ *
+ * @param planificador Pool de manejadores
+ * @param buzon Buzón a programar (ya tiene la referencia del pool)
+ */
+static void programar(t_planificador *planificador, t_buzon *buzon)
+{
+    int indice = cola_propia;
+    if (indice < 0)
+        indice = atomic_fetch_add(&planificador->siguiente_cola, 1) % planificador->cantidad_hilos;
+
+    cola_agregar(&planificador->colas[indice], buzon);
+    atomic_fetch_add(&planificador->pendientes, 1);
+
+    if (atomic_load(&planificador->durmiendo) > 0)
+    {
+        pthread_mutex_lock(&planificador->mutex_espera);
+        pthread_cond_signal(&planificador->hay_trabajo);
+        pthread_mutex_unlock(&planificador->mutex_espera);
+    }
+}
+
+/**
+ * @brief Copia un frame al buzón de su conexión y lo programa si hace falta
+ *
+ * @param planificador Pool de manejadores
+ * @param buzon Buzón de la conexión que recibió el frame
+ * @param recibido Frame recibido (se copia con su payload)
+ * @return bool false si no hay memoria para la copia o para la cola de
+ *         confirmaciones que pide el frame (el frame no se encola)
+ */
+bool planificador_encolar(t_planificador *planificador, t_buzon *buzon, t_frame *recibido)
+{
+    // Sin cola el cliente esperaría para siempre el ACK
+    if (recibido->confirmar && buzon_confirmaciones(buzon) == NULL)
+        return false;
+
+    t_frame_pendiente *frame = tomar_frame(buzon, recibido->size);
+    if (frame == NULL)
+        return false;
+    frame->siguiente = NULL;
+    frame->cod_op = recibido->cod_op;
+    frame->size = recibido->size;
+    frame->formato = recibido->formato;
+    frame->bytes = recibido->bytes;
+    frame->confirmar = recibido->confirmar;
+    frame->solicitud = recibido->solicitud;
+    memcpy(frame->payload, recibido->payload, recibido->size);
+
+    atomic_fetch_add(&buzon->bytes_pendientes, frame->bytes);
+    atomic_fetch_add(&planificador->memoria_pendiente, sizeof(t_frame_pendiente) + frame->capacidad);
+
+    pthread_mutex_lock(&buzon->mutex);
+
+    if (buzon->ultimo != NULL)
+        buzon->ultimo->siguiente = frame;
+    else
+        buzon->primero = frame;
+    buzon->ultimo = frame;
+
+    // Si ya está programado, el manejador que lo tenga verá el frame nuevo
+    bool programar_buzon = !buzon->programado;
+    if (programar_buzon)
+    {
+        buzon->programado = true;
+        atomic_fetch_add(&buzon->referencias, 1); // Referencia del pool
+    }
+
+    pthread_mutex_unlock(&buzon->mutex);
+
+    if (programar_buzon)
+        programar(planificador, buzon);
+    return true;
+}
+
+/**
+ * @brief Procesa hasta FRAMES_POR_TURNO frames de un buzón
+ *
+ * Cada frame procesado devuelve su crédito al cliente (si lo pidió) y
+ * vuelve a los libres del buzón. Las confirmaciones y el crédito del
+ * turno se envían juntos al terminarlo. Si le quedan frames vuelve a la
+ * cola del hilo; si no, deja de estar programado y se suelta la
+ * referencia del pool.
+ *
+ * @param planificador Pool de manejadores
+ * @param buzon Buzón a atender
+ */
+static void atender_buzon(t_planificador *planificador, t_buzon *buzon)
+{
+    t_confirmaciones *confirmaciones = NULL;
+    t_frame_pendiente *procesado = NULL;
+
+    for (int i = 0; i < FRAMES_POR_TURNO; i++)
+    {
+        // El frame anterior se devuelve con el mismo lock que toma el siguiente
+        pthread_mutex_lock(&buzon->mutex);
+        devolver_frame(buzon, procesado);
+        procesado = NULL;
+        t_frame_pendiente *frame = buzon->primero;
+        if (frame != NULL)
+        {
+            buzon->primero = frame->siguiente;
+            if (buzon->primero == NULL)
+                buzon->ultimo = NULL;
+        }
+        confirmaciones = buzon->confirmaciones;
+        pthread_mutex_unlock(&buzon->mutex);
+
+        if (frame == NULL)
+            break;
+
+        // Vencido el plazo de drenado, los frames se liberan sin procesar
+        if (!atomic_load_explicit(&planificador->descartar, memory_order_relaxed))
+        {
+            t_frame a_procesar = {
+                .cod_op = frame->cod_op,
+                .size = frame->size,
+                .payload = frame->payload,
+                .formato = frame->formato,
+                .confirmar = frame->confirmar,
+                .solicitud = frame->solicitud,
+                .confirmaciones = confirmaciones};
+            planificador->manejador(buzon->socket, &a_procesar);
+        }
+
+        atomic_fetch_sub(&buzon->bytes_pendientes, frame->bytes);
+        atomic_fetch_sub(&planificador->memoria_pendiente, sizeof(t_frame_pendiente) + frame->capacidad);
+        if (confirmaciones != NULL)
+            otorgar_credito(confirmaciones, frame->bytes);
+        procesado = frame;
+    }
+
+    // Un solo envío para todas las confirmaciones y el crédito del turno
+    if (confirmaciones != NULL)
+        enviar_confirmaciones(confirmaciones);
+
+    pthread_mutex_lock(&buzon->mutex);
+    devolver_frame(buzon, procesado);
+    bool quedan = buzon->primero != NULL;
+    if (!quedan)
+        buzon->programado = false;
+    pthread_mutex_unlock(&buzon->mutex);
+
+    if (quedan)
+        programar(planificador, buzon); // Conserva la referencia del pool
+    else
+        buzon_soltar(buzon);
+}
+
+/**
+ * @brief Busca trabajo: primero en la cola propia, después robando
+ *
+ * Las víctimas se recorren empezando por una elegida al azar para que
+ * los ladrones no se amontonen sobre la misma cola.
+ *
+ * @param planificador Pool de manejadores
+ * @param indice Cola propia del hilo
+ * @param semilla Estado del generador aleatorio del hilo
+ * @return t_buzon* Buzón a atender o NULL si no hay trabajo
+ */
+static t_buzon *buscar_trabajo(t_planificador *planificador, int indice, unsigned int *semilla)
+{
+    t_buzon *buzon = cola_tomar(&planificador->colas[indice]);
+    if (buzon != NULL)
+        return buzon;
+
+    int cantidad = planificador->cantidad_hilos;
+    int victima = rand_r(semilla) % cantidad;
+
+    for (int i = 0; i < cantidad; i++, victima = (victima + 1) % cantidad)
+    {
+        if (victima == indice)
+            continue;
+        buzon = cola_robar(&planificador->colas[victima]);
+        if (buzon != NULL)
+            return buzon;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Cuerpo de cada hilo manejador
+ *
+ * @param argumento t_argumento_manejador del hilo (se libera acá)
+ * @return void* Siempre NULL
+ */
+static void *ejecutar_manejador(void *argumento)
+{
+    t_argumento_manejador *datos = argumento;
+    t_planificador *planificador = datos->planificador;
+    int indice = datos->indice;
+    unsigned int semilla = (unsigned int)indice * 2654435761u + 1;
+    free(datos);
+
+    cola_propia = indice;
+
+    while (1)
+    {
+        t_buzon *buzon = buscar_trabajo(planificador, indice, &semilla);
+        if (buzon != NULL)
+        {
+            atomic_fetch_sub(&planificador->pendientes, 1);
+            atender_buzon(planificador, buzon);
+            continue;
+        }
+
+        // Hay trabajo en alguna cola que no se pudo robar: reintentar
+        if (atomic_load(&planificador->pendientes) > 0)
+        {
+            sched_yield();
+            continue;
+        }
+
+        pthread_mutex_lock(&planificador->mutex_espera);
+        atomic_fetch_add(&planificador->durmiendo, 1);
+        while (atomic_load(&planificador->pendientes) == 0 && atomic_load(&planificador->activo))
+            pthread_cond_wait(&planificador->hay_trabajo, &planificador->mutex_espera);
+        atomic_fetch_sub(&planificador->durmiendo, 1);
+        bool terminar = atomic_load(&planificador->pendientes) == 0 && !atomic_load(&planificador->activo);
+        pthread_mutex_unlock(&planificador->mutex_espera);
+
+        if (terminar)
+            break;
+    }
+
+    return NULL;
+}
+
+// ========== POOL ==========
+
+/**
+ * @brief Calcula el instante absoluto en que vence un plazo
+ *
+ * @param plazo_ms Milisegundos desde ahora
+ * @return struct timespec Instante en CLOCK_REALTIME (el de pthread_timedjoin_np)
+ */
+static struct timespec vencimiento_en(int plazo_ms)
+{
+    struct timespec limite;
+    clock_gettime(CLOCK_REALTIME, &limite);
+    limite.tv_sec += plazo_ms / 1000;
+    limite.tv_nsec += (long)(plazo_ms % 1000) * 1000000;
+    if (limite.tv_nsec >= 1000000000)
+    {
+        limite.tv_sec++;
+        limite.tv_nsec -= 1000000000;
+    }
+    return limite;
+}
+
+/**
+ * @brief Detiene los hilos lanzados y libera el pool
+ *
+ * Los hilos terminan recién cuando no queda ningún buzón programado. Si
+ * hay plazo y se vence, los frames que queden se descartan para que los
+ * hilos terminen enseguida, y se los espera GRACIA_DESCARTE_MS más. Los
+ * que sigan ocupados se desacoplan y se abandonan: el pool queda sin
+ * liberar porque todavía lo usan.
+ *
+ * @param planificador Pool a liberar
+ * @param hilos_lanzados Hilos que llegaron a crearse
+ * @param plazo_ms Milisegundos para procesar lo pendiente (-1 = sin plazo)
+ * @return bool true si se procesó todo lo pendiente
+ */
+static bool detener_planificador(t_planificador *planificador, int hilos_lanzados, int plazo_ms)
+{
+    pthread_mutex_lock(&planificador->mutex_espera);
+    atomic_store(&planificador->activo, false);
+    pthread_cond_broadcast(&planificador->hay_trabajo);
+    pthread_mutex_unlock(&planificador->mutex_espera);
+
+    struct timespec limite = vencimiento_en(plazo_ms);
+
+    bool completo = true;
+    int abandonados = 0;
+    for (int i = 0; i < hilos_lanzados; i++)
+    {
+        if (plazo_ms < 0)
+        {
+            pthread_join(planificador->hilos[i], NULL);
+            continue;
+        }
+
+        if (pthread_timedjoin_np(planificador->hilos[i], NULL, &limite) == 0)
+            continue;
+
+        if (completo)
+        {
+            completo = false;
+            atomic_store(&planificador->descartar, true);
+            log_warning(logger, "Plazo de drenado vencido: se descartan %d buzones pendientes",
+                        atomic_load(&planificador->pendientes));
+
+            // Descartando, los hilos tienen un plazo corto para terminar
+            limite = vencimiento_en(GRACIA_DESCARTE_MS);
+            if (pthread_timedjoin_np(planificador->hilos[i], NULL, &limite) == 0)
+                continue;
+        }
+
+        pthread_detach(planificador->hilos[i]);
+        abandonados++;
+    }
+
+    if (abandonados > 0)
+    {
+        log_error(logger, "Se abandonan %d hilos manejadores que no terminaron despues del plazo de drenado",
+                  abandonados);
+        return false;
+    }
+
+    for (int i = 0; i < planificador->cantidad_hilos; i++)
+    {
+        pthread_mutex_destroy(&planificador->colas[i].mutex);
+        free(planificador->colas[i].buzones);
+    }
+
+    free(planificador->hilos);
+    free(planificador->colas);
+    pthread_mutex_destroy(&planificador->mutex_espera);
+    pthread_cond_destroy(&planificador->hay_trabajo);
+    free(planificador);
+
+    return completo;
+}
+
+/**
+ * @brief Crea el pool y lanza sus hilos manejadores
+ *
+ * @param cantidad_hilos Hilos manejadores (0 = uno por núcleo)
+ * @param manejador Función a invocar por cada frame
+ * @return t_planificador* Pool creado o NULL si hay error
+ */
+t_planificador *planificador_crear(int cantidad_hilos, t_manejador_frame manejador)
+{
+    if (cantidad_hilos <= 0)
+    {
+        long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+        cantidad_hilos = nucleos > 0 ? (int)nucleos : 1;
+    }
+
+    t_planificador *planificador = calloc(1, sizeof(t_planificador));
+    t_cola_robo *colas = calloc(cantidad_hilos, sizeof(t_cola_robo));
+    pthread_t *hilos = calloc(cantidad_hilos, sizeof(pthread_t));
+    if (planificador == NULL || colas == NULL || hilos == NULL)
+    {
+        log_error(logger, "No hay memoria para el pool de %d hilos", cantidad_hilos);
+        free(planificador);
+        free(colas);
+        free(hilos);
+        return NULL;
+    }
+
+    planificador->cantidad_hilos = cantidad_hilos;
+    planificador->manejador = manejador;
+    planificador->colas = colas;
+    planificador->hilos = hilos;
+    atomic_init(&planificador->activo, true);
+    pthread_mutex_init(&planificador->mutex_espera, NULL);
+    pthread_cond_init(&planificador->hay_trabajo, NULL);
+
+    // Las colas tienen que existir antes de que algún hilo intente robar
+    bool colas_creadas = true;
+    for (int i = 0; i < cantidad_hilos; i++)
+    {
+        pthread_mutex_init(&planificador->colas[i].mutex, NULL);
+        planificador->colas[i].capacidad = 64;
+        planificador->colas[i].buzones = malloc(64 * sizeof(t_buzon *));
+        if (planificador->colas[i].buzones == NULL)
+            colas_creadas = false;
+    }
+
+    if (!colas_creadas)
+    {
+        log_error(logger, "No hay memoria para las colas del pool");
+        detener_planificador(planificador, 0, -1);
+        return NULL;
+    }
+
+    for (int i = 0; i < cantidad_hilos; i++)
+    {
+        t_argumento_manejador *argumento = malloc(sizeof(t_argumento_manejador));
+        if (argumento != NULL)
+        {
+            argumento->planificador = planificador;
+            argumento->indice = i;
+        }
+
+        if (argumento == NULL || pthread_create(&planificador->hilos[i], NULL, ejecutar_manejador, argumento) != 0)
+        {
+            log_error(logger, "No se pudo crear el hilo manejador %d", i);
+            free(argumento);
+            detener_planificador(planificador, i, -1);
+            return NULL;
+        }
+    }
+
+    log_info(logger, "Pool de manejadores listo (%d hilos)", cantidad_hilos);
+    return planificador;
+}
+
+/**
+ * @brief Procesa lo pendiente, detiene los hilos y libera el pool
+ *
+ * Los reactores tienen que haber terminado antes: después de esta
+ * llamada no se puede encolar.
+ *
+ * @param planificador Pool a destruir
+ */
+void planificador_destruir(t_planificador *planificador)
+{
+    detener_planificador(planificador, planificador->cantidad_hilos, -1);
+}
+
+/**
+ * @brief Procesa lo pendiente durante un plazo, descarta el resto y libera el pool
+ *
+ * Acota el tiempo de apagado: lo que no se procesó dentro del plazo se
+ * libera sin llamar al manejador.
+ *
+ * @param planificador Pool a destruir
+ * @param plazo_ms Milisegundos para procesar lo pendiente
+ * @return bool true si se procesó todo dentro del plazo
+ */
+bool planificador_drenar(t_planificador *planificador, int plazo_ms)
+{
+    return detener_planificador(planificador, planificador->cantidad_hilos, plazo_ms < 0 ? 0 : plazo_ms);
+}
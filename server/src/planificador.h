@@ -0,0 +1,228 @@
+#ifndef PLANIFICADOR_H_
+#define PLANIFICADOR_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <commons/log.h>
+#include "utils.h"
+#include "decodificador.h"
+#include "metricas.h"
+
+/**
+ * @file planificador.h
+ * @brief Pool de hilos manejadores con robo de trabajo (work-stealing)
+ *
+ * Los reactores solo leen y decodifican: cada frame completo se copia al
+ * buzón de su conexión y el buzón se programa en el pool. Cada hilo
+ * manejador tiene su propia cola doble; toma trabajo de su extremo y,
+ * cuando se queda sin trabajo, roba del otro extremo de la cola de una
+ * víctima elegida al azar.
+ *
+ * La unidad que se programa es el buzón de la conexión, no el frame: un
+ * buzón está en el pool como mucho una vez, así que los frames de una
+ * misma conexión se procesan de a uno y en el orden en que llegaron,
+ * mientras que conexiones distintas se reparten entre todos los núcleos.
+ *
+ * Los frames copiados se reutilizan: el manejador devuelve cada frame
+ * procesado a la lista de libres de su buzón y el reactor los vuelve a
+ * usar para los siguientes frames de esa conexión, así que en régimen
+ * encolar no reserva memoria.
+ */
+
+// ========== CONSTANTES ==========
+
+/**
+ * @brief Frames que procesa un manejador de un buzón antes de devolverlo al pool
+ */
+#define FRAMES_POR_TURNO 64
+
+/**
+ * @brief Milisegundos que se espera a los hilos después de vencido el plazo de drenado
+ *
+ * Alcanza para que descarten lo que quede; los que sigan ocupados (un
+ * manejador bloqueado) se abandonan.
+ */
+#define GRACIA_DESCARTE_MS 100
+
+/**
+ * @brief Frames procesados que guarda cada buzón para reutilizar
+ *
+ * Cubre unos cuantos turnos en vuelo; si la conexión tiene más frames
+ * sin procesar, los que sobran se reservan y se liberan como antes.
+ */
+#define FRAMES_LIBRES_POR_BUZON (4 * FRAMES_POR_TURNO)
+
+/**
+ * @brief Bytes mínimos de payload que se reservan por frame copiado
+ *
+ * Frames chicos de tamaños distintos pueden reutilizar la misma reserva.
+ */
+#define PAYLOAD_MINIMO_PENDIENTE 256
+
+/**
+ * @brief Payload máximo de un frame que se guarda para reutilizar
+ *
+ * Los más grandes se liberan al procesarse: un pico de tamaño no queda
+ * reservado mientras dure la conexión.
+ */
+#define PAYLOAD_MAXIMO_REUTILIZABLE (64 * 1024)
+
+// ========== TIPOS ==========
+
+/**
+ * @brief Función que procesa un frame (misma firma que t_procesar_frame)
+ */
+typedef void (*t_manejador_frame)(int socket_cliente, t_frame *frame);
+
+/**
+ * @brief Frame copiado fuera del decodificador, esperando ser procesado
+ */
+typedef struct t_frame_pendiente
+{
+    struct t_frame_pendiente *siguiente; // Siguiente frame de la conexión (o libre)
+    int cod_op;                          // Código de operación
+    int size;                            // Tamaño del payload
+    int capacidad;                       // Bytes reservados para el payload
+    t_formato formato;                   // Versión y flags del frame
+    int bytes;                           // Bytes que ocupó en el socket
+    bool confirmar;                      // true si el cliente espera un ACK
+    uint32_t solicitud;                  // ID de solicitud (si confirmar)
+    char payload[];                      // Copia del payload
+} t_frame_pendiente;
+
+/**
+ * @brief Buzón de frames pendientes de una conexión
+ *
+ * Lo comparten el reactor (que agrega frames) y el manejador que lo esté
+ * procesando. Se libera cuando el reactor lo cierra y ningún manejador
+ * lo tiene programado.
+ *
+ * La cola de confirmaciones se crea con la primera solicitud (o el
+ * pedido de crédito), sobre un dup() del socket que se cierra al liberar
+ * el buzón. El manejador la vacía al terminar cada turno.
+ *
+ * bytes_pendientes cuenta lo que ocupaban en el socket los frames sin
+ * procesar: es lo que el reactor compara con el crédito de la conexión.
+ *
+ * Los frames procesados vuelven a libres (con el mutex). Cuando el
+ * reactor se queda sin reserva se lleva todos los libres de una vez,
+ * así que toma el mutex una vez por tanda y no por frame.
+ */
+typedef struct
+{
+    int socket;                       // Socket del cliente
+    pthread_mutex_t mutex;            // Protege la lista, programado y confirmaciones
+    t_frame_pendiente *primero;       // Próximo frame a procesar
+    t_frame_pendiente *ultimo;        // Último frame recibido
+    t_frame_pendiente *libres;        // Frames procesados para reutilizar
+    int cantidad_libres;              // Frames en libres
+    t_frame_pendiente *reserva;       // Frames libres que tomó el reactor (solo el reactor)
+    bool programado;                  // true si el buzón está en el pool
+    atomic_int referencias;           // Reactor + pool (si está programado)
+    t_confirmaciones *confirmaciones; // ACK y crédito pendientes (NULL hasta que se pidan)
+    atomic_long bytes_pendientes;     // Bytes en el socket de los frames sin procesar
+} t_buzon;
+
+/**
+ * @brief Cola doble de un hilo manejador
+ *
+ * El dueño agrega y toma por el final; los ladrones toman por el
+ * principio, que tiene el trabajo más viejo.
+ */
+typedef struct
+{
+    pthread_mutex_t mutex; // Protege la cola
+    t_buzon **buzones;     // Arreglo circular
+    int capacidad;         // Tamaño del arreglo
+    int inicio;            // Posición del elemento más viejo
+    int cantidad;          // Elementos en la cola
+} t_cola_robo;
+
+/**
+ * @brief Pool de hilos manejadores
+ */
+typedef struct
+{
+    int cantidad_hilos;            // Hilos manejadores
+    pthread_t *hilos;              // Hilos lanzados
+    t_cola_robo *colas;            // Una cola por hilo
+    t_manejador_frame manejador;   // Función que procesa cada frame
+    atomic_int pendientes;         // Buzones programados en alguna cola
+    atomic_long memoria_pendiente; // Bytes reservados por los frames de todos los buzones
+    atomic_int durmiendo;          // Hilos esperando trabajo
+    atomic_uint siguiente_cola;    // Reparto de buzones que llegan de afuera
+    atomic_bool activo;            // false para terminar los hilos
+    atomic_bool descartar;         // true si se venció el plazo de drenado
+    pthread_mutex_t mutex_espera;  // Mutex de la espera sin trabajo
+    pthread_cond_t hay_trabajo;    // Se señala al programar un buzón
+} t_planificador;
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Crea el pool y lanza sus hilos manejadores
+ * @param cantidad_hilos Hilos manejadores (0 = uno por núcleo)
+ * @param manejador Función a invocar por cada frame
+ * @return t_planificador* Pool creado o NULL si hay error
+ */
+t_planificador *planificador_crear(int cantidad_hilos, t_manejador_frame manejador);
+
+/**
+ * @brief Copia un frame al buzón de su conexión y lo programa si hace falta
+ * @param planificador Pool de manejadores
+ * @param buzon Buzón de la conexión que recibió el frame
+ * @param frame Frame recibido (se copia con su payload)
+ * @return bool false si no hay memoria para la copia o para la cola de
+ *         confirmaciones que pide el frame (el frame no se encola)
+ */
+bool planificador_encolar(t_planificador *planificador, t_buzon *buzon, t_frame *frame);
+
+/**
+ * @brief Procesa lo pendiente, detiene los hilos y libera el pool
+ * @param planificador Pool a destruir
+ */
+void planificador_destruir(t_planificador *planificador);
+
+/**
+ * @brief Procesa lo pendiente durante un plazo, descarta el resto y libera el pool
+ *
+ * Si algún hilo no termina ni siquiera descartando, se abandona y el
+ * pool no se libera (ese hilo todavía lo usa). Si devuelve false, quien
+ * llama tampoco debe liberar lo que use el manejador, como el logger.
+ *
+ * @param planificador Pool a destruir
+ * @param plazo_ms Milisegundos para procesar lo pendiente
+ * @return bool true si se procesó todo dentro del plazo
+ */
+bool planificador_drenar(t_planificador *planificador, int plazo_ms);
+
+/**
+ * @brief Crea el buzón de una conexión
+ * @param socket Socket del cliente
+ * @return t_buzon* Buzón creado (liberar con buzon_cerrar()) o NULL si no hay memoria
+ */
+t_buzon *buzon_crear(int socket);
+
+/**
+ * @brief Devuelve la cola de confirmaciones del buzón, creándola si hace falta
+ * @param buzon Buzón de la conexión (solo desde el hilo del reactor)
+ * @return t_confirmaciones* Cola del buzón o NULL si no se pudo duplicar el socket
+ */
+t_confirmaciones *buzon_confirmaciones(t_buzon *buzon);
+
+/**
+ * @brief Suelta la referencia del reactor al buzón de una conexión cerrada
+ *
+ * Los frames ya recibidos se procesan igual; el buzón se libera cuando
+ * ningún manejador lo tiene programado.
+ *
+ * @param buzon Buzón a cerrar
+ */
+void buzon_cerrar(t_buzon *buzon);
+
+#endif /* PLANIFICADOR_H_ */
@@ -0,0 +1,1107 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // accept4()
+#endif
+
+#include "reactor.h"
+
+// Marca del eventfd de apagado en data.ptr (el socket de escucha usa NULL)
+static char marca_apagado;
+#define EVENTO_APAGADO ((void *)&marca_apagado)
+
+// Crédito inicial de cada conexión (CREDITO_ILIMITADO = sin control de flujo)
+static uint32_t credito_conexion = CREDITO_POR_CONEXION;
+
+// Bytes de frames sin procesar en el pool a partir de los que se pausa (0 = sin límite)
+static long memoria_pendiente_maxima = MEMORIA_PENDIENTE_MAXIMA;
+
+// Motor de E/S de los reactores que se creen
+static t_motor_io motor_io = MOTOR_EPOLL;
+
+// Con io_uring, el tipo de operación va en los bits bajos del dato de
+// usuario y la conexión (alineada a 8 por calloc) en el resto
+#define URING_ACEPTAR 1
+#define URING_APAGADO 2
+#define URING_CANCELAR 3
+#define URING_RECIBIR 4
+#define URING_ESCRIBIR 5
+#define URING_TIPO 7
+
+/**
+ * @brief Configura el control de flujo de todos los reactores
+ *
+ * Se llama antes de crear los reactores.
+ *
+ * @param credito Crédito inicial por conexión en bytes (0 = sin control de flujo)
+ * @param memoria_maxima Bytes sin procesar en el pool a partir de los que se pausa (0 = sin límite)
+ */
+void establecer_control_flujo(long credito, long memoria_maxima)
+{
+    if (credito <= 0)
+        credito_conexion = CREDITO_ILIMITADO;
+    else
+        credito_conexion = credito < CREDITO_ILIMITADO ? (uint32_t)credito : CREDITO_ILIMITADO - 1;
+    memoria_pendiente_maxima = memoria_maxima > 0 ? memoria_maxima : 0;
+}
+
+/**
+ * @brief Elige el motor de E/S de los reactores
+ *
+ * Se llama antes de crear los reactores. Si io_uring no está disponible,
+ * reactor_crear() usa epoll igual.
+ *
+ * @param motor MOTOR_EPOLL o MOTOR_IO_URING
+ */
+void establecer_motor_io(t_motor_io motor)
+{
+    motor_io = motor;
+}
+
+/**
+ * @brief Convierte el texto de configuración en un motor de E/S
+ *
+ * @param texto "EPOLL" o "IO_URING"
+ * @return t_motor_io Motor (EPOLL si el texto no se reconoce)
+ */
+t_motor_io motor_io_desde_texto(char *texto)
+{
+    if (texto != NULL && strcmp(texto, "IO_URING") == 0)
+        return MOTOR_IO_URING;
+
+    return MOTOR_EPOLL;
+}
+
+/**
+ * @brief Pone un file descriptor en modo no bloqueante
+ *
+ * @param fd File descriptor a configurar
+ * @return int 0 si se configuró correctamente, -1 si hay error
+ */
+int poner_no_bloqueante(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags == -1)
+        return -1;
+
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+/**
+ * @brief Arma el dato de usuario de una operación de io_uring
+ *
+ * @param conexion Conexión de la operación (NULL si no es de una conexión)
+ * @param tipo URING_ACEPTAR, URING_RECIBIR, ...
+ * @return uint64_t Dato de usuario
+ */
+static uint64_t dato_uring(t_conexion *conexion, int tipo)
+{
+    return (uint64_t)(uintptr_t)conexion | tipo;
+}
+
+/**
+ * @brief Reserva una SQE para una operación del reactor
+ *
+ * Si io_uring no toma más SQE, el reactor queda trabado: no arma más
+ * operaciones y su bucle termina como con un error de io_uring_enter().
+ *
+ * @param reactor Reactor con io_uring
+ * @return struct io_uring_sqe* SQE a completar o NULL si está trabado
+ */
+static struct io_uring_sqe *obtener_sqe(t_reactor *reactor)
+{
+    if (reactor->uring_trabado)
+        return NULL;
+
+    struct io_uring_sqe *sqe = uring_obtener_sqe(reactor->uring);
+    if (sqe == NULL)
+    {
+        log_error(logger, "io_uring no acepta mas operaciones: %s", strerror(errno));
+        reactor->uring_trabado = true;
+    }
+    return sqe;
+}
+
+/**
+ * @brief Arma el accept() multishot del socket de escucha
+ *
+ * @param reactor Reactor con io_uring
+ */
+static void armar_aceptar(t_reactor *reactor)
+{
+    struct io_uring_sqe *sqe = obtener_sqe(reactor);
+    if (sqe == NULL)
+        return;
+
+    uring_preparar_aceptar(sqe, reactor->socket_servidor, dato_uring(NULL, URING_ACEPTAR));
+    reactor->operaciones++;
+}
+
+/**
+ * @brief Arma el recv() multishot de una conexión
+ *
+ * @param reactor Reactor con io_uring
+ * @param conexion Conexión a recibir
+ */
+static void armar_recepcion(t_reactor *reactor, t_conexion *conexion)
+{
+    struct io_uring_sqe *sqe = obtener_sqe(reactor);
+    if (sqe == NULL)
+        return;
+
+    uring_preparar_recibir(sqe, conexion->socket, dato_uring(conexion, URING_RECIBIR));
+    conexion->recibiendo = true;
+    conexion->operaciones++;
+    reactor->operaciones++;
+}
+
+/**
+ * @brief Arma el aviso de lugar en el socket para reintentar los ACK
+ *
+ * Es un poll() multishot de POLLOUT: como EPOLLOUT con EPOLLET, avisa
+ * cuando el socket vuelve a tener lugar después de haberse llenado.
+ *
+ * @param reactor Reactor con io_uring
+ * @param conexion Conexión a observar
+ */
+static void armar_escritura(t_reactor *reactor, t_conexion *conexion)
+{
+    struct io_uring_sqe *sqe = obtener_sqe(reactor);
+    if (sqe == NULL)
+        return;
+
+    uring_preparar_sondeo(sqe, conexion->socket, POLLOUT, true, dato_uring(conexion, URING_ESCRIBIR));
+    conexion->operaciones++;
+    reactor->operaciones++;
+}
+
+/**
+ * @brief Cancela las operaciones de un tipo de una conexión
+ *
+ * Cada operación termina con un último completado (-ECANCELED), que
+ * puede llegar después de otros con datos.
+ *
+ * @param reactor Reactor con io_uring
+ * @param conexion Conexión dueña de las operaciones
+ * @param tipo URING_RECIBIR o URING_ESCRIBIR
+ */
+static void cancelar_operaciones(t_reactor *reactor, t_conexion *conexion, int tipo)
+{
+    struct io_uring_sqe *sqe = obtener_sqe(reactor);
+    if (sqe != NULL)
+        uring_preparar_cancelar(sqe, dato_uring(conexion, tipo), dato_uring(NULL, URING_CANCELAR));
+}
+
+/**
+ * @brief Cierra la conexión de un cliente y libera su estado de lectura
+ *
+ * Se quita el socket de epoll antes de cerrarlo: el buzón y las
+ * confirmaciones tienen copias con dup() y epoll no lo olvida mientras
+ * quede alguna abierta.
+ *
+ * Con io_uring se cancelan sus operaciones y la conexión se libera
+ * cuando llega el último completado que la nombra.
+ *
+ * @param reactor Reactor dueño de la conexión
+ * @param conexion Conexión a cerrar
+ */
+static void cerrar_conexion(t_reactor *reactor, t_conexion *conexion)
+{
+    // Desenganchar la conexión de la lista del reactor
+    if (conexion->anterior != NULL)
+        conexion->anterior->siguiente = conexion->siguiente;
+    else
+        reactor->conexiones = conexion->siguiente;
+    if (conexion->siguiente != NULL)
+        conexion->siguiente->anterior = conexion->anterior;
+    if (conexion->pausada)
+        reactor->conexiones_pausadas--;
+    if (conexion->limite_respuestas != 0)
+        reactor->conexiones_respondiendo--;
+
+    // Último intento de entregar los ACK pendientes antes de cerrar
+    if (conexion->confirmaciones != NULL)
+    {
+        enviar_confirmaciones(conexion->confirmaciones);
+        confirmaciones_destruir(conexion->confirmaciones);
+    }
+
+    if (reactor->uring == NULL)
+        epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, conexion->socket, NULL);
+    close(conexion->socket);
+    decodificador_destruir(conexion->decodificador);
+    if (conexion->buzon != NULL)
+        buzon_cerrar(conexion->buzon);
+    reactor->conexiones_activas--;
+    metricas_conexion_cerrada();
+
+    if (reactor->uring == NULL || conexion->operaciones == 0)
+    {
+        free(conexion);
+        return;
+    }
+
+    conexion->cerrada = true;
+    cancelar_operaciones(reactor, conexion, URING_RECIBIR);
+    cancelar_operaciones(reactor, conexion, URING_ESCRIBIR);
+}
+
+/**
+ * @brief Crea el estado de un cliente recién aceptado y empieza a recibir
+ *
+ * Con epoll registra el socket; con io_uring arma su recv() multishot y
+ * el aviso de lugar para los ACK.
+ *
+ * @param reactor Reactor que recibe la conexión
+ * @param socket_cliente Socket no bloqueante del cliente
+ */
+static void registrar_conexion(t_reactor *reactor, int socket_cliente)
+{
+    t_conexion *conexion = calloc(1, sizeof(t_conexion));
+    t_decodificador *decodificador = decodificador_crear(CAPACIDAD_DECODIFICADOR);
+    t_buzon *buzon = reactor->planificador != NULL ? buzon_crear(socket_cliente) : NULL;
+    if (conexion == NULL || decodificador == NULL || (reactor->planificador != NULL && buzon == NULL))
+    {
+        log_error(logger, "No hay memoria para el cliente %d", socket_cliente);
+        close(socket_cliente);
+        if (decodificador != NULL)
+            decodificador_destruir(decodificador);
+        if (buzon != NULL)
+            buzon_cerrar(buzon);
+        free(conexion);
+        return;
+    }
+
+    conexion->socket = socket_cliente;
+    conexion->decodificador = decodificador;
+    conexion->buzon = buzon;
+
+    if (reactor->uring != NULL)
+    {
+        armar_recepcion(reactor, conexion);
+        armar_escritura(reactor, conexion);
+    }
+    else
+    {
+        struct epoll_event evento = {
+            .events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET,
+            .data.ptr = conexion};
+
+        if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, socket_cliente, &evento) == -1)
+        {
+            log_error(logger, "No se pudo registrar el cliente en epoll: %s", strerror(errno));
+            close(socket_cliente);
+            decodificador_destruir(conexion->decodificador);
+            if (conexion->buzon != NULL)
+                buzon_cerrar(conexion->buzon);
+            free(conexion);
+            return;
+        }
+    }
+
+    // Enganchar la conexión al principio de la lista del reactor
+    conexion->siguiente = reactor->conexiones;
+    if (reactor->conexiones != NULL)
+        reactor->conexiones->anterior = conexion;
+    reactor->conexiones = conexion;
+    reactor->conexiones_activas++;
+    metricas_conexion_abierta();
+
+    log_info(logger, "Se conecto un cliente! (%d activos)", reactor->conexiones_activas);
+}
+
+/**
+ * @brief Acepta todas las conexiones pendientes del socket de escucha
+ *
+ * En modo edge-triggered solo se recibe una notificación aunque haya varios
+ * clientes esperando, por lo que se acepta hasta que accept4() devuelva EAGAIN.
+ *
+ * @param reactor Reactor que recibe las conexiones
+ */
+static void aceptar_clientes(t_reactor *reactor)
+{
+    while (1)
+    {
+        int socket_cliente = accept4(reactor->socket_servidor, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (socket_cliente == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                log_error(logger, "Error aceptando cliente: %s", strerror(errno));
+            return;
+        }
+
+        registrar_conexion(reactor, socket_cliente);
+    }
+}
+
+/**
+ * @brief Envía los ACK y el crédito pendientes de una conexión
+ *
+ * Se llama después de cada lectura y cuando el socket vuelve a aceptar
+ * datos, para reintentar lo que no había aceptado. Con planificador la
+ * cola es la del buzón, que solo crea el hilo del reactor, así que leer
+ * el puntero acá no necesita el mutex.
+ *
+ * @param conexion Conexión cuyo socket volvió a aceptar datos
+ */
+static void vaciar_confirmaciones(t_conexion *conexion)
+{
+    t_confirmaciones *confirmaciones = conexion->buzon != NULL ? conexion->buzon->confirmaciones
+                                                               : conexion->confirmaciones;
+    if (confirmaciones != NULL)
+        enviar_confirmaciones(confirmaciones);
+}
+
+/**
+ * @brief Milisegundos de un reloj monótono
+ *
+ * @return uint64_t Instante actual en milisegundos
+ */
+static uint64_t ahora_ms(void)
+{
+    struct timespec instante;
+    clock_gettime(CLOCK_MONOTONIC, &instante);
+    return (uint64_t)instante.tv_sec * 1000 + instante.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Indica si a una conexión le quedan frames sin procesar o respuestas sin enviar
+ *
+ * El manejador encola el ACK de un frame antes de descontarlo de
+ * bytes_pendientes, así que mientras falte responder algo una de las dos
+ * cuentas lo muestra.
+ *
+ * @param conexion Conexión a revisar
+ * @return bool true si todavía hay algo que enviarle al cliente
+ */
+static bool respuestas_pendientes(t_conexion *conexion)
+{
+    if (conexion->buzon != NULL && atomic_load(&conexion->buzon->bytes_pendientes) > 0)
+        return true;
+
+    t_confirmaciones *confirmaciones = conexion->buzon != NULL ? conexion->buzon->confirmaciones
+                                                               : conexion->confirmaciones;
+    return confirmaciones != NULL && confirmaciones_pendientes(confirmaciones) > 0;
+}
+
+/**
+ * @brief Decide si sigue abierta una conexión cuyo cliente dejó de enviar
+ *
+ * Un cliente que cierra solo su lado de escritura (shutdown(SHUT_WR))
+ * todavía espera los ACK de lo que mandó: la conexión queda abierta hasta
+ * que el pool procese sus frames y se envíen sus respuestas, o hasta
+ * PLAZO_RESPUESTAS_MS si el cliente no las lee.
+ *
+ * @param reactor Reactor dueño de la conexión
+ * @param conexion Conexión que dejó de enviar (y no está pausada)
+ * @return bool true si sigue abierta, false si hay que cerrarla
+ */
+static bool esperar_respuestas(t_reactor *reactor, t_conexion *conexion)
+{
+    vaciar_confirmaciones(conexion);
+    if (!respuestas_pendientes(conexion))
+        return false;
+
+    if (conexion->limite_respuestas == 0)
+    {
+        conexion->limite_respuestas = ahora_ms() + PLAZO_RESPUESTAS_MS;
+        reactor->conexiones_respondiendo++;
+        return true;
+    }
+
+    if (ahora_ms() < conexion->limite_respuestas)
+        return true;
+
+    log_warning(logger, "El cliente %d no recibio sus respuestas en %d ms. Cerrando conexion",
+                conexion->socket, PLAZO_RESPUESTAS_MS);
+    return false;
+}
+
+/**
+ * @brief Cierra las conexiones que ya recibieron sus respuestas o agotaron el plazo
+ *
+ * Sus frames los procesa el pool en otro hilo, así que no siempre llega
+ * un evento cuando terminan: se revisan acá en cada vuelta.
+ *
+ * @param reactor Reactor con conexiones esperando respuestas
+ */
+static void cerrar_respondidas(t_reactor *reactor)
+{
+    t_conexion *siguiente;
+
+    for (t_conexion *conexion = reactor->conexiones; conexion != NULL; conexion = siguiente)
+    {
+        siguiente = conexion->siguiente;
+        if (conexion->limite_respuestas == 0 || esperar_respuestas(reactor, conexion))
+            continue;
+
+        cerrar_conexion(reactor, conexion);
+        log_info(logger, "el cliente se desconecto (%d activos)", reactor->conexiones_activas);
+    }
+}
+
+/**
+ * @brief Devuelve la cola de confirmaciones de una conexión, creándola si hace falta
+ *
+ * Con planificador es la del buzón; si no, una propia sobre el mismo socket.
+ *
+ * @param conexion Conexión del cliente
+ * @return t_confirmaciones* Cola de la conexión (NULL si no se pudo crear)
+ */
+static t_confirmaciones *confirmaciones_de(t_conexion *conexion)
+{
+    if (conexion->buzon != NULL)
+        return buzon_confirmaciones(conexion->buzon);
+
+    if (conexion->confirmaciones == NULL)
+        conexion->confirmaciones = confirmaciones_crear(conexion->socket, false);
+    return conexion->confirmaciones;
+}
+
+/**
+ * @brief Decide si se puede seguir leyendo una conexión y actualiza su pausa
+ *
+ * Se pausa si el cliente no lee sus confirmaciones y pasan de
+ * MAXIMO_BYTES_CONFIRMACIONES: sus ACK nunca se descartan, así que la
+ * lectura espera a que se vacíen. Sin planificador lo leído se procesa
+ * antes de volver a leer, así que no hay otro motivo. Con planificador
+ * también se pausa si su buzón tiene más del doble del crédito sin
+ * procesar (un cliente que respeta el crédito no llega) o si el pool
+ * entero supera la memoria pendiente máxima.
+ *
+ * @param reactor Reactor dueño de la conexión
+ * @param conexion Conexión a leer
+ * @return bool true si se puede leer
+ */
+static bool memoria_disponible(t_reactor *reactor, t_conexion *conexion)
+{
+    bool disponible = true;
+
+    t_confirmaciones *confirmaciones = conexion->buzon != NULL ? conexion->buzon->confirmaciones
+                                                               : conexion->confirmaciones;
+    if (confirmaciones != NULL && confirmaciones_pendientes(confirmaciones) >= MAXIMO_BYTES_CONFIRMACIONES)
+        disponible = false;
+
+    if (conexion->buzon != NULL)
+    {
+        if (credito_conexion != CREDITO_ILIMITADO &&
+            atomic_load(&conexion->buzon->bytes_pendientes) >= 2 * (long)credito_conexion)
+            disponible = false;
+        if (memoria_pendiente_maxima > 0 &&
+            atomic_load(&reactor->planificador->memoria_pendiente) >= memoria_pendiente_maxima)
+            disponible = false;
+    }
+
+    if (disponible == conexion->pausada)
+    {
+        conexion->pausada = !disponible;
+        reactor->conexiones_pausadas += conexion->pausada ? 1 : -1;
+        if (conexion->pausada)
+            metricas_lectura_pausada();
+    }
+
+    return disponible;
+}
+
+/**
+ * @brief Procesa los frames completos que haya en el decodificador
+ *
+ * Si el reactor tiene planificador, cada frame se copia al buzón de la
+ * conexión en lugar de procesarse acá. Si no, las solicitudes procesadas
+ * en cada tanda se confirman juntas en un solo ACK, junto con el
+ * crédito de los frames procesados. Los pedidos de crédito los atiende
+ * el reactor y no llegan a los manejadores.
+ *
+ * @param reactor Reactor dueño de la conexión
+ * @param conexion Conexión con datos recibidos
+ * @return bool true si todos los frames eran válidos, false si hay que cerrarla
+ */
+static bool procesar_frames(t_reactor *reactor, t_conexion *conexion)
+{
+    t_frame frame;
+    int resultado;
+    bool credito_pedido = false;
+
+    while ((resultado = decodificador_siguiente(conexion->decodificador, &frame)) == 1)
+    {
+        if (frame.cod_op == CREDITO)
+        {
+            t_confirmaciones *confirmaciones = confirmaciones_de(conexion);
+            if (confirmaciones != NULL)
+                habilitar_credito(confirmaciones, credito_conexion);
+            credito_pedido = true;
+            continue;
+        }
+
+        if (conexion->buzon != NULL)
+        {
+            if (planificador_encolar(reactor->planificador, conexion->buzon, &frame))
+                continue;
+
+            log_error(logger, "No se pudo encolar el frame de %d bytes del cliente %d. Cerrando conexion",
+                      frame.size, conexion->socket);
+            return false;
+        }
+
+        frame.confirmaciones = frame.confirmar ? confirmaciones_de(conexion) : conexion->confirmaciones;
+        if (frame.confirmar && frame.confirmaciones == NULL)
+        {
+            // Sin cola el cliente esperaría para siempre el ACK
+            log_error(logger, "No se puede confirmar al cliente %d. Cerrando conexion", conexion->socket);
+            return false;
+        }
+        reactor->procesar(conexion->socket, &frame);
+        if (conexion->confirmaciones != NULL)
+            otorgar_credito(conexion->confirmaciones, frame.bytes);
+    }
+
+    // Con planificador los ACK los envía el manejador; el crédito inicial no espera
+    if (conexion->buzon == NULL || credito_pedido)
+        vaciar_confirmaciones(conexion);
+
+    if (resultado == -1)
+    {
+        metricas_error_decodificacion();
+        log_warning(logger, "Frame invalido del cliente %d. Cerrando conexion", conexion->socket);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Procesa todos los datos disponibles en el socket de un cliente
+ *
+ * Cada recv() trae todo lo que entra en el buffer del decodificador y luego
+ * se procesan todos los frames completos que haya. Se repite hasta vaciar el
+ * socket (EAGAIN), como exige el modo edge-triggered, o hasta que falte
+ * memoria: entonces la conexión queda pausada con datos en el socket y
+ * reactor_ejecutar() la vuelve a leer cuando se libere.
+ *
+ * @param reactor Reactor dueño de la conexión
+ * @param conexion Conexión con datos disponibles
+ * @return bool true si la conexión sigue abierta, false si hay que cerrarla
+ */
+static bool leer_conexion(t_reactor *reactor, t_conexion *conexion)
+{
+    while (1)
+    {
+        if (!memoria_disponible(reactor, conexion))
+            return true;
+
+        ssize_t recibidos = decodificador_leer(conexion->decodificador, conexion->socket);
+        if (recibidos == 0)
+        {
+            // El cliente dejó de enviar: ya se procesó todo lo que mandó
+            conexion->fin_recibido = true;
+            return esperar_respuestas(reactor, conexion);
+        }
+        if (recibidos == -1)
+        {
+            if (errno == ENOMEM)
+                log_error(logger, "No hay memoria para el frame del cliente %d", conexion->socket);
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        metricas_bytes_recibidos(recibidos);
+
+        if (!procesar_frames(reactor, conexion))
+            return false;
+    }
+}
+
+/**
+ * @brief Crea un reactor sobre un socket de escucha ya inicializado
+ *
+ * Pone el socket de escucha en modo no bloqueante y lo registra en una
+ * nueva instancia de epoll. Con MOTOR_IO_URING crea en cambio una
+ * instancia de io_uring, y si el kernel no la soporta (o no hay memoria
+ * para el reactor) usa epoll.
+ *
+ * @param socket_servidor Socket devuelto por iniciar_servidor()
+ * @param procesar Función a invocar por cada frame recibido
+ * @param planificador Pool donde despachar los frames (NULL = en línea)
+ * @return t_reactor* Reactor creado o NULL si hay error
+ */
+t_reactor *reactor_crear(int socket_servidor, t_procesar_frame procesar, t_planificador *planificador)
+{
+    if (motor_io == MOTOR_IO_URING)
+    {
+        t_uring *uring = uring_crear();
+        t_reactor *reactor = uring != NULL ? calloc(1, sizeof(t_reactor)) : NULL;
+        if (reactor != NULL)
+        {
+            reactor->epoll_fd = -1;
+            reactor->uring = uring;
+            reactor->socket_servidor = socket_servidor;
+            reactor->procesar = procesar;
+            reactor->planificador = planificador;
+            reactor->evento_apagado = -1;
+            return reactor;
+        }
+        if (uring != NULL)
+        {
+            int error = errno;
+            uring_destruir(uring);
+            errno = error;
+        }
+        log_warning(logger, "io_uring no esta disponible (%s), se usa epoll", strerror(errno));
+    }
+
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd == -1)
+    {
+        log_error(logger, "No se pudo crear la instancia de epoll: %s", strerror(errno));
+        return NULL;
+    }
+
+    // El socket de escucha se identifica con data.ptr == NULL
+    struct epoll_event evento = {.events = EPOLLIN | EPOLLET, .data.ptr = NULL};
+
+    if (poner_no_bloqueante(socket_servidor) == -1 ||
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, socket_servidor, &evento) == -1)
+    {
+        log_error(logger, "No se pudo registrar el socket de escucha: %s", strerror(errno));
+        close(epoll_fd);
+        return NULL;
+    }
+
+    t_reactor *reactor = calloc(1, sizeof(t_reactor));
+    if (reactor == NULL)
+    {
+        log_error(logger, "No hay memoria para el reactor");
+        close(epoll_fd);
+        return NULL;
+    }
+    reactor->epoll_fd = epoll_fd;
+    reactor->socket_servidor = socket_servidor;
+    reactor->procesar = procesar;
+    reactor->planificador = planificador;
+    reactor->evento_apagado = -1;
+
+    return reactor;
+}
+
+/**
+ * @brief Hace que el reactor drene y termine cuando un eventfd sea legible
+ *
+ * El eventfd se registra en modo level-triggered y nunca se lee, así un
+ * único write() despierta a todos los reactores que lo observan. Con
+ * io_uring se observa con un poll() que arma reactor_ejecutar().
+ *
+ * @param reactor Reactor a configurar
+ * @param evento_apagado eventfd compartido de apagado
+ * @return bool true si se registró
+ */
+bool reactor_observar_apagado(t_reactor *reactor, int evento_apagado)
+{
+    if (reactor->uring != NULL)
+    {
+        reactor->evento_apagado = evento_apagado;
+        return true;
+    }
+
+    struct epoll_event evento = {.events = EPOLLIN, .data.ptr = EVENTO_APAGADO};
+
+    if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, evento_apagado, &evento) == -1)
+    {
+        log_error(logger, "No se pudo registrar el evento de apagado: %s", strerror(errno));
+        return false;
+    }
+
+    reactor->evento_apagado = evento_apagado;
+    return true;
+}
+
+/**
+ * @brief Deja de aceptar clientes y procesa lo que ya llegó
+ *
+ * Saca el socket de escucha de epoll y hace una última lectura de cada
+ * conexión: los frames que ya están en el buffer del socket se procesan
+ * (o se despachan al pool). Las conexiones se cierran después, en
+ * reactor_destruir().
+ *
+ * @param reactor Reactor a drenar
+ */
+static void drenar_reactor(t_reactor *reactor)
+{
+    epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, reactor->socket_servidor, NULL);
+
+    for (t_conexion *conexion = reactor->conexiones; conexion != NULL; conexion = conexion->siguiente)
+        leer_conexion(reactor, conexion);
+
+    log_info(logger, "Reactor drenado (%d conexiones por cerrar)", reactor->conexiones_activas);
+}
+
+/**
+ * @brief Procesa lo recibido por io_uring que quedó en el decodificador
+ *
+ * Si falta memoria la conexión queda pausada con los datos en el
+ * decodificador y se cancela su recv(): lo que el kernel ya había
+ * recibido llega igual y se agrega, así que lo retenido queda acotado.
+ *
+ * @param reactor Reactor con io_uring
+ * @param conexion Conexión con datos recibidos
+ * @return bool true si la conexión sigue abierta, false si hay que cerrarla
+ */
+static bool consumir_recibido(t_reactor *reactor, t_conexion *conexion)
+{
+    if (!memoria_disponible(reactor, conexion))
+    {
+        if (conexion->recibiendo)
+            cancelar_operaciones(reactor, conexion, URING_RECIBIR);
+        return true;
+    }
+
+    if (!procesar_frames(reactor, conexion))
+        return false;
+
+    // El cliente dejó de enviar y ya se procesó todo lo que mandó
+    if (conexion->fin_recibido)
+        return esperar_respuestas(reactor, conexion);
+
+    if (!conexion->recibiendo && !reactor->apagando)
+        armar_recepcion(reactor, conexion);
+    return true;
+}
+
+/**
+ * @brief Vuelve a leer las conexiones pausadas que ya tienen memoria
+ *
+ * Una conexión pausada no recibe más eventos de epoll (en modo
+ * edge-triggered quedó con datos sin leer), así que se reintenta acá.
+ * Con io_uring se procesa lo retenido y se vuelve a armar su recv().
+ *
+ * @param reactor Reactor con conexiones pausadas
+ */
+static void reanudar_conexiones(t_reactor *reactor)
+{
+    t_conexion *siguiente;
+
+    for (t_conexion *conexion = reactor->conexiones; conexion != NULL; conexion = siguiente)
+    {
+        siguiente = conexion->siguiente;
+        if (!conexion->pausada)
+            continue;
+
+        // Puede estar pausada esperando que el cliente lea sus ACK
+        vaciar_confirmaciones(conexion);
+        if (reactor->uring != NULL ? consumir_recibido(reactor, conexion) : leer_conexion(reactor, conexion))
+            continue;
+
+        cerrar_conexion(reactor, conexion);
+        log_info(logger, "el cliente se desconecto (%d activos)", reactor->conexiones_activas);
+    }
+}
+
+/**
+ * @brief Atiende un completado del recv() multishot de una conexión
+ *
+ * Copia los datos del buffer provisto al decodificador y lo devuelve
+ * enseguida al anillo, así los buffers no se agotan aunque haya muchas
+ * conexiones. Si el recv terminó (sin IORING_CQE_F_MORE) y la conexión
+ * sigue, se vuelve a armar al procesar lo recibido. Si la conexión se
+ * cierra puede quedar liberada: después no se la puede usar.
+ *
+ * @param reactor Reactor con io_uring
+ * @param conexion Conexión del recv
+ * @param completado Completado del recv
+ */
+static void atender_recepcion(t_reactor *reactor, t_conexion *conexion, struct io_uring_cqe *completado)
+{
+    if (!(completado->flags & IORING_CQE_F_MORE))
+        conexion->recibiendo = false;
+
+    bool cargado = true;
+    if (completado->res > 0 && (completado->flags & IORING_CQE_F_BUFFER))
+    {
+        unsigned buffer = completado->flags >> IORING_CQE_BUFFER_SHIFT;
+        cargado = decodificador_cargar(conexion->decodificador, uring_buffer(reactor->uring, buffer), completado->res);
+        metricas_bytes_recibidos(completado->res);
+        uring_devolver_buffer(reactor->uring, buffer);
+    }
+
+    // Sin buffers libres o cancelado por una pausa el recv se vuelve a armar;
+    // sin memoria para lo recibido se perdieron bytes y se cierra
+    bool abierta = cargado && (completado->res >= 0 || completado->res == -ENOBUFS || completado->res == -ECANCELED);
+    if (completado->res == 0)
+        conexion->fin_recibido = true;
+
+    if (abierta && consumir_recibido(reactor, conexion))
+        return;
+
+    cerrar_conexion(reactor, conexion);
+    log_info(logger, "el cliente se desconecto (%d activos)", reactor->conexiones_activas);
+}
+
+/**
+ * @brief Atiende un completado de io_uring
+ *
+ * Lleva la cuenta de las operaciones en curso: un completado sin
+ * IORING_CQE_F_MORE es el último de su operación. Una conexión cerrada
+ * se libera cuando termina su última operación.
+ *
+ * @param reactor Reactor con io_uring
+ * @param completado Completado a atender
+ * @return bool true si es el aviso de apagado
+ */
+static bool atender_completado(t_reactor *reactor, struct io_uring_cqe *completado)
+{
+    int tipo = completado->user_data & URING_TIPO;
+    t_conexion *conexion = (t_conexion *)(uintptr_t)(completado->user_data & ~(uint64_t)URING_TIPO);
+    bool ultimo = !(completado->flags & IORING_CQE_F_MORE);
+
+    if (tipo == URING_CANCELAR)
+        return false;
+    if (ultimo)
+    {
+        reactor->operaciones--;
+        if (conexion != NULL)
+            conexion->operaciones--;
+    }
+
+    switch (tipo)
+    {
+    case URING_APAGADO:
+        return true;
+
+    case URING_ACEPTAR:
+        if (completado->res >= 0)
+            registrar_conexion(reactor, completado->res);
+        else if (completado->res != -ECANCELED)
+            log_error(logger, "Error aceptando cliente: %s", strerror(-completado->res));
+        if (ultimo && !reactor->apagando)
+            armar_aceptar(reactor);
+        return false;
+
+    case URING_RECIBIR:
+        if (!conexion->cerrada)
+        {
+            atender_recepcion(reactor, conexion, completado);
+            return false;
+        }
+        if (completado->res > 0 && (completado->flags & IORING_CQE_F_BUFFER))
+            uring_devolver_buffer(reactor->uring, completado->flags >> IORING_CQE_BUFFER_SHIFT);
+        break;
+
+    case URING_ESCRIBIR:
+        if (conexion->cerrada)
+            break;
+        if (completado->res > 0 && (completado->res & POLLOUT))
+            vaciar_confirmaciones(conexion);
+        if (ultimo && !reactor->apagando)
+            armar_escritura(reactor, conexion);
+        break;
+    }
+
+    if (conexion->cerrada && conexion->operaciones == 0)
+        free(conexion);
+    return false;
+}
+
+/**
+ * @brief Atiende todos los completados que haya en la CQ
+ *
+ * @param reactor Reactor con io_uring
+ * @return bool true si entre ellos estaba el aviso de apagado
+ */
+static bool atender_completados(t_reactor *reactor)
+{
+    bool apagar = false;
+    struct io_uring_cqe *completado;
+
+    while ((completado = uring_completado(reactor->uring)) != NULL)
+    {
+        // Copiarlo libera el lugar en la CQ antes de procesar el frame
+        struct io_uring_cqe copia = *completado;
+        uring_completado_visto(reactor->uring);
+        apagar |= atender_completado(reactor, &copia);
+    }
+
+    return apagar;
+}
+
+/**
+ * @brief Cancela todas las operaciones de io_uring y procesa lo que ya llegó
+ *
+ * Espera los completados de todo lo cancelado (que pueden traer datos) y
+ * después lee directo de cada socket lo que quedó, como con epoll.
+ *
+ * @param reactor Reactor con io_uring
+ */
+static void drenar_uring(t_reactor *reactor)
+{
+    reactor->apagando = true;
+    struct io_uring_sqe *sqe = obtener_sqe(reactor);
+    if (sqe != NULL)
+        uring_preparar_cancelar_todo(sqe, dato_uring(NULL, URING_CANCELAR));
+
+    // Trabado, lo que siga en curso no va a terminar: se lee directo de los sockets
+    while (reactor->operaciones > 0 && !reactor->uring_trabado)
+    {
+        if (uring_enviar(reactor->uring, -1) == -1)
+        {
+            log_error(logger, "Error en io_uring_enter: %s", strerror(errno));
+            break;
+        }
+        atender_completados(reactor);
+    }
+
+    t_conexion *siguiente;
+    for (t_conexion *conexion = reactor->conexiones; conexion != NULL; conexion = siguiente)
+    {
+        siguiente = conexion->siguiente;
+        if (consumir_recibido(reactor, conexion))
+            leer_conexion(reactor, conexion);
+    }
+
+    log_info(logger, "Reactor drenado (%d conexiones por cerrar)", reactor->conexiones_activas);
+}
+
+/**
+ * @brief Bucle de eventos con io_uring
+ *
+ * Arma un accept() multishot y un poll() del evento de apagado, y en
+ * cada vuelta manda todas las SQE preparadas (recv rearmados,
+ * cancelaciones, avisos de escritura) y espera completados con un solo
+ * io_uring_enter(). Mientras haya conexiones pausadas o esperando
+ * respuestas la espera es de ESPERA_PAUSADAS_MS, como con epoll.
+ *
+ * @param reactor Reactor con io_uring
+ */
+static void ejecutar_uring(t_reactor *reactor)
+{
+    armar_aceptar(reactor);
+    struct io_uring_sqe *sqe = reactor->evento_apagado != -1 ? obtener_sqe(reactor) : NULL;
+    if (sqe != NULL)
+    {
+        uring_preparar_sondeo(sqe, reactor->evento_apagado, POLLIN, false, dato_uring(NULL, URING_APAGADO));
+        reactor->operaciones++;
+    }
+
+    bool apagar = false;
+    while (!apagar && !reactor->uring_trabado)
+    {
+        int espera = reactor->conexiones_pausadas > 0 || reactor->conexiones_respondiendo > 0 ? ESPERA_PAUSADAS_MS : -1;
+        if (uring_enviar(reactor->uring, espera) == -1)
+        {
+            log_error(logger, "Error en io_uring_enter: %s", strerror(errno));
+            break;
+        }
+
+        apagar = atender_completados(reactor);
+
+        if (reactor->conexiones_pausadas > 0 && !apagar)
+            reanudar_conexiones(reactor);
+        if (reactor->conexiones_respondiendo > 0 && !apagar)
+            cerrar_respondidas(reactor);
+    }
+
+    drenar_uring(reactor);
+}
+
+/**
+ * @brief Ejecuta el bucle de eventos del reactor
+ *
+ * Espera eventos de epoll y los despacha: nuevas conexiones en el socket de
+ * escucha, datos disponibles, lugar para los ACK pendientes o
+ * desconexiones en los sockets de clientes.
+ * La desconexión de un cliente solo cierra esa conexión; si solo cerró su
+ * envío, la conexión sigue abierta hasta entregarle sus respuestas. Mientras
+ * haya conexiones pausadas o esperando respuestas, epoll_wait() espera a lo
+ * sumo ESPERA_PAUSADAS_MS y después de cada tanda se reintenta leerlas o se
+ * cierran las ya respondidas.
+ *
+ * Cuando el eventfd de apagado se vuelve legible termina de atender los
+ * eventos de la tanda, drena las conexiones y retorna.
+ *
+ * Con io_uring el bucle es el de ejecutar_uring(), con el mismo
+ * comportamiento.
+ *
+ * @param reactor Reactor a ejecutar
+ */
+void reactor_ejecutar(t_reactor *reactor)
+{
+    if (reactor->uring != NULL)
+    {
+        ejecutar_uring(reactor);
+        return;
+    }
+
+    struct epoll_event eventos[EVENTOS_POR_ITERACION];
+    bool apagar = false;
+
+    while (!apagar)
+    {
+        int espera = reactor->conexiones_pausadas > 0 || reactor->conexiones_respondiendo > 0 ? ESPERA_PAUSADAS_MS : -1;
+        int cantidad = epoll_wait(reactor->epoll_fd, eventos, EVENTOS_POR_ITERACION, espera);
+        if (cantidad == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            log_error(logger, "Error en epoll_wait: %s", strerror(errno));
+            return;
+        }
+
+        for (int i = 0; i < cantidad; i++)
+        {
+            t_conexion *conexion = eventos[i].data.ptr;
+
+            if (conexion == EVENTO_APAGADO)
+            {
+                apagar = true;
+                continue;
+            }
+
+            if (conexion == NULL)
+            {
+                if (!apagar)
+                    aceptar_clientes(reactor);
+                continue;
+            }
+
+            // Leer primero: puede haber frames completos antes del cierre
+            bool abierta = !(eventos[i].events & (EPOLLERR | EPOLLHUP)) &&
+                           (!(eventos[i].events & EPOLLIN) || leer_conexion(reactor, conexion));
+
+            if (abierta && (eventos[i].events & EPOLLOUT))
+                vaciar_confirmaciones(conexion);
+
+            // Un cliente que dejó de enviar espera sus respuestas; si la conexión
+            // está pausada, se decide cuando se termine de leer lo que mandó
+            if (abierta && (eventos[i].events & EPOLLRDHUP) && !conexion->pausada)
+                abierta = esperar_respuestas(reactor, conexion);
+
+            if (!abierta)
+            {
+                cerrar_conexion(reactor, conexion);
+                log_info(logger, "el cliente se desconecto (%d activos)", reactor->conexiones_activas);
+            }
+        }
+
+        if (reactor->conexiones_pausadas > 0 && !apagar)
+            reanudar_conexiones(reactor);
+        if (reactor->conexiones_respondiendo > 0 && !apagar)
+            cerrar_respondidas(reactor);
+    }
+
+    drenar_reactor(reactor);
+}
+
+/**
+ * @brief Cierra todas las conexiones y libera el reactor
+ *
+ * No cierra el socket de escucha, que pertenece a quien creó el reactor.
+ *
+ * @param reactor Reactor a destruir
+ */
+void reactor_destruir(t_reactor *reactor)
+{
+    while (reactor->conexiones != NULL)
+        cerrar_conexion(reactor, reactor->conexiones);
+
+    if (reactor->uring != NULL)
+        uring_destruir(reactor->uring);
+    else
+        close(reactor->epoll_fd);
+    free(reactor);
+}
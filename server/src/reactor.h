@@ -0,0 +1,203 @@
+#ifndef REACTOR_H_
+#define REACTOR_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <commons/log.h>
+#include "utils.h"
+#include "decodificador.h"
+#include "planificador.h"
+#include "metricas.h"
+#include "uring.h"
+
+/**
+ * @file reactor.h
+ * @brief Bucle de eventos basado en epoll para atender múltiples clientes
+ *
+ * El reactor acepta conexiones y lee de todos los clientes desde un único
+ * hilo usando sockets no bloqueantes y epoll en modo edge-triggered. Cada
+ * conexión tiene su propio decodificador, de modo que un frame
+ * [código_operación][tamaño][payload] puede llegar en cualquier cantidad de
+ * fragmentos (o varios frames en una sola lectura) sin bloquear al resto
+ * de los clientes.
+ *
+ * Con un planificador, los frames no se procesan en el hilo del reactor:
+ * se copian al buzón de la conexión y los procesa el pool de manejadores,
+ * así un manejador lento no frena la lectura de los sockets.
+ *
+ * Las solicitudes (frames con FLAG_SOLICITUD) se confirman con un ACK
+ * por lectura del socket en línea, o por turno del buzón en el pool (ver
+ * confirmaciones.h). Si el socket no acepta el ACK, el reactor lo
+ * reintenta cuando epoll avisa que volvió a tener lugar (EPOLLOUT).
+ *
+ * Control de flujo: un cliente que envía un CREDITO recibe un crédito
+ * inicial de bytes y, a medida que se procesan sus frames, el crédito
+ * que ocupaban; no envía más de lo que tiene. Además, con planificador
+ * el reactor deja de leer una conexión (la pausa) mientras su buzón
+ * tenga más del doble del crédito sin procesar o todos los buzones
+ * juntos superen la memoria pendiente máxima. El cliente queda frenado
+ * por TCP y la memoria del servidor acotada aunque no respete el crédito.
+ *
+ * Con MOTOR_IO=IO_URING el reactor usa io_uring en lugar de epoll: un
+ * accept() y un recv() por conexión multishot, con buffers provistos
+ * por el reactor, y todas las operaciones de una vuelta se mandan con
+ * un solo io_uring_enter() que además espera los completados. Así no
+ * hay un recv() por lectura ni un epoll_wait() aparte. Si el kernel no
+ * lo soporta (ver uring.h) se usa epoll.
+ */
+
+// ========== CONSTANTES ==========
+
+/**
+ * @brief Cantidad máxima de eventos procesados por cada llamada a epoll_wait()
+ */
+#define EVENTOS_POR_ITERACION 64
+
+/**
+ * @brief Crédito por defecto que se otorga a cada conexión (bytes)
+ */
+#define CREDITO_POR_CONEXION (1024 * 1024)
+
+/**
+ * @brief Bytes por defecto de frames sin procesar en el pool a partir de los que se pausa la lectura
+ */
+#define MEMORIA_PENDIENTE_MAXIMA (256L * 1024 * 1024)
+
+/**
+ * @brief Milisegundos entre reintentos de las conexiones pausadas o esperando respuestas
+ */
+#define ESPERA_PAUSADAS_MS 1
+
+/**
+ * @brief Milisegundos que sigue abierta una conexión que dejó de enviar, esperando sus respuestas
+ */
+#define PLAZO_RESPUESTAS_MS 5000
+
+// ========== TIPOS ==========
+
+/**
+ * @brief Motor de E/S con el que el reactor espera y recibe
+ */
+typedef enum
+{
+    MOTOR_EPOLL,   // epoll edge-triggered y recv() por lectura
+    MOTOR_IO_URING // io_uring con accept() y recv() multishot
+} t_motor_io;
+
+/**
+ * @brief Función que procesa un frame completo recibido de un cliente
+ *
+ * El frame y su payload pertenecen al reactor y solo son válidos durante
+ * la llamada.
+ *
+ * @param socket_cliente Socket del cliente que envió el frame
+ * @param frame Código, formato y payload del frame
+ */
+typedef void (*t_procesar_frame)(int socket_cliente, t_frame *frame);
+
+/**
+ * @brief Estado de una conexión de cliente
+ */
+typedef struct t_conexion
+{
+    int socket;                       // Socket no bloqueante del cliente
+    t_decodificador *decodificador;   // Bytes recibidos pendientes de procesar
+    t_buzon *buzon;                   // Frames para el pool (NULL si se procesan en línea)
+    t_confirmaciones *confirmaciones; // ACK y crédito de lo procesado en línea (NULL hasta que se pidan)
+    bool pausada;                     // true si se dejó de leer por falta de memoria
+    bool recibiendo;                  // io_uring: recv() multishot en curso
+    bool fin_recibido;                // El cliente dejó de enviar (puede quedar algo sin procesar)
+    uint64_t limite_respuestas;       // Instante (ms) hasta el que se esperan sus respuestas (0 = no espera)
+    bool cerrada;                     // io_uring: cerrada, se libera con su último completado
+    int operaciones;                  // io_uring: operaciones en curso que la nombran
+
+    struct t_conexion *anterior;  // Conexión anterior en la lista del reactor
+    struct t_conexion *siguiente; // Conexión siguiente en la lista del reactor
+} t_conexion;
+
+/**
+ * @brief Reactor que atiende a todos los clientes de un socket de escucha
+ */
+typedef struct
+{
+    int epoll_fd;                 // Instancia de epoll (-1 con io_uring)
+    t_uring *uring;               // Instancia de io_uring (NULL = epoll)
+    int operaciones;              // io_uring: operaciones en curso
+    bool apagando;                // io_uring: drenando, no se arman operaciones nuevas
+    bool uring_trabado;           // io_uring: no toma más SQE, el bucle termina
+    int socket_servidor;          // Socket de escucha (no bloqueante)
+    int conexiones_activas;       // Cantidad de clientes conectados
+    int conexiones_pausadas;      // Conexiones que se dejaron de leer
+    int conexiones_respondiendo;  // Conexiones que dejaron de enviar y esperan sus respuestas
+    t_conexion *conexiones;       // Lista de conexiones abiertas
+    t_procesar_frame procesar;    // Callback invocado por cada frame completo
+    t_planificador *planificador; // Pool de manejadores (NULL = procesar en línea)
+    int evento_apagado;           // eventfd que pide drenar y terminar (-1 = ninguno)
+} t_reactor;
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Configura el control de flujo de todos los reactores
+ * @param credito Crédito inicial por conexión en bytes (0 = sin control de flujo)
+ * @param memoria_maxima Bytes sin procesar en el pool a partir de los que se pausa (0 = sin límite)
+ */
+void establecer_control_flujo(long credito, long memoria_maxima);
+
+/**
+ * @brief Elige el motor de E/S de los reactores
+ * @param motor MOTOR_EPOLL o MOTOR_IO_URING
+ */
+void establecer_motor_io(t_motor_io motor);
+
+/**
+ * @brief Convierte el texto de configuración en un motor de E/S
+ * @param texto "EPOLL" o "IO_URING"
+ * @return t_motor_io Motor (EPOLL si el texto no se reconoce)
+ */
+t_motor_io motor_io_desde_texto(char *texto);
+
+/**
+ * @brief Crea un reactor sobre un socket de escucha ya inicializado
+ * @param socket_servidor Socket devuelto por iniciar_servidor()
+ * @param procesar Función a invocar por cada frame recibido
+ * @param planificador Pool donde despachar los frames (NULL = en línea)
+ * @return t_reactor* Reactor creado o NULL si hay error
+ */
+t_reactor *reactor_crear(int socket_servidor, t_procesar_frame procesar, t_planificador *planificador);
+
+/**
+ * @brief Hace que el reactor drene y termine cuando un eventfd sea legible
+ * @param reactor Reactor a configurar
+ * @param evento_apagado eventfd compartido de apagado (no se lee nunca)
+ * @return bool true si se registró en epoll
+ */
+bool reactor_observar_apagado(t_reactor *reactor, int evento_apagado);
+
+/**
+ * @brief Ejecuta el bucle de eventos hasta el apagado o un error de epoll/io_uring
+ * @param reactor Reactor a ejecutar
+ */
+void reactor_ejecutar(t_reactor *reactor);
+
+/**
+ * @brief Cierra todas las conexiones y libera el reactor
+ * @param reactor Reactor a destruir
+ */
+void reactor_destruir(t_reactor *reactor);
+
+/**
+ * @brief Pone un file descriptor en modo no bloqueante
+ * @param fd File descriptor a configurar
+ * @return int 0 si se configuró correctamente, -1 si hay error
+ */
+int poner_no_bloqueante(int fd);
+
+#endif /* REACTOR_H_ */
@@ -1,16 +1,34 @@
 #include "server.h"
 
+// eventfd que despierta a los workers para el apagado (lo escribe el handler de señales)
+static int evento_apagado = -1;
+
 /**
  * @brief Función principal del servidor
  *
  * Esta función implementa un servidor que:
  * 1. Inicializa el sistema de logging
- * 2. Inicia el servidor en el puerto configurado
- * 3. Espera conexiones de clientes
- * 4. Procesa mensajes y paquetes en un bucle infinito
- * 5. Maneja desconexiones de clientes
+ * 2. Lee la configuración desde servidor.config
+ * 3. Lanza un worker por núcleo, cada uno con su socket SO_REUSEPORT
+ * 4. Cada worker atiende a sus clientes con un reactor epoll (o io_uring
+ *    con MOTOR_IO=IO_URING)
+ *    (y, si HANDLERS > 0, despacha los frames a un pool de manejadores)
+ * 5. Cierra solo la conexión del cliente que se desconecta
+ * 6. Ante SIGTERM o SIGINT deja de aceptar clientes, procesa lo que ya
+ *    llegó (con un plazo de TIEMPO_DRENADO_MS), cierra el journal, vacía
+ *    el log y termina
+ *
+ * Los mensajes recibidos se loguean en segundo plano (ver log_async.h)
+ * para no frenar a los workers con el formateo y la escritura del log.
+ * Con JOURNAL=1 además se guardan en binario en un journal mapeado en
+ * memoria (ver journal.h). Con METRICAS=1 cada hilo cuenta frames,
+ * bytes y latencias, que se consultan en METRICAS_SOCKET (ver metricas.h).
+ *
+ * Los clientes que lo piden reciben CREDITO_CONEXION bytes de crédito y
+ * el pool pausa la lectura de los sockets si acumula más de
+ * MEMORIA_PENDIENTE_MAXIMA bytes sin procesar (ver reactor.h).
  *
- * El servidor puede recibir dos tipos de operaciones:
+ * Las operaciones que atiende se registran en registrar_operaciones():
  * - MENSAJE: Un mensaje simple
  * - PAQUETE: Múltiples mensajes agrupados
  *
@@ -21,45 +39,285 @@ int main(void)
     // Inicializar logger del servidor con nivel DEBUG
     logger = log_create("log.log", "Servidor", 1, LOG_LEVEL_DEBUG);
 
-    // Iniciar servidor y obtener socket de escucha
-    int server_fd = iniciar_servidor();
-    log_info(logger, "Servidor listo para recibir al cliente");
+    t_config_servidor config = cargar_configuracion();
+    establecer_tamanio_maximo_frame(config.tamanio_maximo_frame);
+    establecer_control_flujo(config.credito_conexion, config.memoria_pendiente);
+    establecer_motor_io(config.motor_io);
+    registrar_operaciones();
+
+    if (!iniciar_log_async(config.capacidad_log, config.politica_log))
+        log_warning(logger, "No se pudo iniciar el log asincrono, se loguea en linea");
+
+    if (config.journal && !iniciar_journal(config.parametros_journal))
+        log_warning(logger, "No se pudo iniciar el journal en %s, los frames no se guardan", config.parametros_journal.directorio);
+
+    if (config.metricas && !iniciar_metricas(config.socket_metricas))
+        log_warning(logger, "Se cuentan metricas pero no se pueden consultar por %s", config.socket_metricas);
+
+    // Pool de manejadores: los workers solo leen y decodifican
+    t_planificador *planificador = NULL;
+    if (config.manejadores > 0)
+    {
+        planificador = planificador_crear(config.manejadores, despachar_operacion);
+        if (planificador == NULL)
+            log_warning(logger, "No se pudo crear el pool de manejadores, se procesa en los workers");
+    }
+
+    // Evento de apagado: lo escriben los handlers de SIGTERM/SIGINT
+    evento_apagado = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (evento_apagado == -1 || !instalar_apagado(evento_apagado))
+        log_warning(logger, "No se pudo preparar el apagado ordenado: %s", strerror(errno));
+
+    // Lanzar los workers: cada uno escucha en PUERTO con su propio socket
+    int cantidad_workers;
+    t_worker *workers = iniciar_workers(config.workers, despachar_operacion, planificador, evento_apagado, &cantidad_workers);
+    if (workers == NULL)
+    {
+        log_error(logger, "No se pudo iniciar ningun worker");
+        if (planificador != NULL)
+            planificador_destruir(planificador);
+        finalizar_metricas();
+        finalizar_journal();
+        finalizar_log_async();
+        log_destroy(logger);
+        return EXIT_FAILURE;
+    }
+    log_info(logger, "Servidor listo para recibir clientes (%d workers)", cantidad_workers);
+
+    // Los workers terminan al pedir el apagado (o si falla su epoll)
+    esperar_workers(workers, cantidad_workers);
+
+    // Procesar los frames que quedaron en el pool, con plazo. Si se venció
+    // puede haber manejadores abandonados que todavía loguean en línea
+    bool drenado = planificador == NULL || planificador_drenar(planificador, config.tiempo_drenado_ms);
+    if (!drenado)
+        log_warning(logger, "Se vencio el plazo de drenado (%d ms)", config.tiempo_drenado_ms);
+
+    uint64_t pedido = 0;
+    bool apagado_pedido = evento_apagado != -1 && read(evento_apagado, &pedido, sizeof(pedido)) == sizeof(pedido);
+    if (evento_apagado != -1)
+        close(evento_apagado);
+
+    finalizar_metricas();
+    finalizar_journal();
+    finalizar_log_async();
+    if (apagado_pedido)
+        log_info(logger, "Servidor apagado");
+    else
+        log_error(logger, "Los workers terminaron por un error");
+    if (drenado)
+        log_destroy(logger);
+    return apagado_pedido ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Handler de SIGTERM y SIGINT
+ *
+ * Solo escribe en el eventfd (write() es async-signal-safe): los
+ * workers lo ven en su epoll y drenan.
+ *
+ * @param senial Señal recibida
+ */
+static void pedir_apagado(int senial)
+{
+    (void)senial;
+    int errno_previo = errno;
+    uint64_t uno = 1;
+    ssize_t escritos = write(evento_apagado, &uno, sizeof(uno));
+    (void)escritos;
+    errno = errno_previo;
+}
+
+/**
+ * @brief Instala los handlers de SIGTERM y SIGINT que piden el apagado
+ *
+ * @param evento Evento que observan los workers (se escribe al recibir la señal)
+ * @return bool true si se instalaron los handlers
+ */
+bool instalar_apagado(int evento)
+{
+    evento_apagado = evento;
+
+    struct sigaction accion = {0};
+    accion.sa_handler = pedir_apagado;
+    sigemptyset(&accion.sa_mask);
+    accion.sa_flags = SA_RESTART;
+
+    return sigaction(SIGTERM, &accion, NULL) == 0 && sigaction(SIGINT, &accion, NULL) == 0;
+}
+
+/**
+ * @brief Carga la configuración del servidor, con valores por defecto
+ *
+ * Si servidor.config no existe o le falta alguna clave se usan los
+ * valores por defecto:
+ * - WORKERS=0 (un worker por núcleo)
+ * - MOTOR_IO=EPOLL (EPOLL o IO_URING)
+ * - HANDLERS=0 (cada worker procesa sus frames, sin pool de manejadores)
+ * - TIEMPO_DRENADO_MS=5000 (plazo para procesar lo pendiente al apagar)
+ * - LOG_CAPACIDAD=65536 (entradas del anillo de log asíncrono)
+ * - LOG_POLITICA=DESCARTAR (descartar mensajes si el anillo está lleno)
+ * - TAMANIO_MAXIMO_FRAME=16777216 (frames más grandes cierran la conexión)
+ * - CREDITO_CONEXION=1048576 (bytes que un cliente envía sin esperar, 0 = sin control de flujo)
+ * - MEMORIA_PENDIENTE_MAXIMA=268435456 (bytes sin procesar en el pool que pausan la lectura, 0 = sin límite)
+ * - JOURNAL=0 (no guardar los frames recibidos en el journal binario)
+ * - JOURNAL_DIRECTORIO=journal (directorio de los segmentos)
+ * - JOURNAL_TAMANIO_SEGMENTO=67108864 (bytes preasignados por segmento)
+ * - JOURNAL_FSYNC=LOTE (NUNCA, LOTE o SIEMPRE)
+ * - JOURNAL_LOTE_BYTES=1048576 (bytes sin sincronizar que disparan un msync)
+ * - JOURNAL_INTERVALO_MS=100 (espera máxima entre msync con LOTE)
+ * - METRICAS=0 (no contar métricas)
+ * - METRICAS_SOCKET=metricas.sock (socket Unix de consulta, vacío = ninguno)
+ *
+ * @return t_config_servidor Parámetros del servidor
+ */
+t_config_servidor cargar_configuracion(void)
+{
+    t_config_servidor parametros = {
+        .workers = 0,
+        .motor_io = MOTOR_EPOLL,
+        .manejadores = 0,
+        .tiempo_drenado_ms = 5000,
+        .capacidad_log = CAPACIDAD_LOG_ASYNC,
+        .politica_log = LOG_ASYNC_DESCARTAR,
+        .tamanio_maximo_frame = TAMANIO_MAXIMO_FRAME,
+        .credito_conexion = CREDITO_POR_CONEXION,
+        .memoria_pendiente = MEMORIA_PENDIENTE_MAXIMA,
+        .journal = false,
+        .parametros_journal = {
+            .directorio = "journal",
+            .tamanio_segmento = TAMANIO_SEGMENTO_JOURNAL,
+            .politica = JOURNAL_FSYNC_LOTE,
+            .lote_bytes = LOTE_BYTES_JOURNAL,
+            .intervalo_ms = INTERVALO_JOURNAL_MS},
+        .metricas = false,
+        .socket_metricas = "metricas.sock"};
+
+    t_config *config = config_create(ARCHIVO_CONFIG);
+    if (config == NULL)
+    {
+        log_info(logger, "No se encontro %s, usando valores por defecto", ARCHIVO_CONFIG);
+        return parametros;
+    }
+
+    if (config_has_property(config, "WORKERS"))
+        parametros.workers = config_get_int_value(config, "WORKERS");
+    if (config_has_property(config, "MOTOR_IO"))
+        parametros.motor_io = motor_io_desde_texto(config_get_string_value(config, "MOTOR_IO"));
+    if (config_has_property(config, "HANDLERS"))
+        parametros.manejadores = config_get_int_value(config, "HANDLERS");
+    if (config_has_property(config, "TIEMPO_DRENADO_MS"))
+        parametros.tiempo_drenado_ms = config_get_int_value(config, "TIEMPO_DRENADO_MS");
+    if (config_has_property(config, "LOG_CAPACIDAD"))
+        parametros.capacidad_log = config_get_int_value(config, "LOG_CAPACIDAD");
+    if (config_has_property(config, "LOG_POLITICA"))
+        parametros.politica_log = politica_log_desde_texto(config_get_string_value(config, "LOG_POLITICA"));
+    if (config_has_property(config, "TAMANIO_MAXIMO_FRAME"))
+        parametros.tamanio_maximo_frame = config_get_int_value(config, "TAMANIO_MAXIMO_FRAME");
+    if (config_has_property(config, "CREDITO_CONEXION"))
+        parametros.credito_conexion = config_get_long_value(config, "CREDITO_CONEXION");
+    if (config_has_property(config, "MEMORIA_PENDIENTE_MAXIMA"))
+        parametros.memoria_pendiente = config_get_long_value(config, "MEMORIA_PENDIENTE_MAXIMA");
+    if (config_has_property(config, "JOURNAL"))
+        parametros.journal = config_get_int_value(config, "JOURNAL") != 0;
+    if (config_has_property(config, "JOURNAL_DIRECTORIO"))
+        snprintf(parametros.parametros_journal.directorio, sizeof(parametros.parametros_journal.directorio),
+                 "%s", config_get_string_value(config, "JOURNAL_DIRECTORIO"));
+    if (config_has_property(config, "JOURNAL_TAMANIO_SEGMENTO"))
+        parametros.parametros_journal.tamanio_segmento = config_get_long_value(config, "JOURNAL_TAMANIO_SEGMENTO");
+    if (config_has_property(config, "JOURNAL_FSYNC"))
+        parametros.parametros_journal.politica = politica_fsync_desde_texto(config_get_string_value(config, "JOURNAL_FSYNC"));
+    if (config_has_property(config, "JOURNAL_LOTE_BYTES"))
+        parametros.parametros_journal.lote_bytes = config_get_long_value(config, "JOURNAL_LOTE_BYTES");
+    if (config_has_property(config, "JOURNAL_INTERVALO_MS"))
+        parametros.parametros_journal.intervalo_ms = config_get_int_value(config, "JOURNAL_INTERVALO_MS");
+    if (config_has_property(config, "METRICAS"))
+        parametros.metricas = config_get_int_value(config, "METRICAS") != 0;
+    if (config_has_property(config, "METRICAS_SOCKET"))
+        snprintf(parametros.socket_metricas, sizeof(parametros.socket_metricas),
+                 "%s", config_get_string_value(config, "METRICAS_SOCKET"));
+
+    config_destroy(config);
+    return parametros;
+}
 
-    // Esperar y aceptar conexión de un cliente
-    int cliente_fd = esperar_cliente(server_fd);
-    t_list *lista;
+/**
+ * @brief Registra las operaciones que atiende el servidor
+ *
+ * Para agregar una operación: sumar su código al enum op_code (en el
+ * cliente y en el servidor) y registrarla acá.
+ */
+void registrar_operaciones(void)
+{
+    registrar_operacion(MENSAJE, "MENSAJE", NULL, manejar_mensaje);
+    registrar_operacion(PAQUETE, "PAQUETE", decodificar_paquete, manejar_paquete);
+}
+
+/**
+ * @brief Loguea un mensaje simple
+ *
+ * @param contexto Frame MENSAJE recibido
+ */
+void manejar_mensaje(t_contexto_operacion *contexto)
+{
+    registrar_en_journal(contexto->socket_cliente, contexto->cod_op, contexto->formato, contexto->payload, contexto->size);
+    log_async(LOG_LEVEL_INFO, "Me llego el mensaje: %.*s", contexto->payload, contexto->size);
+}
 
-    // Bucle principal: procesar mensajes del cliente
-    while (1)
+/**
+ * @brief Ubica los elementos de un paquete sin copiarlos
+ *
+ * La vista se reutiliza para todos los paquetes que procesa el hilo.
+ *
+ * @param contexto Frame PAQUETE recibido (decodificado apunta a la vista)
+ * @return bool true si el paquete está bien formado
+ */
+bool decodificar_paquete(t_contexto_operacion *contexto)
+{
+    static __thread t_vista_paquete *vista = NULL;
+
+    if (vista == NULL)
+        vista = crear_vista_paquete();
+    if (!parsear_vista_paquete_formato(vista, contexto->payload, contexto->size, contexto->formato))
+        return false;
+
+    contexto->decodificado = vista;
+    return true;
+}
+
+/**
+ * @brief Loguea todos los valores de un paquete
+ *
+ * El frame se guarda entero en el journal (si está activo). Los
+ * paquetes fragmentados se loguean a medida que llega cada frame:
+ * las partes de un valor partido entre frames se marcan con "..." en
+ * lugar de juntarlas, así el manejador no guarda nada entre frames.
+ *
+ * @param contexto Frame PAQUETE ya decodificado en una t_vista_paquete
+ */
+void manejar_paquete(t_contexto_operacion *contexto)
+{
+    t_vista_paquete *vista = contexto->decodificado;
+
+    registrar_en_journal(contexto->socket_cliente, contexto->cod_op, contexto->formato, contexto->payload, contexto->size);
+
+    if (!(contexto->formato.flags & FLAG_PAQUETE_CONTINUADO))
+        log_async(LOG_LEVEL_INFO, "Me llegaron los siguientes valores:\n%.*s", "", 0);
+
+    // Iterar y mostrar todos los mensajes recibidos
+    for (int i = 0; i < vista->cantidad; i++)
     {
-        // Recibir código de operación del cliente
-        int cod_op = recibir_operacion(cliente_fd);
-
-        // Procesar según el tipo de operación
-        switch (cod_op)
-        {
-        case MENSAJE:
-            // Procesar mensaje simple
-            recibir_mensaje(cliente_fd);
-            break;
-        case PAQUETE:
-            // Procesar paquete con múltiples mensajes
-            lista = recibir_paquete(cliente_fd);
-            log_info(logger, "Me llegaron los siguientes valores:\n");
-            // Iterar y mostrar todos los mensajes recibidos
-            list_iterate(lista, (void *)iterator);
-            break;
-        case -1:
-            // Cliente se desconectó
-            log_error(logger, "el cliente se desconecto. Terminando servidor");
-            return EXIT_FAILURE;
-        default:
-            // Operación desconocida
-            log_warning(logger, "Operacion desconocida. No quieras meter la pata");
-            break;
-        }
+        t_fragmento_elemento fragmento = fragmento_vista_paquete(vista, i);
+
+        if (fragmento.comienza && fragmento.termina)
+            log_async(LOG_LEVEL_INFO, "%.*s", fragmento.datos, fragmento.longitud);
+        else if (fragmento.comienza)
+            log_async(LOG_LEVEL_INFO, "%.*s...", fragmento.datos, fragmento.longitud);
+        else if (fragmento.termina)
+            log_async(LOG_LEVEL_INFO, "...%.*s", fragmento.datos, fragmento.longitud);
+        else
+            log_async(LOG_LEVEL_INFO, "...%.*s...", fragmento.datos, fragmento.longitud);
     }
-    return EXIT_SUCCESS;
 }
 
 /**
@@ -73,5 +331,5 @@ int main(void)
 void iterator(char *value)
 {
     // Registrar cada mensaje en el log
-    log_info(logger, "%s", value);
+    log_async(LOG_LEVEL_INFO, "%.*s", value, strlen(value));
 }
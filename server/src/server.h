@@ -4,8 +4,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <signal.h>
+#include <sys/eventfd.h>
 #include <commons/log.h>
+#include <commons/config.h>
 #include "utils.h"
+#include "reactor.h"
+#include "workers.h"
+#include "log_async.h"
+#include "planificador.h"
+#include "operaciones.h"
+#include "journal.h"
+#include "metricas.h"
 
 /**
  * @file server.h
@@ -15,8 +25,72 @@
  * del servidor que procesa mensajes de clientes.
  */
 
+// ========== CONFIGURACIÓN ==========
+
+/**
+ * @brief Archivo de configuración del servidor (opcional)
+ */
+#define ARCHIVO_CONFIG "servidor.config"
+
+/**
+ * @brief Parámetros del servidor leídos desde ARCHIVO_CONFIG
+ */
+typedef struct
+{
+    int workers;                 // WORKERS: hilos con socket SO_REUSEPORT propio (0 = uno por núcleo)
+    t_motor_io motor_io;         // MOTOR_IO: EPOLL o IO_URING (vuelve a epoll si no hay soporte)
+    int manejadores;             // HANDLERS: hilos del pool de manejadores (0 = procesar en el worker)
+    int tiempo_drenado_ms;       // TIEMPO_DRENADO_MS: plazo para procesar lo pendiente al apagar
+    int capacidad_log;           // LOG_CAPACIDAD: entradas del anillo de log asíncrono
+    t_politica_log politica_log; // LOG_POLITICA: DESCARTAR o BLOQUEAR con el anillo lleno
+    int tamanio_maximo_frame;    // TAMANIO_MAXIMO_FRAME: payload más grande aceptado por frame
+    long credito_conexion;       // CREDITO_CONEXION: crédito de cada cliente en bytes (0 = sin control de flujo)
+    long memoria_pendiente;      // MEMORIA_PENDIENTE_MAXIMA: bytes sin procesar en el pool para pausar la lectura (0 = sin límite)
+    bool journal;                // JOURNAL: guardar los frames recibidos en el journal binario
+    t_parametros_journal parametros_journal; // JOURNAL_*: directorio, segmentos y fsync
+    bool metricas;               // METRICAS: contar métricas por hilo
+    char socket_metricas[TAMANIO_RUTA_METRICAS]; // METRICAS_SOCKET: socket Unix de consulta ("" = ninguno)
+} t_config_servidor;
+
 // ========== DECLARACIONES DE FUNCIONES ==========
 
+/**
+ * @brief Carga la configuración del servidor, con valores por defecto
+ * @return t_config_servidor Parámetros del servidor
+ */
+t_config_servidor cargar_configuracion(void);
+
+/**
+ * @brief Instala los handlers de SIGTERM y SIGINT que piden el apagado
+ * @param evento_apagado eventfd que observan los workers
+ * @return bool true si se instalaron los handlers
+ */
+bool instalar_apagado(int evento_apagado);
+
+/**
+ * @brief Registra las operaciones que atiende el servidor
+ */
+void registrar_operaciones(void);
+
+/**
+ * @brief Maneja una operación MENSAJE
+ * @param contexto Frame recibido
+ */
+void manejar_mensaje(t_contexto_operacion *contexto);
+
+/**
+ * @brief Decodifica una operación PAQUETE en una vista sin copias
+ * @param contexto Frame recibido (decodificado apunta a la vista)
+ * @return bool true si el paquete está bien formado
+ */
+bool decodificar_paquete(t_contexto_operacion *contexto);
+
+/**
+ * @brief Maneja una operación PAQUETE ya decodificada
+ * @param contexto Frame recibido
+ */
+void manejar_paquete(t_contexto_operacion *contexto);
+
 /**
  * @brief Función auxiliar para iterar sobre mensajes recibidos
  * @param value String con el mensaje a procesar
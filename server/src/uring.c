@@ -0,0 +1,463 @@
+#include "uring.h"
+
+/**
+ * @brief Syscall io_uring_setup() (glibc no la envuelve)
+ */
+static int uring_setup(unsigned entradas, struct io_uring_params *parametros)
+{
+    return (int)syscall(__NR_io_uring_setup, entradas, parametros);
+}
+
+/**
+ * @brief Syscall io_uring_enter() (glibc no la envuelve)
+ */
+static int uring_enter(int fd, unsigned a_enviar, unsigned minimo, unsigned flags, void *argumento, size_t tamanio)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, a_enviar, minimo, flags, argumento, tamanio);
+}
+
+/**
+ * @brief Syscall io_uring_register() (glibc no la envuelve)
+ */
+static int uring_register(int fd, unsigned operacion, void *argumento, unsigned cantidad)
+{
+    return (int)syscall(__NR_io_uring_register, fd, operacion, argumento, cantidad);
+}
+
+/**
+ * @brief Verifica que el kernel tenga recv multishot
+ *
+ * No hay un feature flag para recv multishot: se toma como indicio la
+ * operación SEND_ZC, que llegó en la misma versión (Linux 6.0).
+ *
+ * @param fd File descriptor de io_uring
+ * @return bool true si el kernel la soporta
+ */
+static bool soporta_recv_multishot(int fd)
+{
+    size_t tamanio = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *sonda = calloc(1, tamanio);
+
+    bool soportado = uring_register(fd, IORING_REGISTER_PROBE, sonda, 256) == 0 &&
+                     sonda->last_op >= IORING_OP_SEND_ZC &&
+                     (sonda->ops[IORING_OP_SEND_ZC].flags & IO_URING_OP_SUPPORTED);
+
+    free(sonda);
+    return soportado;
+}
+
+/**
+ * @brief Mapea las colas de envío y de completados
+ *
+ * @param uring Instancia con el fd ya creado
+ * @param parametros Offsets devueltos por io_uring_setup()
+ * @return bool true si se mapearon
+ */
+static bool mapear_colas(t_uring *uring, struct io_uring_params *parametros)
+{
+    uring->tamanio_memoria_sq = parametros->sq_off.array + parametros->sq_entries * sizeof(unsigned);
+    uring->tamanio_memoria_cq = parametros->cq_off.cqes + parametros->cq_entries * sizeof(struct io_uring_cqe);
+
+    // Con SINGLE_MMAP las dos colas comparten un único mapeo
+    if (parametros->features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (uring->tamanio_memoria_cq > uring->tamanio_memoria_sq)
+            uring->tamanio_memoria_sq = uring->tamanio_memoria_cq;
+        uring->tamanio_memoria_cq = 0;
+    }
+
+    uring->memoria_sq = mmap(NULL, uring->tamanio_memoria_sq, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQ_RING);
+    if (uring->memoria_sq == MAP_FAILED)
+        return false;
+
+    uring->memoria_cq = uring->memoria_sq;
+    if (uring->tamanio_memoria_cq > 0)
+    {
+        uring->memoria_cq = mmap(NULL, uring->tamanio_memoria_cq, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_CQ_RING);
+        if (uring->memoria_cq == MAP_FAILED)
+            return false;
+    }
+
+    uring->tamanio_sqes = parametros->sq_entries * sizeof(struct io_uring_sqe);
+    uring->sqes = mmap(NULL, uring->tamanio_sqes, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQES);
+    if (uring->sqes == MAP_FAILED)
+        return false;
+
+    char *sq = uring->memoria_sq;
+    uring->sq_cabeza = (unsigned *)(sq + parametros->sq_off.head);
+    uring->sq_cola = (unsigned *)(sq + parametros->sq_off.tail);
+    uring->sq_indices = (unsigned *)(sq + parametros->sq_off.array);
+    uring->sq_mascara = *(unsigned *)(sq + parametros->sq_off.ring_mask);
+    uring->sq_siguiente = *uring->sq_cola;
+
+    // Cada lugar de la SQ apunta siempre a la SQE del mismo índice
+    for (unsigned i = 0; i < parametros->sq_entries; i++)
+        uring->sq_indices[i] = i;
+
+    char *cq = uring->memoria_cq;
+    uring->cq_cabeza = (unsigned *)(cq + parametros->cq_off.head);
+    uring->cq_cola = (unsigned *)(cq + parametros->cq_off.tail);
+    uring->cqes = (struct io_uring_cqe *)(cq + parametros->cq_off.cqes);
+    uring->cq_mascara = *(unsigned *)(cq + parametros->cq_off.ring_mask);
+
+    return true;
+}
+
+/**
+ * @brief Registra el anillo de buffers provistos y le carga todos los buffers
+ *
+ * @param uring Instancia con las colas mapeadas
+ * @return bool true si se registró
+ */
+static bool registrar_buffers(t_uring *uring)
+{
+    size_t tamanio_anillo = BUFFERS_URING * sizeof(struct io_uring_buf);
+    uring->buffers = mmap(NULL, tamanio_anillo, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (uring->buffers == MAP_FAILED)
+    {
+        uring->buffers = NULL;
+        return false;
+    }
+
+    struct io_uring_buf_reg registro = {
+        .ring_addr = (uint64_t)(uintptr_t)uring->buffers,
+        .ring_entries = BUFFERS_URING,
+        .bgid = GRUPO_BUFFERS_URING};
+    if (uring_register(uring->fd, IORING_REGISTER_PBUF_RING, &registro, 1) != 0)
+        return false;
+
+    uring->datos_buffers = malloc((size_t)BUFFERS_URING * TAMANIO_BUFFER_URING);
+    if (uring->datos_buffers == NULL)
+        return false;
+
+    for (unsigned i = 0; i < BUFFERS_URING; i++)
+        uring_devolver_buffer(uring, i);
+
+    return true;
+}
+
+/**
+ * @brief Crea la instancia y registra el anillo de buffers provistos
+ *
+ * Pide una CQ cuatro veces más grande que la SQ, porque cada accept() y
+ * recv() multishot genera muchos completados por cada SQE.
+ *
+ * @return t_uring* Instancia o NULL si el kernel no soporta lo necesario
+ */
+t_uring *uring_crear(void)
+{
+    struct io_uring_params parametros;
+    memset(&parametros, 0, sizeof(parametros));
+    parametros.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+    parametros.cq_entries = 4 * ENTRADAS_URING;
+
+    t_uring *uring = calloc(1, sizeof(t_uring));
+    if (uring == NULL)
+        return NULL;
+
+    uring->fd = uring_setup(ENTRADAS_URING, &parametros);
+    if (uring->fd == -1)
+    {
+        free(uring);
+        return NULL;
+    }
+
+    uring->memoria_sq = uring->memoria_cq = MAP_FAILED;
+    uring->sqes = MAP_FAILED;
+
+    unsigned necesarias = IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((parametros.features & necesarias) != necesarias || !soporta_recv_multishot(uring->fd) ||
+        !mapear_colas(uring, &parametros) || !registrar_buffers(uring))
+    {
+        uring_destruir(uring);
+        return NULL;
+    }
+
+    return uring;
+}
+
+/**
+ * @brief Libera la instancia (las operaciones en curso se cancelan)
+ *
+ * Cerrar el fd cancela lo que siga en curso en el kernel.
+ *
+ * @param uring Instancia a liberar
+ */
+void uring_destruir(t_uring *uring)
+{
+    close(uring->fd);
+
+    if (uring->sqes != MAP_FAILED)
+        munmap(uring->sqes, uring->tamanio_sqes);
+    if (uring->memoria_cq != MAP_FAILED && uring->memoria_cq != uring->memoria_sq)
+        munmap(uring->memoria_cq, uring->tamanio_memoria_cq);
+    if (uring->memoria_sq != MAP_FAILED)
+        munmap(uring->memoria_sq, uring->tamanio_memoria_sq);
+    if (uring->buffers != NULL)
+        munmap(uring->buffers, BUFFERS_URING * sizeof(struct io_uring_buf));
+
+    free(uring->datos_buffers);
+    free(uring->apartados);
+    free(uring);
+}
+
+/**
+ * @brief Saca los completados de la CQ sin atenderlos
+ *
+ * Con la CQ llena el kernel puede rechazar SQE nuevas (EBUSY) hasta que
+ * se lean completados. Copiarlos a apartados le hace lugar, y
+ * uring_completado() los entrega antes que los de la CQ, en el mismo
+ * orden.
+ *
+ * @param uring Instancia
+ * @return bool true si apartó alguno
+ */
+static bool apartar_completados(t_uring *uring)
+{
+    unsigned cabeza = *uring->cq_cabeza;
+    unsigned cola = __atomic_load_n(uring->cq_cola, __ATOMIC_ACQUIRE);
+    if (cabeza == cola)
+        return false;
+
+    // Los ya entregados dejan su lugar al principio
+    if (uring->primer_apartado > 0)
+    {
+        memmove(uring->apartados, uring->apartados + uring->primer_apartado,
+                uring->cantidad_apartados * sizeof(struct io_uring_cqe));
+        uring->primer_apartado = 0;
+    }
+
+    unsigned necesarios = uring->cantidad_apartados + (cola - cabeza);
+    if (necesarios > uring->capacidad_apartados)
+    {
+        struct io_uring_cqe *apartados = realloc(uring->apartados, necesarios * sizeof(struct io_uring_cqe));
+        if (apartados == NULL)
+            return false;
+        uring->apartados = apartados;
+        uring->capacidad_apartados = necesarios;
+    }
+
+    for (; cabeza != cola; cabeza++)
+        uring->apartados[uring->cantidad_apartados++] = uring->cqes[cabeza & uring->cq_mascara];
+    __atomic_store_n(uring->cq_cabeza, cabeza, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * @brief Reserva la próxima SQE, mandando las pendientes si la cola está llena
+ *
+ * La SQE no se publica hasta el próximo uring_enviar(). Si la SQ está
+ * llena y el kernel no la vacía, se apartan los completados para hacerle
+ * lugar en la CQ; solo se rinde cuando ni así avanza.
+ *
+ * @param uring Instancia
+ * @return struct io_uring_sqe* SQE en cero, lista para completar, o NULL si
+ *         el kernel no toma más SQE ni haciéndole lugar en la CQ
+ */
+struct io_uring_sqe *uring_obtener_sqe(t_uring *uring)
+{
+    while (uring->sq_siguiente - __atomic_load_n(uring->sq_cabeza, __ATOMIC_ACQUIRE) > uring->sq_mascara)
+    {
+        unsigned cabeza = __atomic_load_n(uring->sq_cabeza, __ATOMIC_ACQUIRE);
+        if (uring_enviar(uring, 0) == -1)
+            return NULL;
+
+        // El kernel tomó SQE o dejó completados que se pueden apartar
+        bool avanzo = __atomic_load_n(uring->sq_cabeza, __ATOMIC_ACQUIRE) != cabeza;
+        if (!apartar_completados(uring) && !avanzo)
+            return NULL;
+    }
+
+    struct io_uring_sqe *sqe = &uring->sqes[uring->sq_siguiente & uring->sq_mascara];
+    uring->sq_siguiente++;
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+/**
+ * @brief Manda las SQE preparadas y espera completados con un solo io_uring_enter()
+ *
+ * Publica todas las SQE reservadas desde la llamada anterior y, si
+ * espera_ms no es 0, bloquea hasta que haya al menos un completado o
+ * venza la espera.
+ *
+ * @param uring Instancia
+ * @param espera_ms Espera máxima por un completado (-1 = sin límite, 0 = no esperar)
+ * @return int 0 si se enviaron, -1 si hay error (ver errno; ETIME/EINTR no son errores)
+ */
+int uring_enviar(t_uring *uring, int espera_ms)
+{
+    __atomic_store_n(uring->sq_cola, uring->sq_siguiente, __ATOMIC_RELEASE);
+    unsigned a_enviar = uring->sq_siguiente - __atomic_load_n(uring->sq_cabeza, __ATOMIC_ACQUIRE);
+
+    struct __kernel_timespec espera = {
+        .tv_sec = espera_ms / 1000,
+        .tv_nsec = (long long)(espera_ms % 1000) * 1000000};
+    struct io_uring_getevents_arg argumento = {
+        .sigmask = 0,
+        .sigmask_sz = _NSIG / 8,
+        .ts = espera_ms > 0 ? (uint64_t)(uintptr_t)&espera : 0};
+
+    int resultado = uring_enter(uring->fd, a_enviar, espera_ms != 0 ? 1 : 0,
+                                IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                                &argumento, sizeof(argumento));
+    if (resultado == -1 && (errno == ETIME || errno == EINTR || errno == EBUSY || errno == EAGAIN))
+        return 0;
+
+    return resultado == -1 ? -1 : 0;
+}
+
+/**
+ * @brief Devuelve el siguiente completado sin consumirlo
+ *
+ * Entrega primero los que apartó uring_obtener_sqe(), que son anteriores
+ * a los que sigan en la CQ.
+ *
+ * @param uring Instancia
+ * @return struct io_uring_cqe* Completado o NULL si no hay
+ */
+struct io_uring_cqe *uring_completado(t_uring *uring)
+{
+    if (uring->cantidad_apartados > 0)
+        return &uring->apartados[uring->primer_apartado];
+
+    unsigned cabeza = *uring->cq_cabeza;
+    if (cabeza == __atomic_load_n(uring->cq_cola, __ATOMIC_ACQUIRE))
+        return NULL;
+
+    return &uring->cqes[cabeza & uring->cq_mascara];
+}
+
+/**
+ * @brief Marca como leído el completado devuelto por uring_completado()
+ *
+ * @param uring Instancia
+ */
+void uring_completado_visto(t_uring *uring)
+{
+    if (uring->cantidad_apartados > 0)
+    {
+        uring->primer_apartado++;
+        if (--uring->cantidad_apartados == 0)
+            uring->primer_apartado = 0;
+        return;
+    }
+
+    __atomic_store_n(uring->cq_cabeza, *uring->cq_cabeza + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Datos del buffer provisto que usó un recv()
+ *
+ * @param uring Instancia
+ * @param buffer Índice del buffer (cqe->flags >> IORING_CQE_BUFFER_SHIFT)
+ * @return char* Inicio del buffer
+ */
+char *uring_buffer(t_uring *uring, unsigned buffer)
+{
+    return uring->datos_buffers + (size_t)buffer * TAMANIO_BUFFER_URING;
+}
+
+/**
+ * @brief Devuelve un buffer provisto al anillo para que el kernel lo reutilice
+ *
+ * @param uring Instancia
+ * @param buffer Índice del buffer
+ */
+void uring_devolver_buffer(t_uring *uring, unsigned buffer)
+{
+    struct io_uring_buf *entrada = &uring->buffers->bufs[uring->cola_buffers & (BUFFERS_URING - 1)];
+    entrada->addr = (uint64_t)(uintptr_t)uring_buffer(uring, buffer);
+    entrada->len = TAMANIO_BUFFER_URING;
+    entrada->bid = (unsigned short)buffer;
+
+    uring->cola_buffers++;
+    __atomic_store_n(&uring->buffers->tail, uring->cola_buffers, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Prepara un accept() multishot que no bloquea ni hereda el socket
+ *
+ * @param sqe SQE a completar
+ * @param socket_servidor Socket de escucha
+ * @param datos Dato de usuario de cada completado
+ */
+void uring_preparar_aceptar(struct io_uring_sqe *sqe, int socket_servidor, uint64_t datos)
+{
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = socket_servidor;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = datos;
+}
+
+/**
+ * @brief Prepara un recv() multishot con buffers provistos
+ *
+ * Cada completado trae en cqe->flags el índice del buffer que usó. El
+ * recv sigue activo mientras el completado tenga IORING_CQE_F_MORE.
+ *
+ * @param sqe SQE a completar
+ * @param socket Socket del que recibir
+ * @param datos Dato de usuario de cada completado
+ */
+void uring_preparar_recibir(struct io_uring_sqe *sqe, int socket, uint64_t datos)
+{
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = socket;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = GRUPO_BUFFERS_URING;
+    sqe->user_data = datos;
+}
+
+/**
+ * @brief Prepara un poll() de un file descriptor
+ *
+ * @param sqe SQE a completar
+ * @param fd File descriptor a observar
+ * @param eventos Eventos de poll (POLLIN, POLLOUT, ...)
+ * @param multishot true para que siga activo después de cada aviso
+ * @param datos Dato de usuario de cada completado
+ */
+void uring_preparar_sondeo(struct io_uring_sqe *sqe, int fd, unsigned eventos, bool multishot, uint64_t datos)
+{
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = eventos;
+    sqe->len = multishot ? IORING_POLL_ADD_MULTI : 0;
+    sqe->user_data = datos;
+}
+
+/**
+ * @brief Prepara la cancelación de las operaciones con un dato de usuario
+ *
+ * @param sqe SQE a completar
+ * @param objetivo Dato de usuario de las operaciones a cancelar
+ * @param datos Dato de usuario del completado de la cancelación
+ */
+void uring_preparar_cancelar(struct io_uring_sqe *sqe, uint64_t objetivo, uint64_t datos)
+{
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = objetivo;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_ALL;
+    sqe->user_data = datos;
+}
+
+/**
+ * @brief Prepara la cancelación de todas las operaciones en curso
+ *
+ * @param sqe SQE a completar
+ * @param datos Dato de usuario del completado de la cancelación
+ */
+void uring_preparar_cancelar_todo(struct io_uring_sqe *sqe, uint64_t datos)
+{
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY | IORING_ASYNC_CANCEL_ALL;
+    sqe->user_data = datos;
+}
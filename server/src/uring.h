@@ -0,0 +1,199 @@
+#ifndef URING_H_
+#define URING_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "utils.h"
+
+/**
+ * @file uring.h
+ * @brief Envoltorio mínimo de io_uring para el camino de recepción
+ *
+ * Usa las syscalls directamente (sin liburing): mapea las colas de envío
+ * (SQ) y de completados (CQ) y registra un anillo de buffers provistos
+ * del que el kernel toma dónde escribir cada recv() multishot, así no
+ * hace falta un buffer por conexión mientras no llegan datos.
+ *
+ * Las SQE se preparan en la cola sin syscalls y uring_enviar() las manda
+ * todas juntas con un solo io_uring_enter(), que además espera los
+ * completados. Lo usa un único hilo: no hay sincronización entre hilos.
+ *
+ * Requiere recv multishot (Linux 6.0). uring_crear() falla con un
+ * kernel anterior o si io_uring está deshabilitado, y quien lo usa
+ * vuelve a epoll.
+ */
+
+// ========== CONSTANTES ==========
+
+/**
+ * @brief Entradas de la cola de envío (la de completados es el cuádruple)
+ */
+#define ENTRADAS_URING 256
+
+/**
+ * @brief Cantidad de buffers provistos para recv (potencia de 2)
+ */
+#define BUFFERS_URING 256
+
+/**
+ * @brief Tamaño de cada buffer provisto
+ */
+#define TAMANIO_BUFFER_URING (16 * 1024)
+
+/**
+ * @brief Grupo con el que se registra el anillo de buffers
+ */
+#define GRUPO_BUFFERS_URING 0
+
+// ========== TIPOS ==========
+
+/**
+ * @brief Instancia de io_uring con su anillo de buffers provistos
+ *
+ * Los punteros apuntan a la memoria compartida con el kernel.
+ */
+typedef struct
+{
+    int fd; // File descriptor de io_uring
+
+    void *memoria_sq;              // Mapeo de la SQ (y de la CQ si comparten mapeo)
+    size_t tamanio_memoria_sq;     // Bytes mapeados de la SQ
+    void *memoria_cq;              // Mapeo de la CQ
+    size_t tamanio_memoria_cq;     // Bytes mapeados de la CQ (0 = comparte el de la SQ)
+    struct io_uring_sqe *sqes;     // Arreglo de SQE
+    size_t tamanio_sqes;           // Bytes mapeados del arreglo de SQE
+
+    unsigned *sq_cabeza;           // Primera SQE que el kernel no consumió
+    unsigned *sq_cola;             // Siguiente SQE publicada
+    unsigned *sq_indices;          // Índices de SQE publicados en la SQ
+    unsigned sq_mascara;           // Entradas de la SQ - 1
+    unsigned sq_pendientes;        // SQE preparadas y no publicadas
+    unsigned sq_siguiente;         // Próxima SQE libre (sin publicar)
+
+    unsigned *cq_cabeza;           // Primer completado sin leer
+    unsigned *cq_cola;             // Siguiente completado que escribe el kernel
+    struct io_uring_cqe *cqes;     // Arreglo de completados
+    unsigned cq_mascara;           // Entradas de la CQ - 1
+
+    struct io_uring_cqe *apartados; // Completados sacados de la CQ para hacer lugar
+    unsigned capacidad_apartados;   // Lugar en apartados
+    unsigned primer_apartado;       // Próximo apartado a entregar
+    unsigned cantidad_apartados;    // Apartados sin entregar
+
+    struct io_uring_buf_ring *buffers; // Anillo de buffers provistos
+    char *datos_buffers;               // BUFFERS_URING buffers contiguos
+    unsigned short cola_buffers;       // Próximo lugar a devolver en el anillo
+} t_uring;
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Crea la instancia y registra el anillo de buffers provistos
+ * @return t_uring* Instancia o NULL si el kernel no soporta lo necesario
+ */
+t_uring *uring_crear(void);
+
+/**
+ * @brief Libera la instancia (las operaciones en curso se cancelan)
+ * @param uring Instancia a liberar
+ */
+void uring_destruir(t_uring *uring);
+
+/**
+ * @brief Reserva la próxima SQE, mandando las pendientes si la cola está llena
+ * @param uring Instancia
+ * @return struct io_uring_sqe* SQE en cero, lista para completar, o NULL si
+ *         el kernel no toma más SQE ni haciéndole lugar en la CQ
+ */
+struct io_uring_sqe *uring_obtener_sqe(t_uring *uring);
+
+/**
+ * @brief Manda las SQE preparadas y espera completados con un solo io_uring_enter()
+ * @param uring Instancia
+ * @param espera_ms Espera máxima por un completado (-1 = sin límite, 0 = no esperar)
+ * @return int 0 si se enviaron, -1 si hay error (ver errno; ETIME/EINTR no son errores)
+ */
+int uring_enviar(t_uring *uring, int espera_ms);
+
+/**
+ * @brief Devuelve el siguiente completado sin consumirlo
+ * @param uring Instancia
+ * @return struct io_uring_cqe* Completado o NULL si no hay
+ */
+struct io_uring_cqe *uring_completado(t_uring *uring);
+
+/**
+ * @brief Marca como leído el completado devuelto por uring_completado()
+ * @param uring Instancia
+ */
+void uring_completado_visto(t_uring *uring);
+
+/**
+ * @brief Datos del buffer provisto que usó un recv()
+ * @param uring Instancia
+ * @param buffer Índice del buffer (cqe->flags >> IORING_CQE_BUFFER_SHIFT)
+ * @return char* Inicio del buffer
+ */
+char *uring_buffer(t_uring *uring, unsigned buffer);
+
+/**
+ * @brief Devuelve un buffer provisto al anillo para que el kernel lo reutilice
+ * @param uring Instancia
+ * @param buffer Índice del buffer
+ */
+void uring_devolver_buffer(t_uring *uring, unsigned buffer);
+
+/**
+ * @brief Prepara un accept() multishot que no bloquea ni hereda el socket
+ * @param sqe SQE a completar
+ * @param socket_servidor Socket de escucha
+ * @param datos Dato de usuario de cada completado
+ */
+void uring_preparar_aceptar(struct io_uring_sqe *sqe, int socket_servidor, uint64_t datos);
+
+/**
+ * @brief Prepara un recv() multishot con buffers provistos
+ * @param sqe SQE a completar
+ * @param socket Socket del que recibir
+ * @param datos Dato de usuario de cada completado
+ */
+void uring_preparar_recibir(struct io_uring_sqe *sqe, int socket, uint64_t datos);
+
+/**
+ * @brief Prepara un poll() de un file descriptor
+ * @param sqe SQE a completar
+ * @param fd File descriptor a observar
+ * @param eventos Eventos de poll (POLLIN, POLLOUT, ...)
+ * @param multishot true para que siga activo después de cada aviso
+ * @param datos Dato de usuario de cada completado
+ */
+void uring_preparar_sondeo(struct io_uring_sqe *sqe, int fd, unsigned eventos, bool multishot, uint64_t datos);
+
+/**
+ * @brief Prepara la cancelación de las operaciones con un dato de usuario
+ * @param sqe SQE a completar
+ * @param objetivo Dato de usuario de las operaciones a cancelar
+ * @param datos Dato de usuario del completado de la cancelación
+ */
+void uring_preparar_cancelar(struct io_uring_sqe *sqe, uint64_t objetivo, uint64_t datos);
+
+/**
+ * @brief Prepara la cancelación de todas las operaciones en curso
+ * @param sqe SQE a completar
+ * @param datos Dato de usuario del completado de la cancelación
+ */
+void uring_preparar_cancelar_todo(struct io_uring_sqe *sqe, uint64_t datos);
+
+#endif /* URING_H_ */
@@ -1,8 +1,36 @@
 #include "utils.h"
+#include "log_async.h"
 
 // Logger global del servidor
 t_log *logger;
 
+// Payload más grande que se acepta en un frame
+static int maximo_frame = TAMANIO_MAXIMO_FRAME;
+
+/**
+ * @brief Cambia el tamaño máximo aceptado para el payload de un frame
+ *
+ * Se llama al iniciar, antes de lanzar los workers. Acota la memoria que
+ * un cliente puede hacer reservar por conexión: un frame más grande se
+ * rechaza sin leer su payload.
+ *
+ * @param bytes Tamaño máximo (<= 0 = TAMANIO_MAXIMO_FRAME)
+ */
+void establecer_tamanio_maximo_frame(int bytes)
+{
+    maximo_frame = bytes > 0 ? bytes : TAMANIO_MAXIMO_FRAME;
+}
+
+/**
+ * @brief Tamaño máximo aceptado para el payload de un frame
+ *
+ * @return int Tamaño máximo en bytes
+ */
+int tamanio_maximo_frame(void)
+{
+    return maximo_frame;
+}
+
 /**
  * @brief Inicializa y configura el servidor TCP
  *
@@ -13,13 +41,16 @@ t_log *logger;
  * 4. Asocia el socket al puerto definido en PUERTO
  * 5. Pone el socket en modo escucha
  *
+ * Gracias a SO_REUSEPORT se puede llamar varias veces (por ejemplo una vez
+ * por worker) y el kernel reparte las conexiones entrantes entre los sockets.
+ *
  * @return int File descriptor del socket de escucha, -1 si hay error
  */
 int iniciar_servidor(void)
 {
-    int socket_servidor;
+    int resultado;
 
-    struct addrinfo hints, *servinfo, *p;
+    struct addrinfo hints, *servinfo;
 
     // Inicializar estructura hints para configuración
     memset(&hints, 0, sizeof(hints));
@@ -28,7 +59,12 @@ int iniciar_servidor(void)
     hints.ai_flags = AI_PASSIVE;     // Usar IP local
 
     // Resolver información del servidor (puerto PUERTO, cualquier IP local)
-    socket_servidor = getaddrinfo(NULL, PUERTO, &hints, &servinfo);
+    resultado = getaddrinfo(NULL, PUERTO, &hints, &servinfo);
+    if (resultado != 0)
+    {
+        log_error(logger, "getaddrinfo: %s", gai_strerror(resultado));
+        return -1;
+    }
 
     // Crear el socket de escucha del servidor
     int fd_escucha = socket(servinfo->ai_family,
@@ -36,13 +72,19 @@ int iniciar_servidor(void)
                             servinfo->ai_protocol);
 
     // Configurar socket para reutilizar puerto (evita "Address already in use")
-    socket_servidor = setsockopt(fd_escucha, SOL_SOCKET, SO_REUSEPORT, &(int){1}, sizeof(int));
-
     // Asociar el socket al puerto especificado
-    socket_servidor = bind(fd_escucha, servinfo->ai_addr, servinfo->ai_addrlen);
-
     // Poner el socket en modo escucha (acepta hasta SOMAXCONN conexiones pendientes)
-    socket_servidor = listen(fd_escucha, SOMAXCONN);
+    if (fd_escucha == -1 ||
+        setsockopt(fd_escucha, SOL_SOCKET, SO_REUSEPORT, &(int){1}, sizeof(int)) == -1 ||
+        bind(fd_escucha, servinfo->ai_addr, servinfo->ai_addrlen) == -1 ||
+        listen(fd_escucha, SOMAXCONN) == -1)
+    {
+        log_error(logger, "No se pudo escuchar en el puerto %s: %s", PUERTO, strerror(errno));
+        if (fd_escucha != -1)
+            close(fd_escucha);
+        freeaddrinfo(servinfo);
+        return -1;
+    }
 
     // Liberar información del servidor
     freeaddrinfo(servinfo);
@@ -69,49 +111,192 @@ int esperar_cliente(int socket_servidor)
     return socket_cliente;
 }
 
+// Última cabecera leída por recibir_operacion() en este hilo. En v2 el
+// tamaño viene en la misma cabecera, así que queda guardado hasta que lo
+// pida recibir_buffer().
+static __thread struct
+{
+    int socket;        // Socket del que se leyó
+    int size;          // Tamaño del payload (solo v2)
+    bool pendiente;    // true si recibir_buffer() todavía no usó size
+    t_formato formato; // Formato del frame
+} cabecera_leida = {.socket = -1};
+
 /**
  * @brief Recibe el código de operación del cliente
  *
  * Lee los primeros 4 bytes del mensaje para determinar qué tipo de
- * operación quiere realizar el cliente (MENSAJE o PAQUETE).
+ * operación quiere realizar el cliente (MENSAJE o PAQUETE). Si empiezan
+ * con la magia de v2 lee el resto de la cabecera v2.
  *
  * @param socket_cliente File descriptor del socket del cliente
  * @return int Código de operación (MENSAJE, PAQUETE) o -1 si hay error/desconexión
  */
 int recibir_operacion(int socket_cliente)
 {
+    uint8_t cabecera[TAMANIO_CABECERA_V2];
     int cod_op;
 
     // Recibir exactamente sizeof(int) bytes con MSG_WAITALL
-    if (recv(socket_cliente, &cod_op, sizeof(int), MSG_WAITALL) > 0)
-        return cod_op; // Operación recibida correctamente
-    else
+    if (recv(socket_cliente, cabecera, sizeof(int), MSG_WAITALL) != sizeof(int))
     {
         // Error en recepción o cliente desconectado
         close(socket_cliente);
         return -1;
     }
+
+    cabecera_leida.socket = socket_cliente;
+    cabecera_leida.pendiente = false;
+    cabecera_leida.formato = FORMATO_V1;
+
+    if (cabecera[0] != MAGIA_PROTOCOLO_0 || cabecera[1] != MAGIA_PROTOCOLO_1)
+    {
+        memcpy(&cod_op, cabecera, sizeof(int));
+        return cod_op;
+    }
+
+    // Cabecera v2: falta [u32 cod_op][u32 size]
+    if (cabecera[2] != PROTOCOLO_V2 ||
+        recv(socket_cliente, cabecera + 4, TAMANIO_CABECERA_V2 - 4, MSG_WAITALL) != TAMANIO_CABECERA_V2 - 4)
+    {
+        close(socket_cliente);
+        return -1;
+    }
+
+    cabecera_leida.formato = (t_formato){.version = PROTOCOLO_V2, .flags = cabecera[3]};
+    cabecera_leida.size = (int)leer_u32le(cabecera + 8);
+    cabecera_leida.pendiente = true;
+
+    // La recepción bloqueante no confirma: el ID de solicitud se descarta
+    if (cabecera_leida.formato.flags & FLAG_SOLICITUD)
+    {
+        uint8_t solicitud[BYTES_ID_SOLICITUD];
+        if (cabecera_leida.size < BYTES_ID_SOLICITUD ||
+            recv(socket_cliente, solicitud, BYTES_ID_SOLICITUD, MSG_WAITALL) != BYTES_ID_SOLICITUD)
+        {
+            close(socket_cliente);
+            return -1;
+        }
+        cabecera_leida.size -= BYTES_ID_SOLICITUD;
+        cabecera_leida.formato.flags &= ~FLAG_SOLICITUD;
+    }
+
+    return (int)leer_u32le(cabecera + 4);
+}
+
+/**
+ * @brief Obtiene el tamaño del payload del frame en curso
+ *
+ * En v2 ya llegó con la cabecera; en v1 se recibe ahora. Un tamaño mayor
+ * que tamanio_maximo_frame() es inválido: no se reserva memoria para él.
+ *
+ * @param socket_cliente File descriptor del socket del cliente
+ * @param size Se completa con el tamaño del payload
+ * @return bool true si el tamaño es válido
+ */
+static bool recibir_tamanio(int socket_cliente, int *size)
+{
+    if (cabecera_leida.pendiente && cabecera_leida.socket == socket_cliente)
+    {
+        cabecera_leida.pendiente = false;
+        *size = cabecera_leida.size;
+        return *size >= 0 && *size <= maximo_frame;
+    }
+
+    return recv(socket_cliente, size, sizeof(int), MSG_WAITALL) == sizeof(int) &&
+           *size >= 0 && *size <= maximo_frame;
+}
+
+/**
+ * @brief Formato del último frame cuya cabecera se leyó de un socket
+ *
+ * @param socket_cliente File descriptor del socket del cliente
+ * @return t_formato Formato del frame (v1 si no se leyó ninguna cabecera)
+ */
+static t_formato formato_recibido(int socket_cliente)
+{
+    return cabecera_leida.socket == socket_cliente ? cabecera_leida.formato : FORMATO_V1;
+}
+
+/**
+ * @brief Tamaño original de un payload comprimido
+ *
+ * @param payload Payload [u32le tamaño original][bloque]
+ * @param size Tamaño del payload
+ * @return int Tamaño original o -1 si es inválido o supera tamanio_maximo_frame()
+ */
+int tamanio_original_comprimido(const void *payload, int size)
+{
+    if (size < BYTES_TAMANIO_ORIGINAL)
+        return -1;
+
+    uint32_t original = leer_u32le(payload);
+    return original <= (uint32_t)maximo_frame ? (int)original : -1;
+}
+
+/**
+ * @brief Descomprime un payload comprimido
+ *
+ * @param payload Payload [u32le tamaño original][bloque]
+ * @param size Tamaño del payload
+ * @param destino Lugar para tamanio_original_comprimido() bytes
+ * @return bool true si el bloque da exactamente el tamaño original
+ */
+bool descomprimir_payload(const void *payload, int size, void *destino)
+{
+    int original = tamanio_original_comprimido(payload, size);
+    if (original == -1)
+        return false;
+
+    return descomprimir_bloque((const char *)payload + BYTES_TAMANIO_ORIGINAL, size - BYTES_TAMANIO_ORIGINAL,
+                               destino, original) == original;
+}
+
+/**
+ * @brief Reemplaza un buffer comprimido recibido por su versión descomprimida
+ *
+ * @param buffer Buffer recibido (se libera)
+ * @param size Tamaño del buffer (se actualiza al original)
+ * @return void* Buffer descomprimido (del heap) o NULL si es inválido
+ */
+static void *descomprimir_recibido(void *buffer, int *size)
+{
+    int original = tamanio_original_comprimido(buffer, *size);
+    void *descomprimido = original >= 0 ? malloc(original > 0 ? original : 1) : NULL;
+
+    if (descomprimido != NULL && !descomprimir_payload(buffer, *size, descomprimido))
+    {
+        free(descomprimido);
+        descomprimido = NULL;
+    }
+
+    free(buffer);
+    *size = original;
+    cabecera_leida.formato.flags &= ~FLAG_COMPRIMIDO;
+    return descomprimido;
 }
 
 /**
  * @brief Recibe un buffer de datos del cliente
  *
  * Esta función:
- * 1. Recibe primero el tamaño del buffer (4 bytes)
+ * 1. Recibe primero el tamaño del buffer (4 bytes; en v2 ya vino en la cabecera)
  * 2. Aloca memoria para ese tamaño
  * 3. Recibe los datos del buffer
- * 4. Devuelve el buffer y actualiza el tamaño por referencia
+ * 4. Si el frame venía comprimido, lo descomprime
+ * 5. Devuelve el buffer y actualiza el tamaño por referencia
  *
  * @param size Puntero donde se guardará el tamaño del buffer recibido
  * @param socket_cliente File descriptor del socket del cliente
- * @return void* Puntero al buffer recibido (debe ser liberado con free())
+ * @return void* Puntero al buffer recibido (debe ser liberado con free()) o NULL si hay error
  */
 void *recibir_buffer(int *size, int socket_cliente)
 {
     void *buffer;
 
     // Recibir primero el tamaño del buffer
-    recv(socket_cliente, size, sizeof(int), MSG_WAITALL);
+    if (!recibir_tamanio(socket_cliente, size))
+        return NULL;
 
     // Alocar memoria para el buffer
     buffer = malloc(*size);
@@ -119,6 +304,9 @@ void *recibir_buffer(int *size, int socket_cliente)
     // Recibir los datos del buffer
     recv(socket_cliente, buffer, *size, MSG_WAITALL);
 
+    if (formato_recibido(socket_cliente).flags & FLAG_COMPRIMIDO)
+        return descomprimir_recibido(buffer, size);
+
     return buffer;
 }
 
@@ -136,14 +324,125 @@ void recibir_mensaje(int socket_cliente)
 
     // Recibir el buffer con el mensaje
     char *buffer = recibir_buffer(&size, socket_cliente);
+    if (buffer == NULL)
+        return;
 
     // Registrar el mensaje recibido
-    log_info(logger, "Me llego el mensaje: %s", buffer);
+    log_async(LOG_LEVEL_INFO, "Me llego el mensaje: %.*s", buffer, strnlen(buffer, size));
 
     // Liberar memoria del buffer
     free(buffer);
 }
 
+/**
+ * @brief Lee la longitud del próximo elemento de un paquete
+ *
+ * Según el formato la longitud es un int del host (v1), un u32
+ * little-endian (v2) o un LEB128 (v2 con FLAG_LONGITUDES_VARINT).
+ *
+ * @param buffer Buffer del paquete
+ * @param size Tamaño total del buffer
+ * @param desplazamiento Posición de la longitud (avanza hasta el elemento)
+ * @param formato Formato del frame que trajo el paquete
+ * @param longitud Se completa con la longitud del elemento
+ * @return bool true si la longitud es válida y el elemento entra en el buffer
+ */
+bool leer_longitud_elemento(const void *buffer, int size, int *desplazamiento, t_formato formato, int *longitud)
+{
+    const uint8_t *bytes = buffer;
+    int posicion = *desplazamiento;
+    int64_t valor;
+
+    if (formato.version == PROTOCOLO_V2 && (formato.flags & FLAG_LONGITUDES_VARINT))
+    {
+        // LEB128: 7 bits por byte, el bit alto indica que sigue otro byte
+        uint64_t acumulado = 0;
+        for (int corrimiento = 0;; corrimiento += 7)
+        {
+            if (posicion >= size || corrimiento > 28)
+                return false;
+            uint8_t byte = bytes[posicion++];
+            acumulado |= (uint64_t)(byte & 0x7F) << corrimiento;
+            if (!(byte & 0x80))
+                break;
+        }
+        valor = (int64_t)acumulado;
+    }
+    else
+    {
+        if (size - posicion < 4)
+            return false;
+
+        if (formato.version == PROTOCOLO_V2)
+        {
+            valor = leer_u32le(bytes + posicion);
+        }
+        else
+        {
+            int entero;
+            memcpy(&entero, bytes + posicion, sizeof(int));
+            valor = entero;
+        }
+        posicion += 4;
+    }
+
+    if (valor < 0 || valor > size - posicion)
+        return false;
+
+    *longitud = (int)valor;
+    *desplazamiento = posicion;
+    return true;
+}
+
+/**
+ * @brief Deserializa los mensajes individuales de un buffer de paquete
+ *
+ * El formato del buffer es: [tamaño_msg1][msg1][tamaño_msg2][msg2]...
+ * Si un tamaño excede los límites del buffer se descarta el resto.
+ *
+ * @param buffer Buffer con los datos del paquete
+ * @param size Tamaño total del buffer
+ * @return t_list* Lista con copias de todos los mensajes (debe ser liberada)
+ */
+t_list *deserializar_paquete(void *buffer, int size)
+{
+    return deserializar_paquete_formato(buffer, size, FORMATO_V1);
+}
+
+/**
+ * @brief Deserializa un paquete en el formato indicado
+ *
+ * @param buffer Buffer del paquete
+ * @param size Tamaño total del buffer
+ * @param formato Formato del frame que trajo el paquete
+ * @return t_list* Lista con copias de todos los mensajes (debe ser liberada)
+ */
+t_list *deserializar_paquete_formato(void *buffer, int size, t_formato formato)
+{
+    int desplazamiento = 0;          // Offset actual en el buffer
+    t_list *valores = list_create(); // Lista para almacenar mensajes
+    int tamanio;                     // Tamaño del mensaje actual
+
+    // Deserializar mensajes uno por uno
+    while (desplazamiento < size)
+    {
+        // Leer tamaño del siguiente mensaje, ignorando tamaños corruptos
+        // en lugar de leer fuera del buffer
+        if (!leer_longitud_elemento(buffer, size, &desplazamiento, formato, &tamanio))
+            break;
+
+        // Alocar memoria y leer el mensaje
+        char *valor = malloc(tamanio);
+        memcpy(valor, buffer + desplazamiento, tamanio);
+        desplazamiento += tamanio;
+
+        // Agregar mensaje a la lista
+        list_add(valores, valor);
+    }
+
+    return valores;
+}
+
 /**
  * @brief Recibe y procesa un paquete con múltiples mensajes
  *
@@ -160,32 +459,170 @@ void recibir_mensaje(int socket_cliente)
  */
 t_list *recibir_paquete(int socket_cliente)
 {
-    int size;                        // Tamaño total del buffer
-    int desplazamiento = 0;          // Offset actual en el buffer
-    void *buffer;                    // Buffer con todos los datos
-    t_list *valores = list_create(); // Lista para almacenar mensajes
-    int tamanio;                     // Tamaño del mensaje actual
+    int size;     // Tamaño total del buffer
+    void *buffer; // Buffer con todos los datos
 
     // Recibir buffer completo con todos los mensajes
     buffer = recibir_buffer(&size, socket_cliente);
+    if (buffer == NULL)
+        return list_create();
 
     // Deserializar mensajes uno por uno
+    t_list *valores = deserializar_paquete_formato(buffer, size, formato_recibido(socket_cliente));
+
+    // Liberar buffer temporal
+    free(buffer);
+    return valores;
+}
+
+/**
+ * @brief Crea una vista de paquete vacía y reutilizable
+ *
+ * @return t_vista_paquete* Vista creada (liberar con eliminar_vista_paquete())
+ */
+t_vista_paquete *crear_vista_paquete(void)
+{
+    return calloc(1, sizeof(t_vista_paquete));
+}
+
+/**
+ * @brief Ubica los elementos de un buffer de paquete sin copiarlos
+ *
+ * Recorre el buffer una sola vez registrando el offset y la longitud de
+ * cada elemento. El buffer no se copia: la vista es válida mientras el
+ * buffer lo sea. El arreglo de slices crece geométricamente y se conserva
+ * para el próximo paquete.
+ *
+ * @param vista Vista a completar (se reutiliza su arreglo de slices)
+ * @param buffer Buffer con el formato [tamaño][dato][tamaño][dato]...
+ * @param size Tamaño total del buffer
+ * @return bool true si el buffer es válido, false si tiene tamaños corruptos
+ */
+bool parsear_vista_paquete(t_vista_paquete *vista, void *buffer, int size)
+{
+    return parsear_vista_paquete_formato(vista, buffer, size, FORMATO_V1);
+}
+
+/**
+ * @brief Ubica los elementos de un paquete en el formato indicado
+ *
+ * @param vista Vista a completar (se reutiliza su arreglo de slices)
+ * @param buffer Buffer del paquete
+ * @param size Tamaño total del buffer
+ * @param formato Formato del frame que trajo el paquete
+ * @return bool true si el buffer es válido, false si tiene tamaños corruptos
+ */
+bool parsear_vista_paquete_formato(t_vista_paquete *vista, void *buffer, int size, t_formato formato)
+{
+    int desplazamiento = 0;
+    int tamanio;
+
+    if (vista->buffer_propio)
+        free(vista->buffer);
+    vista->buffer = buffer;
+    vista->buffer_propio = false;
+    vista->cantidad = 0;
+    vista->formato = formato;
+
     while (desplazamiento < size)
     {
-        // Leer tamaño del siguiente mensaje
-        memcpy(&tamanio, buffer + desplazamiento, sizeof(int));
-        desplazamiento += sizeof(int);
+        // Leer tamaño del siguiente elemento
+        if (!leer_longitud_elemento(buffer, size, &desplazamiento, formato, &tamanio))
+            return false;
+
+        // Agrandar el arreglo de slices solo si hace falta
+        if (vista->cantidad == vista->capacidad)
+        {
+            vista->capacidad = vista->capacidad > 0 ? vista->capacidad * 2 : 16;
+            vista->elementos = realloc(vista->elementos, vista->capacidad * sizeof(t_slice));
+        }
+
+        vista->elementos[vista->cantidad].offset = desplazamiento;
+        vista->elementos[vista->cantidad].longitud = tamanio;
+        vista->cantidad++;
 
-        // Alocar memoria y leer el mensaje
-        char *valor = malloc(tamanio);
-        memcpy(valor, buffer + desplazamiento, tamanio);
         desplazamiento += tamanio;
+    }
 
-        // Agregar mensaje a la lista
-        list_add(valores, valor);
+    return true;
+}
+
+/**
+ * @brief Devuelve un puntero al elemento i de la vista
+ *
+ * @param vista Vista de paquete
+ * @param indice Índice del elemento (0..cantidad-1)
+ * @param longitud Se completa con la cantidad de bytes del elemento
+ * @return void* Puntero al elemento dentro del buffer
+ */
+void *elemento_vista_paquete(t_vista_paquete *vista, int indice, int *longitud)
+{
+    t_slice *slice = &vista->elementos[indice];
+
+    *longitud = slice->longitud;
+    return vista->buffer + slice->offset;
+}
+
+/**
+ * @brief Devuelve el elemento i de la vista indicando si está partido entre frames
+ *
+ * Solo el primer y el último elemento de un fragmento pueden estar
+ * partidos; el resto siempre llega entero. Permite procesar un paquete
+ * fragmentado a medida que llegan sus frames, sin juntar los elementos.
+ *
+ * @param vista Vista de paquete
+ * @param indice Índice del elemento (0..cantidad-1)
+ * @return t_fragmento_elemento Datos del elemento y si comienza o termina en este frame
+ */
+t_fragmento_elemento fragmento_vista_paquete(t_vista_paquete *vista, int indice)
+{
+    t_fragmento_elemento fragmento;
+
+    fragmento.datos = elemento_vista_paquete(vista, indice, &fragmento.longitud);
+    fragmento.comienza = indice > 0 || !(vista->formato.flags & FLAG_ELEMENTO_CONTINUADO);
+    fragmento.termina = indice < vista->cantidad - 1 || !(vista->formato.flags & FLAG_ELEMENTO_SIGUE);
+
+    return fragmento;
+}
+
+/**
+ * @brief Recibe un paquete y devuelve su vista (dueña del buffer recibido)
+ *
+ * Equivalente a recibir_paquete() pero con una sola allocation para el
+ * buffer y otra para los slices, sin importar la cantidad de elementos.
+ *
+ * @param socket_cliente Socket del cliente
+ * @return t_vista_paquete* Vista del paquete o NULL si el buffer es inválido
+ */
+t_vista_paquete *recibir_paquete_vista(int socket_cliente)
+{
+    int size;
+    void *buffer = recibir_buffer(&size, socket_cliente);
+    if (buffer == NULL)
+        return NULL;
+
+    t_vista_paquete *vista = crear_vista_paquete();
+
+    if (!parsear_vista_paquete_formato(vista, buffer, size, formato_recibido(socket_cliente)))
+    {
+        free(buffer);
+        eliminar_vista_paquete(vista);
+        return NULL;
     }
 
-    // Liberar buffer temporal
-    free(buffer);
-    return valores;
+    vista->buffer_propio = true;
+    return vista;
+}
+
+/**
+ * @brief Libera la vista (y el buffer si le pertenece)
+ *
+ * @param vista Vista a liberar
+ */
+void eliminar_vista_paquete(t_vista_paquete *vista)
+{
+    if (vista->buffer_propio)
+        free(vista->buffer);
+    free(vista->elementos);
+    free(vista);
 }
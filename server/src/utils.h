@@ -9,7 +9,11 @@
 #include <commons/log.h>
 #include <commons/collections/list.h>
 #include <string.h>
+#include <stdbool.h>
+#include <errno.h>
 #include <assert.h>
+#include <stdint.h>
+#include "descompresion.h"
 
 /**
  * @file utils.h
@@ -26,6 +30,106 @@
  */
 #define PUERTO "4444"
 
+// ========== PROTOCOLO ==========
+
+/**
+ * @brief Versiones del formato de los frames
+ *
+ * - v1: [int cod_op][int size][payload], enteros en el orden del host.
+ * - v2: ['T']['P'][u8 versión][u8 flags][u32 cod_op][u32 size][payload],
+ *   enteros little-endian. Con FLAG_LONGITUDES_VARINT las longitudes de
+ *   los elementos de un paquete van en LEB128 en lugar de u32.
+ *
+ * Cada conexión usa la versión de su primer frame.
+ */
+#define PROTOCOLO_V1 1
+#define PROTOCOLO_V2 2
+
+#define MAGIA_PROTOCOLO_0 'T'
+#define MAGIA_PROTOCOLO_1 'P'
+
+#define TAMANIO_CABECERA_V1 (2 * (int)sizeof(int))
+#define TAMANIO_CABECERA_V2 12
+
+/**
+ * @brief Flags de la cabecera v2
+ */
+#define FLAG_LONGITUDES_VARINT 0x01   // Longitudes de elementos en LEB128
+#define FLAG_COMPRIMIDO 0x02          // Payload comprimido (ver descompresion.h)
+#define FLAG_PAQUETE_SIGUE 0x04       // El paquete sigue en el próximo frame
+#define FLAG_PAQUETE_CONTINUADO 0x08  // El frame continúa el paquete del frame anterior
+#define FLAG_ELEMENTO_SIGUE 0x10      // El último elemento sigue en el próximo frame
+#define FLAG_ELEMENTO_CONTINUADO 0x20 // El primer elemento continúa al último del frame anterior
+#define FLAG_SOLICITUD 0x40           // El payload empieza con el ID de solicitud a confirmar
+
+/**
+ * @brief Flags que indican que un frame es un fragmento de un paquete más grande
+ *
+ * Un paquete fragmentado se envía como varios frames PAQUETE seguidos en
+ * la misma conexión. Cada fragmento es un paquete válido por sí solo: un
+ * elemento que no entra se parte en varios elementos, uno por fragmento,
+ * y los flags indican cómo se unen. Así el servidor nunca necesita más
+ * memoria que la de un frame, sin importar el tamaño del paquete.
+ */
+#define FLAGS_FRAGMENTO (FLAG_PAQUETE_SIGUE | FLAG_PAQUETE_CONTINUADO | FLAG_ELEMENTO_SIGUE | FLAG_ELEMENTO_CONTINUADO)
+
+/**
+ * @brief Bytes del tamaño original al principio de un payload comprimido
+ *
+ * Un payload con FLAG_COMPRIMIDO es [u32le tamaño original][bloque]. El
+ * resto del servidor nunca lo ve: recibir_buffer() y el decodificador lo
+ * entregan ya descomprimido y sin el flag.
+ */
+#define BYTES_TAMANIO_ORIGINAL 4
+
+/**
+ * @brief Bytes del ID de solicitud al principio de un payload con FLAG_SOLICITUD
+ *
+ * Un frame con FLAG_SOLICITUD es [cabecera][u32le ID][payload]: el ID va
+ * afuera del bloque comprimido y la cabecera lo cuenta en el tamaño. El
+ * decodificador lo saca del payload (y el flag del formato) antes de
+ * entregar el frame, y el servidor responde con una confirmación ACK.
+ */
+#define BYTES_ID_SOLICITUD 4
+
+/**
+ * @brief Bytes de cada confirmación en el payload de un frame ACK
+ *
+ * El payload de un ACK es una secuencia de [u32le ID][u8 estado], una por
+ * solicitud, en el orden en que se procesaron.
+ */
+#define BYTES_CONFIRMACION 5
+
+/**
+ * @brief Estados de una solicitud confirmada
+ */
+#define CONFIRMACION_PROCESADA 0 // El manejador procesó el frame
+#define CONFIRMACION_RECHAZADA 1 // Operación desconocida o payload mal formado
+
+/**
+ * @brief Bytes del payload de un frame CREDITO del servidor
+ *
+ * El cliente pide control de flujo con un CREDITO sin payload; el
+ * servidor responde con [u32le bytes] que puede enviarle y, a medida que
+ * procesa sus frames, le devuelve los bytes que ocupaban (cabeceras
+ * incluidas) en nuevos CREDITO. Ver reactor.h.
+ */
+#define BYTES_CREDITO 4
+
+/**
+ * @brief Crédito que se otorga si el control de flujo está deshabilitado
+ */
+#define CREDITO_ILIMITADO UINT32_MAX
+
+/**
+ * @brief Tamaño máximo por defecto del payload de un frame
+ *
+ * Un frame más grande se rechaza en lugar de reservar memoria para él;
+ * los paquetes más grandes se envían fragmentados. Se cambia con
+ * establecer_tamanio_maximo_frame().
+ */
+#define TAMANIO_MAXIMO_FRAME (16 * 1024 * 1024)
+
 // ========== ENUMERACIONES ==========
 
 /**
@@ -34,13 +138,82 @@
  * Define los tipos de mensaje que puede recibir el servidor:
  * - MENSAJE: Un mensaje simple del cliente
  * - PAQUETE: Múltiples mensajes agrupados del cliente
+ * - ACK: Confirmaciones de solicitudes (solo las envía el servidor)
+ * - CREDITO: Pedido u otorgamiento de crédito para el control de flujo
+ *
+ * El enum se comparte con client/src/utils.h: ambos deben coincidir.
  */
 typedef enum
 {
-    MENSAJE, // Operación para recibir un mensaje simple
-    PAQUETE  // Operación para recibir múltiples mensajes
+    MENSAJE = 0, // Operación para recibir un mensaje simple
+    PAQUETE = 1, // Operación para recibir múltiples mensajes
+    ACK = 2,     // Confirmaciones de solicitudes (servidor -> cliente)
+    CREDITO = 3, // Pedido (cliente -> servidor) u otorgamiento (servidor -> cliente) de crédito
+
+    // Las operaciones nuevas van acá, con valor explícito y en el mismo
+    // orden en cliente y servidor (es el valor que viaja por la red)
+
+    OP_CODE_MAX // Cantidad de códigos (no es una operación)
 } op_code;
 
+// ========== ESTRUCTURAS ==========
+
+/**
+ * @brief Formato con el que llegó un frame
+ */
+typedef struct
+{
+    uint8_t version; // PROTOCOLO_V1 o PROTOCOLO_V2
+    uint8_t flags;   // Flags de la cabecera (siempre 0 en v1)
+} t_formato;
+
+/**
+ * @brief Formato de los frames v1 (el del protocolo original)
+ */
+#define FORMATO_V1 ((t_formato){.version = PROTOCOLO_V1, .flags = 0})
+
+/**
+ * @brief Ubicación de un elemento dentro del buffer de un paquete
+ */
+typedef struct
+{
+    int offset;   // Posición del primer byte del elemento en el buffer
+    int longitud; // Cantidad de bytes del elemento
+} t_slice;
+
+/**
+ * @brief Parte de un elemento de un paquete, tal como llegó en un frame
+ *
+ * En un paquete sin fragmentar cada elemento llega entero (comienza y
+ * termina). En un paquete fragmentado el primer y el último elemento de
+ * cada frame pueden ser parte de un elemento partido entre frames.
+ */
+typedef struct
+{
+    void *datos;   // Bytes de esta parte (apuntan al buffer recibido)
+    int longitud;  // Cantidad de bytes de esta parte
+    bool comienza; // true si es el principio del elemento
+    bool termina;  // true si es el final del elemento
+} t_fragmento_elemento;
+
+/**
+ * @brief Vista de un paquete recibido, sin copiar sus elementos
+ *
+ * Cada elemento es un t_slice que apunta al buffer recibido, por lo que
+ * recorrer un paquete no requiere ninguna allocation por elemento. El
+ * arreglo de slices se reutiliza entre paquetes y solo crece cuando llega
+ * un paquete con más elementos que los vistos hasta el momento.
+ */
+typedef struct
+{
+    void *buffer;        // Buffer del paquete (prestado salvo buffer_propio)
+    bool buffer_propio;  // true si la vista debe liberar el buffer
+    int cantidad;        // Cantidad de elementos del paquete
+    int capacidad;       // Capacidad del arreglo de slices
+    t_slice *elementos;  // Ubicación de cada elemento en el buffer
+    t_formato formato;   // Formato del frame (flags de fragmento incluidos)
+} t_vista_paquete;
+
 // ========== VARIABLES GLOBALES ==========
 
 /**
@@ -53,6 +226,18 @@ extern t_log *logger;
 
 // ========== DECLARACIONES DE FUNCIONES ==========
 
+/**
+ * @brief Cambia el tamaño máximo aceptado para el payload de un frame
+ * @param bytes Tamaño máximo (<= 0 = TAMANIO_MAXIMO_FRAME)
+ */
+void establecer_tamanio_maximo_frame(int);
+
+/**
+ * @brief Tamaño máximo aceptado para el payload de un frame
+ * @return int Tamaño máximo en bytes
+ */
+int tamanio_maximo_frame(void);
+
 /**
  * @brief Recibe un buffer de datos del cliente
  * @param size Puntero donde se guardará el tamaño recibido
@@ -81,6 +266,106 @@ int esperar_cliente(int);
  */
 t_list *recibir_paquete(int);
 
+/**
+ * @brief Deserializa los mensajes de un buffer de paquete ya recibido
+ * @param buffer Buffer con el formato [tamaño][dato][tamaño][dato]...
+ * @param size Tamaño total del buffer
+ * @return t_list* Lista con copias de los mensajes (debe ser liberada)
+ */
+t_list *deserializar_paquete(void *, int);
+
+/**
+ * @brief Deserializa un paquete en el formato indicado
+ * @param buffer Buffer del paquete
+ * @param size Tamaño total del buffer
+ * @param formato Formato del frame que trajo el paquete
+ * @return t_list* Lista con copias de los mensajes (debe ser liberada)
+ */
+t_list *deserializar_paquete_formato(void *, int, t_formato);
+
+/**
+ * @brief Lee la longitud del próximo elemento de un paquete
+ * @param buffer Buffer del paquete
+ * @param size Tamaño total del buffer
+ * @param desplazamiento Posición de la longitud (avanza hasta el elemento)
+ * @param formato Formato del frame que trajo el paquete
+ * @param longitud Se completa con la longitud del elemento
+ * @return bool true si la longitud es válida y el elemento entra en el buffer
+ */
+bool leer_longitud_elemento(const void *, int, int *, t_formato, int *);
+
+/**
+ * @brief Tamaño original de un payload comprimido
+ * @param payload Payload [u32le tamaño original][bloque]
+ * @param size Tamaño del payload
+ * @return int Tamaño original o -1 si es inválido o supera tamanio_maximo_frame()
+ */
+int tamanio_original_comprimido(const void *, int);
+
+/**
+ * @brief Descomprime un payload comprimido
+ * @param payload Payload [u32le tamaño original][bloque]
+ * @param size Tamaño del payload
+ * @param destino Lugar para tamanio_original_comprimido() bytes
+ * @return bool true si el bloque da exactamente el tamaño original
+ */
+bool descomprimir_payload(const void *, int, void *);
+
+/**
+ * @brief Crea una vista de paquete vacía y reutilizable
+ * @return t_vista_paquete* Vista creada (liberar con eliminar_vista_paquete())
+ */
+t_vista_paquete *crear_vista_paquete(void);
+
+/**
+ * @brief Ubica los elementos de un buffer de paquete sin copiarlos
+ * @param vista Vista a completar (se reutiliza su arreglo de slices)
+ * @param buffer Buffer con el formato [tamaño][dato][tamaño][dato]...
+ * @param size Tamaño total del buffer
+ * @return bool true si el buffer es válido, false si tiene tamaños corruptos
+ */
+bool parsear_vista_paquete(t_vista_paquete *, void *, int);
+
+/**
+ * @brief Ubica los elementos de un paquete en el formato indicado
+ * @param vista Vista a completar (se reutiliza su arreglo de slices)
+ * @param buffer Buffer del paquete
+ * @param size Tamaño total del buffer
+ * @param formato Formato del frame que trajo el paquete
+ * @return bool true si el buffer es válido, false si tiene tamaños corruptos
+ */
+bool parsear_vista_paquete_formato(t_vista_paquete *, void *, int, t_formato);
+
+/**
+ * @brief Devuelve un puntero al elemento i de la vista
+ * @param vista Vista de paquete
+ * @param indice Índice del elemento (0..cantidad-1)
+ * @param longitud Se completa con la cantidad de bytes del elemento
+ * @return void* Puntero al elemento dentro del buffer
+ */
+void *elemento_vista_paquete(t_vista_paquete *, int, int *);
+
+/**
+ * @brief Devuelve el elemento i de la vista indicando si está partido entre frames
+ * @param vista Vista de paquete
+ * @param indice Índice del elemento (0..cantidad-1)
+ * @return t_fragmento_elemento Datos del elemento y si comienza o termina en este frame
+ */
+t_fragmento_elemento fragmento_vista_paquete(t_vista_paquete *, int);
+
+/**
+ * @brief Recibe un paquete y devuelve su vista (dueña del buffer recibido)
+ * @param socket_cliente Socket del cliente
+ * @return t_vista_paquete* Vista del paquete o NULL si el buffer es inválido
+ */
+t_vista_paquete *recibir_paquete_vista(int);
+
+/**
+ * @brief Libera la vista (y el buffer si le pertenece)
+ * @param vista Vista a liberar
+ */
+void eliminar_vista_paquete(t_vista_paquete *);
+
 /**
  * @brief Recibe y procesa un mensaje simple
  * @param socket_cliente Socket del cliente
@@ -94,4 +379,15 @@ void recibir_mensaje(int);
  */
 int recibir_operacion(int);
 
+/**
+ * @brief Lee un entero de 32 bits little-endian
+ * @param origen Bytes a leer
+ * @return uint32_t Valor leído
+ */
+static inline uint32_t leer_u32le(const void *origen)
+{
+    const uint8_t *bytes = origen;
+    return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
 #endif /* UTILS_H_ */
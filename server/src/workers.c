@@ -0,0 +1,131 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // pthread_setaffinity_np()
+#endif
+
+#include "workers.h"
+
+/**
+ * @brief Cantidad de núcleos disponibles en la máquina
+ *
+ * @return int Núcleos en línea (al menos 1)
+ */
+int cantidad_nucleos(void)
+{
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    return nucleos > 0 ? (int)nucleos : 1;
+}
+
+/**
+ * @brief Cuerpo de cada hilo worker
+ *
+ * Fija el hilo a su núcleo y ejecuta el reactor sobre el socket propio
+ * del worker hasta que el reactor termine (por apagado o por error).
+ *
+ * @param argumento Puntero al t_worker del hilo
+ * @return void* Siempre NULL
+ */
+static void *ejecutar_worker(void *argumento)
+{
+    t_worker *worker = argumento;
+
+    // Fijar el hilo a su núcleo para conservar las cachés calientes
+    cpu_set_t nucleos;
+    CPU_ZERO(&nucleos);
+    CPU_SET(worker->cpu, &nucleos);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(nucleos), &nucleos) != 0)
+        log_warning(logger, "Worker %d: no se pudo fijar al nucleo %d", worker->id, worker->cpu);
+
+    log_info(logger, "Worker %d escuchando en el nucleo %d", worker->id, worker->cpu);
+    reactor_ejecutar(worker->reactor);
+
+    return NULL;
+}
+
+/**
+ * @brief Lanza los workers, cada uno con su socket y su reactor
+ *
+ * Los sockets y reactores se crean antes de lanzar los hilos para que un
+ * error de bind se detecte enseguida. Si algún worker no puede iniciarse se
+ * continúa con los que sí pudieron.
+ *
+ * @param cantidad Cantidad de workers (0 = uno por núcleo)
+ * @param procesar Función a invocar por cada frame recibido
+ * @param planificador Pool compartido de manejadores (NULL = procesar en el worker)
+ * @param evento_apagado eventfd que pide a los workers drenar y terminar (-1 = ninguno)
+ * @param lanzados Se completa con la cantidad de workers lanzados
+ * @return t_worker* Arreglo de workers o NULL si no se pudo lanzar ninguno
+ */
+t_worker *iniciar_workers(int cantidad, t_procesar_frame procesar, t_planificador *planificador, int evento_apagado, int *lanzados)
+{
+    int nucleos = cantidad_nucleos();
+    if (cantidad <= 0)
+        cantidad = nucleos;
+
+    t_worker *workers = calloc(cantidad, sizeof(t_worker));
+    *lanzados = 0;
+
+    for (int i = 0; i < cantidad; i++)
+    {
+        t_worker *worker = &workers[*lanzados];
+        worker->id = i;
+        worker->cpu = i % nucleos;
+        worker->procesar = procesar;
+
+        // Cada worker abre su propio socket sobre PUERTO (SO_REUSEPORT)
+        worker->socket_servidor = iniciar_servidor();
+        if (worker->socket_servidor == -1)
+            continue;
+
+        worker->reactor = reactor_crear(worker->socket_servidor, procesar, planificador);
+        if (worker->reactor == NULL)
+        {
+            close(worker->socket_servidor);
+            continue;
+        }
+
+        if (evento_apagado != -1 && !reactor_observar_apagado(worker->reactor, evento_apagado))
+        {
+            reactor_destruir(worker->reactor);
+            close(worker->socket_servidor);
+            continue;
+        }
+
+        if (pthread_create(&worker->hilo, NULL, ejecutar_worker, worker) != 0)
+        {
+            log_error(logger, "No se pudo crear el hilo del worker %d", i);
+            reactor_destruir(worker->reactor);
+            close(worker->socket_servidor);
+            continue;
+        }
+
+        (*lanzados)++;
+    }
+
+    if (*lanzados == 0)
+    {
+        free(workers);
+        return NULL;
+    }
+
+    return workers;
+}
+
+/**
+ * @brief Espera a que terminen todos los workers y libera sus recursos
+ *
+ * Al destruir cada reactor se cierran las conexiones que sigan abiertas.
+ *
+ * @param workers Arreglo devuelto por iniciar_workers()
+ * @param cantidad Cantidad de workers lanzados
+ */
+void esperar_workers(t_worker *workers, int cantidad)
+{
+    for (int i = 0; i < cantidad; i++)
+    {
+        pthread_join(workers[i].hilo, NULL);
+        reactor_destruir(workers[i].reactor);
+        close(workers[i].socket_servidor);
+    }
+
+    free(workers);
+}
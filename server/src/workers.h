@@ -0,0 +1,64 @@
+#ifndef WORKERS_H_
+#define WORKERS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <commons/log.h>
+#include "utils.h"
+#include "reactor.h"
+
+/**
+ * @file workers.h
+ * @brief Modo multi-núcleo: un reactor independiente por hilo
+ *
+ * Cada worker abre su propio socket de escucha sobre PUERTO con
+ * SO_REUSEPORT, se fija a un núcleo y ejecuta su propio reactor. El kernel
+ * reparte las conexiones nuevas entre los sockets, por lo que los workers
+ * no comparten estado en el camino de recepción.
+ */
+
+// ========== TIPOS ==========
+
+/**
+ * @brief Estado de un hilo worker
+ */
+typedef struct
+{
+    int id;                    // Número de worker (0..N-1)
+    int cpu;                   // Núcleo al que se fija el hilo
+    pthread_t hilo;            // Hilo que ejecuta el reactor
+    int socket_servidor;       // Socket de escucha propio del worker
+    t_reactor *reactor;        // Reactor del worker
+    t_procesar_frame procesar; // Callback para cada frame recibido
+} t_worker;
+
+// ========== DECLARACIONES DE FUNCIONES ==========
+
+/**
+ * @brief Cantidad de núcleos disponibles en la máquina
+ * @return int Núcleos en línea (al menos 1)
+ */
+int cantidad_nucleos(void);
+
+/**
+ * @brief Lanza los workers, cada uno con su socket y su reactor
+ * @param cantidad Cantidad de workers (0 = uno por núcleo)
+ * @param procesar Función a invocar por cada frame recibido
+ * @param planificador Pool compartido de manejadores (NULL = procesar en el worker)
+ * @param evento_apagado eventfd que pide a los workers drenar y terminar (-1 = ninguno)
+ * @param lanzados Se completa con la cantidad de workers lanzados
+ * @return t_worker* Arreglo de workers o NULL si no se pudo lanzar ninguno
+ */
+t_worker *iniciar_workers(int cantidad, t_procesar_frame procesar, t_planificador *planificador, int evento_apagado, int *lanzados);
+
+/**
+ * @brief Espera a que terminen todos los workers y libera sus recursos
+ * @param workers Arreglo devuelto por iniciar_workers()
+ * @param cantidad Cantidad de workers lanzados
+ */
+void esperar_workers(t_worker *workers, int cantidad);
+
+#endif /* WORKERS_H_ */